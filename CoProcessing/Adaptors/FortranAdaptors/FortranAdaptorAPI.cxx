@@ -22,11 +22,15 @@
 #include "vtkCPInputDataDescription.h"
 #include "vtkCPProcessor.h"
 #include "vtkCPPythonScriptPipeline.h"
+#include "vtkCellArray.h"
 #include "vtkDoubleArray.h"
 #include "vtkFieldData.h"
+#include "vtkIdTypeArray.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
+#include "vtkStdString.h"
+#include "vtkUnsignedCharArray.h"
 #include "vtkUnstructuredGrid.h"
 
 using namespace std;
@@ -79,6 +83,101 @@ bool ConvertFortranStringToCString(char* fortranString, int fortranStringLength,
   return true;
 }
 
+vtkDataArray* CreateFieldArray(const char* name, double* data,
+                               vtkIdType numTuples, int numComponents,
+                               vtkIdType componentStride)
+{
+  vtkDoubleArray* array = vtkDoubleArray::New();
+  array->SetName(name);
+  array->SetNumberOfComponents(numComponents);
+  if(numComponents == 1 || componentStride == 1)
+    {
+    // save == 1 so VTK never frees simulation memory
+    array->SetArray(data, numTuples*numComponents, 1);
+    }
+  else
+    {
+    array->SetNumberOfTuples(numTuples);
+    double* values = array->GetPointer(0);
+    for(int j=0;j<numComponents;j++)
+      {
+      const double* component = data + j*componentStride;
+      for(vtkIdType i=0;i<numTuples;i++)
+        {
+        values[i*numComponents+j] = component[i];
+        }
+      }
+    }
+  return array;
+}
+
+void SetGridPoints(vtkPointSet* grid, vtkIdType numPoints, double* coords,
+                   vtkIdType componentStride)
+{
+  vtkDataArray* coordsArray = CreateFieldArray(
+    "coordinates", coords, numPoints, 3, componentStride);
+  vtkPoints* points = vtkPoints::New();
+  points->SetData(coordsArray);
+  coordsArray->Delete();
+  grid->SetPoints(points);
+  points->Delete();
+}
+
+void InsertBlockOfCells(vtkUnstructuredGrid* grid, int cellType,
+                        vtkIdType numCells, int numPointsPerCell,
+                        int* connectivity, vtkIdType cellStride,
+                        vtkIdType pointStride, int idOffset)
+{
+  vtkCellArray* cells = grid->GetCells();
+  vtkUnsignedCharArray* types = grid->GetCellTypesArray();
+  vtkIdTypeArray* locations = grid->GetCellLocationsArray();
+  vtkIdType oldNumCells = 0;
+  if(cells && types && locations)
+    {
+    cells->Register(0);
+    types->Register(0);
+    locations->Register(0);
+    oldNumCells = cells->GetNumberOfCells();
+    }
+  else
+    {
+    cells = vtkCellArray::New();
+    types = vtkUnsignedCharArray::New();
+    locations = vtkIdTypeArray::New();
+    }
+
+  vtkIdType numPoints = grid->GetNumberOfPoints();
+  vtkIdTypeArray* ia = cells->GetData();
+  vtkIdType location = ia->GetNumberOfTuples();
+  vtkIdType* connPtr = ia->WritePointer(location, numCells*(numPointsPerCell+1));
+  unsigned char* typesPtr = types->WritePointer(oldNumCells, numCells);
+  vtkIdType* locationsPtr = locations->WritePointer(oldNumCells, numCells);
+  for(vtkIdType i=0;i<numCells;i++)
+    {
+    typesPtr[i] = static_cast<unsigned char>(cellType);
+    locationsPtr[i] = location;
+    *connPtr++ = numPointsPerCell;
+    const int* cellIds = connectivity + i*cellStride;
+    for(int j=0;j<numPointsPerCell;j++)
+      {
+      vtkIdType id = cellIds[j*pointStride] + idOffset;
+      if(id < 0 || id >= numPoints)
+        {
+        cout << id << " is not a valid node id\n";
+        }
+      *connPtr++ = id;
+      }
+    location += numPointsPerCell+1;
+    }
+  // SetCells() also updates the insert location of the cell array
+  cells->SetCells(oldNumCells+numCells, ia);
+
+  grid->SetCells(types, locations, cells);
+  cells->Delete();
+  types->Delete();
+  locations->Delete();
+}
+
 void coprocessorinitialize_(char* pythonFileName, int* pythonFileNameLength )
 {
   if(!coProcessor)
@@ -187,6 +286,50 @@ void needtocreategrid_(int* needGrid)
     }
 }
 
+void gridtopologychanged_()
+{
+  if(coProcessorData)
+    {
+    coProcessorData->GetInputDescriptionByName("input")->SetGrid(0);
+    }
+}
+
+void addpointfield_(char* name, int* nameLength, double* data,
+                    int* numTuples, int* numComponents, int* componentStride)
+{
+  if(!coProcessorData)
+    {
+    vtkGenericWarningMacro("Unable to access CoProcessorData.");
+    return;
+    }
+  vtkCPInputDataDescription* idd =
+    coProcessorData->GetInputDescriptionByName("input");
+  vtkStdString fieldName(name, *nameLength);
+  if(!idd->IsFieldNeeded(fieldName.c_str()))
+    {
+    return;
+    }
+  vtkDataSet* grid = vtkDataSet::SafeDownCast(idd->GetGrid());
+  if(!grid)
+    {
+    vtkMultiBlockDataSet* multiBlock =
+      vtkMultiBlockDataSet::SafeDownCast(idd->GetGrid());
+    if(multiBlock && multiBlock->GetNumberOfBlocks() > 0)
+      {
+      grid = vtkDataSet::SafeDownCast(multiBlock->GetBlock(0));
+      }
+    }
+  if(!grid)
+    {
+    cout << "CoProcessing: No grid to attach " << fieldName << " to.\n";
+    return;
+    }
+  vtkDataArray* array = CreateFieldArray(
+    fieldName.c_str(), data, *numTuples, *numComponents, *componentStride);
+  grid->GetPointData()->AddArray(array);
+  array->Delete();
+}
+
 void coprocess_()
 {
   if(!isTimeDataSet)
@@ -15,8 +15,13 @@
 #ifndef FortranAdaptorAPI_h
 #define FortranAdaptorAPI_h
 
+#include "vtkType.h"
+
 class vtkCPDataDescription;
+class vtkDataArray;
 class vtkDataSet;
+class vtkPointSet;
+class vtkUnstructuredGrid;
 
 // function to return the singleton/static vtkCPDataDescription object
 // that contains the grid and fields stuff
@@ -25,6 +30,35 @@ void ClearFieldDataFromGrid(vtkDataSet* grid);
 bool ConvertFortranStringToCString(char* fortranString, int fortranStringLength,
                                    char* cString, int cStringMaxLength);
 
+// Simulation arrays are described by the number of tuples, the number of
+// components and the componentStride, which is the distance (in values)
+// between two components of the same tuple.  componentStride == 1 is an
+// interleaved (array of structures) layout, componentStride == numTuples
+// is the usual fortran layout where each component is stored contiguously
+// (e.g. dofArray+nshg*k).  VTK arrays are interleaved, so only scalars and
+// interleaved arrays can use the simulation memory directly; those are
+// wrapped in place and must stay valid until coprocess_() returns.  Any
+// other layout, including the usual fortran one, is copied.
+
+// create a double array for a simulation field.  Scalars and interleaved
+// arrays are wrapped, other layouts are copied.  The caller owns the
+// returned array.
+vtkDataArray* CreateFieldArray(const char* name, double* data,
+                               vtkIdType numTuples, int numComponents,
+                               vtkIdType componentStride);
+// set the points of grid from simulation coordinates
+void SetGridPoints(vtkPointSet* grid, vtkIdType numPoints, double* coords,
+                   vtkIdType componentStride);
+// append a block of cells of a single type to grid.  Point j of cell i is
+// connectivity[i*cellStride+j*pointStride]+idOffset so both row and column
+// major connectivity, 0 or 1 based, can be passed directly.  This writes
+// the cell arrays in bulk instead of going through InsertNextCell().  The
+// points of grid must be set first: point ids outside of them are reported.
+void InsertBlockOfCells(vtkUnstructuredGrid* grid, int cellType,
+                        vtkIdType numCells, int numPointsPerCell,
+                        int* connectivity, vtkIdType cellStride,
+                        vtkIdType pointStride, int idOffset);
+
 // for now assume that the coprocessor is run through a python script
 extern "C" void coprocessorinitialize_(char* pythonFileName, int* pythonFileNameLength);
 extern "C" void coprocessorfinalize_();
@@ -36,6 +70,16 @@ extern "C" void requestdatadescription_(int* timeStep, double* time,
 // it sets needgrid to 0 if it does have a copy of the grid but does not
 // check if the grid is modified or needs to be updated
 extern "C" void needtocreategrid_(int* needGrid);
+// the grid is kept between time steps until this is called.  It should be
+// called whenever the topology of the simulation mesh changes so that the
+// next call to needtocreategrid_() asks for a new grid.
+extern "C" void gridtopologychanged_();
+// add a point field to the grid (or to the first block of a multiblock
+// grid) if the coprocessing pipelines need it this time step.  See above
+// for the meaning of componentStride.
+extern "C" void addpointfield_(char* name, int* nameLength, double* data,
+                               int* numTuples, int* numComponents,
+                               int* componentStride);
 // do the actual coprocessing.  it is assumed that the vtkCPDataDescription
 // has been filled in elsewhere.
 extern "C" void coprocess_();
@@ -55,16 +55,19 @@ extern "C" void add_scalar_(char *fname, int *len, double *data, int *size)
 
 extern "C" void add_vector_(char *fname, int *len, double *data0, double *data1, double *data2, int *size)
 {
-  vtkDoubleArray *arr = vtkDoubleArray::New ();
   vtkStdString name (fname, *len);
+  // each component is a separate fortran array, so they are interleaved
+  // into a new array
+  vtkDoubleArray *arr = vtkDoubleArray::New ();
   arr->SetName (name);
   arr->SetNumberOfComponents (3);
   arr->SetNumberOfTuples (*size);
-  for (int i = 0; i < *size; i ++) 
+  double *values = arr->GetPointer (0);
+  for (int i = 0; i < *size; i ++)
     {
-    arr->SetComponent (i, 0, data0[i]);
-    arr->SetComponent (i, 1, data1[i]);
-    arr->SetComponent (i, 2, data2[i]);
+    values[3*i] = data0[i];
+    values[3*i+1] = data1[i];
+    values[3*i+2] = data2[i];
     }
   vtkMultiBlockDataSet *grid = 
           vtkMultiBlockDataSet::SafeDownCast (
@@ -112,8 +115,9 @@ extern "C" void add_pressure_ (int *index, double *data, int *size)
     arr->Delete ();
     }
 
-  for (int i = 0; i < *size; i ++) 
+  double *values = arr->GetPointer (0) + real_index;
+  for (int i = 0; i < *size; i ++)
     {
-    arr->SetComponent (i, real_index, data[i]);
+    values[6*i] = data[i];
     }
 }
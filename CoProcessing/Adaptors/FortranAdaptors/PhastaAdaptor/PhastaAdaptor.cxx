@@ -19,8 +19,10 @@
 #include "vtkCPDataDescription.h"
 #include "vtkCPInputDataDescription.h"
 #include "vtkCPProcessor.h"
+#include "vtkCellArray.h"
 #include "vtkDoubleArray.h"
 #include "vtkFieldData.h"
+#include "vtkIdTypeArray.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
 #include "vtkUnstructuredGrid.h"
@@ -35,20 +37,8 @@ extern "C" void createpointsandallocatecells_(
     }
 
   vtkUnstructuredGrid* Grid = vtkUnstructuredGrid::New();
-  vtkPoints* nodePoints = vtkPoints::New();
-  vtkDoubleArray* coords = vtkDoubleArray::New();
-  coords->SetNumberOfComponents(3);
-  coords->SetNumberOfTuples(*numPoints);
-  for(int i=0;i<*numPoints;i++) 
-    {
-    double tuple[3] = {coordsArray[i], coordsArray[i+*numPoints], 
-                       coordsArray[i+*numPoints*2]};
-    coords->SetTupleValue(i, tuple);
-    }
-  nodePoints->SetData(coords);
-  coords->Delete();
-  Grid->SetPoints(nodePoints);
-  nodePoints->Delete();
+  // phasta stores the x, y and z coordinates one after the other
+  SetGridPoints(Grid, *numPoints, coordsArray, *numPoints);
   Grid->Allocate(*numCells);
   GetCoProcessorData()->GetInputDescriptionByName("input")->SetGrid(Grid);
   Grid->Delete();
@@ -62,6 +52,7 @@ extern "C" void insertblockofcells_(
   if(!grid)
     {
     cout << "CoProcessing: Could not access grid for cell insertion.\n";
+    return;
     }
   int type = -1;
   switch(*numPointsPerCell)
@@ -93,26 +84,21 @@ extern "C" void insertblockofcells_(
     return;
     }
     }
-  vtkIdType pts[8]; //assume for now we only have linear elements
-  vtkIdType numPoints = grid->GetNumberOfPoints();
-  for(int iCell=0;iCell<*numCellsInBlock;iCell++)
-    {
-    for(int i=0;i<*numPointsPerCell;i++)
+  // phasta's connectivity is column major and 1 based
+  InsertBlockOfCells(grid, type, *numCellsInBlock, *numPointsPerCell,
+                     cellConnectivity, 1, *numCellsInBlock, -1);
+  if(type == VTK_TETRA)
+    { // change the canonical ordering of the tet to match VTK style.
+    // pts[0] is the number of points of each cell.
+    vtkIdTypeArray* ia = grid->GetCells()->GetData();
+    vtkIdType* pts = ia->GetPointer(
+      ia->GetNumberOfTuples() - *numCellsInBlock*(*numPointsPerCell+1));
+    for(int iCell=0;iCell<*numCellsInBlock;iCell++, pts += *numPointsPerCell+1)
       {
-      pts[i] = cellConnectivity[iCell+i*(*numCellsInBlock)]-1;//-1 to get from f to c++
-      
-      if(pts[i] < 0 || pts[i] >= numPoints)
-        {
-        cout << pts[i] << " is not a valid node id\n";
-        }
+      vtkIdType temp = pts[1];
+      pts[1] = pts[2];
+      pts[2] = temp;
       }
-    if(type == VTK_TETRA)
-      { // change the canonical ordering of the tet to match VTK style
-      vtkIdType temp = pts[0];
-      pts[0] = pts[1];
-      pts[1] = temp;
-      }
-    grid->InsertNextCell(type, *numPointsPerCell, pts);
     }
 }
 
@@ -133,16 +119,9 @@ extern "C" void addfields_(
   //velocity
   if(idd->IsFieldNeeded("velocity"))
     {
-    vtkDoubleArray* velocity = vtkDoubleArray::New();
-    velocity->SetName("velocity");
-    velocity->SetNumberOfComponents(3);
-    velocity->SetNumberOfTuples(NumberOfNodes);
-    for (vtkIdType idx=0; idx<NumberOfNodes; idx++)
-      {
-      velocity->SetTuple3(idx, dofArray[idx],
-                          dofArray[idx+ *nshg],
-                          dofArray[idx+ *nshg*2]);
-      }
+    // the components are stored one after the other so this is copied
+    vtkDataArray* velocity = CreateFieldArray(
+      "velocity", dofArray, NumberOfNodes, 3, *nshg);
     UnstructuredGrid->GetPointData()->AddArray(velocity);
     velocity->Delete();
     }
@@ -150,9 +129,8 @@ extern "C" void addfields_(
   //pressure
   if(idd->IsFieldNeeded("pressure"))
     {
-    vtkDoubleArray* pressure = vtkDoubleArray::New();
-    pressure->SetName("pressure");
-    pressure->SetArray(dofArray+*nshg*3, NumberOfNodes, 1);
+    vtkDataArray* pressure = CreateFieldArray(
+      "pressure", dofArray+*nshg*3, NumberOfNodes, 1, *nshg);
     UnstructuredGrid->GetPointData()->AddArray(pressure);
     pressure->Delete();
     }
@@ -161,9 +139,8 @@ extern "C" void addfields_(
   // temperature only varies from compressible flow
   if(idd->IsFieldNeeded("temperature") && *compressibleFlow == 1)
     {
-    vtkDoubleArray* temperature = vtkDoubleArray::New();
-    temperature->SetName("temperature");
-    temperature->SetArray(dofArray+*nshg*4, NumberOfNodes, 1);
+    vtkDataArray* temperature = CreateFieldArray(
+      "temperature", dofArray+*nshg*4, NumberOfNodes, 1, *nshg);
     UnstructuredGrid->GetPointData()->AddArray(temperature);
     temperature->Delete();
     }
@@ -0,0 +1,144 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    AsynchronousPythonScriptCoProcessing.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Runs a python script pipeline with AsynchronousCoProcessing on. The
+// script's DoCoProcessing() sleeps before it looks at the grid, so the
+// simulation step that follows CoProcess() overlaps it: the simulation
+// overwrites its field while the pipeline is still busy, and the next
+// time step is skipped. The script must still see the original values.
+
+#include "CPSystemInformation.h"
+#include "vtkCPDataDescription.h"
+#include "vtkCPInputDataDescription.h"
+#include "vtkCPProcessor.h"
+#include "vtkCPPythonScriptPipeline.h"
+#include "vtkDoubleArray.h"
+#include "vtkImageData.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+
+#ifdef COPROCESSOR_USE_MPI
+#define MPICH_SKIP_MPICXX
+#include "mpi.h"
+#endif
+#include <iostream>
+#include <vtksys/ios/fstream>
+
+int main(int argc, char* argv[])
+{
+  if(argc < 2)
+    {
+    cerr << "Wrong number of arguments.  Command is: <exe> <python script>\n";
+    return 1;
+    }
+  // The helper thread is only used when MPI supports calls from it.
+  bool threaded = true;
+#ifdef COPROCESSOR_USE_MPI
+  int provided = MPI_THREAD_SINGLE;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+  threaded = (provided == MPI_THREAD_MULTIPLE);
+#endif
+  int errors = 0;
+  vtkCPProcessor* processor = vtkCPProcessor::New();
+  vtkCPPythonScriptPipeline* pipeline = vtkCPPythonScriptPipeline::New();
+  if(!pipeline->Initialize(argv[1]))
+    {
+    errors++;
+    }
+  processor->AddPipeline(pipeline);
+  pipeline->Delete();
+  processor->Initialize();
+  processor->AsynchronousCoProcessingOn();
+
+  vtkSmartPointer<vtkImageData> grid = vtkSmartPointer<vtkImageData>::New();
+  grid->SetDimensions(20, 20, 20);
+  vtkSmartPointer<vtkDoubleArray> pressure =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  pressure->SetName("Pressure");
+  pressure->SetNumberOfTuples(grid->GetNumberOfPoints());
+  for(vtkIdType i=0;i<grid->GetNumberOfPoints();i++)
+    {
+    pressure->SetValue(i, 1. + i);
+    }
+  grid->GetPointData()->AddArray(pressure);
+  double expected[2];
+  pressure->GetRange(expected);
+
+  vtkSmartPointer<vtkCPDataDescription> dataDescription =
+    vtkSmartPointer<vtkCPDataDescription>::New();
+  dataDescription->SetTimeData(0, 0);
+  dataDescription->AddInput("input");
+  if(!processor->RequestDataDescription(dataDescription))
+    {
+    cerr << "Time step 0 was not requested.\n";
+    errors++;
+    }
+  dataDescription->GetInputDescriptionByName("input")->SetGrid(grid);
+  processor->CoProcess(dataDescription);
+
+  // The next simulation step, while the python pipeline is still busy.
+  if(threaded && !processor->IsCoProcessing())
+    {
+    cerr << "CoProcess() waited for the python pipeline.\n";
+    errors++;
+    }
+  for(vtkIdType i=0;i<grid->GetNumberOfPoints();i++)
+    {
+    pressure->SetValue(i, -1.);
+    }
+  vtkSmartPointer<vtkCPDataDescription> nextDataDescription =
+    vtkSmartPointer<vtkCPDataDescription>::New();
+  nextDataDescription->SetTimeData(0.1, 1);
+  nextDataDescription->AddInput("input");
+  if(threaded)
+    {
+    if(processor->RequestDataDescription(nextDataDescription))
+      {
+      cerr << "Time step 1 was requested while time step 0 was processed.\n";
+      errors++;
+      }
+    if(!processor->IsCoProcessing())
+      {
+      cerr << "The simulation step did not overlap the python pipeline.\n";
+      errors++;
+      }
+    }
+
+  processor->WaitForCoProcessing();
+  vtksys_ios::ifstream result("CPAsynchronous0.txt");
+  double range[2] = {0, 0};
+  if(!(result >> range[0] >> range[1]))
+    {
+    cerr << "The python pipeline did not write its output.\n";
+    errors++;
+    }
+  else if(range[0] != expected[0] || range[1] != expected[1])
+    {
+    cerr << "The python pipeline saw the range " << range[0] << " "
+         << range[1] << " instead of " << expected[0] << " "
+         << expected[1] << ".\n";
+    errors++;
+    }
+
+  processor->Finalize();
+  processor->Delete();
+
+#ifdef COPROCESSOR_USE_MPI
+  MPI_Finalize();
+#endif
+
+  cout << "Finished run with " << errors << " errors.\n";
+
+  return errors;
+}
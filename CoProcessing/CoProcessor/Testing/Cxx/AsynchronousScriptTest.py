@@ -0,0 +1,20 @@
+import time
+
+def RequestDataDescription(datadescription):
+  datadescription.GetInputDescriptionByName("input").AllFieldsOn()
+  datadescription.GetInputDescriptionByName("input").GenerateMeshOn()
+  return
+
+def DoCoProcessing(datadescription):
+  # take long enough for the simulation to move on and overwrite its
+  # own copy of the data in the meantime
+  time.sleep(2)
+
+  grid = datadescription.GetInputDescriptionByName("input").GetGrid()
+  pressurerange = grid.GetPointData().GetArray("Pressure").GetRange()
+
+  filename = 'CPAsynchronous' + str(datadescription.GetTimeStep()) + '.txt'
+  f = open(filename, 'w')
+  f.write(repr(pressurerange[0]) + ' ' + repr(pressurerange[1]) + '\n')
+  f.close()
+  return
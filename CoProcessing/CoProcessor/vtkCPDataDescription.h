@@ -56,6 +56,10 @@ public:
   /// Provides access to a grid description using the index.
   vtkCPInputDataDescription *GetInputDescription(unsigned int);
 
+  /// Returns the name of the grid of the given index or NULL if
+  /// the index is out of range.
+  const char* GetInputDescriptionName(unsigned int);
+
   /// Provides access to a grid description using the grid name.
   vtkCPInputDataDescription *GetInputDescriptionByName(const char*);
 
@@ -14,35 +14,113 @@
 =========================================================================*/
 #include "vtkCPProcessor.h"
 
+#include "CPSystemInformation.h"
+#include "vtkConditionVariable.h"
 #include "vtkCPDataDescription.h"
+#include "vtkCPInputDataDescription.h"
 #include "vtkCPPipeline.h"
 #include "vtkCPPythonScriptPipeline.h"
 #include "vtkDataObject.h"
 #include "vtkFieldData.h"
+#include "vtkMutexLock.h"
 #include "vtkObjectFactory.h"
 #include "vtkSmartPointer.h"
 #include "vtkSMProxyManager.h"
 
+#include <vtkstd/deque>
 #include <vtkstd/set>
 
+#ifdef COPROCESSOR_USE_MPI
+# include <mpi.h>
+#endif
+
 struct vtkCPProcessorInternals
 {
   typedef vtkstd::set<vtkSmartPointer<vtkCPPipeline> > PipelineSet;
   typedef PipelineSet::iterator PipelineSetIterator;
   PipelineSet Pipelines;
+
+  /// A time step waiting to be processed by the helper thread.
+  struct StagedTimeStep
+  {
+    vtkSmartPointer<vtkCPDataDescription> DataDescription;
+    unsigned long Size;
+  };
+
+  vtkCPProcessorInternals()
+    {
+    this->Threader = 0;
+    this->ThreadId = -1;
+    this->StagedMemory = 0;
+    this->Busy = false;
+    this->Exit = false;
+    this->ThreadSupportChecked = false;
+    this->ThreadSupport = false;
+    this->InterpretorReleased = false;
+    }
+
+  vtkstd::deque<StagedTimeStep> Queue;
+  vtkSmartPointer<vtkMultiThreader> Threader;
+  int ThreadId;
+  /// Protects Queue, StagedMemory, Busy and Exit.
+  vtkSmartPointer<vtkMutexLock> QueueLock;
+  vtkSmartPointer<vtkConditionVariable> QueueCondition;
+  unsigned long StagedMemory;
+  /// True from the time a time step is queued until the helper thread
+  /// has run all the pipelines on it.
+  bool Busy;
+  bool Exit;
+  /// Whether the helper thread may be used at all, see
+  /// vtkCPProcessor::CanUseCoProcessingThread().
+  bool ThreadSupportChecked;
+  bool ThreadSupport;
+  /// Whether the simulation thread has released the python interpretor
+  /// to the helper thread, see vtkCPPythonScriptPipeline::ReleaseInterpretor().
+  bool InterpretorReleased;
 };
 
+namespace
+{
+  // Copy the time and the grids of source so that the simulation may
+  // change its data while the copy is being processed. Returns the
+  // size of the copied grids in kibibytes.
+  unsigned long vtkCPStageDataDescription(vtkCPDataDescription* source,
+                                          vtkCPDataDescription* copy)
+  {
+    unsigned long size = 0;
+    copy->SetTimeData(source->GetTime(), source->GetTimeStep());
+    for(unsigned int i=0;i<source->GetNumberOfInputDescriptions();i++)
+      {
+      const char* name = source->GetInputDescriptionName(i);
+      copy->AddInput(name);
+      vtkDataObject* grid = source->GetInputDescription(i)->GetGrid();
+      if(grid)
+        {
+        vtkDataObject* gridCopy = grid->NewInstance();
+        gridCopy->DeepCopy(grid);
+        size += gridCopy->GetActualMemorySize();
+        copy->GetInputDescriptionByName(name)->SetGrid(gridCopy);
+        gridCopy->Delete();
+        }
+      }
+    return size;
+  }
+}
+
 vtkStandardNewMacro(vtkCPProcessor);
 
 //----------------------------------------------------------------------------
 vtkCPProcessor::vtkCPProcessor()
 {
   this->Internal = new vtkCPProcessorInternals;
+  this->AsynchronousCoProcessing = 0;
+  this->StagingMemoryLimit = 1048576;
 }
 
 //----------------------------------------------------------------------------
 vtkCPProcessor::~vtkCPProcessor()
 {
+  this->StopCoProcessingThread();
   delete this->Internal;
 }
 
@@ -73,6 +151,19 @@ int vtkCPProcessor::RequestDataDescription(
     vtkWarningMacro("DataDescription is NULL.");
     return 0;
     }
+  if(this->AsynchronousCoProcessing && this->Internal->Threader)
+    {
+    if(this->IsCoProcessing())
+      {
+      // The pipelines are not thread safe and the helper thread is still
+      // running them on an earlier time step, so this one is skipped
+      // rather than making the simulation wait.
+      vtkDebugMacro("Skipping time step " << DataDescription->GetTimeStep()
+                    << ", the previous one is still being processed.");
+      return 0;
+      }
+    this->AcquireInterpretor();
+    }
   int DoCoProcessing = 0;
   DataDescription->Reset();
   for(vtkCPProcessorInternals::PipelineSetIterator iter = 
@@ -95,6 +186,46 @@ int vtkCPProcessor::CoProcess(vtkCPDataDescription* DataDescription)
     vtkWarningMacro("DataDescription is NULL.");
     return 0;
     }
+  if(!this->AsynchronousCoProcessing || !this->CanUseCoProcessingThread())
+    {
+    this->StopCoProcessingThread();
+    return this->ExecutePipelines(DataDescription);
+    }
+
+  this->StartCoProcessingThread();
+  // Normally RequestDataDescription() has already checked that the helper
+  // thread is idle.
+  this->WaitForCoProcessing();
+  vtkCPProcessorInternals* internal = this->Internal;
+
+  vtkSmartPointer<vtkCPDataDescription> staged =
+    vtkSmartPointer<vtkCPDataDescription>::New();
+  unsigned long size = vtkCPStageDataDescription(DataDescription, staged);
+  if(size > this->StagingMemoryLimit)
+    {
+    vtkWarningMacro("Time step " << DataDescription->GetTimeStep()
+                    << " needs " << size << " KiB of staging memory, more than"
+                    << " StagingMemoryLimit. Processing it synchronously.");
+    return this->ExecutePipelines(DataDescription);
+    }
+
+  // Hand the time step, and the python interpretor, to the helper thread.
+  this->ReleaseInterpretor();
+  internal->QueueLock->Lock();
+  vtkCPProcessorInternals::StagedTimeStep timeStep;
+  timeStep.DataDescription = staged;
+  timeStep.Size = size;
+  internal->Queue.push_back(timeStep);
+  internal->StagedMemory += size;
+  internal->Busy = true;
+  internal->QueueCondition->Broadcast();
+  internal->QueueLock->Unlock();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkCPProcessor::ExecutePipelines(vtkCPDataDescription* DataDescription)
+{
   int Success = 1;
   DataDescription->Reset();
   for(vtkCPProcessorInternals::PipelineSetIterator iter = 
@@ -109,9 +240,177 @@ int vtkCPProcessor::CoProcess(vtkCPDataDescription* DataDescription)
   return Success;
 }
 
+//----------------------------------------------------------------------------
+bool vtkCPProcessor::CanUseCoProcessingThread()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(internal->ThreadSupportChecked)
+    {
+    return internal->ThreadSupport;
+    }
+  internal->ThreadSupportChecked = true;
+  internal->ThreadSupport = true;
+#ifdef COPROCESSOR_USE_MPI
+  int initialized = 0;
+  MPI_Initialized(&initialized);
+  if(initialized)
+    {
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    if(provided != MPI_THREAD_MULTIPLE)
+      {
+      vtkWarningMacro("MPI was not initialized with MPI_THREAD_MULTIPLE. "
+                      "Coprocessing synchronously.");
+      internal->ThreadSupport = false;
+      }
+    }
+#endif
+  return internal->ThreadSupport;
+}
+
+//----------------------------------------------------------------------------
+void vtkCPProcessor::WaitForCoProcessing()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(!internal->Threader)
+    {
+    return;
+    }
+  internal->QueueLock->Lock();
+  while(internal->Busy)
+    {
+    internal->QueueCondition->Wait(internal->QueueLock);
+    }
+  internal->QueueLock->Unlock();
+  this->AcquireInterpretor();
+}
+
+//----------------------------------------------------------------------------
+bool vtkCPProcessor::IsCoProcessing()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(!internal->Threader)
+    {
+    return false;
+    }
+  internal->QueueLock->Lock();
+  bool busy = internal->Busy;
+  internal->QueueLock->Unlock();
+  return busy;
+}
+
+//----------------------------------------------------------------------------
+void vtkCPProcessor::ReleaseInterpretor()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(internal->InterpretorReleased)
+    {
+    return;
+    }
+  for(vtkCPProcessorInternals::PipelineSetIterator iter =
+        internal->Pipelines.begin();
+      iter!=internal->Pipelines.end();iter++)
+    {
+    if(vtkCPPythonScriptPipeline::SafeDownCast(iter->GetPointer()))
+      {
+      vtkCPPythonScriptPipeline::ReleaseInterpretor();
+      internal->InterpretorReleased = true;
+      break;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkCPProcessor::AcquireInterpretor()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(internal->InterpretorReleased)
+    {
+    vtkCPPythonScriptPipeline::AcquireInterpretor();
+    internal->InterpretorReleased = false;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkCPProcessor::StartCoProcessingThread()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(internal->Threader)
+    {
+    return;
+    }
+  internal->QueueLock = vtkSmartPointer<vtkMutexLock>::New();
+  internal->QueueCondition = vtkSmartPointer<vtkConditionVariable>::New();
+  internal->Exit = false;
+  internal->Threader = vtkSmartPointer<vtkMultiThreader>::New();
+  internal->ThreadId = internal->Threader->SpawnThread(
+    &vtkCPProcessor::CoProcessingThread, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkCPProcessor::StopCoProcessingThread()
+{
+  vtkCPProcessorInternals* internal = this->Internal;
+  if(!internal->Threader)
+    {
+    return;
+    }
+  internal->QueueLock->Lock();
+  internal->Exit = true;
+  internal->QueueCondition->Broadcast();
+  internal->QueueLock->Unlock();
+  internal->Threader->TerminateThread(internal->ThreadId);
+  internal->Threader = 0;
+  internal->ThreadId = -1;
+  this->AcquireInterpretor();
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkCPProcessor::CoProcessingThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkCPProcessor* self = static_cast<vtkCPProcessor*>(info->UserData);
+  vtkCPProcessorInternals* internal = self->Internal;
+  for(;;)
+    {
+    internal->QueueLock->Lock();
+    while(internal->Queue.empty() && !internal->Exit)
+      {
+      internal->QueueCondition->Wait(internal->QueueLock);
+      }
+    if(internal->Queue.empty())
+      {
+      // Exit was requested and everything has been processed.
+      internal->QueueLock->Unlock();
+      break;
+      }
+    vtkCPProcessorInternals::StagedTimeStep timeStep = internal->Queue.front();
+    internal->Queue.pop_front();
+    internal->QueueLock->Unlock();
+
+    // Python pipelines take the global interpreter lock themselves.
+    if(!self->ExecutePipelines(timeStep.DataDescription))
+      {
+      vtkGenericWarningMacro("Asynchronous coprocessing of time step "
+                             << timeStep.DataDescription->GetTimeStep()
+                             << " failed.");
+      }
+    timeStep.DataDescription = 0;
+
+    internal->QueueLock->Lock();
+    internal->StagedMemory -= timeStep.Size;
+    internal->Busy = !internal->Queue.empty();
+    internal->QueueCondition->Broadcast();
+    internal->QueueLock->Unlock();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 int vtkCPProcessor::Finalize()
 {
+  this->StopCoProcessingThread();
   this->Internal->Pipelines.clear();
   return 1;
 }
@@ -120,4 +419,7 @@ int vtkCPProcessor::Finalize()
 void vtkCPProcessor::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "AsynchronousCoProcessing: "
+     << this->AsynchronousCoProcessing << "\n";
+  os << indent << "StagingMemoryLimit: " << this->StagingMemoryLimit << "\n";
 }
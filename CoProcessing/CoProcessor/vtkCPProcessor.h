@@ -16,6 +16,7 @@
 #define vtkCPProcessor_h
 
 #include "vtkObject.h"
+#include "vtkMultiThreader.h" // for VTK_THREAD_RETURN_TYPE
 #include "CPWin32Header.h" // For windows import/export of shared libraries
 
 struct vtkCPProcessorInternals;
@@ -88,10 +89,69 @@ public:
   /// implementation an opportunity to clean up, before it is destroyed.
   virtual int Finalize();
 
+  /// Set/get whether CoProcess() should return before the pipelines
+  /// have executed. When on, CoProcess() deep copies the grids of the
+  /// data description and a helper thread runs all the pipelines,
+  /// including python script pipelines and their writers, on the copy
+  /// while the simulation continues. Python pipelines hold the python
+  /// global interpreter lock on the helper thread; the simulation thread
+  /// gives up the interpretor while they run (see
+  /// vtkCPPythonScriptPipeline::ReleaseInterpretor()). The pipelines are
+  /// not thread safe, so while the helper thread is still busy with a
+  /// time step, RequestDataDescription() returns 0 without asking the
+  /// pipelines and that time step is skipped. Call WaitForCoProcessing()
+  /// before RequestDataDescription() to process every requested time
+  /// step instead. When MPI is initialized without MPI_THREAD_MULTIPLE,
+  /// all pipelines are run synchronously.
+  /// Off by default.
+  vtkSetMacro(AsynchronousCoProcessing, int);
+  vtkGetMacro(AsynchronousCoProcessing, int);
+  vtkBooleanMacro(AsynchronousCoProcessing, int);
+
+  /// Set/get the maximum amount of memory, in kibibytes, used by the
+  /// copy of the grids processed asynchronously. Time steps whose copy
+  /// would be larger are processed synchronously.
+  /// The default is 1048576 (1 GiB).
+  vtkSetMacro(StagingMemoryLimit, unsigned long);
+  vtkGetMacro(StagingMemoryLimit, unsigned long);
+
+  /// Wait until all time steps handed to the helper thread have been
+  /// processed. Does nothing when AsynchronousCoProcessing is off.
+  void WaitForCoProcessing();
+
+  /// Returns true while the helper thread is processing a time step.
+  bool IsCoProcessing();
+
 protected:
   vtkCPProcessor();
   virtual ~vtkCPProcessor();
 
+  /// Run the pipelines on DataDescription. Returns 1 if all of them
+  /// succeeded and 0 otherwise.
+  int ExecutePipelines(vtkCPDataDescription* DataDescription);
+
+  /// Returns false when the helper thread may not be used because MPI
+  /// does not support calls from multiple threads.
+  bool CanUseCoProcessingThread();
+
+  /// Start/stop the helper thread used when AsynchronousCoProcessing is
+  /// on. StopCoProcessingThread() processes pending time steps first.
+  void StartCoProcessingThread();
+  void StopCoProcessingThread();
+
+  /// Give the python interpretor to the helper thread before it runs
+  /// python script pipelines and take it back on the simulation thread
+  /// before the pipelines are used there again.
+  void ReleaseInterpretor();
+  void AcquireInterpretor();
+
+  //BTX
+  static VTK_THREAD_RETURN_TYPE CoProcessingThread(void* arg);
+  //ETX
+
+  int AsynchronousCoProcessing;
+  unsigned long StagingMemoryLimit;
+
 private:
   vtkCPProcessor(const vtkCPProcessor&); // Not implemented
   void operator=(const vtkCPProcessor&); // Not implemented
@@ -12,6 +12,7 @@
      PURPOSE.  See the above copyright notice for more information.
 
 =========================================================================*/
+#include "vtkPython.h" // include Python.h before other headers
 #include "vtkCPPythonScriptPipeline.h"
 
 #include "CPSystemInformation.h"
@@ -35,6 +36,93 @@ using vtksys_ios::ostringstream;
 
 vtkCPPythonHelper* vtkCPPythonScriptPipeline::PythonHelper = 0;
 
+namespace
+{
+  // The sub-interpretor the scripts run in, recorded by vtkInternals::Enter().
+  PyInterpreterState* vtkCPPythonInterpretorState = 0;
+  // The thread state saved by ReleaseInterpretor(), 0 while the thread that
+  // initialized python holds the global interpreter lock.
+  PyThreadState* vtkCPPythonSavedThreadState = 0;
+}
+
+//----------------------------------------------------------------------------
+class vtkCPPythonScriptPipeline::vtkInternals
+{
+public:
+  enum
+    {
+    REQUEST_DATA_DESCRIPTION = 0,
+    DO_COPROCESSING,
+    NUMBER_OF_FUNCTIONS
+    };
+
+  vtkInternals()
+    {
+    this->ThreadState = 0;
+    this->DataDescriptionClass = 0;
+    for(int i=0;i<NUMBER_OF_FUNCTIONS;i++)
+      {
+      this->Functions[i] = 0;
+      }
+    }
+
+  /// Must be called with the interpretor made current.
+  void Release()
+    {
+    Py_XDECREF(this->DataDescriptionClass);
+    this->DataDescriptionClass = 0;
+    for(int i=0;i<NUMBER_OF_FUNCTIONS;i++)
+      {
+      Py_XDECREF(this->Functions[i]);
+      this->Functions[i] = 0;
+      }
+    }
+
+  bool IsValid()
+    {
+    return this->DataDescriptionClass &&
+      this->Functions[REQUEST_DATA_DESCRIPTION] &&
+      this->Functions[DO_COPROCESSING];
+    }
+
+  /// Make the interpretor current on the calling thread. While the
+  /// interpretor is released (see ReleaseInterpretor()) this takes the
+  /// global interpreter lock with a new thread state of the calling
+  /// thread instead of borrowing the one of the initializing thread.
+  void Enter(vtkPVPythonInterpretor* interp)
+    {
+    if(vtkCPPythonSavedThreadState && vtkCPPythonInterpretorState)
+      {
+      this->ThreadState = PyThreadState_New(vtkCPPythonInterpretorState);
+      PyEval_AcquireThread(this->ThreadState);
+      }
+    else
+      {
+      interp->MakeCurrent();
+      vtkCPPythonInterpretorState = PyThreadState_Get()->interp;
+      }
+    }
+
+  void Leave(vtkPVPythonInterpretor* interp)
+    {
+    if(this->ThreadState)
+      {
+      PyThreadState_Clear(this->ThreadState);
+      // Also releases the global interpreter lock.
+      PyThreadState_DeleteCurrent();
+      this->ThreadState = 0;
+      }
+    else
+      {
+      interp->ReleaseControl();
+      }
+    }
+
+  PyThreadState* ThreadState;
+  PyObject* DataDescriptionClass;
+  PyObject* Functions[NUMBER_OF_FUNCTIONS];
+};
+
 vtkStandardNewMacro(vtkCPPythonScriptPipeline);
 
 //----------------------------------------------------------------------------
@@ -51,11 +139,15 @@ vtkCPPythonScriptPipeline::vtkCPPythonScriptPipeline()
     this->PythonHelper->Register(this);
     }
   this->PythonScriptName = 0;
+  this->OutputFrequency = 0;
+  this->Internals = new vtkInternals;
 }
 
 //----------------------------------------------------------------------------
 vtkCPPythonScriptPipeline::~vtkCPPythonScriptPipeline()
 {
+  this->Finalize();
+  delete this->Internals;
   this->PythonHelper->UnRegister(this);
   this->SetPythonScriptName(0);
 }
@@ -86,9 +178,96 @@ int vtkCPPythonScriptPipeline::Initialize(const char* fileName)
   this->PythonHelper->GetPythonInterpretor()->RunSimpleString(
     loadPythonModules.str().c_str());
   this->PythonHelper->GetPythonInterpretor()->FlushMessages();
+
+  if(!this->CacheCallables())
+    {
+    vtkWarningMacro("Could not look up the functions of " << fileNameName
+                    << ". Falling back to running python source every time step.");
+    }
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkCPPythonScriptPipeline::Finalize()
+{
+  if(this->Internals && this->Internals->IsValid())
+    {
+    vtkPVPythonInterpretor* interp =
+      this->PythonHelper->GetPythonInterpretor();
+    this->Internals->Enter(interp);
+    this->Internals->Release();
+    this->Internals->Leave(interp);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkCPPythonScriptPipeline::CacheCallables()
+{
+  vtkPVPythonInterpretor* interp = this->PythonHelper->GetPythonInterpretor();
+  this->Internals->Enter(interp);
+  this->Internals->Release();
+
+#ifndef COPROCESSOR_WIN32_BUILD
+  const char* wrapperModuleName = "libvtkCoProcessorPython";
+#else
+  const char* wrapperModuleName = "vtkCoProcessorPython";
+#endif
+  PyObject* wrapperModule = PyImport_ImportModule(
+    const_cast<char*>(wrapperModuleName));
+  PyObject* scriptModule = PyImport_ImportModule(this->PythonScriptName);
+  if(wrapperModule && scriptModule)
+    {
+    this->Internals->DataDescriptionClass = PyObject_GetAttrString(
+      wrapperModule, const_cast<char*>("vtkCPDataDescription"));
+    this->Internals->Functions[vtkInternals::REQUEST_DATA_DESCRIPTION] =
+      PyObject_GetAttrString(scriptModule,
+                             const_cast<char*>("RequestDataDescription"));
+    this->Internals->Functions[vtkInternals::DO_COPROCESSING] =
+      PyObject_GetAttrString(scriptModule,
+                             const_cast<char*>("DoCoProcessing"));
+    }
+  Py_XDECREF(wrapperModule);
+  Py_XDECREF(scriptModule);
+  PyErr_Clear();
+
+  int valid = this->Internals->IsValid() ? 1 : 0;
+  if(!valid)
+    {
+    this->Internals->Release();
+    }
+  this->Internals->Leave(interp);
+  return valid;
+}
+
+//----------------------------------------------------------------------------
+int vtkCPPythonScriptPipeline::CallCachedFunction(
+  int functionIndex, vtkCPDataDescription* dataDescription)
+{
+  vtkStdString dataDescriptionString = this->GetPythonAddress(dataDescription);
+  vtkPVPythonInterpretor* interp = this->PythonHelper->GetPythonInterpretor();
+  this->Internals->Enter(interp);
+  // The wrapper references the existing C++ object, nothing is copied.
+  PyObject* pyDataDescription = PyObject_CallFunction(
+    this->Internals->DataDescriptionClass, const_cast<char*>("s"),
+    dataDescriptionString.c_str());
+  PyObject* result = 0;
+  if(pyDataDescription)
+    {
+    result = PyObject_CallFunctionObjArgs(
+      this->Internals->Functions[functionIndex], pyDataDescription, NULL);
+    }
+  if(!result)
+    {
+    PyErr_Print();
+    }
+  Py_XDECREF(result);
+  Py_XDECREF(pyDataDescription);
+  this->Internals->Leave(interp);
+  interp->FlushMessages();
+  return result ? 1 : 0;
+}
+
 //----------------------------------------------------------------------------
 int vtkCPPythonScriptPipeline::RequestDataDescription(
   vtkCPDataDescription* dataDescription)
@@ -98,6 +277,17 @@ int vtkCPPythonScriptPipeline::RequestDataDescription(
     vtkWarningMacro("dataDescription is NULL.");
     return 0;
     }
+  if(this->OutputFrequency > 0 &&
+     dataDescription->GetTimeStep() % this->OutputFrequency != 0)
+    {
+    return 0;
+    }
+  if(this->Internals->IsValid())
+    {
+    this->CallCachedFunction(vtkInternals::REQUEST_DATA_DESCRIPTION,
+                             dataDescription);
+    return dataDescription->GetIfAnyGridNecessary()? 1: 0;
+    }
   // check the script to see if it should be run...
   vtkStdString dataDescriptionString = this->GetPythonAddress(dataDescription);
 
@@ -113,8 +303,7 @@ int vtkCPPythonScriptPipeline::RequestDataDescription(
               << this->PythonScriptName << ".RequestdataDescription(dataDescription)\n";
 #endif
 
-  this->PythonHelper->GetPythonInterpretor()->RunSimpleString(pythonInput.str().c_str());
-  this->PythonHelper->GetPythonInterpretor()->FlushMessages();
+  this->RunSimpleString(pythonInput.str().c_str());
   return dataDescription->GetIfAnyGridNecessary()? 1: 0;
 }
 
@@ -127,6 +316,11 @@ int vtkCPPythonScriptPipeline::CoProcess(
     vtkWarningMacro("DataDescription is NULL.");
     return 0;
     }
+  if(this->Internals->IsValid())
+    {
+    return this->CallCachedFunction(vtkInternals::DO_COPROCESSING,
+                                    dataDescription);
+    }
   vtkStdString dataDescriptionString = this->GetPythonAddress(dataDescription);
 
   ostringstream pythonInput;
@@ -140,12 +334,46 @@ int vtkCPPythonScriptPipeline::CoProcess(
     << dataDescriptionString << "')\n"
     << this->PythonScriptName << ".DoCoProcessing(dataDescription)\n";
 
-  this->PythonHelper->GetPythonInterpretor()->RunSimpleString(
-    pythonInput.str().c_str());
-  this->PythonHelper->GetPythonInterpretor()->FlushMessages();
+  this->RunSimpleString(pythonInput.str().c_str());
   return 1;  
 }
 
+//----------------------------------------------------------------------------
+void vtkCPPythonScriptPipeline::RunSimpleString(const char* script)
+{
+  vtkPVPythonInterpretor* interp = this->PythonHelper->GetPythonInterpretor();
+  this->Internals->Enter(interp);
+  // The cast is necessary because PyRun_SimpleString() hasn't always been const-correct
+  PyRun_SimpleString(const_cast<char*>(script));
+  this->Internals->Leave(interp);
+  interp->FlushMessages();
+}
+
+//----------------------------------------------------------------------------
+void vtkCPPythonScriptPipeline::ReleaseInterpretor()
+{
+  if(vtkCPPythonSavedThreadState || !Py_IsInitialized())
+    {
+    return;
+    }
+  if(!PyEval_ThreadsInitialized())
+    {
+    // Creates the global interpreter lock, held by this thread.
+    PyEval_InitThreads();
+    }
+  vtkCPPythonSavedThreadState = PyEval_SaveThread();
+}
+
+//----------------------------------------------------------------------------
+void vtkCPPythonScriptPipeline::AcquireInterpretor()
+{
+  if(vtkCPPythonSavedThreadState)
+    {
+    PyEval_RestoreThread(vtkCPPythonSavedThreadState);
+    vtkCPPythonSavedThreadState = 0;
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkStdString vtkCPPythonScriptPipeline::GetPythonAddress(void* pointer)
 {
@@ -172,6 +400,7 @@ void vtkCPPythonScriptPipeline::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
   os << indent << "PythonHelper: " << this->PythonHelper << "\n";
   os << indent << "PythonScriptName: " << this->PythonScriptName << "\n";
+  os << indent << "OutputFrequency: " << this->OutputFrequency << "\n";
 }
 
 
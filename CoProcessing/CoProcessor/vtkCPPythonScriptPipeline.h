@@ -52,6 +52,27 @@ public:
   /// Execute the pipeline. Returns 1 for success and 0 for failure.
   virtual int CoProcess(vtkCPDataDescription* dataDescription);
 
+  /// Set/get the output frequency in time steps. When positive,
+  /// RequestDataDescription() returns 0 without calling into python
+  /// on time steps that are not a multiple of it. The script's own
+  /// RequestDataDescription() still decides on the remaining time
+  /// steps. The default is 0 which always asks the script.
+  vtkSetClampMacro(OutputFrequency, int, 0, VTK_LARGE_INTEGER);
+  vtkGetMacro(OutputFrequency, int);
+
+  /// Release the python objects cached by Initialize(). Returns 1.
+  virtual int Finalize();
+
+  /// Let other threads execute python script pipelines. The thread that
+  /// initialized python (the simulation thread) calls ReleaseInterpretor()
+  /// before another thread runs the pipelines and AcquireInterpretor()
+  /// before it uses python again. In between, RequestDataDescription()
+  /// and CoProcess() may be called from any thread, one call at a time:
+  /// each holds the python global interpreter lock with a thread state
+  /// of the calling thread. Both do nothing when called twice in a row.
+  static void ReleaseInterpretor();
+  static void AcquireInterpretor();
+
 protected:
   vtkCPPythonScriptPipeline();
   virtual ~vtkCPPythonScriptPipeline();
@@ -59,6 +80,23 @@ protected:
   /// Return the address of Pointer for the python script.
   vtkStdString GetPythonAddress(void* pointer);
 
+  /// Look up the script's RequestDataDescription and DoCoProcessing
+  /// functions and the vtkCPDataDescription wrapper class once so that
+  /// every time step can call them directly instead of compiling
+  /// python source. Returns 1 if all were found and 0 otherwise, in
+  /// which case the per time step scripts are used.
+  int CacheCallables();
+
+  /// Call the cached script function FunctionIndex (one of the
+  /// vtkInternals enum values) with a python wrapper of
+  /// dataDescription. Returns 1 for success and 0 for failure.
+  int CallCachedFunction(int functionIndex,
+                         vtkCPDataDescription* dataDescription);
+
+  /// Run python source in the interpretor of the scripts, for scripts
+  /// whose functions could not be cached.
+  void RunSimpleString(const char* script);
+
   /// Set/get macro functinos for setting PythonScriptName.
   vtkSetStringMacro(PythonScriptName);
   vtkGetStringMacro(PythonScriptName);
@@ -73,6 +111,13 @@ private:
   /// The name of the python script (without the path or extension)
   /// that is used as the namespace of the functions of the script.
   char* PythonScriptName;
+
+  int OutputFrequency;
+
+//BTX
+  class vtkInternals;
+  vtkInternals* Internals;
+//ETX
 };
 
 
@@ -0,0 +1,301 @@
+// -*- c++ -*-
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestTemporalRanges.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+// Checks the ranges computed by vtkTemporalRanges, the reuse and the
+// invalidation of its cache file, and the ranges computed by
+// vtkPTemporalRanges with the data or the time steps distributed among the
+// processes.
+
+#include "vtkCommunicator.h"
+#include "vtkDoubleArray.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataAlgorithm.h"
+#include "vtkPTemporalRanges.h"
+#include "vtkSmartPointer.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkTable.h"
+#include "vtkTemporalRanges.h"
+#include "vtkTestUtilities.h"
+#include "vtkToolkits.h"
+
+#ifdef VTK_USE_MPI
+# include "vtkMPIController.h"
+#else
+# include "vtkDummyController.h"
+#endif
+
+#include <vtkstd/string>
+#include <vtksys/ios/fstream>
+#include <vtksys/SystemTools.hxx>
+
+#include <math.h>
+
+#define VTK_CREATE(type, name) \
+  vtkSmartPointer<type> name = vtkSmartPointer<type>::New()
+
+static const int NUMBER_OF_TIME_STEPS = 5;
+static const vtkIdType NUMBER_OF_POINTS = 1000;
+
+//=============================================================================
+// Produces the requested piece of NUMBER_OF_POINTS points at the time steps
+// 0, 1, ...  Point i has the scalar "Value" t + i and the vector "Vector"
+// (t, i, 0).  Counts its executions.
+class vtkTemporalRangesTestSource : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkTemporalRangesTestSource *New();
+  vtkTypeMacro(vtkTemporalRangesTestSource, vtkPolyDataAlgorithm);
+
+  int NumberOfExecutions;
+
+protected:
+  vtkTemporalRangesTestSource()
+    {
+    this->SetNumberOfInputPorts(0);
+    this->NumberOfExecutions = 0;
+    }
+
+  virtual int RequestInformation(vtkInformation *,
+                                 vtkInformationVector **,
+                                 vtkInformationVector *outputVector)
+    {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    double times[NUMBER_OF_TIME_STEPS];
+    for (int t = 0; t < NUMBER_OF_TIME_STEPS; t++)
+      {
+      times[t] = t;
+      }
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_STEPS(), times,
+                 NUMBER_OF_TIME_STEPS);
+    double range[2] = { 0.0, NUMBER_OF_TIME_STEPS - 1 };
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_RANGE(), range, 2);
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::MAXIMUM_NUMBER_OF_PIECES(),
+                 -1);
+    return 1;
+    }
+
+  virtual int RequestData(vtkInformation *,
+                          vtkInformationVector **,
+                          vtkInformationVector *outputVector)
+    {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    vtkPolyData *output = vtkPolyData::GetData(outputVector);
+    int piece = outInfo->Get(
+                       vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER());
+    int numPieces = outInfo->Get(
+                   vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES());
+    double time = 0.0;
+    if (outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEPS()))
+      {
+      time = outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEPS())[0];
+      }
+    this->NumberOfExecutions++;
+
+    vtkIdType begin = (NUMBER_OF_POINTS*piece)/numPieces;
+    vtkIdType end = (NUMBER_OF_POINTS*(piece + 1))/numPieces;
+    VTK_CREATE(vtkPoints, points);
+    VTK_CREATE(vtkDoubleArray, value);
+    value->SetName("Value");
+    VTK_CREATE(vtkDoubleArray, vector);
+    vector->SetName("Vector");
+    vector->SetNumberOfComponents(3);
+    for (vtkIdType i = begin; i < end; i++)
+      {
+      points->InsertNextPoint(static_cast<double>(i), 0.0, 0.0);
+      value->InsertNextValue(time + i);
+      vector->InsertNextTuple3(time, static_cast<double>(i), 0.0);
+      }
+    output->SetPoints(points);
+    output->GetPointData()->AddArray(value);
+    output->GetPointData()->AddArray(vector);
+    return 1;
+    }
+
+private:
+  vtkTemporalRangesTestSource(const vtkTemporalRangesTestSource &); // Not implemented
+  void operator=(const vtkTemporalRangesTestSource &);  // Not implemented
+};
+
+vtkStandardNewMacro(vtkTemporalRangesTestSource);
+
+//=============================================================================
+static int CheckColumn(vtkTable *table, const char *name, double average,
+                       double minimum, double maximum, double count)
+{
+  vtkDoubleArray *column
+    = vtkDoubleArray::SafeDownCast(table->GetColumnByName(name));
+  if (!column || (column->GetNumberOfTuples() != vtkTemporalRanges::NUMBER_OF_ROWS))
+    {
+    cerr << "Missing column " << name << endl;
+    return 1;
+    }
+  double expected[vtkTemporalRanges::NUMBER_OF_ROWS];
+  expected[vtkTemporalRanges::AVERAGE_ROW] = average;
+  expected[vtkTemporalRanges::MINIMUM_ROW] = minimum;
+  expected[vtkTemporalRanges::MAXIMUM_ROW] = maximum;
+  expected[vtkTemporalRanges::COUNT_ROW] = count;
+  for (int row = 0; row < vtkTemporalRanges::NUMBER_OF_ROWS; row++)
+    {
+    if (fabs(column->GetValue(row) - expected[row]) > 1e-9*(1.0 + count))
+      {
+      cerr << "Wrong value in row " << row << " of " << name << ": "
+           << column->GetValue(row) << " instead of " << expected[row] << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+// Checks the ranges of all the points over all the time steps.
+static int CheckRanges(vtkTable *table)
+{
+  double lastTime = NUMBER_OF_TIME_STEPS - 1;
+  double lastPoint = static_cast<double>(NUMBER_OF_POINTS - 1);
+  double count = static_cast<double>(NUMBER_OF_TIME_STEPS*NUMBER_OF_POINTS);
+  int status = 0;
+  status |= CheckColumn(table, "Value", 0.5*(lastTime + lastPoint), 0.0,
+                        lastTime + lastPoint, count);
+  status |= CheckColumn(table, "Vector_0", 0.5*lastTime, 0.0, lastTime, count);
+  status |= CheckColumn(table, "Vector_1", 0.5*lastPoint, 0.0, lastPoint,
+                        count);
+  status |= CheckColumn(table, "Vector_2", 0.0, 0.0, 0.0, count);
+  if (!vtkDoubleArray::SafeDownCast(table->GetColumnByName("Vector_M")))
+    {
+    cerr << "Missing column Vector_M" << endl;
+    status = 1;
+    }
+  return status;
+}
+
+//=============================================================================
+// Computes the ranges with a new source and returns the number of times the
+// source executed.
+static int ComputeRanges(vtkTemporalRanges *ranges)
+{
+  VTK_CREATE(vtkTemporalRangesTestSource, source);
+  ranges->SetInputConnection(source->GetOutputPort());
+  ranges->Update();
+  return source->NumberOfExecutions;
+}
+
+static int TestCache(const vtkstd::string &tempDir)
+{
+  vtkstd::string dataFile = tempDir + "/TestTemporalRanges.dat";
+  vtkstd::string cacheFile = tempDir + "/TestTemporalRanges.ranges";
+  vtksys::SystemTools::RemoveFile(cacheFile.c_str());
+    {
+    vtksys_ios::ofstream file(dataFile.c_str());
+    file << "data" << endl;
+    }
+
+  VTK_CREATE(vtkTemporalRanges, ranges);
+  ranges->SetCacheFileName(cacheFile.c_str());
+  ranges->SetCacheKey(dataFile.c_str());
+  int executions = ComputeRanges(ranges);
+  if ((executions != NUMBER_OF_TIME_STEPS) || CheckRanges(ranges->GetOutput()))
+    {
+    cerr << "Wrong ranges without cache." << endl;
+    return 1;
+    }
+
+  // The cache has the ranges: only the first time step is read.
+  ranges->GetOutput()->Initialize();
+  executions = ComputeRanges(ranges);
+  if ((executions != 1) || CheckRanges(ranges->GetOutput()))
+    {
+    cerr << "The cached ranges were not used: " << executions
+         << " executions." << endl;
+    return 1;
+    }
+
+  // Rewriting the data file invalidates the cached ranges.
+    {
+    vtksys_ios::ofstream file(dataFile.c_str(), ios::app);
+    file << "more data" << endl;
+    }
+  executions = ComputeRanges(ranges);
+  if ((executions != NUMBER_OF_TIME_STEPS) || CheckRanges(ranges->GetOutput()))
+    {
+    cerr << "The cached ranges of a rewritten file were used." << endl;
+    return 1;
+    }
+
+  vtksys::SystemTools::RemoveFile(cacheFile.c_str());
+  vtksys::SystemTools::RemoveFile(dataFile.c_str());
+  return 0;
+}
+
+//=============================================================================
+// All processes compute the ranges, process 0 gets the result.
+static int TestParallel(vtkMultiProcessController *controller,
+                        int partitionTimeSteps)
+{
+  int myId = controller->GetLocalProcessId();
+  int numProcs = controller->GetNumberOfProcesses();
+
+  VTK_CREATE(vtkTemporalRangesTestSource, source);
+  VTK_CREATE(vtkPTemporalRanges, ranges);
+  ranges->SetController(controller);
+  ranges->SetPartitionTimeSteps(partitionTimeSteps);
+  ranges->SetInputConnection(source->GetOutputPort());
+  ranges->GetOutput()->SetUpdateExtent(myId, numProcs, 0);
+  ranges->Update();
+
+  if (myId == 0)
+    {
+    return CheckRanges(ranges->GetOutput());
+    }
+  if (ranges->GetOutput()->GetColumnByName("Value"))
+    {
+    cerr << "Process " << myId << " has ranges." << endl;
+    return 1;
+    }
+  return 0;
+}
+
+//=============================================================================
+int main(int argc, char *argv[])
+{
+#ifdef VTK_USE_MPI
+  VTK_CREATE(vtkMPIController, controller);
+#else
+  VTK_CREATE(vtkDummyController, controller);
+#endif
+  controller->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(controller);
+
+  int status = 0;
+  if (controller->GetLocalProcessId() == 0)
+    {
+    char *tempDir = vtkTestUtilities::GetArgOrEnvOrDefault(
+                        "-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+    status |= TestCache(tempDir);
+    delete[] tempDir;
+    }
+  status |= TestParallel(controller, 0);
+  status |= TestParallel(controller, 1);
+
+  int globalStatus = status;
+  controller->AllReduce(&status, &globalStatus, 1, vtkCommunicator::MAX_OP);
+  vtkMultiProcessController::SetGlobalController(NULL);
+  controller->Finalize();
+  return globalStatus;
+}
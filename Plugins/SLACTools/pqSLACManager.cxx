@@ -53,6 +53,7 @@
 
 #include <QMainWindow>
 #include <QPointer>
+#include <QStringList>
 #include <QtDebug>
 
 #include "ui_pqSLACActionHolder.h"
@@ -858,6 +859,23 @@ void pqSLACManager::resetRangeTemporal()
                                                         "TemporalRanges",
                                                         meshReader, 1);
 
+  // Cache the ranges next to the mesh file, keyed by the files read, so that
+  // computing them again for the same data is quick.
+  QStringList meshFiles = pqSMAdaptor::getFileListProperty(
+                                 meshReaderProxy->GetProperty("MeshFileName"));
+  QStringList modeFiles = pqSMAdaptor::getFileListProperty(
+                                 meshReaderProxy->GetProperty("ModeFileName"));
+  if (!meshFiles.isEmpty())
+    {
+    vtkSMProxy *rangeFilterProxy = rangeFilter->getProxy();
+    pqSMAdaptor::setElementProperty(
+                           rangeFilterProxy->GetProperty("CacheFileName"),
+                           meshFiles[0] + ".ranges");
+    pqSMAdaptor::setElementProperty(rangeFilterProxy->GetProperty("CacheKey"),
+                                    (meshFiles + modeFiles).join(";"));
+    rangeFilterProxy->UpdateVTKObjects();
+    }
+
   this->showField(this->CurrentFieldName);
 
   // We have already pushed everything to the server manager, and I don't want
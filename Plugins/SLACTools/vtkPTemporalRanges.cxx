@@ -28,6 +28,8 @@
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTable.h"
 
+#include <vtkstd/algorithm>
+
 #include "vtkSmartPointer.h"
 #define VTK_CREATE(type, name) \
   vtkSmartPointer<type> name = vtkSmartPointer<type>::New()
@@ -100,6 +102,7 @@ vtkPTemporalRanges::vtkPTemporalRanges()
 {
   this->Controller = NULL;
   this->SetController(vtkMultiProcessController::GetGlobalController());
+  this->PartitionTimeSteps = 0;
 }
 
 vtkPTemporalRanges::~vtkPTemporalRanges()
@@ -112,27 +115,108 @@ void vtkPTemporalRanges::PrintSelf(ostream &os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
 
   os << indent << "Controller: " << this->Controller << endl;
+  os << indent << "PartitionTimeSteps: " << this->PartitionTimeSteps << endl;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPTemporalRanges::IsPartitioningTimeSteps()
+{
+  return (   this->PartitionTimeSteps && this->Controller
+          && (this->Controller->GetNumberOfProcesses() > 1) );
 }
 
 //-----------------------------------------------------------------------------
-int vtkPTemporalRanges::RequestData(vtkInformation *request,
-                                    vtkInformationVector **inputVector,
-                                    vtkInformationVector *outputVector)
+// Process i handles time steps i, i+N, i+2N, ... where N is the number of
+// processes.
+int vtkPTemporalRanges::GetNumberOfTimeIterations(int numTimeSteps)
 {
-  if (!this->Superclass::RequestData(request, inputVector, outputVector))
+  if (!this->IsPartitioningTimeSteps())
+    {
+    return this->Superclass::GetNumberOfTimeIterations(numTimeSteps);
+    }
+
+  int numProcs = this->Controller->GetNumberOfProcesses();
+  int procId = this->Controller->GetLocalProcessId();
+  if (procId >= numTimeSteps)
     {
     return 0;
     }
+  return (numTimeSteps - procId + numProcs - 1)/numProcs;
+}
+
+int vtkPTemporalRanges::GetTimeStepIndex(int iteration)
+{
+  if (!this->IsPartitioningTimeSteps())
+    {
+    return this->Superclass::GetTimeStepIndex(iteration);
+    }
+
+  return (  this->Controller->GetLocalProcessId()
+          + iteration*this->Controller->GetNumberOfProcesses() );
+}
 
-  if (!request->Has(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING()))
+//-----------------------------------------------------------------------------
+int vtkPTemporalRanges::RequestUpdateExtent(vtkInformation *request,
+                                            vtkInformationVector **inputVector,
+                                            vtkInformationVector *outputVector)
+{
+  if (!this->Superclass::RequestUpdateExtent(request, inputVector,
+                                             outputVector))
     {
-    // Finished last execution.  Reduce tables.
-    this->Reduce(vtkTable::GetData(outputVector));
+    return 0;
+    }
+
+  // Processes without any time step keep requesting their own piece, which
+  // they ignore.
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  int numTimeSteps = vtkstd::max(
+             inInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS()), 1);
+  if (   this->IsPartitioningTimeSteps()
+      && (this->GetNumberOfTimeIterations(numTimeSteps) > 0) )
+    {
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER(), 0);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES(), 1);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS(),
+                0);
     }
 
   return 1;
 }
 
+//-----------------------------------------------------------------------------
+void vtkPTemporalRanges::FinishTable(vtkTable *output, vtkInformation *inInfo)
+{
+  this->Reduce(output);
+
+  if (!this->Controller || (this->Controller->GetLocalProcessId() == 0))
+    {
+    this->Superclass::FinishTable(output, inInfo);
+    }
+}
+
+//-----------------------------------------------------------------------------
+int vtkPTemporalRanges::ReadCache(vtkTable *output, vtkInformation *inInfo)
+{
+  if (!this->Controller || (this->Controller->GetNumberOfProcesses() <= 1))
+    {
+    return this->Superclass::ReadCache(output, inInfo);
+    }
+
+  // Process 0 decides from the columns it has.  On a hit, it has the complete
+  // ranges and the other processes have nothing to contribute.
+  int cached = 0;
+  if (this->Controller->GetLocalProcessId() == 0)
+    {
+    cached = this->Superclass::ReadCache(output, inInfo);
+    }
+  this->Controller->Broadcast(&cached, 1, 0);
+  if (cached && (this->Controller->GetLocalProcessId() != 0))
+    {
+    output->Initialize();
+    }
+  return cached;
+}
+
 //-----------------------------------------------------------------------------
 void vtkPTemporalRanges::Reduce(vtkTable *table)
 {
@@ -23,7 +23,16 @@
 // .SECTION Description
 //
 // vtkPTemporalRanges works basically like its superclass, vtkTemporalRanges,
-// except that it works in a data parallel manner.
+// except that it works in a data parallel manner.  The partial ranges of all
+// processes are combined on process 0, which also reads and writes the cache
+// file.
+//
+// When PartitionTimeSteps is on, the time steps are distributed among the
+// processes instead of the data: each process requests the whole dataset
+// (piece 0 of 1) for every Nth time step.  This only works with readers that
+// can produce the whole dataset independently on each process (vtkPSLACReader,
+// which partitions the mesh with collective communication, cannot) and each
+// process needs to hold the whole dataset for one time step.
 //
 
 #ifndef __vtkPTemporalRanges_h
@@ -43,18 +52,37 @@ public:
   vtkGetObjectMacro(Controller, vtkMultiProcessController);
   virtual void SetController(vtkMultiProcessController *);
 
+  // Description:
+  // When on, distribute the time steps among the processes instead of the
+  // data.  Off by default.
+  vtkSetMacro(PartitionTimeSteps, int);
+  vtkGetMacro(PartitionTimeSteps, int);
+  vtkBooleanMacro(PartitionTimeSteps, int);
+
 protected:
   vtkPTemporalRanges();
   ~vtkPTemporalRanges();
 
   vtkMultiProcessController *Controller;
+  int PartitionTimeSteps;
+
+  virtual int RequestUpdateExtent(vtkInformation *,
+                                  vtkInformationVector **,
+                                  vtkInformationVector *);
 
-  virtual int RequestData(vtkInformation *,
-                          vtkInformationVector **,
-                          vtkInformationVector *);
+  virtual int GetNumberOfTimeIterations(int numTimeSteps);
+  virtual int GetTimeStepIndex(int iteration);
+
+  virtual void FinishTable(vtkTable *output, vtkInformation *inInfo);
+  virtual int ReadCache(vtkTable *output, vtkInformation *inInfo);
 
   virtual void Reduce(vtkTable *table);
 
+  // Description:
+  // Returns true if the time steps are currently distributed among several
+  // processes.
+  bool IsPartitioningTimeSteps();
+
 private:
   vtkPTemporalRanges(const vtkPTemporalRanges &);       // Not implemented
   void operator=(const vtkPTemporalRanges &);           // Not implemented
@@ -28,6 +28,7 @@
 #include "vtkDoubleArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
@@ -40,10 +41,15 @@
   vtkSmartPointer<type> name = vtkSmartPointer<type>::New()
 
 #include <vtkstd/algorithm>
+#include <vtkstd/set>
+#include <vtkstd/string>
 #include <vtkstd/vector>
+#include <vtksys/ios/fstream>
 #include <vtksys/ios/sstream>
+#include <vtksys/SystemTools.hxx>
 
 #include <math.h>
+#include <stdlib.h>
 
 //=============================================================================
 // This is not super portable.  We really should be using vtkMath::IsNan.  The
@@ -78,53 +84,199 @@ namespace vtkTemporalRangesNamespace{
     column->SetValue(COUNT_ROW,   0.0);
   }
 
-  inline void AccumulateValue(double value, vtkDoubleArray *column)
+  // Merges the statistics of some values into a column.  Does nothing when
+  // there are no values (which would make the average NaN).
+  inline void AccumulateStatistics(double average, double minimum,
+                                   double maximum, double count,
+                                   vtkDoubleArray *target)
   {
-    if (!isnan(value))
+    if (count <= 0.0)
       {
-      column->SetValue(AVERAGE_ROW, value + column->GetValue(AVERAGE_ROW));
-      column->SetValue(MINIMUM_ROW, vtkstd::min(column->GetValue(MINIMUM_ROW),
-                                                value));
-      column->SetValue(MAXIMUM_ROW, vtkstd::max(column->GetValue(MAXIMUM_ROW),
-                                                value));
-      column->SetValue(COUNT_ROW, column->GetValue(COUNT_ROW) + 1);
+      return;
       }
-  }
-
-  inline void AccumulateColumn(vtkDoubleArray *source,
-                               vtkDoubleArray *target)
-  {
     double targetCount = target->GetValue(COUNT_ROW);
-    double sourceCount = source->GetValue(COUNT_ROW);
-    double totalCount = targetCount + sourceCount;
+    double totalCount = targetCount + count;
     double targetTotal = targetCount*target->GetValue(AVERAGE_ROW);
-    double sourceTotal = sourceCount*source->GetValue(AVERAGE_ROW);
-    target->SetValue(AVERAGE_ROW, (targetTotal + sourceTotal)/totalCount);
-    target->SetValue(MINIMUM_ROW, vtkstd::min(source->GetValue(MINIMUM_ROW),
+    target->SetValue(AVERAGE_ROW, (targetTotal + count*average)/totalCount);
+    target->SetValue(MINIMUM_ROW, vtkstd::min(minimum,
                                               target->GetValue(MINIMUM_ROW)));
-    target->SetValue(MAXIMUM_ROW, vtkstd::max(source->GetValue(MAXIMUM_ROW),
+    target->SetValue(MAXIMUM_ROW, vtkstd::max(maximum,
                                               target->GetValue(MAXIMUM_ROW)));
     target->SetValue(COUNT_ROW, totalCount);
   }
+
+  inline void AccumulateColumn(vtkDoubleArray *source,
+                               vtkDoubleArray *target)
+  {
+    AccumulateStatistics(source->GetValue(AVERAGE_ROW),
+                         source->GetValue(MINIMUM_ROW),
+                         source->GetValue(MAXIMUM_ROW),
+                         source->GetValue(COUNT_ROW), target);
+  }
+
+  // The values of an array are accumulated in "slots", one per component plus
+  // one for the magnitude (the last) when there are several components.  Each
+  // slot has 4 entries: the sum, minimum, maximum, and count of the values that
+  // are not NaN.
+  const int SLOT_SIZE = 4;
+
+  inline int GetNumberOfSlots(int numComponents)
+  {
+    return (numComponents > 1) ? (numComponents + 1) : numComponents;
+  }
+
+  inline void InitializeSlots(double *slots, int numSlots)
+  {
+    for (int i = 0; i < numSlots; i++, slots += SLOT_SIZE)
+      {
+      slots[0] = 0.0;
+      slots[1] = vtkTypeTraits<double>::Max();
+      slots[2] = vtkTypeTraits<double>::Min();
+      slots[3] = 0.0;
+      }
+  }
+
+  inline void AccumulateSlot(double value, double *slot)
+  {
+    if (!isnan(value))
+      {
+      slot[0] += value;
+      slot[1] = vtkstd::min(slot[1], value);
+      slot[2] = vtkstd::max(slot[2], value);
+      slot[3] += 1.0;
+      }
+  }
+
+  inline void MergeSlot(const double *source, double *target)
+  {
+    target[0] += source[0];
+    target[1] = vtkstd::min(target[1], source[1]);
+    target[2] = vtkstd::max(target[2], source[2]);
+    target[3] += source[3];
+  }
+
+  template<class T>
+  void AccumulateTuples(const T *data, int numComponents,
+                        vtkIdType begin, vtkIdType end, double *slots)
+  {
+    const T *tuple = data + begin*numComponents;
+    double *magnitudeSlot = slots + SLOT_SIZE*numComponents;
+    for (vtkIdType i = begin; i < end; i++, tuple += numComponents)
+      {
+      double mag = 0.0;
+      for (int j = 0; j < numComponents; j++)
+        {
+        double value = static_cast<double>(tuple[j]);
+        mag += value*value;
+        AccumulateSlot(value, slots + SLOT_SIZE*j);
+        }
+      if (numComponents > 1)
+        {
+        AccumulateSlot(sqrt(mag), magnitudeSlot);
+        }
+      }
+  }
+
+  // Accumulates tuples [begin, end) of an array in the slots.
+  void AccumulateTupleRange(vtkDataArray *field, vtkIdType begin,
+                            vtkIdType end, double *slots)
+  {
+    int numComponents = field->GetNumberOfComponents();
+    switch (field->GetDataType())
+      {
+      vtkTemplateMacro(AccumulateTuples(
+                         static_cast<VTK_TT *>(field->GetVoidPointer(0)),
+                         numComponents, begin, end, slots));
+      default:
+        for (vtkIdType i = begin; i < end; i++)
+          {
+          double mag = 0.0;
+          for (int j = 0; j < numComponents; j++)
+            {
+            double value = field->GetComponent(i, j);
+            mag += value*value;
+            AccumulateSlot(value, slots + SLOT_SIZE*j);
+            }
+          if (numComponents > 1)
+            {
+            AccumulateSlot(sqrt(mag), slots + SLOT_SIZE*numComponents);
+            }
+          }
+        break;
+      }
+  }
+
+  // Don't spawn threads for fewer tuples than this per thread.
+  const vtkIdType MINIMUM_TUPLES_PER_THREAD = 100000;
 };
 using namespace vtkTemporalRangesNamespace;
 
+//=============================================================================
+// The tuples of a large array are split in contiguous ranges, one per thread.
+// Each thread accumulates its range in its own slots.
+class vtkTemporalRangesTask
+{
+public:
+  vtkDataArray *Field;
+  int NumberOfSlots;
+  vtkstd::vector<double> Slots;
+
+  void Execute(int threadId, int numThreads)
+    {
+    vtkIdType numTuples = this->Field->GetNumberOfTuples();
+    vtkIdType begin = (numTuples * threadId) / numThreads;
+    vtkIdType end = (numTuples * (threadId + 1)) / numThreads;
+    AccumulateTupleRange(this->Field, begin, end,
+                         &this->Slots[SLOT_SIZE*this->NumberOfSlots*threadId]);
+    }
+};
+
+static VTK_THREAD_RETURN_TYPE vtkTemporalRangesThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info
+    = static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkTemporalRangesTask *task
+    = static_cast<vtkTemporalRangesTask *>(info->UserData);
+  task->Execute(info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //=============================================================================
 vtkStandardNewMacro(vtkTemporalRanges);
 
 //-----------------------------------------------------------------------------
 vtkTemporalRanges::vtkTemporalRanges()
 {
+  this->CacheFileName = NULL;
+  this->CacheKey = NULL;
   this->CurrentTimeIndex = 0;
 }
 
 vtkTemporalRanges::~vtkTemporalRanges()
 {
+  this->SetCacheFileName(NULL);
+  this->SetCacheKey(NULL);
 }
 
 void vtkTemporalRanges::PrintSelf(ostream &os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "CacheFileName: "
+     << (this->CacheFileName ? this->CacheFileName : "(none)") << endl;
+  os << indent << "CacheKey: "
+     << (this->CacheKey ? this->CacheKey : "(none)") << endl;
+}
+
+//-----------------------------------------------------------------------------
+int vtkTemporalRanges::GetNumberOfTimeIterations(int numTimeSteps)
+{
+  return numTimeSteps;
+}
+
+int vtkTemporalRanges::GetTimeStepIndex(int iteration)
+{
+  return iteration;
 }
 
 //-----------------------------------------------------------------------------
@@ -172,8 +324,17 @@ int vtkTemporalRanges::RequestUpdateExtent(
   double *inTimes = inInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
   if (inTimes)
     {
+    int numTimeSteps
+      = inInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+    int numIterations = this->GetNumberOfTimeIterations(numTimeSteps);
+    int index = 0;
+    if (numIterations > 0)
+      {
+      index = this->GetTimeStepIndex(vtkstd::min(this->CurrentTimeIndex,
+                                                 numIterations - 1));
+      }
     inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEPS(),
-                &inTimes[this->CurrentTimeIndex], 1);
+                &inTimes[index], 1);
     }
 
   return 1;
@@ -187,34 +348,50 @@ int vtkTemporalRanges::RequestData(vtkInformation *request,
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
   vtkTable *output = vtkTable::GetData(outputVector);
 
+  // Data without time is processed as a single time step.
+  int numTimeSteps = vtkstd::max(
+             inInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS()), 1);
+  int numIterations = this->GetNumberOfTimeIterations(numTimeSteps);
+
   if (this->CurrentTimeIndex == 0)
     {
     // First execution.  Initialize table.
     this->InitializeTable(output);
     }
 
-  vtkCompositeDataSet *compositeInput = vtkCompositeDataSet::GetData(inInfo);
-  vtkDataSet *dsInput = vtkDataSet::GetData(inInfo);
-
-  if (compositeInput)
-    {
-    this->AccumulateCompositeData(compositeInput, output);
-    }
-  else if (dsInput)
+  if (this->CurrentTimeIndex < numIterations)
     {
-    this->AccumulateDataSet(dsInput, output);
+    vtkCompositeDataSet *compositeInput = vtkCompositeDataSet::GetData(inInfo);
+    vtkDataSet *dsInput = vtkDataSet::GetData(inInfo);
+
+    if (compositeInput)
+      {
+      this->AccumulateCompositeData(compositeInput, output);
+      }
+    else if (dsInput)
+      {
+      this->AccumulateDataSet(dsInput, output);
+      }
+    else
+      {
+      vtkWarningMacro(<< "Unknown data type : "
+                      << vtkDataObject::GetData(inputVector[0])->GetClassName());
+      this->CurrentTimeIndex = 0;
+      return 0;
+      }
     }
-  else
+
+  // The first time step tells which columns there are, so check the cache.
+  int cached = 0;
+  if (   (this->CurrentTimeIndex == 0)
+      && this->CacheFileName && (this->CacheFileName[0] != '\0') )
     {
-    vtkWarningMacro(<< "Unknown data type : "
-                    << vtkDataObject::GetData(inputVector[0])->GetClassName());
-    return 0;
+    cached = this->ReadCache(output, inInfo);
     }
 
   this->CurrentTimeIndex++;
 
-  if (  this->CurrentTimeIndex
-      < inInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS()) )
+  if (!cached && (this->CurrentTimeIndex < numIterations))
     {
     // There is still more to do.
     request->Set(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING(), 1);
@@ -224,11 +401,24 @@ int vtkTemporalRanges::RequestData(vtkInformation *request,
     // We are done.  Finish up.
     request->Remove(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
     this->CurrentTimeIndex = 0;
+    if (!cached)
+      {
+      this->FinishTable(output, inInfo);
+      }
     }
 
   return 1;
 }
 
+//-----------------------------------------------------------------------------
+void vtkTemporalRanges::FinishTable(vtkTable *output, vtkInformation *inInfo)
+{
+  if (this->CacheFileName && (this->CacheFileName[0] != '\0'))
+    {
+    this->WriteCache(output, inInfo);
+    }
+}
+
 //-----------------------------------------------------------------------------
 void vtkTemporalRanges::InitializeTable(vtkTable *output)
 {
@@ -295,57 +485,69 @@ void vtkTemporalRanges::AccumulateArray(vtkDataArray *field, vtkTable *output)
 {
   int numComponents = field->GetNumberOfComponents();
   vtkIdType numTuples = field->GetNumberOfTuples();
-  vtkDoubleArray *magnitudeColumn = NULL;
-  vtkstd::vector<vtkDoubleArray *> componentColumns(numComponents);
-  VTK_CREATE(vtkDoubleArray, magnitudeAccumulate);
-  vtkstd::vector<vtkSmartPointer<vtkDoubleArray> > componentAccumulate(numComponents);
+  int numSlots = GetNumberOfSlots(numComponents);
+  if (numSlots < 1)
+    {
+    return;
+    }
+
+  vtkstd::vector<vtkDoubleArray *> columns(numSlots);
   if (numComponents > 1)
     {
-    magnitudeColumn = this->GetColumn(output, field->GetName(), -1);
-    InitializeColumn(magnitudeAccumulate);
     for (int i = 0; i < numComponents; i++)
       {
-      componentColumns[i] = this->GetColumn(output, field->GetName(), i);
-      componentAccumulate[i] = vtkSmartPointer<vtkDoubleArray>::New();
-      InitializeColumn(componentAccumulate[i]);
+      columns[i] = this->GetColumn(output, field->GetName(), i);
       }
+    columns[numComponents] = this->GetColumn(output, field->GetName(), -1);
     }
   else
     {
-    componentColumns[0] = this->GetColumn(output, field->GetName());
-    componentAccumulate[0] = vtkSmartPointer<vtkDoubleArray>::New();
-    InitializeColumn(componentAccumulate[0]);
+    columns[0] = this->GetColumn(output, field->GetName());
     }
 
-  for (vtkIdType i = 0; i < numTuples; i++)
+  vtkTemporalRangesTask task;
+  task.Field = field;
+  task.NumberOfSlots = numSlots;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  int maxThreads = static_cast<int>(numTuples/MINIMUM_TUPLES_PER_THREAD);
+  int numThreads = vtkstd::max(1, vtkstd::min(threader->GetNumberOfThreads(),
+                                              maxThreads));
+  task.Slots.resize(SLOT_SIZE*numSlots*numThreads);
+  for (int t = 0; t < numThreads; t++)
     {
-    double mag = 0.0;
-    for (int j = 0; j < numComponents; j++)
-      {
-      double value = field->GetComponent(i, j);
-      mag += value*value;
-      AccumulateValue(value, componentAccumulate[j]);
-      }
-    if (magnitudeColumn)
-      {
-      mag = sqrt(mag);
-      AccumulateValue(mag, magnitudeAccumulate);
-      }
+    InitializeSlots(&task.Slots[SLOT_SIZE*numSlots*t], numSlots);
+    }
+  if (numThreads > 1)
+    {
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(vtkTemporalRangesThread, &task);
+    threader->SingleMethodExecute();
     }
+  else
+    {
+    task.Execute(0, 1);
+    }
+  threader->Delete();
 
-  for (int j = 0; j < numComponents; j++)
+  // Combine the partial results in thread order.
+  double *slots = &task.Slots[0];
+  for (int t = 1; t < numThreads; t++)
     {
-    componentAccumulate[j]->SetValue(AVERAGE_ROW,
-                              (  componentAccumulate[j]->GetValue(AVERAGE_ROW)
-                               / componentAccumulate[j]->GetValue(COUNT_ROW) ));
-    AccumulateColumn(componentAccumulate[j], componentColumns[j]);
+    for (int i = 0; i < numSlots; i++)
+      {
+      MergeSlot(&task.Slots[SLOT_SIZE*(numSlots*t + i)], slots + SLOT_SIZE*i);
+      }
     }
-  if (magnitudeColumn)
+
+  for (int i = 0; i < numSlots; i++)
     {
-    magnitudeAccumulate->SetValue(AVERAGE_ROW,
-                                  (  magnitudeAccumulate->GetValue(AVERAGE_ROW)
-                                   / magnitudeAccumulate->GetValue(COUNT_ROW)));
-    AccumulateColumn(magnitudeAccumulate, magnitudeColumn);
+    double *slot = slots + SLOT_SIZE*i;
+    double count = slot[3];
+    if (count > 0.0)
+      {
+      AccumulateStatistics(slot[0]/count, slot[1], slot[2], count, columns[i]);
+      }
     }
 }
 
@@ -401,3 +603,164 @@ vtkDoubleArray *vtkTemporalRanges::GetColumn(vtkTable *table, const char *name)
 
   return array;
 }
+
+//-----------------------------------------------------------------------------
+vtkStdString vtkTemporalRanges::GetCacheEntryKey(vtkInformation *inInfo)
+{
+  vtksys_ios::ostringstream key;
+  key.precision(17);
+  key << (this->CacheKey ? this->CacheKey : "");
+
+  // Rewriting a file of the key changes its modification time or size, which
+  // makes the old entries stale.
+  vtkstd::string cacheKey = this->CacheKey ? this->CacheKey : "";
+  size_t begin = 0;
+  while (begin <= cacheKey.size())
+    {
+    size_t end = cacheKey.find(';', begin);
+    if (end == vtkstd::string::npos)
+      {
+      end = cacheKey.size();
+      }
+    vtkstd::string fileName = cacheKey.substr(begin, end - begin);
+    if (   !fileName.empty() && vtksys::SystemTools::FileExists(fileName.c_str())
+        && !vtksys::SystemTools::FileIsDirectory(fileName.c_str()) )
+      {
+      key << " " << vtksys::SystemTools::ModifiedTime(fileName.c_str())
+          << " " << vtksys::SystemTools::FileLength(fileName.c_str());
+      }
+    begin = end + 1;
+    }
+
+  int numTimeSteps
+    = inInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+  key << " " << numTimeSteps;
+  double *inTimes = inInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+  if (inTimes && (numTimeSteps > 0))
+    {
+    key << " " << inTimes[0] << " " << inTimes[numTimeSteps-1];
+    }
+
+  // Tabs and line breaks separate the entries of the cache file.
+  vtkStdString result = key.str();
+  for (size_t i = 0; i < result.size(); i++)
+    {
+    if ((result[i] == '\t') || (result[i] == '\n') || (result[i] == '\r'))
+      {
+      result[i] = ' ';
+      }
+    }
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+// Each line of the cache file is an entry with the following fields separated
+// by tabs: key, column name, average, minimum, maximum, count.
+int vtkTemporalRanges::ReadCache(vtkTable *output, vtkInformation *inInfo)
+{
+  vtksys_ios::ifstream file(this->CacheFileName);
+  if (!file)
+    {
+    return 0;
+    }
+
+  vtkStdString key = this->GetCacheEntryKey(inInfo);
+  VTK_CREATE(vtkTable, cached);
+  this->InitializeTable(cached);
+  vtkstd::string line;
+  while (vtkstd::getline(file, line))
+    {
+    vtkstd::vector<vtkstd::string> fields;
+    size_t begin = 0;
+    for (size_t tab = line.find('\t'); tab != vtkstd::string::npos;
+         begin = tab + 1, tab = line.find('\t', begin))
+      {
+      fields.push_back(line.substr(begin, tab - begin));
+      }
+    fields.push_back(line.substr(begin));
+    if ((fields.size() != 2 + NUMBER_OF_ROWS) || (fields[0] != key)) continue;
+    if (!output->GetColumnByName(fields[1].c_str())) continue;
+
+    vtkDoubleArray *column = this->GetColumn(cached, fields[1].c_str());
+    column->SetValue(AVERAGE_ROW, atof(fields[2].c_str()));
+    column->SetValue(MINIMUM_ROW, atof(fields[3].c_str()));
+    column->SetValue(MAXIMUM_ROW, atof(fields[4].c_str()));
+    column->SetValue(COUNT_ROW, atof(fields[5].c_str()));
+    }
+
+  // Only use the cache if it has all the columns.
+  int numColumns = 0;
+  for (vtkIdType c = 0; c < output->GetNumberOfColumns(); c++)
+    {
+    vtkAbstractArray *column = output->GetColumn(c);
+    if (!vtkDoubleArray::SafeDownCast(column)) continue;
+    if (!cached->GetColumnByName(column->GetName()))
+      {
+      return 0;
+      }
+    numColumns++;
+    }
+  if (numColumns == 0)
+    {
+    return 0;
+    }
+
+  output->ShallowCopy(cached);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkTemporalRanges::WriteCache(vtkTable *output, vtkInformation *inInfo)
+{
+  vtkStdString key = this->GetCacheEntryKey(inInfo);
+
+  // Keep the entries of other keys and of columns not in the output.
+  vtkstd::set<vtkstd::string> names;
+  for (vtkIdType c = 0; c < output->GetNumberOfColumns(); c++)
+    {
+    vtkAbstractArray *column = output->GetColumn(c);
+    if (vtkDoubleArray::SafeDownCast(column))
+      {
+      names.insert(column->GetName());
+      }
+    }
+  vtkstd::vector<vtkstd::string> lines;
+  vtksys_ios::ifstream oldFile(this->CacheFileName);
+  vtkstd::string line;
+  while (oldFile && vtkstd::getline(oldFile, line))
+    {
+    size_t keyEnd = line.find('\t');
+    if (keyEnd == vtkstd::string::npos) continue;
+    size_t nameEnd = line.find('\t', keyEnd + 1);
+    if (   (line.compare(0, keyEnd, key) == 0) && (keyEnd == key.size())
+        && (names.find(line.substr(keyEnd + 1, nameEnd - keyEnd - 1))
+            != names.end()) )
+      {
+      continue;
+      }
+    lines.push_back(line);
+    }
+  oldFile.close();
+
+  vtksys_ios::ofstream file(this->CacheFileName);
+  if (!file)
+    {
+    vtkWarningMacro(<< "Could not write cache file " << this->CacheFileName);
+    return;
+    }
+  for (size_t i = 0; i < lines.size(); i++)
+    {
+    file << lines[i] << "\n";
+    }
+  file.precision(17);
+  for (vtkIdType c = 0; c < output->GetNumberOfColumns(); c++)
+    {
+    vtkDoubleArray *column = vtkDoubleArray::SafeDownCast(output->GetColumn(c));
+    if (!column) continue;
+    file << key << "\t" << column->GetName()
+         << "\t" << column->GetValue(AVERAGE_ROW)
+         << "\t" << column->GetValue(MINIMUM_ROW)
+         << "\t" << column->GetValue(MAXIMUM_ROW)
+         << "\t" << column->GetValue(COUNT_ROW) << "\n";
+    }
+}
@@ -31,11 +31,19 @@
 // and time, it will also give a single statistics over all blocks in a data
 // set.
 //
+// Large arrays are accumulated by several threads (see vtkMultiThreader).  When
+// CacheFileName is set, the ranges are stored in that file under CacheKey (plus
+// the number and range of the time steps) and the name of each column.  A later
+// execution with the same key only reads the first time step: if the cache has
+// an entry for all the columns computed from it, the cached ranges are used for
+// the whole output.
+//
 
 #ifndef __vtkTemporalRanges_h
 #define __vtkTemporalRanges_h
 
 #include "vtkTableAlgorithm.h"
+#include "vtkStdString.h" // For GetCacheEntryKey()
 
 class vtkCompositeDataSet;
 class vtkDataSet;
@@ -59,12 +67,39 @@ public:
   };
 //ETX
 
+  // Description:
+  // File in which the computed ranges are cached.  Caching is disabled when
+  // this is NULL or empty (the default).
+  vtkSetStringMacro(CacheFileName);
+  vtkGetStringMacro(CacheFileName);
+
+  // Description:
+  // Identifies the input data in the cache file, typically by the names of the
+  // files it is read from separated by semicolons.  The modification time and
+  // size of each of these files are part of the key, so the cached ranges of a
+  // file are not used after it is rewritten.  It must not contain tabs or line
+  // breaks.
+  vtkSetStringMacro(CacheKey);
+  vtkGetStringMacro(CacheKey);
+
 protected:
   vtkTemporalRanges();
   ~vtkTemporalRanges();
 
+  char *CacheFileName;
+  char *CacheKey;
+
+  // Number of time steps processed so far in the current execution.
   int CurrentTimeIndex;
 
+  // Description:
+  // The number of time steps accumulated by this filter out of the given
+  // number of input time steps, and the index (in the input time steps) of each
+  // of them.  The default processes them all in order.  Subclasses can
+  // override these to only process a subset of the time steps.
+  virtual int GetNumberOfTimeIterations(int numTimeSteps);
+  virtual int GetTimeStepIndex(int iteration);
+
   virtual int FillInputPortInformation(int port, vtkInformation *info);
 
   virtual int RequestInformation(vtkInformation *,
@@ -89,6 +124,19 @@ protected:
 
   virtual void AccumulateTable(vtkTable *source, vtkTable *target);
 
+  // Description:
+  // Called once all the time steps have been accumulated in the output.  Writes
+  // the ranges to the cache file.
+  virtual void FinishTable(vtkTable *output, vtkInformation *inInfo);
+
+  // Description:
+  // Replaces the columns of the output with the cached ranges.  Returns 1 if
+  // the cache has an entry for every column, otherwise 0 and the output is
+  // unchanged.
+  virtual int ReadCache(vtkTable *output, vtkInformation *inInfo);
+  virtual void WriteCache(vtkTable *output, vtkInformation *inInfo);
+  vtkStdString GetCacheEntryKey(vtkInformation *inInfo);
+
   virtual vtkDoubleArray *GetColumn(vtkTable *table, const char *name,
                                     int component);
   virtual vtkDoubleArray *GetColumn(vtkTable *table, const char *name);
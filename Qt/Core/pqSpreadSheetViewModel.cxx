@@ -78,6 +78,10 @@ public:
   {
   this->ActiveBlockNumber = 0;
   this->Dirty = true;
+  this->VisibleTopBlock = -1;
+  this->VisibleBottomBlock = -1;
+  this->ScrollDirection = 1;
+  this->Fetching = false;
   this->VTKConnect = vtkSmartPointer<vtkEventQtSlotConnect>::New();
   this->DecimalPrecision = 6;
   }
@@ -154,6 +158,16 @@ public:
   QTimer Timer;
   QSet<vtkIdType> PendingBlocks;
 
+  // Blocks to fetch ahead of the visible ones, in the scroll direction.
+  QTimer PrefetchTimer;
+  QList<vtkIdType> PrefetchBlocks;
+  vtkIdType VisibleTopBlock;
+  vtkIdType VisibleBottomBlock;
+  int ScrollDirection;
+  // Set while blocks are being fetched. Fetching processes events (to show
+  // the progress), which must not start other requests.
+  bool Fetching;
+
   QTimer SelectionTimer;
   QSet<vtkIdType> PendingSelectionBlocks;
   vtkSmartPointer<vtkEventQtSlotConnect> VTKConnect;
@@ -171,6 +185,13 @@ pqSpreadSheetViewModel::pqSpreadSheetViewModel()
   QObject::connect(&this->Internal->Timer, SIGNAL(timeout()),
     this, SLOT(delayedUpdate()));
 
+  // Prefetch one block at a time when the application is idle so that user
+  // events are processed between the requests.
+  this->Internal->PrefetchTimer.setSingleShot(true);
+  this->Internal->PrefetchTimer.setInterval(0);
+  QObject::connect(&this->Internal->PrefetchTimer, SIGNAL(timeout()),
+    this, SLOT(prefetchNextBlock()));
+
   this->Internal->SelectionTimer.setSingleShot(true);
   this->Internal->SelectionTimer.setInterval(100);//milliseconds.
   QObject::connect(&this->Internal->SelectionTimer, SIGNAL(timeout()),
@@ -264,6 +285,10 @@ void pqSpreadSheetViewModel::update()
 void pqSpreadSheetViewModel::forceUpdate()
 {
   this->Internal->Dirty = false;
+  // The cache was cleaned, prefetch again for the visible blocks.
+  this->Internal->PrefetchBlocks.clear();
+  this->Internal->VisibleTopBlock = -1;
+  this->Internal->VisibleBottomBlock = -1;
   // Note that this method is called after the representation has already been
   // updated.
   int old_rows = this->Internal->NumberOfRows;
@@ -339,6 +364,12 @@ void pqSpreadSheetViewModel::delayedUpdate()
 {
   vtkSMSpreadSheetRepresentationProxy* repr = 
     this->Internal->Representation;
+  if (this->Internal->Fetching)
+    {
+    // A request is already in flight, try again once it is done.
+    this->Internal->Timer.start();
+    return;
+    }
   if (repr)
     {
     QModelIndex topLeft;
@@ -348,7 +379,9 @@ void pqSpreadSheetViewModel::delayedUpdate()
       {
       // cout << "Requesting : (" << repr << ") " << blockNumber << endl;
       this->Internal->ActiveBlockNumber = blockNumber;
+      this->Internal->Fetching = true;
       repr->GetOutput(this->Internal->ActiveBlockNumber);
+      this->Internal->Fetching = false;
 
       QModelIndex myTopLeft(this->index(blockNumber*blocksize, 0));
       int botRow = blocksize*(blockNumber+1);
@@ -365,6 +398,7 @@ void pqSpreadSheetViewModel::delayedUpdate()
       // we always invalidate header data, just to be on a safe side.
       this->headerDataChanged(Qt::Horizontal, 0, this->columnCount()-1);
       }
+    this->Internal->PrefetchTimer.start();
     }
 }
 
@@ -401,6 +435,65 @@ void pqSpreadSheetViewModel::setActiveBlock(QModelIndex top, QModelIndex bottom)
       this->Internal->PendingBlocks.insert(cc);
       this->Internal->PendingSelectionBlocks.insert(cc);
       }
+
+    // Blocks ahead in the scroll direction are prefetched once the visible
+    // blocks are available.
+    if (topBlock != this->Internal->VisibleTopBlock ||
+      bottomBlock != this->Internal->VisibleBottomBlock)
+      {
+      if (topBlock != this->Internal->VisibleTopBlock)
+        {
+        this->Internal->ScrollDirection =
+          (topBlock < this->Internal->VisibleTopBlock)? -1 : 1;
+        }
+      this->Internal->VisibleTopBlock = topBlock;
+      this->Internal->VisibleBottomBlock = bottomBlock;
+      this->Internal->PrefetchBlocks.clear();
+      for (vtkIdType cc=1; cc <= pqSpreadSheetViewModel::PrefetchSize; cc++)
+        {
+        this->Internal->PrefetchBlocks.push_back(
+          this->Internal->ScrollDirection > 0?
+          bottomBlock + cc : topBlock - cc);
+        }
+      }
+    this->Internal->PrefetchTimer.start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void pqSpreadSheetViewModel::prefetchNextBlock()
+{
+  vtkSMSpreadSheetRepresentationProxy* repr = 
+    this->Internal->Representation;
+  if (!repr || this->Internal->Fetching || this->Internal->Dirty)
+    {
+    return;
+    }
+
+  // Visible blocks have priority: the prefetching resumes after they are
+  // fetched.
+  foreach (vtkIdType blockNumber, this->Internal->PendingBlocks)
+    {
+    if (!repr->IsAvailable(blockNumber))
+      {
+      return;
+      }
+    }
+
+  while (!this->Internal->PrefetchBlocks.isEmpty())
+    {
+    vtkIdType blockNumber = this->Internal->PrefetchBlocks.takeFirst();
+    this->Internal->Fetching = true;
+    bool fetched = repr->Prefetch(blockNumber);
+    this->Internal->Fetching = false;
+    if (fetched)
+      {
+      break;
+      }
+    }
+  if (!this->Internal->PrefetchBlocks.isEmpty())
+    {
+    this->Internal->PrefetchTimer.start();
     }
 }
 
@@ -951,3 +1044,37 @@ int pqSpreadSheetViewModel::getDecimalPrecision()
 {
   return this->Internal->DecimalPrecision;
 }
+
+//-----------------------------------------------------------------------------
+void pqSpreadSheetViewModel::sort(int column, Qt::SortOrder order)
+{
+  vtkSMSpreadSheetRepresentationProxy* repr = 
+    this->Internal->Representation;
+  if (!repr || !repr->IsAvailable(this->Internal->ActiveBlockNumber))
+    {
+    return;
+    }
+
+  vtkTable* table = vtkTable::SafeDownCast(
+    repr->GetOutput(this->Internal->ActiveBlockNumber));
+  QString name;
+  if (table && column >= 0 && column < table->GetNumberOfColumns())
+    {
+    name = table->GetColumnName(column);
+    }
+  if (name == "vtkOriginalIndices" || name == "vtkOriginalProcessIds")
+    {
+    name = QString();
+    }
+
+  pqSMAdaptor::setElementProperty(repr->GetProperty("SortColumnName"), name);
+  pqSMAdaptor::setElementProperty(repr->GetProperty("SortAscending"),
+    (order == Qt::AscendingOrder)? 1 : 0);
+  repr->UpdateVTKObjects();
+  // The cached blocks hold the rows in the previous order.
+  repr->CleanCache();
+  if (this->Internal->DataRepresentation)
+    {
+    this->Internal->DataRepresentation->renderViewEventually();
+    }
+}
@@ -116,8 +116,13 @@ public:
 
   /// Set the best estimate for the visible block. The model will request data
   /// (if not available) only for the most recently selected active block.
+  /// Once it is available, the next PrefetchSize blocks in the scroll
+  /// direction are fetched in the background.
   void setActiveBlock(QModelIndex top, QModelIndex bottom);
 
+  /// Number of blocks fetched ahead of the visible ones.
+  enum { PrefetchSize = 2 };
+
   /// Returns the field type for the data currently shown by this model.
   int getFieldType() const;
 
@@ -132,6 +137,11 @@ public:
   void setDecimalPrecision(int);
   int getDecimalPrecision();
 
+  /// Sorts the rows by the given column. Sorting is done on the server, on the
+  /// rows of all processes, so that blocks are fetched in the sorted order.
+  /// Sorting by the index or process id columns restores the input order.
+  virtual void sort(int column, Qt::SortOrder order=Qt::AscendingOrder);
+
 signals:
   void requestDelayedUpdate() const;
   
@@ -149,6 +159,9 @@ private slots:
   /// called to fetch selection for all pending blocks.
   void delayedSelectionUpdate();
 
+  /// called when idle to fetch the next block ahead of the visible ones.
+  void prefetchNextBlock();
+
   void markDirty();
 
 protected:
@@ -196,6 +196,15 @@ pqSpreadSheetViewWidget::pqSpreadSheetViewWidget(QWidget* parentObject)
   QObject::connect(
     this->horizontalHeader(), SIGNAL(sectionDoubleClicked(int)),
     this, SLOT(onSectionDoubleClicked(int)), Qt::QueuedConnection);
+
+  // Clicking on a header sorts by that column. We don't use
+  // setSortingEnabled() since it sorts right away by the first column.
+  this->horizontalHeader()->setClickable(true);
+  this->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+  this->horizontalHeader()->setSortIndicatorShown(true);
+  QObject::connect(
+    this->horizontalHeader(), SIGNAL(sortIndicatorChanged(int, Qt::SortOrder)),
+    this, SLOT(onSortIndicatorChanged(int, Qt::SortOrder)));
 }
 
 //-----------------------------------------------------------------------------
@@ -239,6 +248,16 @@ void pqSpreadSheetViewWidget::paintEvent(QPaintEvent* pevent)
     }
 }
 
+//-----------------------------------------------------------------------------
+void pqSpreadSheetViewWidget::onSortIndicatorChanged(int section,
+  Qt::SortOrder order)
+{
+  if (this->model())
+    {
+    this->model()->sort(section, order);
+    }
+}
+
 //-----------------------------------------------------------------------------
 /// Called when user double clicks on a column header.
 void pqSpreadSheetViewWidget::onSectionDoubleClicked(int logicalindex)
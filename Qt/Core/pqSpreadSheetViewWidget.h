@@ -65,6 +65,10 @@ protected slots:
   /// being stretched over the full view for better viewing.
   void onSectionDoubleClicked(int);
 
+  /// called when a header section is clicked to change the sort order. The
+  /// rows are sorted on the server by the model.
+  void onSortIndicatorChanged(int, Qt::SortOrder);
+
 protected:
   /// Overridden to tell the pqSpreadSheetViewModel about the active viewport.
   virtual void paintEvent(QPaintEvent* event);
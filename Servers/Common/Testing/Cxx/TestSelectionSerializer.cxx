@@ -0,0 +1,172 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestSelectionSerializer.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkInformation.h"
+#include "vtkIntArray.h"
+#include "vtkSelection.h"
+#include "vtkSelectionNode.h"
+#include "vtkSelectionSerializer.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <vtksys/ios/sstream>
+
+static vtkSelectionNode* AddNode(vtkSelection* sel, int contentType,
+  vtkAbstractArray* list)
+{
+  vtkSmartPointer<vtkSelectionNode> node =
+    vtkSmartPointer<vtkSelectionNode>::New();
+  node->SetContentType(contentType);
+  node->SetFieldType(vtkSelectionNode::CELL);
+  node->SetSelectionList(list);
+  sel->AddNode(node);
+  return node;
+}
+
+// Compares the values of the selection lists of two nodes.
+static int CompareLists(vtkSelectionNode* a, vtkSelectionNode* b)
+{
+  vtkAbstractArray* listA = a->GetSelectionList();
+  vtkAbstractArray* listB = b->GetSelectionList();
+  if (!listA || !listB ||
+    listA->GetDataType() != listB->GetDataType() ||
+    listA->GetNumberOfTuples() != listB->GetNumberOfTuples() ||
+    listA->GetNumberOfComponents() != listB->GetNumberOfComponents() ||
+    strcmp(listA->GetName(), listB->GetName()) != 0)
+    {
+    cerr << "The selection lists differ." << endl;
+    return 1;
+    }
+  vtkIdType numValues =
+    listA->GetNumberOfTuples()*listA->GetNumberOfComponents();
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    if (listA->GetVariantValue(i) != listB->GetVariantValue(i))
+      {
+      cerr << "Value " << i << " of " << listA->GetName() << " differs."
+           << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+/// Packs a selection and parses it back.
+int main(int, char*[])
+{
+  vtkSmartPointer<vtkSelection> sel = vtkSmartPointer<vtkSelection>::New();
+
+  // Dense sorted ids, stored as a bit set.
+  vtkSmartPointer<vtkIdTypeArray> ids = vtkSmartPointer<vtkIdTypeArray>::New();
+  ids->SetName("Ids");
+  for (vtkIdType id = 1000; id < 200000; id += (id % 3) + 1)
+    {
+    ids->InsertNextValue(id);
+    }
+  vtkSelectionNode* node = AddNode(sel, vtkSelectionNode::INDICES, ids);
+  node->GetProperties()->Set(vtkSelectionNode::PROCESS_ID(), 3);
+  node->GetProperties()->Set(vtkSelectionNode::COMPOSITE_INDEX(), 7);
+
+  // Unsorted global ids with negative values, stored as deltas.
+  vtkSmartPointer<vtkIntArray> globalIds = vtkSmartPointer<vtkIntArray>::New();
+  globalIds->SetName("GlobalIds");
+  for (int i = 0; i < 1000; ++i)
+    {
+    globalIds->InsertNextValue((i * 7919) % 2003 - 1000);
+    }
+  node = AddNode(sel, vtkSelectionNode::GLOBALIDS, globalIds);
+  node->GetProperties()->Set(vtkSelectionNode::INVERSE(), 1);
+
+  // Thresholds, stored as raw values.
+  vtkSmartPointer<vtkDoubleArray> ranges =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  ranges->SetName("Pressure");
+  ranges->SetNumberOfComponents(2);
+  ranges->InsertNextTuple2(-1.5, 2.25);
+  ranges->InsertNextTuple2(1e30, 1e300);
+  node = AddNode(sel, vtkSelectionNode::THRESHOLDS, ranges);
+  node->GetProperties()->Set(vtkSelectionNode::EPSILON(), 0.125);
+
+  vtkSmartPointer<vtkStringArray> names =
+    vtkSmartPointer<vtkStringArray>::New();
+  names->SetName("Names");
+  names->InsertNextValue("first");
+  names->InsertNextValue("");
+  names->InsertNextValue("third value");
+  AddNode(sel, vtkSelectionNode::VALUES, names);
+
+  vtkSmartPointer<vtkUnsignedCharArray> buffer =
+    vtkSmartPointer<vtkUnsignedCharArray>::New();
+  vtkSelectionSerializer::PrintBinary(sel, buffer);
+
+  vtksys_ios::ostringstream xml;
+  vtkSelectionSerializer::PrintXML(xml, vtkIndent(), 1, sel);
+  if (buffer->GetNumberOfTuples() * 10 > static_cast<vtkIdType>(xml.str().size()))
+    {
+    cerr << "The binary selection takes " << buffer->GetNumberOfTuples()
+         << " bytes and the xml " << xml.str().size() << endl;
+    return 1;
+    }
+
+  vtkSmartPointer<vtkSelection> result = vtkSmartPointer<vtkSelection>::New();
+  if (!vtkSelectionSerializer::ParseBinary(buffer, result))
+    {
+    cerr << "The binary selection could not be parsed." << endl;
+    return 1;
+    }
+  if (result->GetNumberOfNodes() != sel->GetNumberOfNodes())
+    {
+    cerr << "Wrong number of nodes." << endl;
+    return 1;
+    }
+  for (unsigned int cc = 0; cc < sel->GetNumberOfNodes(); ++cc)
+    {
+    vtkSelectionNode* a = sel->GetNode(cc);
+    vtkSelectionNode* b = result->GetNode(cc);
+    if (a->GetContentType() != b->GetContentType() ||
+      a->GetFieldType() != b->GetFieldType())
+      {
+      cerr << "The properties of node " << cc << " differ." << endl;
+      return 1;
+      }
+    if (CompareLists(a, b))
+      {
+      return 1;
+      }
+    }
+  vtkInformation* properties = result->GetNode(0)->GetProperties();
+  if (properties->Get(vtkSelectionNode::PROCESS_ID()) != 3 ||
+    properties->Get(vtkSelectionNode::COMPOSITE_INDEX()) != 7 ||
+    result->GetNode(1)->GetProperties()->Get(vtkSelectionNode::INVERSE()) != 1 ||
+    result->GetNode(2)->GetProperties()->Get(vtkSelectionNode::EPSILON()) !=
+    0.125)
+    {
+    cerr << "Properties were not restored." << endl;
+    return 1;
+    }
+
+  // A truncated buffer must be rejected.
+  if (vtkSelectionSerializer::ParseBinary(buffer->GetPointer(0),
+      buffer->GetNumberOfTuples() / 2, result) ||
+    result->GetNumberOfNodes() != 0)
+    {
+    cerr << "A truncated buffer was accepted." << endl;
+    return 1;
+    }
+  return 0;
+}
@@ -80,6 +80,7 @@ vtkPVOptions::vtkPVOptions()
   this->SetStereoType("Red-Blue");
 
   this->Timeout = 0;
+  this->NumberOfThreads = 1;
 
   if (this->XMLParser)
     {
@@ -215,6 +216,10 @@ void vtkPVOptions::Initialize()
                     "after which the server may timeout. The client typically shows warning "
                     "messages before the server times out.",
                     vtkPVOptions::PVDATA_SERVER|vtkPVOptions::PVSERVER);
+
+  this->AddArgument("--number-of-threads", 0, &this->NumberOfThreads,
+                    "Maximum number of threads each process may use for "
+                    "threaded filters (default 1).");
  
   // Disabling for now since we don't support Cave anymore.
   // this->AddArgument("--cave-configuration", "-cc", &this->CaveConfigurationFileName,
@@ -394,6 +399,7 @@ void vtkPVOptions::PrintSelf(ostream& os, vtkIndent indent)
     }
 
   os << indent << "Timeout: " << this->Timeout << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
   os << indent << "Software Rendering: " << (this->UseSoftwareRendering?"Enabled":"Disabled") << endl;
 
   os << indent << "Satellite Software Rendering: " << (this->UseSatelliteSoftwareRendering?"Enabled":"Disabled") << endl;
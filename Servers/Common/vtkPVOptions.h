@@ -85,6 +85,12 @@ public:
   // server may timeout. timeout <= 0 means no timeout.
   vtkGetMacro(Timeout, int);
 
+  // Description:
+  // Maximum number of threads a process may use for threaded filters
+  // (vtkMultiThreader). Default is 1, since there is typically one process per
+  // core.
+  vtkGetMacro(NumberOfThreads, int);
+
   // Description:
   // Clients need to set the ConnectID so they can handle server connections
   // after the client has started.
@@ -202,6 +208,7 @@ private:
   int TileMullions[2];
   int UseRenderingGroup;
   int Timeout;
+  int NumberOfThreads;
 
   
   char* RenderModuleName;
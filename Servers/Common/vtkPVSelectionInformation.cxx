@@ -23,7 +23,7 @@
 #include "vtkSelectionNode.h"
 #include "vtkSelectionSerializer.h"
 #include "vtkSmartPointer.h"
-#include "vtksys/ios/sstream"
+#include "vtkUnsignedCharArray.h"
 
 vtkStandardNewMacro(vtkPVSelectionInformation);
 
@@ -111,10 +111,11 @@ void vtkPVSelectionInformation::CopyToStream(vtkClientServerStream* css)
   css->Reset();
   *css << vtkClientServerStream::Reply;
 
-  vtksys_ios::ostringstream res;
-  vtkSelectionSerializer::PrintXML(res, vtkIndent(), 1, this->Selection);
-  res << ends;
-  *css << res.str().c_str();
+  vtkUnsignedCharArray* buffer = vtkUnsignedCharArray::New();
+  vtkSelectionSerializer::PrintBinary(this->Selection, buffer);
+  *css << vtkClientServerStream::InsertArray(buffer->GetPointer(0),
+    static_cast<int>(buffer->GetNumberOfTuples()));
+  buffer->Delete();
 
   *css << vtkClientServerStream::End;
 }
@@ -124,12 +125,9 @@ void vtkPVSelectionInformation::CopyFromStream(const vtkClientServerStream* css)
 {
   this->Initialize();
 
-  const char* xml = 0;
-  if(!css->GetArgument(0, 0, &xml))
+  if (!vtkSelectionSerializer::ParseBinary(*css, this->Selection))
     {
-    vtkErrorMacro("Error parsing selection xml from message.");
-    return;
+    vtkErrorMacro("Error parsing selection from message.");
     }
-  vtkSelectionSerializer::Parse(xml, this->Selection);
 }
 
@@ -943,7 +943,9 @@ void vtkProcessModule::InitializeInterpreter()
     {
     return;
     }
-  vtkMultiThreader::SetGlobalMaximumNumberOfThreads(1);
+  int numThreads = this->Options? this->Options->GetNumberOfThreads() : 1;
+  vtkMultiThreader::SetGlobalMaximumNumberOfThreads(
+    numThreads > 1? numThreads : 1);
 
   // Create the interpreter and supporting stream.
   this->Interpreter = vtkClientServerInterpreter::New();
@@ -14,6 +14,8 @@
 =========================================================================*/
 #include "vtkSelectionSerializer.h"
 
+#include "vtkByteSwap.h"
+#include "vtkClientServerStream.h"
 #include "vtkDataArray.h"
 #include "vtkDataSetAttributes.h"
 #include "vtkInformation.h"
@@ -31,6 +33,10 @@
 #include "vtkSelection.h"
 #include "vtkSelectionNode.h"
 #include "vtkStringArray.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <vtkstd/string>
+#include <vtkstd/vector>
 
 vtkStandardNewMacro(vtkSelectionSerializer);
 
@@ -428,6 +434,612 @@ void vtkSelectionSerializer::ParseNode(vtkPVXMLElement* nodeXML,
     }
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+// The binary format starts with these bytes, followed by a version byte and
+// a byte that is 1 if the writer was big endian.
+const unsigned char vtkSSBinaryMagic[4] = { 'P', 'V', 'S', 'B' };
+const unsigned char vtkSSBinaryVersion = 1;
+
+// How the values of a selection list are stored.
+enum
+{
+  vtkSSRawValues = 0,
+  vtkSSDeltaValues = 1,
+  vtkSSBitSet = 2,
+  vtkSSStringValues = 3
+};
+
+// Types of the property values.
+enum
+{
+  vtkSSIntegerProperty = 0,
+  vtkSSDoubleProperty = 1
+};
+
+//----------------------------------------------------------------------------
+// Returns the property key with the given name if it is one of the keys
+// supported by the serializer.
+vtkInformationKey* vtkSSGetKey(const vtkstd::string& name)
+{
+  if (name == "CONTENT_TYPE") { return vtkSelectionNode::CONTENT_TYPE(); }
+  if (name == "FIELD_TYPE") { return vtkSelectionNode::FIELD_TYPE(); }
+  if (name == "SOURCE_ID") { return vtkSelectionNode::SOURCE_ID(); }
+  if (name == "ORIGINAL_SOURCE_ID")
+    {
+    return vtkSelectionSerializer::ORIGINAL_SOURCE_ID();
+    }
+  if (name == "PROP_ID") { return vtkSelectionNode::PROP_ID(); }
+  if (name == "PROCESS_ID") { return vtkSelectionNode::PROCESS_ID(); }
+  if (name == "EPSILON") { return vtkSelectionNode::EPSILON(); }
+  if (name == "CONTAINING_CELLS") { return vtkSelectionNode::CONTAINING_CELLS(); }
+  if (name == "INVERSE") { return vtkSelectionNode::INVERSE(); }
+  if (name == "PIXEL_COUNT") { return vtkSelectionNode::PIXEL_COUNT(); }
+  if (name == "INDEXED_VERTICES") { return vtkSelectionNode::INDEXED_VERTICES(); }
+  if (name == "COMPOSITE_INDEX") { return vtkSelectionNode::COMPOSITE_INDEX(); }
+  if (name == "HIERARCHICAL_LEVEL")
+    {
+    return vtkSelectionNode::HIERARCHICAL_LEVEL();
+    }
+  if (name == "HIERARCHICAL_INDEX")
+    {
+    return vtkSelectionNode::HIERARCHICAL_INDEX();
+    }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+// Appends values to a byte buffer. Fixed size values are written in the
+// native byte order.
+class vtkSSWriter
+{
+public:
+  vtkstd::vector<unsigned char> Data;
+
+  void WriteBytes(const void* data, size_t length)
+    {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    this->Data.insert(this->Data.end(), bytes, bytes + length);
+    }
+
+  template <class T>
+  void Write(T value)
+    {
+    this->WriteBytes(&value, sizeof(T));
+    }
+
+  // Seven bits per byte, lowest bits first.
+  void WriteVarint(vtkTypeUInt64 value)
+    {
+    while (value >= 0x80)
+      {
+      this->Data.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+      }
+    this->Data.push_back(static_cast<unsigned char>(value));
+    }
+
+  void WriteString(const char* str)
+    {
+    size_t length = str? strlen(str) : 0;
+    this->WriteVarint(length);
+    this->WriteBytes(str, length);
+    }
+};
+
+//----------------------------------------------------------------------------
+// Reads values written by vtkSSWriter. Every read fails once the end of the
+// buffer is reached.
+class vtkSSReader
+{
+public:
+  const unsigned char* Data;
+  const unsigned char* End;
+  bool Swap;
+
+  vtkSSReader(const unsigned char* data, vtkIdType length)
+    : Data(data), End(data + length), Swap(false) {}
+
+  size_t GetRemaining() const
+    {
+    return static_cast<size_t>(this->End - this->Data);
+    }
+
+  bool ReadBytes(void* data, size_t length)
+    {
+    if (this->GetRemaining() < length)
+      {
+      return false;
+      }
+    memcpy(data, this->Data, length);
+    this->Data += length;
+    return true;
+    }
+
+  template <class T>
+  bool Read(T& value)
+    {
+    if (!this->ReadBytes(&value, sizeof(T)))
+      {
+      return false;
+      }
+    if (this->Swap)
+      {
+      vtkByteSwap::SwapVoidRange(&value, 1, static_cast<int>(sizeof(T)));
+      }
+    return true;
+    }
+
+  bool ReadVarint(vtkTypeUInt64& value)
+    {
+    value = 0;
+    for (int shift = 0; shift < 64 && this->Data < this->End; shift += 7)
+      {
+      unsigned char byte = *this->Data++;
+      value |= static_cast<vtkTypeUInt64>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        {
+        return true;
+        }
+      }
+    return false;
+    }
+
+  bool ReadString(vtkstd::string& str)
+    {
+    vtkTypeUInt64 length;
+    if (!this->ReadVarint(length) || length > this->GetRemaining())
+      {
+      return false;
+      }
+    str.assign(reinterpret_cast<const char*>(this->Data),
+      static_cast<size_t>(length));
+    this->Data += length;
+    return true;
+    }
+};
+
+//----------------------------------------------------------------------------
+// Deltas between consecutive values are stored zigzag encoded so that small
+// negative deltas stay small.
+inline vtkTypeUInt64 vtkSSZigZag(vtkTypeUInt64 delta)
+{
+  return (delta << 1) ^ static_cast<vtkTypeUInt64>(
+    static_cast<vtkTypeInt64>(delta) >> 63);
+}
+
+inline vtkTypeUInt64 vtkSSUnZigZag(vtkTypeUInt64 value)
+{
+  return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+//----------------------------------------------------------------------------
+// Writes integer values as deltas, or as a bit set when they are strictly
+// increasing and the bit set is smaller.
+template <class T>
+void vtkSSWriteIntegers(vtkSSWriter& writer, const T* data, vtkIdType numValues,
+  bool allowBitSet)
+{
+  vtkSSWriter deltas;
+  bool increasing = true;
+  vtkTypeUInt64 previous = 0;
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    vtkTypeUInt64 value = static_cast<vtkTypeUInt64>(data[i]);
+    deltas.WriteVarint(::vtkSSZigZag(value - previous));
+    increasing = increasing && (i == 0 || data[i] > data[i-1]);
+    previous = value;
+    }
+
+  if (allowBitSet && increasing && numValues > 0)
+    {
+    vtkTypeUInt64 first = static_cast<vtkTypeUInt64>(data[0]);
+    vtkTypeUInt64 range = previous - first;
+    if (range/8 + 1 < deltas.Data.size())
+      {
+      vtkTypeUInt64 numBits = range + 1;
+      vtkTypeUInt64 numBytes = (numBits + 7)/8;
+      writer.Write(static_cast<unsigned char>(vtkSSBitSet));
+      writer.WriteVarint(first);
+      writer.WriteVarint(numBits);
+      vtkstd::vector<unsigned char> bits(static_cast<size_t>(numBytes), 0);
+      for (vtkIdType i = 0; i < numValues; ++i)
+        {
+        vtkTypeUInt64 bit = static_cast<vtkTypeUInt64>(data[i]) - first;
+        bits[static_cast<size_t>(bit/8)] |=
+          static_cast<unsigned char>(1 << (bit%8));
+        }
+      writer.WriteBytes(&bits[0], bits.size());
+      return;
+      }
+    }
+
+  writer.Write(static_cast<unsigned char>(vtkSSDeltaValues));
+  if (!deltas.Data.empty())
+    {
+    writer.WriteBytes(&deltas.Data[0], deltas.Data.size());
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkSSWriteValues(vtkSSWriter& writer, const T* data, vtkIdType numValues,
+  int dataType, int numComps)
+{
+  if (dataType == VTK_FLOAT || dataType == VTK_DOUBLE)
+    {
+    writer.Write(static_cast<unsigned char>(vtkSSRawValues));
+    writer.WriteBytes(data, numValues*sizeof(T));
+    }
+  else
+    {
+    ::vtkSSWriteIntegers(writer, data, numValues, numComps == 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+bool vtkSSReadValues(vtkSSReader& reader, int encoding, T* data,
+  vtkIdType numValues)
+{
+  switch (encoding)
+    {
+  case vtkSSRawValues:
+    if (!reader.ReadBytes(data, numValues*sizeof(T)))
+      {
+      return false;
+      }
+    if (reader.Swap && sizeof(T) > 1)
+      {
+      vtkByteSwap::SwapVoidRange(data, static_cast<int>(numValues),
+        static_cast<int>(sizeof(T)));
+      }
+    return true;
+
+  case vtkSSDeltaValues:
+    {
+    vtkTypeUInt64 value = 0;
+    for (vtkIdType i = 0; i < numValues; ++i)
+      {
+      vtkTypeUInt64 delta;
+      if (!reader.ReadVarint(delta))
+        {
+        return false;
+        }
+      value += ::vtkSSUnZigZag(delta);
+      data[i] = static_cast<T>(value);
+      }
+    return true;
+    }
+
+  case vtkSSBitSet:
+    {
+    vtkTypeUInt64 first, numBits;
+    if (!reader.ReadVarint(first) || !reader.ReadVarint(numBits) ||
+      numBits > 8*static_cast<vtkTypeUInt64>(reader.GetRemaining()))
+      {
+      return false;
+      }
+    const unsigned char* bits = reader.Data;
+    reader.Data += (numBits + 7)/8;
+    vtkIdType i = 0;
+    for (vtkTypeUInt64 bit = 0; bit < numBits; ++bit)
+      {
+      if (bits[bit/8] & (1 << (bit%8)))
+        {
+        if (i == numValues)
+          {
+          return false;
+          }
+        data[i++] = static_cast<T>(first + bit);
+        }
+      }
+    return i == numValues;
+    }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkSSWriteNode(vtkSSWriter& writer, vtkSelectionNode* node)
+{
+  vtkInformation* properties = node->GetProperties();
+  vtkstd::vector<vtkInformationKey*> keys;
+  vtkInformationIterator* iter = vtkInformationIterator::New();
+  iter->SetInformation(properties);
+  for (iter->GoToFirstItem(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem())
+    {
+    vtkInformationKey* key = iter->GetCurrentKey();
+    if (::vtkSSGetKey(key->GetName()) == key)
+      {
+      keys.push_back(key);
+      }
+    }
+  iter->Delete();
+
+  writer.WriteVarint(keys.size());
+  for (size_t cc = 0; cc < keys.size(); ++cc)
+    {
+    writer.WriteString(keys[cc]->GetName());
+    if (keys[cc]->IsA("vtkInformationDoubleKey"))
+      {
+      writer.Write(static_cast<unsigned char>(vtkSSDoubleProperty));
+      writer.Write(properties->Get(
+          static_cast<vtkInformationDoubleKey*>(keys[cc])));
+      }
+    else
+      {
+      writer.Write(static_cast<unsigned char>(vtkSSIntegerProperty));
+      writer.Write(static_cast<vtkTypeInt32>(properties->Get(
+            static_cast<vtkInformationIntegerKey*>(keys[cc]))));
+      }
+    }
+
+  vtkDataSetAttributes* data = node->GetSelectionData();
+  vtkstd::vector<vtkAbstractArray*> arrays;
+  for (int i = 0; i < data->GetNumberOfArrays(); i++)
+    {
+    vtkAbstractArray* array = data->GetAbstractArray(i);
+    if (vtkDataArray::SafeDownCast(array) || vtkStringArray::SafeDownCast(array))
+      {
+      arrays.push_back(array);
+      }
+    }
+
+  writer.WriteVarint(arrays.size());
+  for (size_t cc = 0; cc < arrays.size(); ++cc)
+    {
+    vtkAbstractArray* array = arrays[cc];
+    vtkIdType numValues =
+      array->GetNumberOfTuples()*array->GetNumberOfComponents();
+    writer.WriteVarint(array->GetDataType());
+    writer.WriteString(array->GetName());
+    writer.WriteVarint(array->GetNumberOfComponents());
+    writer.WriteVarint(array->GetNumberOfTuples());
+
+    vtkStringArray* strings = vtkStringArray::SafeDownCast(array);
+    if (strings)
+      {
+      writer.Write(static_cast<unsigned char>(vtkSSStringValues));
+      for (vtkIdType i = 0; i < numValues; ++i)
+        {
+        writer.WriteString(strings->GetValue(i).c_str());
+        }
+      continue;
+      }
+
+    void* dataPtr = array->GetVoidPointer(0);
+    switch (array->GetDataType())
+      {
+      vtkTemplateMacro(::vtkSSWriteValues(writer,
+          static_cast<VTK_TT*>(dataPtr), numValues, array->GetDataType(),
+          array->GetNumberOfComponents()));
+    default:
+      // Unknown types are sent as an empty array.
+      writer.Write(static_cast<unsigned char>(vtkSSRawValues));
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSSReadNode(vtkSSReader& reader, vtkSelectionNode* node)
+{
+  vtkTypeUInt64 numProperties;
+  if (!reader.ReadVarint(numProperties))
+    {
+    return false;
+    }
+  vtkInformation* properties = node->GetProperties();
+  for (vtkTypeUInt64 cc = 0; cc < numProperties; ++cc)
+    {
+    vtkstd::string name;
+    unsigned char type;
+    if (!reader.ReadString(name) || !reader.Read(type))
+      {
+      return false;
+      }
+    vtkInformationKey* key = ::vtkSSGetKey(name);
+    if (type == vtkSSDoubleProperty)
+      {
+      double value;
+      if (!reader.Read(value))
+        {
+        return false;
+        }
+      if (key && key->IsA("vtkInformationDoubleKey"))
+        {
+        properties->Set(static_cast<vtkInformationDoubleKey*>(key), value);
+        }
+      }
+    else
+      {
+      vtkTypeInt32 value;
+      if (!reader.Read(value))
+        {
+        return false;
+        }
+      if (key && key->IsA("vtkInformationIntegerKey"))
+        {
+        properties->Set(static_cast<vtkInformationIntegerKey*>(key), value);
+        }
+      }
+    }
+
+  vtkTypeUInt64 numArrays;
+  if (!reader.ReadVarint(numArrays))
+    {
+    return false;
+    }
+  for (vtkTypeUInt64 cc = 0; cc < numArrays; ++cc)
+    {
+    vtkTypeUInt64 dataType, numComps, numTuples;
+    vtkstd::string name;
+    unsigned char encoding;
+    if (!reader.ReadVarint(dataType) || !reader.ReadString(name) ||
+      !reader.ReadVarint(numComps) || !reader.ReadVarint(numTuples) ||
+      !reader.Read(encoding))
+      {
+      return false;
+      }
+    // Every value takes at least a byte, or a bit in bit sets.
+    vtkTypeUInt64 maxValues = reader.GetRemaining();
+    if (encoding == vtkSSBitSet)
+      {
+      maxValues *= 8;
+      }
+    if (numComps == 0 || numComps > VTK_INT_MAX ||
+      numTuples > maxValues/numComps)
+      {
+      return false;
+      }
+    vtkTypeUInt64 numValues = numComps*numTuples;
+
+    vtkAbstractArray* array =
+      vtkAbstractArray::CreateArray(static_cast<int>(dataType));
+    if (!array)
+      {
+      return false;
+      }
+    array->SetName(name.c_str());
+    array->SetNumberOfComponents(static_cast<int>(numComps));
+    array->SetNumberOfTuples(static_cast<vtkIdType>(numTuples));
+
+    bool valid = true;
+    vtkStringArray* strings = vtkStringArray::SafeDownCast(array);
+    if (strings)
+      {
+      for (vtkIdType i = 0; valid && i < static_cast<vtkIdType>(numValues);
+        ++i)
+        {
+        vtkstd::string value;
+        valid = (encoding == vtkSSStringValues) && reader.ReadString(value);
+        strings->SetValue(i, value);
+        }
+      }
+    else if (vtkDataArray::SafeDownCast(array))
+      {
+      void* dataPtr = array->GetVoidPointer(0);
+      switch (array->GetDataType())
+        {
+        vtkTemplateMacro(valid = ::vtkSSReadValues(reader, encoding,
+            static_cast<VTK_TT*>(dataPtr),
+            static_cast<vtkIdType>(numValues)));
+      default:
+        valid = false;
+        }
+      }
+    else
+      {
+      valid = false;
+      }
+
+    if (valid)
+      {
+      node->GetSelectionData()->AddArray(array);
+      }
+    array->Delete();
+    if (!valid)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+//----------------------------------------------------------------------------
+void vtkSelectionSerializer::PrintBinary(vtkSelection* selection,
+                                         vtkUnsignedCharArray* buffer)
+{
+  vtkSSWriter writer;
+  writer.WriteBytes(vtkSSBinaryMagic, sizeof(vtkSSBinaryMagic));
+  writer.Write(vtkSSBinaryVersion);
+#ifdef VTK_WORDS_BIGENDIAN
+  writer.Write(static_cast<unsigned char>(1));
+#else
+  writer.Write(static_cast<unsigned char>(0));
+#endif
+
+  unsigned int numNodes = selection->GetNumberOfNodes();
+  writer.WriteVarint(numNodes);
+  for (unsigned int i = 0; i < numNodes; i++)
+    {
+    ::vtkSSWriteNode(writer, selection->GetNode(i));
+    }
+
+  buffer->SetNumberOfComponents(1);
+  buffer->SetNumberOfTuples(static_cast<vtkIdType>(writer.Data.size()));
+  memcpy(buffer->GetPointer(0), &writer.Data[0], writer.Data.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkSelectionSerializer::ParseBinary(vtkUnsignedCharArray* buffer,
+                                        vtkSelection* root)
+{
+  return vtkSelectionSerializer::ParseBinary(buffer->GetPointer(0),
+    buffer->GetNumberOfTuples()*buffer->GetNumberOfComponents(), root);
+}
+
+//----------------------------------------------------------------------------
+int vtkSelectionSerializer::ParseBinary(const vtkClientServerStream& css,
+                                        vtkSelection* root)
+{
+  vtkTypeUInt32 length = 0;
+  if (!css.GetArgumentLength(0, 0, &length))
+    {
+    root->Initialize();
+    return 0;
+    }
+  vtkstd::vector<unsigned char> data(length + 1);
+  css.GetArgument(0, 0, &data[0], length);
+  return vtkSelectionSerializer::ParseBinary(&data[0], length, root);
+}
+
+//----------------------------------------------------------------------------
+int vtkSelectionSerializer::ParseBinary(const unsigned char* data,
+                                        vtkIdType length,
+                                        vtkSelection* root)
+{
+  root->Initialize();
+
+  vtkSSReader reader(data, length);
+  unsigned char magic[sizeof(vtkSSBinaryMagic)];
+  unsigned char version, bigEndian;
+  if (!data || !reader.ReadBytes(magic, sizeof(magic)) ||
+    memcmp(magic, vtkSSBinaryMagic, sizeof(magic)) != 0 ||
+    !reader.Read(version) || version != vtkSSBinaryVersion ||
+    !reader.Read(bigEndian))
+    {
+    return 0;
+    }
+#ifdef VTK_WORDS_BIGENDIAN
+  reader.Swap = (bigEndian == 0);
+#else
+  reader.Swap = (bigEndian != 0);
+#endif
+
+  vtkTypeUInt64 numNodes;
+  if (!reader.ReadVarint(numNodes))
+    {
+    return 0;
+    }
+  for (vtkTypeUInt64 i = 0; i < numNodes; i++)
+    {
+    vtkSelectionNode* newNode = vtkSelectionNode::New();
+    bool valid = ::vtkSSReadNode(reader, newNode);
+    root->AddNode(newNode);
+    newNode->Delete();
+    if (!valid)
+      {
+      root->Initialize();
+      return 0;
+      }
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkSelectionSerializer::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -18,6 +18,13 @@
 // serialize/deserialize vtkSelection to/from xml. Currently, it
 // supports only a subset of properties: CONTENT_TYPE, SOURCE_ID,
 // PROP_ID, PROCESS_ID, ORIGINAL_SOURCE_ID
+//
+// Selections can also be packed into a compact binary buffer, which is what
+// is used to move selections between processes. Sorted integer selection
+// lists, such as ids, are stored as variable length deltas or as bit sets,
+// whichever is smaller. The buffer records the byte order of the process
+// that wrote it so that it can be read on any process. XML is meant for
+// state files.
 // .SECTION See Also
 // vtkSelection
 
@@ -26,10 +33,12 @@
 
 #include "vtkObject.h"
 
+class vtkClientServerStream;
 class vtkInformationIntegerKey;
 class vtkPVXMLElement;
 class vtkSelection;
 class vtkSelectionNode;
+class vtkUnsignedCharArray;
 
 class VTK_EXPORT vtkSelectionSerializer : public vtkObject
 {
@@ -54,6 +63,24 @@ public:
   // properties: CONTENT_TYPE, SOURCE_ID, PROP_ID, PROCESS_ID
   static void Parse(const char* xml, vtkSelection* root);
 
+  // Description:
+  // Pack the selection tree into a binary buffer. The same subset of
+  // properties as with xml is supported.
+  static void PrintBinary(vtkSelection* selection,
+                          vtkUnsignedCharArray* buffer);
+
+  // Description:
+  // Create a new selection tree from a buffer filled by PrintBinary(). The
+  // stream version expects the buffer as the first argument of the first
+  // message of the stream. Returns 0 if the buffer is not a valid selection,
+  // in which case root is left empty.
+  static int ParseBinary(vtkUnsignedCharArray* buffer, vtkSelection* root);
+  static int ParseBinary(const vtkClientServerStream& css, vtkSelection* root);
+//BTX
+  static int ParseBinary(const unsigned char* data, vtkIdType length,
+                         vtkSelection* root);
+//ETX
+
   // Description:
   // ID of the dataset or algorithm that the selection belongs to. What
   // ID means is application specific.
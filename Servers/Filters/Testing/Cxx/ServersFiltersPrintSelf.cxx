@@ -37,6 +37,7 @@
 #include "vtkMultiViewManager.h"
 #include "vtkNetworkImageSource.h"
 #include "vtkOrderedCompositeDistributor.h"
+#include "vtkPCSVWriter.h"
 #include "vtkPExtractHistogram.h"
 #include "vtkPhastaReader.h"
 #include "vtkPPhastaReader.h"
@@ -147,6 +148,7 @@ int main(int , char *[])
   c = vtkMultiViewManager::New(); c->Print(cout); c->Delete();
   c = vtkNetworkImageSource::New(); c->Print(cout); c->Delete();
   c = vtkOrderedCompositeDistributor::New(); c->Print(cout); c->Delete();
+  c = vtkPCSVWriter::New(); c->Print(cout); c->Delete();
   c = vtkPExtractHistogram::New(); c->Print(cout); c->Delete();
   c = vtkPhastaReader::New(); c->Print(cout); c->Delete();
   c = vtkPPhastaReader::New(); c->Print(cout); c->Delete();
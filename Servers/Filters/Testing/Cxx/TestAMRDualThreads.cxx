@@ -0,0 +1,225 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestAMRDualThreads.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Contours and clips a two level AMR sphere with merged points on one
+// thread and on several threads, and checks that the outputs have the same
+// points, in the same order, and the same cells.
+
+#include "vtkAMRBox.h"
+#include "vtkAMRDualClip.h"
+#include "vtkAMRDualContour.h"
+#include "vtkCellData.h"
+#include "vtkDataObject.h"
+#include "vtkDataSet.h"
+#include "vtkDoubleArray.h"
+#include "vtkHierarchicalBoxDataSet.h"
+#include "vtkIdList.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiBlockDataSetAlgorithm.h"
+#include "vtkMultiPieceDataSet.h"
+#include "vtkMultiThreader.h"
+#include "vtkSmartPointer.h"
+#include "vtkUniformGrid.h"
+
+#include <math.h>
+
+// Cells of a block, without the ghost layer on each side.
+static const int BlockCells = 8;
+
+// Adds the block of the level at the grid index, with one layer of ghost
+// cells, and the distance to the center of the sphere as cell data.
+static void AddBlock(vtkHierarchicalBoxDataSet* amr, int level,
+                     int ix, int iy, int iz)
+{
+  double spacing = 1.0 / (1 << level);
+  int ext[6];
+  int index[3] = { ix, iy, iz };
+  for (int ii = 0; ii < 3; ++ii)
+    {
+    ext[2*ii] = index[ii] * BlockCells - 1;
+    ext[2*ii+1] = (index[ii] + 1) * BlockCells;
+    }
+
+  vtkSmartPointer<vtkUniformGrid> grid =
+    vtkSmartPointer<vtkUniformGrid>::New();
+  grid->SetSpacing(spacing, spacing, spacing);
+  grid->SetOrigin(ext[0] * spacing, ext[2] * spacing, ext[4] * spacing);
+  grid->SetDimensions(ext[1] - ext[0] + 2, ext[3] - ext[2] + 2,
+                      ext[5] - ext[4] + 2);
+
+  vtkSmartPointer<vtkDoubleArray> density =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  density->SetName("Density");
+  density->SetNumberOfTuples(grid->GetNumberOfCells());
+  vtkIdType cellId = 0;
+  for (int z = ext[4]; z <= ext[5]; ++z)
+    {
+    for (int y = ext[2]; y <= ext[3]; ++y)
+      {
+      for (int x = ext[0]; x <= ext[1]; ++x)
+        {
+        double dx = (x + 0.5) * spacing - 12.0;
+        double dy = (y + 0.5) * spacing - 8.0;
+        double dz = (z + 0.5) * spacing - 8.0;
+        density->SetValue(cellId++, sqrt(dx*dx + dy*dy + dz*dz));
+        }
+      }
+    }
+  grid->GetCellData()->AddArray(density);
+
+  vtkAMRBox box(ext);
+  amr->SetDataSet(level, amr->GetNumberOfDataSets(level), box, grid);
+}
+
+// A 3x2x2 root level with its middle bottom block refined.
+static vtkSmartPointer<vtkHierarchicalBoxDataSet> MakeAMR()
+{
+  vtkSmartPointer<vtkHierarchicalBoxDataSet> amr =
+    vtkSmartPointer<vtkHierarchicalBoxDataSet>::New();
+  for (int z = 0; z < 2; ++z)
+    {
+    for (int y = 0; y < 2; ++y)
+      {
+      for (int x = 0; x < 3; ++x)
+        {
+        AddBlock(amr, 0, x, y, z);
+        }
+      }
+    }
+  for (int z = 0; z < 2; ++z)
+    {
+    for (int y = 0; y < 2; ++y)
+      {
+      for (int x = 2; x < 4; ++x)
+        {
+        AddBlock(amr, 1, x, y, z);
+        }
+      }
+    }
+  amr->SetRefinementRatio(0, 2);
+  return amr;
+}
+
+// Runs the filter with the number of threads and returns a copy of the
+// output piece.
+static vtkSmartPointer<vtkDataSet> Run(vtkMultiBlockDataSetAlgorithm* filter,
+                                       vtkHierarchicalBoxDataSet* amr,
+                                       int numThreads)
+{
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(numThreads);
+  filter->SetInputArrayToProcess(0, 0, 0,
+    vtkDataObject::FIELD_ASSOCIATION_CELLS, "Density");
+  filter->SetInput(amr);
+  filter->Modified();
+  filter->Update();
+  vtkMultiBlockDataSet* output =
+    vtkMultiBlockDataSet::SafeDownCast(filter->GetOutputDataObject(0));
+  vtkMultiPieceDataSet* pieces = output ?
+    vtkMultiPieceDataSet::SafeDownCast(output->GetBlock(0)) : 0;
+  vtkDataSet* piece = pieces ?
+    vtkDataSet::SafeDownCast(pieces->GetPiece(0)) : 0;
+  if (!piece)
+    {
+    return 0;
+    }
+  vtkSmartPointer<vtkDataSet> copy;
+  copy.TakeReference(piece->NewInstance());
+  copy->DeepCopy(piece);
+  return copy;
+}
+
+static int Compare(const char* name, vtkDataSet* expected,
+                   vtkDataSet* actual)
+{
+  if (!expected || !actual)
+    {
+    cerr << name << ": missing output." << endl;
+    return 1;
+    }
+  if (expected->GetNumberOfCells() == 0)
+    {
+    cerr << name << ": the serial output is empty." << endl;
+    return 1;
+    }
+  if (expected->GetNumberOfPoints() != actual->GetNumberOfPoints() ||
+      expected->GetNumberOfCells() != actual->GetNumberOfCells())
+    {
+    cerr << name << ": expected " << expected->GetNumberOfPoints()
+      << " points and " << expected->GetNumberOfCells() << " cells, got "
+      << actual->GetNumberOfPoints() << " points and "
+      << actual->GetNumberOfCells() << " cells." << endl;
+    return 1;
+    }
+  for (vtkIdType ii = 0; ii < expected->GetNumberOfPoints(); ++ii)
+    {
+    double x[3], y[3];
+    expected->GetPoint(ii, x);
+    actual->GetPoint(ii, y);
+    if (x[0] != y[0] || x[1] != y[1] || x[2] != y[2])
+      {
+      cerr << name << ": point " << ii << " differs." << endl;
+      return 1;
+      }
+    }
+  vtkSmartPointer<vtkIdList> expectedIds = vtkSmartPointer<vtkIdList>::New();
+  vtkSmartPointer<vtkIdList> actualIds = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType ii = 0; ii < expected->GetNumberOfCells(); ++ii)
+    {
+    expected->GetCellPoints(ii, expectedIds);
+    actual->GetCellPoints(ii, actualIds);
+    int same = expectedIds->GetNumberOfIds() == actualIds->GetNumberOfIds();
+    for (vtkIdType jj = 0; same && jj < expectedIds->GetNumberOfIds(); ++jj)
+      {
+      same = expectedIds->GetId(jj) == actualIds->GetId(jj);
+      }
+    if (!same)
+      {
+      cerr << name << ": cell " << ii << " differs." << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int main(int, char*[])
+{
+  vtkSmartPointer<vtkHierarchicalBoxDataSet> amr = MakeAMR();
+  int status = 0;
+
+  vtkSmartPointer<vtkAMRDualContour> contour =
+    vtkSmartPointer<vtkAMRDualContour>::New();
+  contour->SetIsoValue(5.3);
+  contour->EnableMergePointsOn();
+  contour->EnableMultiProcessCommunicationOff();
+  vtkSmartPointer<vtkDataSet> serial = Run(contour, amr, 1);
+  for (int numThreads = 2; numThreads <= 5; ++numThreads)
+    {
+    status |= Compare("vtkAMRDualContour", serial,
+                      Run(contour, amr, numThreads));
+    }
+
+  vtkSmartPointer<vtkAMRDualClip> clip =
+    vtkSmartPointer<vtkAMRDualClip>::New();
+  clip->SetIsoValue(5.3);
+  clip->EnableMergePointsOn();
+  clip->EnableDegenerateCellsOn();
+  serial = Run(clip, amr, 1);
+  for (int numThreads = 2; numThreads <= 5; ++numThreads)
+    {
+    status |= Compare("vtkAMRDualClip", serial, Run(clip, amr, numThreads));
+    }
+
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(0);
+  return status;
+}
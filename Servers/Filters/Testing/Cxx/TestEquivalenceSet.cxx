@@ -0,0 +1,97 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestEquivalenceSet.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkEquivalenceSet.h"
+#include "vtkMultiThreader.h"
+#include "vtkSmartPointer.h"
+
+// Members are split in blocks of this size.  Inside a block, even members
+// are equivalent and odd members are equivalent.
+static const int BlockSize = 1000;
+static const int NumberOfMembers = 200 * BlockSize;
+
+static bool AddToSet(int id)
+{
+  return (id + 2) / BlockSize == id / BlockSize;
+}
+
+static VTK_THREAD_RETURN_TYPE AddEquivalences(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkEquivalenceSet* set = static_cast<vtkEquivalenceSet*>(info->UserData);
+  // Interleave the members so that threads work on the same sets.
+  for (int id = NumberOfMembers - 3 - info->ThreadID; id >= 0;
+       id -= info->NumberOfThreads)
+    {
+    if (AddToSet(id))
+      {
+      set->ConcurrentAddEquivalence(id + 2, id);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+static int CheckSets(vtkEquivalenceSet* set, const char* name)
+{
+  int numSets = set->ResolveEquivalences();
+  if (numSets != 2 * NumberOfMembers / BlockSize)
+    {
+    cerr << name << ": wrong number of sets " << numSets << endl;
+    return 1;
+    }
+  for (int id = 0; id < NumberOfMembers; ++id)
+    {
+    // Sets are numbered in the order of their smallest member.
+    int expected = 2 * (id / BlockSize) + id % 2;
+    if (set->GetEquivalentSetId(id) != expected)
+      {
+      cerr << name << ": member " << id << " is in set "
+           << set->GetEquivalentSetId(id) << " instead of " << expected
+           << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+/// Builds the same sets with AddEquivalence and with
+/// ConcurrentAddEquivalence called from several threads.
+int main(int, char*[])
+{
+  vtkSmartPointer<vtkEquivalenceSet> set =
+    vtkSmartPointer<vtkEquivalenceSet>::New();
+  for (int id = NumberOfMembers - 3; id >= 0; --id)
+    {
+    if (AddToSet(id))
+      {
+      set->AddEquivalence(id + 2, id);
+      }
+    }
+  set->AddEquivalence(NumberOfMembers - 1, NumberOfMembers - 1);
+  if (CheckSets(set, "AddEquivalence"))
+    {
+    return 1;
+    }
+
+  set = vtkSmartPointer<vtkEquivalenceSet>::New();
+  set->SetNumberOfMembers(NumberOfMembers);
+  vtkSmartPointer<vtkMultiThreader> threader =
+    vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(4);
+  threader->SetSingleMethod(AddEquivalences, set);
+  threader->SingleMethodExecute();
+  return CheckSets(set, "ConcurrentAddEquivalence");
+}
@@ -13,6 +13,7 @@
 
 =========================================================================*/
 
+#include "vtkBitArray.h"
 #include "vtkCellData.h"
 #include "vtkDoubleArray.h"
 #include "vtkExtractHistogram.h"
@@ -20,6 +21,7 @@
 #include "vtkSmartPointer.h"
 #include "vtkSphereSource.h"
 #include "vtkIntArray.h"
+#include "vtkStringArray.h"
 
 /// Test the output of the vtkExtractHistogram filter in a simple serial case
 int main(int, char*[])
@@ -92,5 +94,78 @@ int main(int, char*[])
     vtkGenericWarningMacro("incorrect bin value.");
     return 1;
     }
+
+  // Test a table large enough to be binned by multiple threads, with averages
+  // of other arrays. The bit array is averaged with the generic API, the
+  // string array has no average.
+  const int num_values = 1000000;
+  const int large_bin_count = 10;
+  vtkSmartPointer<vtkDoubleArray> values = vtkSmartPointer<vtkDoubleArray>::New();
+  values->SetName("values");
+  values->SetNumberOfTuples(num_values);
+  vtkSmartPointer<vtkIntArray> doubled = vtkSmartPointer<vtkIntArray>::New();
+  doubled->SetName("doubled");
+  doubled->SetNumberOfTuples(num_values);
+  vtkSmartPointer<vtkBitArray> odd = vtkSmartPointer<vtkBitArray>::New();
+  odd->SetName("odd");
+  odd->SetNumberOfTuples(num_values);
+  vtkSmartPointer<vtkStringArray> labels =
+    vtkSmartPointer<vtkStringArray>::New();
+  labels->SetName("labels");
+  labels->SetNumberOfTuples(num_values);
+  for (int i = 0; i < num_values; i++)
+    {
+    values->SetValue(i, i);
+    doubled->SetValue(i, 2*(i % 2));
+    odd->SetValue(i, i % 2);
+    labels->SetValue(i, (i % 2) ? "odd" : "even");
+    }
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  table->GetRowData()->AddArray(values);
+  table->GetRowData()->AddArray(doubled);
+  table->GetRowData()->AddArray(odd);
+  table->GetRowData()->AddArray(labels);
+
+  vtkSmartPointer<vtkExtractHistogram> large_extraction =
+    vtkSmartPointer<vtkExtractHistogram>::New();
+  large_extraction->SetInputConnection(table->GetProducerPort());
+  large_extraction->SetInputArrayToProcess(0, 0, 0,
+    vtkDataObject::FIELD_ASSOCIATION_ROWS, "values");
+  large_extraction->SetBinCount(large_bin_count);
+  large_extraction->CalculateAveragesOn();
+  large_extraction->Update();
+
+  vtkTable* const large_histogram = large_extraction->GetOutput();
+  vtkIntArray* const large_bin_values = vtkIntArray::SafeDownCast(
+    large_histogram->GetRowData()->GetArray("bin_values"));
+  vtkDoubleArray* const averages = vtkDoubleArray::SafeDownCast(
+    large_histogram->GetRowData()->GetArray("doubled_average"));
+  vtkDoubleArray* const odd_averages = vtkDoubleArray::SafeDownCast(
+    large_histogram->GetRowData()->GetArray("odd_average"));
+  if (!large_bin_values || !averages || !odd_averages)
+    {
+    vtkGenericWarningMacro(
+      "Missing bin_values, doubled_average or odd_average.");
+    return 1;
+    }
+  if (large_histogram->GetRowData()->GetAbstractArray("labels_average") ||
+    large_histogram->GetRowData()->GetAbstractArray("labels_total"))
+    {
+    vtkGenericWarningMacro("The string array was averaged.");
+    return 1;
+    }
+  for (int i = 0; i < large_bin_count; i++)
+    {
+    if (large_bin_values->GetValue(i) != num_values/large_bin_count)
+      {
+      vtkGenericWarningMacro("incorrect bin value for bin " << i);
+      return 1;
+      }
+    if (averages->GetValue(i) != 1.0 || odd_averages->GetValue(i) != 0.5)
+      {
+      vtkGenericWarningMacro("incorrect average for bin " << i);
+      return 1;
+      }
+    }
   return 0;
 }
@@ -0,0 +1,209 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestGridConnectivity.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Labels two blocks of hexahedra separated by a gap.  Run with MPI, every
+// process gets a slab of the blocks, so the fragments have to be merged
+// across processes.  The fragments are computed with one thread and with
+// several threads.
+
+#include "vtkCellData.h"
+#include "vtkCommunicator.h"
+#include "vtkDoubleArray.h"
+#include "vtkFieldData.h"
+#include "vtkGridConnectivity.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiThreader.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+#include "vtkToolkits.h"
+#include "vtkUnstructuredGrid.h"
+
+#ifdef VTK_USE_MPI
+# include "vtkMPIController.h"
+#else
+# include "vtkDummyController.h"
+#endif
+
+#include <math.h>
+
+// Number of cells along each axis.  The cells with i == GapIndex are
+// removed, which leaves two fragments.
+static const int NX = 60;
+static const int NY = 30;
+static const int NZ = 60;
+static const int GapIndex = 30;
+
+static vtkIdType PointId(int i, int j, int k)
+{
+  return i + (NX + 1) * (j + (NY + 1) * static_cast<vtkIdType>(k));
+}
+
+// Builds the cells of the layers [kBegin, kEnd).  The global point ids are
+// the same on all processes.
+static vtkSmartPointer<vtkUnstructuredGrid> MakeSlab(int kBegin, int kEnd)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkIdTypeArray> globalIds =
+    vtkSmartPointer<vtkIdTypeArray>::New();
+  globalIds->SetName("GlobalNodeId");
+  int i, j, k;
+  for (k = kBegin; k <= kEnd; ++k)
+    {
+    for (j = 0; j <= NY; ++j)
+      {
+      for (i = 0; i <= NX; ++i)
+        {
+        points->InsertNextPoint(i, j, k);
+        globalIds->InsertNextValue(PointId(i, j, k));
+        }
+      }
+    }
+
+  vtkSmartPointer<vtkUnstructuredGrid> grid =
+    vtkSmartPointer<vtkUnstructuredGrid>::New();
+  grid->SetPoints(points);
+  grid->GetPointData()->SetGlobalIds(globalIds);
+  grid->Allocate(NX * NY * (kEnd - kBegin));
+  vtkSmartPointer<vtkDoubleArray> density =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  density->SetName("Density");
+  for (k = kBegin; k < kEnd; ++k)
+    {
+    for (j = 0; j < NY; ++j)
+      {
+      for (i = 0; i < NX; ++i)
+        {
+        if (i == GapIndex)
+          {
+          continue;
+          }
+        vtkIdType ids[8];
+        for (int c = 0; c < 8; ++c)
+          {
+          int ci = i + ((c & 1) ^ ((c >> 1) & 1));
+          int cj = j + ((c >> 1) & 1);
+          int ck = k + ((c >> 2) & 1);
+          ids[c] = PointId(ci, cj, ck - kBegin);
+          }
+        grid->InsertNextCell(VTK_HEXAHEDRON, 8, ids);
+        density->InsertNextValue(2.0);
+        }
+      }
+    }
+  grid->GetCellData()->AddArray(density);
+  return grid;
+}
+
+// Computes the fragments with numThreads threads and checks their volumes.
+static int TestFragments(vtkUnstructuredGrid* input, int numThreads)
+{
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(numThreads);
+  vtkSmartPointer<vtkGridConnectivity> connectivity =
+    vtkSmartPointer<vtkGridConnectivity>::New();
+  connectivity->SetInput(input);
+  connectivity->Update();
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(0);
+
+  vtkPolyData* output = vtkPolyData::SafeDownCast(
+    connectivity->GetOutput()->GetBlock(0));
+  vtkDoubleArray* volumes = vtkDoubleArray::SafeDownCast(
+    output->GetFieldData()->GetArray("Fragment Volume"));
+  vtkDoubleArray* densities = vtkDoubleArray::SafeDownCast(
+    output->GetFieldData()->GetArray("Density"));
+  // Fragment 0 is not used.
+  if (!volumes || !densities || volumes->GetNumberOfTuples() != 3 ||
+    densities->GetNumberOfTuples() != 3)
+    {
+    cerr << "Expected 2 fragments with " << numThreads << " threads." << endl;
+    return 1;
+    }
+  double small = GapIndex * NY * NZ;
+  double large = (NX - GapIndex - 1) * NY * NZ;
+  if (small > large)
+    {
+    double tmp = small;
+    small = large;
+    large = tmp;
+    }
+  double v1 = volumes->GetValue(1);
+  double v2 = volumes->GetValue(2);
+  if (v1 > v2)
+    {
+    double tmp = v1;
+    v1 = v2;
+    v2 = tmp;
+    }
+  if (fabs(v1 - small) > 1e-6 * small || fabs(v2 - large) > 1e-6 * large)
+    {
+    cerr << "Wrong fragment volumes with " << numThreads << " threads: "
+         << v1 << " and " << v2 << " instead of " << small << " and "
+         << large << endl;
+    return 1;
+    }
+  for (int ii = 1; ii < 3; ++ii)
+    {
+    double expected = 2.0 * volumes->GetValue(ii);
+    if (fabs(densities->GetValue(ii) - expected) > 1e-6 * expected)
+      {
+      cerr << "Wrong integrated density with " << numThreads << " threads."
+           << endl;
+      return 1;
+      }
+    }
+
+  // Only the outside of the fragments is left, on every process.
+  vtkIdType numFaces = output->GetNumberOfCells();
+  vtkDataArray* fragmentIds = output->GetCellData()->GetScalars();
+  for (vtkIdType ii = 0; ii < numFaces; ++ii)
+    {
+    double fragmentId = fragmentIds->GetTuple1(ii);
+    if (fragmentId != 1 && fragmentId != 2)
+      {
+      cerr << "Wrong fragment id " << fragmentId << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef VTK_USE_MPI
+  vtkMPIController* controller = vtkMPIController::New();
+#else
+  vtkDummyController* controller = vtkDummyController::New();
+#endif
+  controller->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(controller);
+
+  int numProcs = controller->GetNumberOfProcesses();
+  int myId = controller->GetLocalProcessId();
+  vtkSmartPointer<vtkUnstructuredGrid> input =
+    MakeSlab(NZ * myId / numProcs, NZ * (myId + 1) / numProcs);
+
+  // The threaded labeling kicks in above 20000 cells per thread.  All
+  // processes run both, the filter communicates.
+  int status = TestFragments(input, 1);
+  status |= TestFragments(input, 2);
+
+  int globalStatus = status;
+  controller->AllReduce(&status, &globalStatus, 1, vtkCommunicator::MAX_OP);
+  vtkMultiProcessController::SetGlobalController(0);
+  controller->Finalize();
+  controller->Delete();
+  return globalStatus;
+}
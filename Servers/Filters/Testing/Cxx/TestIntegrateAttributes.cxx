@@ -0,0 +1,96 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestIntegrateAttributes.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkImageData.h"
+#include "vtkIntegrateAttributes.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <math.h>
+
+/// Integrates a linear field over a grid large enough to be split across
+/// threads and compares with the exact values.
+int main(int, char*[])
+{
+  const int dim = 101;
+  const double length = 2.0;
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(dim, dim, dim);
+  image->SetSpacing(length / (dim - 1), length / (dim - 1),
+    length / (dim - 1));
+
+  vtkSmartPointer<vtkDoubleArray> x = vtkSmartPointer<vtkDoubleArray>::New();
+  x->SetName("x");
+  x->SetNumberOfTuples(image->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+    {
+    double pt[3];
+    image->GetPoint(i, pt);
+    x->SetValue(i, pt[0]);
+    }
+  image->GetPointData()->AddArray(x);
+
+  vtkSmartPointer<vtkDoubleArray> one = vtkSmartPointer<vtkDoubleArray>::New();
+  one->SetName("one");
+  one->SetNumberOfTuples(image->GetNumberOfCells());
+  one->FillComponent(0, 1.0);
+  image->GetCellData()->AddArray(one);
+
+  vtkSmartPointer<vtkIntegrateAttributes> integrate =
+    vtkSmartPointer<vtkIntegrateAttributes>::New();
+  integrate->SetInput(image);
+  integrate->Update();
+  vtkUnstructuredGrid* output = integrate->GetOutput();
+
+  const double volume = length * length * length;
+  // The integral of x over the cube, and its center.
+  const double integral = 0.5 * length * length * length * length;
+  const double center = 0.5 * length;
+
+  double value = output->GetCellData()->GetArray("Volume")->GetComponent(0, 0);
+  if (fabs(value - volume) > 1e-9 * volume)
+    {
+    cerr << "Wrong volume: " << value << " instead of " << volume << endl;
+    return 1;
+    }
+  value = output->GetCellData()->GetArray("one")->GetComponent(0, 0);
+  if (fabs(value - volume) > 1e-9 * volume)
+    {
+    cerr << "Wrong cell integral: " << value << " instead of " << volume
+         << endl;
+    return 1;
+    }
+  value = output->GetPointData()->GetArray("x")->GetComponent(0, 0);
+  if (fabs(value - integral) > 1e-9 * integral)
+    {
+    cerr << "Wrong point integral: " << value << " instead of " << integral
+         << endl;
+    return 1;
+    }
+  double pt[3];
+  output->GetPoint(0, pt);
+  for (int i = 0; i < 3; ++i)
+    {
+    if (fabs(pt[i] - center) > 1e-9)
+      {
+      cerr << "Wrong center: " << pt[i] << " instead of " << center << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPCSVWriter.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Writes a table with vtkPCSVWriter and compares the file with the expected
+// text: the header once, then the rows of every process in process order,
+// with real numbers in their shortest form that reads back exactly.  Run
+// with MPI, every process writes its own piece of the table.
+
+#include "vtkCommunicator.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkPCSVWriter.h"
+#include "vtkSmartPointer.h"
+#include "vtkTable.h"
+#include "vtkToolkits.h"
+
+#ifdef VTK_USE_MPI
+# include "vtkMPIController.h"
+#else
+# include "vtkDummyController.h"
+#endif
+
+#include <vtkstd/string>
+#include <vtksys/ios/sstream>
+
+#include <stdio.h>
+
+static const int NumberOfRows = 4;
+static const int NumberOfValues = 6;
+
+static const double DoubleValues[NumberOfValues] =
+  { 0.1, 0.1 + 0.2, 1.0 / 3.0, 1e-300, -2.5, 100.0 };
+static const char* DoubleStrings[NumberOfValues] =
+  { "0.1", "0.30000000000000004", "0.3333333333333333", "1e-300", "-2.5",
+    "100" };
+
+static const float FloatValues[NumberOfValues] =
+  { 0.1f, 1.0f / 3.0f, 16777216.0f, -0.5f, 1e-30f, 3.14159265f };
+static const char* FloatStrings[NumberOfValues] =
+  { "0.1", "0.33333334", "16777216", "-0.5", "1e-30", "3.1415927" };
+
+static vtkSmartPointer<vtkTable> MakePiece(int myId)
+{
+  vtkSmartPointer<vtkIntArray> id = vtkSmartPointer<vtkIntArray>::New();
+  id->SetName("Id");
+  id->SetNumberOfTuples(NumberOfRows);
+  vtkSmartPointer<vtkDoubleArray> x = vtkSmartPointer<vtkDoubleArray>::New();
+  x->SetName("X");
+  x->SetNumberOfTuples(NumberOfRows);
+  vtkSmartPointer<vtkFloatArray> y = vtkSmartPointer<vtkFloatArray>::New();
+  y->SetName("Y");
+  y->SetNumberOfTuples(NumberOfRows);
+  vtkSmartPointer<vtkDoubleArray> v = vtkSmartPointer<vtkDoubleArray>::New();
+  v->SetName("V");
+  v->SetNumberOfComponents(2);
+  v->SetNumberOfTuples(NumberOfRows);
+  for (int cc = 0; cc < NumberOfRows; ++cc)
+    {
+    int row = myId * NumberOfRows + cc;
+    id->SetValue(cc, row);
+    x->SetValue(cc, DoubleValues[row % NumberOfValues]);
+    y->SetValue(cc, FloatValues[row % NumberOfValues]);
+    v->SetComponent(cc, 0, DoubleValues[(row + 1) % NumberOfValues]);
+    v->SetComponent(cc, 1, row);
+    }
+
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  table->AddColumn(id);
+  table->AddColumn(x);
+  table->AddColumn(y);
+  table->AddColumn(v);
+  return table;
+}
+
+static vtkstd::string ExpectedText(int numProcs)
+{
+  vtksys_ios::ostringstream text;
+  text << "\"Id\",\"X\",\"Y\",\"V:0\",\"V:1\"\n";
+  for (int row = 0; row < numProcs * NumberOfRows; ++row)
+    {
+    text << row << ","
+      << DoubleStrings[row % NumberOfValues] << ","
+      << FloatStrings[row % NumberOfValues] << ","
+      << DoubleStrings[(row + 1) % NumberOfValues] << ","
+      << row << "\n";
+    }
+  return text.str();
+}
+
+static int CheckFile(const char* fileName, int numProcs)
+{
+  FILE* file = fopen(fileName, "rb");
+  if (!file)
+    {
+    cerr << "Cannot open " << fileName << endl;
+    return 1;
+    }
+  vtkstd::string actual;
+  char chunk[1024];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+    actual.append(chunk, length);
+    }
+  fclose(file);
+
+  vtkstd::string expected = ExpectedText(numProcs);
+  if (actual != expected)
+    {
+    cerr << "Expected:" << endl << expected << "Got:" << endl << actual;
+    return 1;
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef VTK_USE_MPI
+  vtkMPIController* controller = vtkMPIController::New();
+#else
+  vtkDummyController* controller = vtkDummyController::New();
+#endif
+  controller->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(controller);
+  int myId = controller->GetLocalProcessId();
+  int numProcs = controller->GetNumberOfProcesses();
+
+  const char* fileName = "TestPCSVWriter.csv";
+  vtkSmartPointer<vtkTable> piece = MakePiece(myId);
+  vtkSmartPointer<vtkPCSVWriter> writer =
+    vtkSmartPointer<vtkPCSVWriter>::New();
+  writer->SetController(controller);
+  writer->SetPiece(myId);
+  writer->SetNumberOfPieces(numProcs);
+  writer->SetFileName(fileName);
+  writer->SetInput(piece);
+  writer->Write();
+
+  int status = 0;
+  if (myId == 0)
+    {
+    status = CheckFile(fileName, numProcs);
+    }
+  int globalStatus = status;
+  controller->AllReduce(&status, &globalStatus, 1, vtkCommunicator::MAX_OP);
+  vtkMultiProcessController::SetGlobalController(0);
+  controller->Finalize();
+  controller->Delete();
+  return globalStatus;
+}
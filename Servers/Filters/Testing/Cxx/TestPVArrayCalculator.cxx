@@ -0,0 +1,177 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestPVArrayCalculator.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPVArrayCalculator.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+
+#include <string.h>
+
+namespace
+{
+vtkPolyData* CreateInput(vtkIdType numPoints)
+{
+  vtkMath::RandomSeed(1234);
+
+  vtkPoints* points = vtkPoints::New();
+  points->SetNumberOfPoints(numPoints);
+  vtkFloatArray* velocity = vtkFloatArray::New();
+  velocity->SetName("Velocity");
+  velocity->SetNumberOfComponents(3);
+  velocity->SetNumberOfTuples(numPoints);
+  vtkDoubleArray* pressure = vtkDoubleArray::New();
+  pressure->SetName("Pressure");
+  pressure->SetNumberOfTuples(numPoints);
+  vtkIntArray* material = vtkIntArray::New();
+  material->SetName("Material");
+  material->SetNumberOfTuples(numPoints);
+
+  for (vtkIdType i = 0; i < numPoints; ++i)
+    {
+    points->SetPoint(i, vtkMath::Random(-1, 1), vtkMath::Random(-1, 1),
+      vtkMath::Random(-1, 1));
+    velocity->SetTuple3(i, vtkMath::Random(-5, 5), vtkMath::Random(-5, 5),
+      vtkMath::Random(-5, 5));
+    // Include exact zeros to exercise the invalid-value replacement.
+    pressure->SetValue(i, (i % 7 == 0) ? 0.0 : vtkMath::Random(-2, 10));
+    material->SetValue(i, static_cast<int>(i % 5));
+    }
+
+  vtkPolyData* data = vtkPolyData::New();
+  data->SetPoints(points);
+  data->GetPointData()->AddArray(velocity);
+  data->GetPointData()->AddArray(pressure);
+  data->GetPointData()->AddArray(material);
+  points->Delete();
+  velocity->Delete();
+  pressure->Delete();
+  material->Delete();
+  return data;
+}
+
+vtkDataArray* Evaluate(vtkPolyData* input, const char* function, int fast,
+  double& seconds)
+{
+  vtkSmartPointer<vtkPVArrayCalculator> calc =
+    vtkSmartPointer<vtkPVArrayCalculator>::New();
+  calc->SetInput(input);
+  calc->SetFunction(function);
+  calc->SetResultArrayName("Result");
+  calc->SetFastEvaluation(fast);
+  // The block evaluator only runs when invalid values are replaced.
+  calc->SetReplaceInvalidValues(1);
+  calc->SetReplacementValue(-1.0);
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  timer->StartTimer();
+  calc->Update();
+  timer->StopTimer();
+  seconds = timer->GetElapsedTime();
+
+  vtkDataArray* result =
+    calc->GetOutput()->GetPointData()->GetArray("Result");
+  if (result)
+    {
+    result->Register(NULL);
+    }
+  return result;
+}
+}
+
+/// Checks that the block evaluator of vtkPVArrayCalculator produces exactly
+/// the same values as vtkFunctionParser for scalar, vector and mixed
+/// expressions, and that it copes with an empty input. The speedup over
+/// vtkFunctionParser is reported but does not fail the test since timings
+/// on shared test machines are too noisy.
+int main(int, char*[])
+{
+  const vtkIdType numPoints = 1000003;
+  const char* functions[] = {
+    "Pressure*2+Material",
+    "sqrt(Pressure)+ln(Pressure)/Pressure",
+    "mag(Velocity)*max(Pressure,Material)-min(coordsX,coordsY)",
+    "norm(Velocity)*Pressure+coords-iHat",
+    "Velocity.coords*exp(-abs(Velocity_X))+asin(coordsZ)",
+    "cos(Velocity_Y)^2+sin(Velocity_Z)^2+tanh(coordsX)*floor(Pressure)",
+    "-Velocity*Pressure",
+    "log(Pressure)+cross(Velocity,coords).jHat",
+    "Pressure*Velocity",
+    "Material*coords+Pressure*(Velocity-jHat)",
+    NULL
+  };
+
+  vtkPolyData* input = CreateInput(numPoints);
+  int status = 0;
+  for (int f = 0; functions[f]; ++f)
+    {
+    double parserTime, fastTime;
+    vtkDataArray* expected = Evaluate(input, functions[f], 0, parserTime);
+    vtkDataArray* actual = Evaluate(input, functions[f], 1, fastTime);
+    if (!expected || !actual)
+      {
+      cerr << "No result for \"" << functions[f] << "\"" << endl;
+      status = 1;
+      }
+    else if (expected->GetNumberOfTuples() != actual->GetNumberOfTuples() ||
+      expected->GetNumberOfComponents() != actual->GetNumberOfComponents() ||
+      expected->GetDataType() != actual->GetDataType() ||
+      memcmp(expected->GetVoidPointer(0), actual->GetVoidPointer(0),
+        expected->GetNumberOfTuples() * expected->GetNumberOfComponents() *
+        expected->GetDataTypeSize()) != 0)
+      {
+      cerr << "Results differ for \"" << functions[f] << "\"" << endl;
+      status = 1;
+      }
+    else
+      {
+      cout << "\"" << functions[f] << "\": vtkFunctionParser " << parserTime
+           << " s, block evaluator " << fastTime << " s ("
+           << parserTime / (fastTime > 0 ? fastTime : 1e-9) << "x)" << endl;
+      }
+    if (expected)
+      {
+      expected->Delete();
+      }
+    if (actual)
+      {
+      actual->Delete();
+      }
+    }
+  input->Delete();
+
+  vtkPolyData* empty = CreateInput(0);
+  double seconds;
+  vtkDataArray* result =
+    Evaluate(empty, "Pressure*Velocity+coords", 1, seconds);
+  if (!result || result->GetNumberOfTuples() != 0)
+    {
+    cerr << "Wrong result for an empty input" << endl;
+    status = 1;
+    }
+  if (result)
+    {
+    result->Delete();
+    }
+  empty->Delete();
+  return status;
+}
@@ -0,0 +1,181 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVExtractSelectionQuery.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
+#include "vtkMultiThreader.h"
+#include "vtkPVExtractSelection.h"
+#include "vtkQuerySelectionSource.h"
+#include "vtkSelection.h"
+#include "vtkSelectionNode.h"
+#include "vtkSmartPointer.h"
+
+#include <vtkstd/vector>
+
+// Enough cells for the scans to be split among threads.
+static const int Dimension = 51;
+
+// Values with many duplicates.
+static double Value(vtkIdType cell, int shift)
+{
+  return static_cast<double>((cell * 37 + shift) % 101);
+}
+
+// Runs the query and checks that the extracted cells are the ones with a
+// value in any of the [ranges[2*i], ranges[2*i+1]] intervals.
+static int CheckQuery(vtkPVExtractSelection* extractor,
+  vtkQuerySelectionSource* query, vtkDoubleArray* values,
+  const vtkstd::vector<double>& ranges)
+{
+  query->Modified();
+  extractor->Update();
+
+  vtkSelection* output = vtkSelection::SafeDownCast(
+    extractor->GetOutputDataObject(1));
+  vtkIdTypeArray* ids = 0;
+  for (unsigned int cc = 0; cc < output->GetNumberOfNodes(); ++cc)
+    {
+    if (output->GetNode(cc)->GetFieldType() == vtkSelectionNode::CELL)
+      {
+      ids = vtkIdTypeArray::SafeDownCast(
+        output->GetNode(cc)->GetSelectionList());
+      }
+    }
+  if (!ids)
+    {
+    cerr << "No cell ids were extracted." << endl;
+    return 1;
+    }
+
+  vtkIdType numExpected = 0;
+  for (vtkIdType cell = 0; cell < values->GetNumberOfTuples(); ++cell)
+    {
+    double value = values->GetValue(cell);
+    for (size_t r = 0; r < ranges.size(); r += 2)
+      {
+      if (value >= ranges[r] && value <= ranges[r+1])
+        {
+        ++numExpected;
+        break;
+        }
+      }
+    }
+  if (ids->GetNumberOfTuples() != numExpected)
+    {
+    cerr << ids->GetNumberOfTuples() << " cells were extracted instead of "
+         << numExpected << endl;
+    return 1;
+    }
+  for (vtkIdType cc = 0; cc < ids->GetNumberOfTuples(); ++cc)
+    {
+    double value = values->GetValue(ids->GetValue(cc));
+    bool inside = false;
+    for (size_t r = 0; r < ranges.size(); r += 2)
+      {
+      inside = inside || (value >= ranges[r] && value <= ranges[r+1]);
+      }
+    if (!inside)
+      {
+      cerr << "Cell " << ids->GetValue(cc) << " does not match the query."
+           << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+// Runs a range query and a value query.
+static int CheckQueries(vtkPVExtractSelection* extractor,
+  vtkQuerySelectionSource* query, vtkDoubleArray* values)
+{
+  vtkstd::vector<double> ranges;
+  ranges.push_back(10.0);
+  ranges.push_back(20.5);
+  query->SetOperator(vtkQuerySelectionSource::IS_BETWEEN);
+  query->SetNumberOfDoubleValues(2);
+  query->SetDoubleValues(&ranges[0]);
+  if (CheckQuery(extractor, query, values, ranges))
+    {
+    return 1;
+    }
+
+  double oneOf[3] = { 5.0, 50.0, 100.0 };
+  ranges.clear();
+  for (int cc = 0; cc < 3; ++cc)
+    {
+    ranges.push_back(oneOf[cc]);
+    ranges.push_back(oneOf[cc]);
+    }
+  query->SetOperator(vtkQuerySelectionSource::IS_ONE_OF);
+  query->SetNumberOfDoubleValues(3);
+  query->SetDoubleValues(oneOf);
+  return CheckQuery(extractor, query, values, ranges);
+}
+
+/// Matches queries on a cell array with and without the query index.
+int main(int, char*[])
+{
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(4);
+
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(Dimension, Dimension, Dimension);
+  vtkSmartPointer<vtkDoubleArray> values =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  values->SetName("Value");
+  values->SetNumberOfTuples(image->GetNumberOfCells());
+  for (vtkIdType cell = 0; cell < values->GetNumberOfTuples(); ++cell)
+    {
+    values->SetValue(cell, Value(cell, 0));
+    }
+  image->GetCellData()->AddArray(values);
+
+  vtkSmartPointer<vtkQuerySelectionSource> query =
+    vtkSmartPointer<vtkQuerySelectionSource>::New();
+  query->SetFieldType(vtkSelectionNode::CELL);
+  query->SetTermMode(vtkQuerySelectionSource::ARRAY);
+  query->SetArrayName("Value");
+  query->SetArrayComponent(0);
+
+  vtkSmartPointer<vtkPVExtractSelection> extractor =
+    vtkSmartPointer<vtkPVExtractSelection>::New();
+  extractor->SetInput(image);
+  extractor->SetSelectionConnection(query->GetOutputPort());
+
+  for (int useIndex = 0; useIndex <= 1; ++useIndex)
+    {
+    extractor->SetUseQueryIndex(useIndex);
+    if (CheckQueries(extractor, query, values))
+      {
+      cerr << "Failed with UseQueryIndex " << useIndex << endl;
+      return 1;
+      }
+    }
+
+  // The index has to be rebuilt when the array changes.
+  for (vtkIdType cell = 0; cell < values->GetNumberOfTuples(); ++cell)
+    {
+    values->SetValue(cell, Value(cell, 7));
+    }
+  values->Modified();
+  image->Modified();
+  if (CheckQueries(extractor, query, values))
+    {
+    cerr << "The query index was not updated." << endl;
+    return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,284 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVGlyphFilterInstances.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkImageData.h"
+#include "vtkMath.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkPointData.h"
+#include "vtkPolyData.h"
+#include "vtkPVGlyphFilter.h"
+#include "vtkSmartPointer.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <math.h>
+
+static vtkSmartPointer<vtkImageData> MakeImage(double origin)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(21, 21, 21);
+  image->SetOrigin(origin, 0.0, 0.0);
+
+  vtkIdType numPts = image->GetNumberOfPoints();
+  vtkSmartPointer<vtkDoubleArray> scalars =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  scalars->SetName("s");
+  scalars->SetNumberOfTuples(numPts);
+  vtkSmartPointer<vtkDoubleArray> vectors =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  vectors->SetName("v");
+  vectors->SetNumberOfComponents(3);
+  vectors->SetNumberOfTuples(numPts);
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    double* pt = image->GetPoint(cc);
+    scalars->SetValue(cc, pt[0] + pt[1]);
+    vectors->SetTuple3(cc, 1.0 + pt[2], pt[0], 0.0);
+    }
+  image->GetPointData()->SetScalars(scalars);
+  image->GetPointData()->SetVectors(vectors);
+  return image;
+}
+
+// Checks that the instances have the expected arrays and, when reference is
+// given, the same points as reference with the glyph scale multiplied by
+// ratio.
+static int CheckInstances(vtkPolyData* output, vtkPolyData* reference,
+  double ratio)
+{
+  vtkIdType numPts = output->GetNumberOfPoints();
+  if (numPts == 0 || output->GetNumberOfVerts() != numPts)
+    {
+    cerr << "Expected one vertex per instance." << endl;
+    return 1;
+    }
+  vtkDataArray* scales = output->GetPointData()->GetArray("GlyphScale");
+  vtkDataArray* orientations =
+    output->GetPointData()->GetArray("GlyphOrientation");
+  if (!scales || scales->GetNumberOfComponents() != 3 ||
+    scales->GetNumberOfTuples() != numPts || !orientations ||
+    !output->GetPointData()->GetArray("s"))
+    {
+    cerr << "Missing instance arrays." << endl;
+    return 1;
+    }
+  if (!reference)
+    {
+    return 0;
+    }
+
+  if (reference->GetNumberOfPoints() != numPts)
+    {
+    cerr << "The selected points changed: " << numPts << " instead of "
+         << reference->GetNumberOfPoints() << endl;
+    return 1;
+    }
+  vtkDataArray* refScales = reference->GetPointData()->GetArray("GlyphScale");
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    double pt[3], refPt[3];
+    output->GetPoint(cc, pt);
+    reference->GetPoint(cc, refPt);
+    if (vtkMath::Distance2BetweenPoints(pt, refPt) != 0.0)
+      {
+      cerr << "The selected points changed at instance " << cc << endl;
+      return 1;
+      }
+    double scale = scales->GetComponent(cc, 0);
+    double expected = refScales->GetComponent(cc, 0) * ratio;
+    if (fabs(scale - expected) > 1e-5 * fabs(expected))
+      {
+      cerr << "Wrong glyph scale at instance " << cc << ": " << scale
+           << " instead of " << expected << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+static int TestInput(vtkDataObject* input)
+{
+  vtkSmartPointer<vtkPVGlyphFilter> glyph =
+    vtkSmartPointer<vtkPVGlyphFilter>::New();
+  glyph->SetInput(input);
+  glyph->SetUseMaskPoints(1);
+  glyph->SetRandomMode(1);
+  glyph->SetMaximumNumberOfPoints(500);
+  glyph->GenerateInstancesOn();
+  glyph->Update();
+
+  vtkSmartPointer<vtkPolyData> reference = vtkSmartPointer<vtkPolyData>::New();
+  reference->DeepCopy(glyph->GetOutput());
+  if (CheckInstances(reference, 0, 1.0))
+    {
+    return 1;
+    }
+  if (reference->GetNumberOfPoints() > 600)
+    {
+    cerr << "Too many instances: " << reference->GetNumberOfPoints() << endl;
+    return 1;
+    }
+
+  // Changing the scale reuses the random selection.
+  glyph->SetScaleFactor(2.5);
+  glyph->Update();
+  if (CheckInstances(glyph->GetOutput(), reference, 2.5))
+    {
+    return 1;
+    }
+
+  // So does generating the glyph geometry.
+  glyph->GenerateInstancesOff();
+  glyph->Update();
+  glyph->GenerateInstancesOn();
+  glyph->Update();
+  if (CheckInstances(glyph->GetOutput(), reference, 2.5))
+    {
+    return 1;
+    }
+
+  // Changing the masking parameters makes a new selection.
+  glyph->SetMaximumNumberOfPoints(100);
+  glyph->Update();
+  if (glyph->GetOutput()->GetNumberOfPoints() >=
+    reference->GetNumberOfPoints())
+    {
+    cerr << "The selection was not updated." << endl;
+    return 1;
+    }
+  return 0;
+}
+
+// Gives point cc the ghost level cc % 3.
+static vtkSmartPointer<vtkImageData> MakeGhostImage(double origin)
+{
+  vtkSmartPointer<vtkImageData> image = MakeImage(origin);
+  vtkIdType numPts = image->GetNumberOfPoints();
+  vtkSmartPointer<vtkUnsignedCharArray> ghostLevels =
+    vtkSmartPointer<vtkUnsignedCharArray>::New();
+  ghostLevels->SetName("vtkGhostLevels");
+  ghostLevels->SetNumberOfTuples(numPts);
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    ghostLevels->SetValue(cc, static_cast<unsigned char>(cc % 3));
+    }
+  image->GetPointData()->AddArray(ghostLevels);
+  return image;
+}
+
+// Checks that only the points up to the requested ghost level are
+// instantiated, all of them since the budget is large enough.
+static int CheckGhostLevels(vtkPVGlyphFilter* glyph, int ghostLevel,
+  vtkIdType numPts)
+{
+  glyph->GetOutput()->SetUpdateExtent(0, 1, ghostLevel);
+  glyph->Update();
+  vtkPolyData* output = glyph->GetOutput();
+  vtkIdType expected = 0;
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    expected += (cc % 3 <= ghostLevel) ? 1 : 0;
+    }
+  vtkDataArray* ghostLevels = output->GetPointData()->GetArray("vtkGhostLevels");
+  if (!ghostLevels || output->GetNumberOfPoints() != expected)
+    {
+    cerr << "Expected " << expected << " instances at ghost level "
+         << ghostLevel << ", got " << output->GetNumberOfPoints() << endl;
+    return 1;
+    }
+  double range[2];
+  ghostLevels->GetRange(range, 0);
+  if (range[1] > ghostLevel)
+    {
+    cerr << "Instantiated a point of ghost level " << range[1]
+         << " at ghost level " << ghostLevel << endl;
+    return 1;
+    }
+  return 0;
+}
+
+static int TestGhostLevels(vtkDataObject* input, vtkIdType numPts)
+{
+  vtkSmartPointer<vtkPVGlyphFilter> glyph =
+    vtkSmartPointer<vtkPVGlyphFilter>::New();
+  glyph->SetInput(input);
+  glyph->SetUseMaskPoints(1);
+  glyph->SetRandomMode(0);
+  glyph->SetMaximumNumberOfPoints(100000);
+  glyph->GenerateInstancesOn();
+  if (CheckGhostLevels(glyph, 0, numPts) ||
+    CheckGhostLevels(glyph, 1, numPts) ||
+    CheckGhostLevels(glyph, 0, numPts))
+    {
+    return 1;
+    }
+  if (!vtkMultiBlockDataSet::SafeDownCast(input))
+    {
+    return 0;
+    }
+
+  // The points of the blocks are sampled by the filter itself: the ghost
+  // points do not use up the budget.
+  glyph->SetMaximumNumberOfPoints(300);
+  glyph->GetOutput()->SetUpdateExtent(0, 1, 0);
+  glyph->Update();
+  vtkIdType numInstances = glyph->GetOutput()->GetNumberOfPoints();
+  if (numInstances != 300)
+    {
+    cerr << "Expected 300 instances, got " << numInstances << endl;
+    return 1;
+    }
+  return 0;
+}
+
+int main(int, char*[])
+{
+  vtkSmartPointer<vtkImageData> image = MakeImage(0.0);
+  if (TestInput(image))
+    {
+    cerr << "Failed with an image input." << endl;
+    return 1;
+    }
+
+  vtkSmartPointer<vtkMultiBlockDataSet> blocks =
+    vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  blocks->SetNumberOfBlocks(2);
+  blocks->SetBlock(0, MakeImage(0.0));
+  blocks->SetBlock(1, MakeImage(30.0));
+  if (TestInput(blocks))
+    {
+    cerr << "Failed with a multiblock input." << endl;
+    return 1;
+    }
+
+  vtkSmartPointer<vtkImageData> ghostImage = MakeGhostImage(0.0);
+  if (TestGhostLevels(ghostImage, ghostImage->GetNumberOfPoints()))
+    {
+    cerr << "Failed with ghost points in an image." << endl;
+    return 1;
+    }
+
+  vtkSmartPointer<vtkMultiBlockDataSet> ghostBlocks =
+    vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  ghostBlocks->SetNumberOfBlocks(1);
+  ghostBlocks->SetBlock(0, MakeGhostImage(0.0));
+  if (TestGhostLevels(ghostBlocks, ghostImage->GetNumberOfPoints()))
+    {
+    cerr << "Failed with ghost points in a multiblock." << endl;
+    return 1;
+    }
+  return 0;
+}
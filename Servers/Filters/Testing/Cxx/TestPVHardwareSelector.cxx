@@ -0,0 +1,210 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVHardwareSelector.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Decodes synthetic pixel buffers with vtkPVHardwareSelector, using several
+// threads, and checks that the selection is the same as the one generated by
+// vtkHardwareSelector::GenerateSelection(), with and without a process pass.
+
+#include "vtkDataObject.h"
+#include "vtkIdTypeArray.h"
+#include "vtkInformation.h"
+#include "vtkMultiThreader.h"
+#include "vtkObjectFactory.h"
+#include "vtkPVHardwareSelector.h"
+#include "vtkSelection.h"
+#include "vtkSelectionNode.h"
+#include "vtkSmartPointer.h"
+
+// Enough pixels for the buffers to be split among threads.
+static const int Width = 512;
+static const int Height = 384;
+
+// Gives access to the pixel buffers.
+class vtkTestHardwareSelector : public vtkPVHardwareSelector
+{
+public:
+  static vtkTestHardwareSelector* New();
+  vtkTypeMacro(vtkTestHardwareSelector, vtkPVHardwareSelector);
+
+  // Takes ownership of the buffer, allocated with new[].
+  void SetPixBuffer(int pass, unsigned char* buffer)
+    {
+    delete [] this->PixBuffer[pass];
+    this->PixBuffer[pass] = buffer;
+    }
+
+  vtkSelection* Decode()
+    { return this->GenerateSelectionInParallel(); }
+
+protected:
+  vtkTestHardwareSelector() {}
+  ~vtkTestHardwareSelector() {}
+};
+
+vtkStandardNewMacro(vtkTestHardwareSelector);
+
+// Returns a buffer with the value of every pixel encoded in its color.
+static unsigned char* MakeBuffer(int pass)
+{
+  unsigned char* buffer = new unsigned char[3*Width*Height];
+  for (int y = 0; y < Height; ++y)
+    {
+    for (int x = 0; x < Width; ++x)
+      {
+      // Props 1 to 3 in bands, with background (0) between them.
+      int prop = (x/50 + y/40) % 4;
+      // Attribute ids shifted by one, 0 being no attribute, some of them
+      // needing more than 24 bits.
+      vtkIdType id = (x*7 + y*13) % 5000;
+      if (y % 3 == 0 && x % 2 == 0)
+        {
+        id += (static_cast<vtkIdType>(1) << 24);
+        }
+      int value = 0;
+      switch (pass)
+        {
+        case vtkHardwareSelector::PROCESS_PASS:
+          value = 1 + (x*Height + y) % 3;
+          break;
+        case vtkHardwareSelector::ACTOR_PASS:
+          value = prop;
+          break;
+        case vtkHardwareSelector::ID_LOW24:
+          value = static_cast<int>(id & 0xffffff);
+          break;
+        case vtkHardwareSelector::ID_MID24:
+          value = static_cast<int>((id >> 24) & 0xffffff);
+          break;
+        }
+      unsigned char* rgb = buffer + 3*(y*Width + x);
+      rgb[0] = static_cast<unsigned char>(value & 0xff);
+      rgb[1] = static_cast<unsigned char>((value >> 8) & 0xff);
+      rgb[2] = static_cast<unsigned char>((value >> 16) & 0xff);
+      }
+    }
+  return buffer;
+}
+
+// Returns the node of sel with the prop and process of node, if any.
+static vtkSelectionNode* FindNode(vtkSelection* sel, vtkSelectionNode* node)
+{
+  vtkInformation* properties = node->GetProperties();
+  for (unsigned int cc = 0; cc < sel->GetNumberOfNodes(); ++cc)
+    {
+    vtkInformation* other = sel->GetNode(cc)->GetProperties();
+    if (other->Get(vtkSelectionNode::PROP_ID()) !=
+      properties->Get(vtkSelectionNode::PROP_ID()) ||
+      other->Has(vtkSelectionNode::PROCESS_ID()) !=
+      properties->Has(vtkSelectionNode::PROCESS_ID()))
+      {
+      continue;
+      }
+    if (!properties->Has(vtkSelectionNode::PROCESS_ID()) ||
+      other->Get(vtkSelectionNode::PROCESS_ID()) ==
+      properties->Get(vtkSelectionNode::PROCESS_ID()))
+      {
+      return sel->GetNode(cc);
+      }
+    }
+  return 0;
+}
+
+static int Compare(const char* name, vtkSelection* expected,
+                   vtkSelection* actual)
+{
+  if (expected->GetNumberOfNodes() == 0)
+    {
+    cerr << name << ": the expected selection is empty." << endl;
+    return 1;
+    }
+  if (expected->GetNumberOfNodes() != actual->GetNumberOfNodes())
+    {
+    cerr << name << ": expected " << expected->GetNumberOfNodes()
+      << " nodes, got " << actual->GetNumberOfNodes() << "." << endl;
+    return 1;
+    }
+  for (unsigned int cc = 0; cc < expected->GetNumberOfNodes(); ++cc)
+    {
+    vtkSelectionNode* expectedNode = expected->GetNode(cc);
+    vtkSelectionNode* actualNode = FindNode(actual, expectedNode);
+    if (!actualNode)
+      {
+      cerr << name << ": no node for prop "
+        << expectedNode->GetProperties()->Get(vtkSelectionNode::PROP_ID())
+        << "." << endl;
+      return 1;
+      }
+    if (expectedNode->GetContentType() != actualNode->GetContentType() ||
+      expectedNode->GetFieldType() != actualNode->GetFieldType())
+      {
+      cerr << name << ": the nodes have different types." << endl;
+      return 1;
+      }
+    vtkIdTypeArray* expectedIds =
+      vtkIdTypeArray::SafeDownCast(expectedNode->GetSelectionList());
+    vtkIdTypeArray* actualIds =
+      vtkIdTypeArray::SafeDownCast(actualNode->GetSelectionList());
+    if (!expectedIds || !actualIds ||
+      expectedIds->GetNumberOfTuples() != actualIds->GetNumberOfTuples())
+      {
+      cerr << name << ": the nodes have different numbers of ids." << endl;
+      return 1;
+      }
+    for (vtkIdType ii = 0; ii < expectedIds->GetNumberOfTuples(); ++ii)
+      {
+      if (expectedIds->GetValue(ii) != actualIds->GetValue(ii))
+        {
+        cerr << name << ": id " << ii << " differs." << endl;
+        return 1;
+        }
+      }
+    }
+  return 0;
+}
+
+int main(int, char*[])
+{
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(4);
+
+  vtkSmartPointer<vtkTestHardwareSelector> selector =
+    vtkSmartPointer<vtkTestHardwareSelector>::New();
+  selector->SetArea(0, 0, Width - 1, Height - 1);
+  selector->SetFieldAssociation(vtkDataObject::FIELD_ASSOCIATION_CELLS);
+  // Without the process pass, this process id must not end up in the
+  // selection.
+  selector->SetProcessID(2);
+  selector->SetPixBuffer(vtkHardwareSelector::ACTOR_PASS,
+    MakeBuffer(vtkHardwareSelector::ACTOR_PASS));
+  selector->SetPixBuffer(vtkHardwareSelector::ID_LOW24,
+    MakeBuffer(vtkHardwareSelector::ID_LOW24));
+  selector->SetPixBuffer(vtkHardwareSelector::ID_MID24,
+    MakeBuffer(vtkHardwareSelector::ID_MID24));
+
+  int status = 0;
+  vtkSmartPointer<vtkSelection> expected;
+  vtkSmartPointer<vtkSelection> actual;
+  expected.TakeReference(selector->GenerateSelection());
+  actual.TakeReference(selector->Decode());
+  status |= Compare("Without process pass", expected, actual);
+
+  selector->SetPixBuffer(vtkHardwareSelector::PROCESS_PASS,
+    MakeBuffer(vtkHardwareSelector::PROCESS_PASS));
+  expected.TakeReference(selector->GenerateSelection());
+  actual.TakeReference(selector->Decode());
+  status |= Compare("With process pass", expected, actual);
+
+  selector->ReleasePixBuffers();
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(0);
+  return status;
+}
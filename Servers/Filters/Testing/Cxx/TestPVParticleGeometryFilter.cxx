@@ -0,0 +1,169 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVParticleGeometryFilter.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkPVParticleGeometryFilter passes the points and the point
+// data of point sets, images and composite datasets without generating
+// cells.
+
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkImageData.h"
+#include "vtkIntArray.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPVParticleGeometryFilter.h"
+#include "vtkSmartPointer.h"
+#include "vtkUnstructuredGrid.h"
+
+static vtkSmartPointer<vtkUnstructuredGrid> MakeParticles(vtkIdType numPts,
+  double offset)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(numPts);
+  vtkSmartPointer<vtkDoubleArray> mass =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  mass->SetName("Mass");
+  mass->SetNumberOfTuples(numPts);
+  vtkSmartPointer<vtkIntArray> type = vtkSmartPointer<vtkIntArray>::New();
+  type->SetName("Type");
+  type->SetNumberOfTuples(numPts);
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    points->SetPoint(cc, offset + cc, 2.0 * cc, 0.0);
+    mass->SetValue(cc, offset + cc);
+    type->SetValue(cc, static_cast<int>(cc % 3));
+    }
+
+  vtkSmartPointer<vtkUnstructuredGrid> grid =
+    vtkSmartPointer<vtkUnstructuredGrid>::New();
+  grid->SetPoints(points);
+  grid->GetPointData()->AddArray(mass);
+  grid->GetPointData()->AddArray(type);
+  return grid;
+}
+
+static vtkPolyData* RunFilter(vtkPVParticleGeometryFilter* filter,
+  vtkDataObject* input)
+{
+  filter->SetInput(input);
+  filter->Update();
+  vtkPolyData* output = filter->GetOutput();
+  if (output->GetNumberOfCells() != 0)
+    {
+    cerr << "Expected no cells, got " << output->GetNumberOfCells() << endl;
+    return 0;
+    }
+  return output;
+}
+
+// Checks that the points of output, starting at offset, are the ones of
+// input with the array name.
+static int CheckPoints(vtkPolyData* output, vtkIdType offset,
+  vtkDataSet* input, const char* name)
+{
+  vtkDataArray* outArray = output->GetPointData()->GetArray(name);
+  vtkDataArray* inArray = input->GetPointData()->GetArray(name);
+  if (!outArray)
+    {
+    cerr << "Missing point array " << name << endl;
+    return 1;
+    }
+  vtkIdType numPts = input->GetNumberOfPoints();
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    double pt[3], inPt[3];
+    output->GetPoint(offset + cc, pt);
+    input->GetPoint(cc, inPt);
+    if (pt[0] != inPt[0] || pt[1] != inPt[1] || pt[2] != inPt[2] ||
+      outArray->GetTuple1(offset + cc) != inArray->GetTuple1(cc))
+      {
+      cerr << "Wrong point " << offset + cc << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int main(int, char*[])
+{
+  vtkSmartPointer<vtkPVParticleGeometryFilter> filter =
+    vtkSmartPointer<vtkPVParticleGeometryFilter>::New();
+
+  // Point sets share their coordinates and point data.
+  vtkSmartPointer<vtkUnstructuredGrid> particles = MakeParticles(100, 0.0);
+  vtkPolyData* output = RunFilter(filter, particles);
+  if (!output || output->GetNumberOfPoints() != 100 ||
+    CheckPoints(output, 0, particles, "Mass") ||
+    CheckPoints(output, 0, particles, "Type"))
+    {
+    cerr << "Failed with a point set input." << endl;
+    return 1;
+    }
+  if (output->GetPoints() != particles->GetPoints() ||
+    output->GetPointData()->GetArray("Mass") !=
+    particles->GetPointData()->GetArray("Mass"))
+    {
+    cerr << "The points of a point set were copied." << endl;
+    return 1;
+    }
+
+  // Other datasets have their points copied.
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(4, 5, 6);
+  image->SetOrigin(1.0, 2.0, 3.0);
+  vtkSmartPointer<vtkDoubleArray> scalars =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  scalars->SetName("Mass");
+  scalars->SetNumberOfTuples(image->GetNumberOfPoints());
+  for (vtkIdType cc = 0; cc < image->GetNumberOfPoints(); ++cc)
+    {
+    scalars->SetValue(cc, 0.5 * cc);
+    }
+  image->GetPointData()->SetScalars(scalars);
+  output = RunFilter(filter, image);
+  if (!output || output->GetNumberOfPoints() != image->GetNumberOfPoints() ||
+    CheckPoints(output, 0, image, "Mass"))
+    {
+    cerr << "Failed with an image input." << endl;
+    return 1;
+    }
+
+  // The leaves of composite datasets are appended; only the arrays of all
+  // the leaves are kept.
+  vtkSmartPointer<vtkUnstructuredGrid> first = MakeParticles(50, 0.0);
+  vtkSmartPointer<vtkUnstructuredGrid> second = MakeParticles(70, 1000.0);
+  second->GetPointData()->RemoveArray("Type");
+  vtkSmartPointer<vtkMultiBlockDataSet> blocks =
+    vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  blocks->SetNumberOfBlocks(3);
+  blocks->SetBlock(0, first);
+  blocks->SetBlock(1, MakeParticles(0, 0.0));
+  blocks->SetBlock(2, second);
+  output = RunFilter(filter, blocks);
+  if (!output || output->GetNumberOfPoints() != 120 ||
+    CheckPoints(output, 0, first, "Mass") ||
+    CheckPoints(output, 50, second, "Mass"))
+    {
+    cerr << "Failed with a multiblock input." << endl;
+    return 1;
+    }
+  if (output->GetPointData()->GetArray("Type"))
+    {
+    cerr << "An array missing from a block was passed." << endl;
+    return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,188 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestSciVizStatisticsStreaming.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Fits multi-correlative and PCA models of the same point data with and
+// without StreamingMode and checks that the models are the same.  Run with
+// MPI, every process holds a different part of the observations.
+
+#include "vtkAbstractArray.h"
+#include "vtkCommunicator.h"
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiThreader.h"
+#include "vtkPointData.h"
+#include "vtkPolyData.h"
+#include "vtkPSciVizMultiCorrelativeStats.h"
+#include "vtkPSciVizPCAStats.h"
+#include "vtkSmartPointer.h"
+#include "vtkTable.h"
+#include "vtkToolkits.h"
+#include "vtkVariant.h"
+
+#ifdef VTK_USE_MPI
+# include "vtkMPIController.h"
+#else
+# include "vtkDummyController.h"
+#endif
+
+#include <math.h>
+
+// Enough observations for several threads to get a share of the tuples.
+static const vtkIdType NumberOfObservations = 300000;
+
+static vtkSmartPointer<vtkPolyData> MakeObservations(int myId)
+{
+  vtkSmartPointer<vtkDoubleArray> a = vtkSmartPointer<vtkDoubleArray>::New();
+  a->SetName("A");
+  a->SetNumberOfTuples(NumberOfObservations);
+  vtkSmartPointer<vtkFloatArray> b = vtkSmartPointer<vtkFloatArray>::New();
+  b->SetName("B");
+  b->SetNumberOfTuples(NumberOfObservations);
+  vtkSmartPointer<vtkIntArray> v = vtkSmartPointer<vtkIntArray>::New();
+  v->SetName("V");
+  v->SetNumberOfComponents(2);
+  v->SetNumberOfTuples(NumberOfObservations);
+  for (vtkIdType cc = 0; cc < NumberOfObservations; ++cc)
+    {
+    double t = 0.001 * cc + myId;
+    a->SetValue(cc, 100.0 + sin(t));
+    b->SetValue(cc, static_cast<float>(2.0 * sin(t) + cos(3.0 * t)));
+    v->SetComponent(cc, 0, static_cast<int>(cc % 17) - 8);
+    v->SetComponent(cc, 1, static_cast<int>((cc * 7) % 11) + myId);
+    }
+
+  vtkSmartPointer<vtkPolyData> observations =
+    vtkSmartPointer<vtkPolyData>::New();
+  observations->GetPointData()->AddArray(a);
+  observations->GetPointData()->AddArray(b);
+  observations->GetPointData()->AddArray(v);
+  return observations;
+}
+
+static int CompareTables(vtkTable* expected, vtkTable* actual)
+{
+  if (!expected || !actual ||
+    expected->GetNumberOfColumns() != actual->GetNumberOfColumns() ||
+    expected->GetNumberOfRows() != actual->GetNumberOfRows())
+    {
+    cerr << "The model tables do not have the same shape." << endl;
+    return 1;
+    }
+  for (vtkIdType col = 0; col < expected->GetNumberOfColumns(); ++col)
+    {
+    vtkAbstractArray* expectedCol = expected->GetColumn(col);
+    vtkAbstractArray* actualCol = actual->GetColumn(col);
+    vtkDataArray* expectedData = vtkDataArray::SafeDownCast(expectedCol);
+    vtkDataArray* actualData = vtkDataArray::SafeDownCast(actualCol);
+    for (vtkIdType row = 0; row < expected->GetNumberOfRows(); ++row)
+      {
+      if (expectedData && actualData)
+        {
+        double x = expectedData->GetTuple1(row);
+        double y = actualData->GetTuple1(row);
+        if (fabs(x - y) > 1e-8 * (1.0 + fabs(x)))
+          {
+          cerr << "Column " << expectedCol->GetName() << ", row " << row
+            << ": expected " << x << ", got " << y << endl;
+          return 1;
+          }
+        }
+      else if (expectedCol->GetVariantValue(row).ToString() !=
+        actualCol->GetVariantValue(row).ToString())
+        {
+        cerr << "Column " << expectedCol->GetName() << ", row " << row
+          << ": expected " << expectedCol->GetVariantValue(row).ToString()
+          << ", got " << actualCol->GetVariantValue(row).ToString() << endl;
+        return 1;
+        }
+      }
+    }
+  return 0;
+}
+
+static int CompareModels(vtkSciVizStatistics* tableFilter,
+  vtkSciVizStatistics* streamingFilter, vtkPolyData* observations)
+{
+  vtkSciVizStatistics* filters[2] = { tableFilter, streamingFilter };
+  for (int i = 0; i < 2; ++i)
+    {
+    filters[i]->SetInput(0, observations);
+    filters[i]->EnableAttributeArray("A");
+    filters[i]->EnableAttributeArray("B");
+    filters[i]->EnableAttributeArray("V");
+    filters[i]->SetTask(vtkSciVizStatistics::FULL_STATISTICS);
+    filters[i]->SetStreamingMode(i);
+    filters[i]->Update();
+    }
+
+  vtkMultiBlockDataSet* expected =
+    vtkMultiBlockDataSet::SafeDownCast(tableFilter->GetOutputDataObject(0));
+  vtkMultiBlockDataSet* actual =
+    vtkMultiBlockDataSet::SafeDownCast(streamingFilter->GetOutputDataObject(0));
+  if (!expected || !actual ||
+    expected->GetNumberOfBlocks() != actual->GetNumberOfBlocks())
+    {
+    cerr << "The models do not have the same blocks." << endl;
+    return 1;
+    }
+  for (unsigned int blk = 0; blk < expected->GetNumberOfBlocks(); ++blk)
+    {
+    if (CompareTables(vtkTable::SafeDownCast(expected->GetBlock(blk)),
+        vtkTable::SafeDownCast(actual->GetBlock(blk))))
+      {
+      cerr << "Block " << blk << " of the "
+        << tableFilter->GetClassName() << " model differs." << endl;
+      return 1;
+      }
+    }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef VTK_USE_MPI
+  vtkMPIController* controller = vtkMPIController::New();
+#else
+  vtkDummyController* controller = vtkDummyController::New();
+#endif
+  controller->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(controller);
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(4);
+
+  vtkSmartPointer<vtkPolyData> observations =
+    MakeObservations(controller->GetLocalProcessId());
+
+  vtkSmartPointer<vtkPSciVizMultiCorrelativeStats> mcTable =
+    vtkSmartPointer<vtkPSciVizMultiCorrelativeStats>::New();
+  vtkSmartPointer<vtkPSciVizMultiCorrelativeStats> mcStreaming =
+    vtkSmartPointer<vtkPSciVizMultiCorrelativeStats>::New();
+  int status = CompareModels(mcTable, mcStreaming, observations);
+
+  vtkSmartPointer<vtkPSciVizPCAStats> pcaTable =
+    vtkSmartPointer<vtkPSciVizPCAStats>::New();
+  vtkSmartPointer<vtkPSciVizPCAStats> pcaStreaming =
+    vtkSmartPointer<vtkPSciVizPCAStats>::New();
+  status |= CompareModels(pcaTable, pcaStreaming, observations);
+
+  vtkMultiThreader::SetGlobalDefaultNumberOfThreads(0);
+  int globalStatus = status;
+  controller->AllReduce(&status, &globalStatus, 1, vtkCommunicator::MAX_OP);
+  vtkMultiProcessController::SetGlobalController(0);
+  controller->Finalize();
+  controller->Delete();
+  return globalStatus;
+}
@@ -0,0 +1,130 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestTableStreamer.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkSmartPointer.h"
+#include "vtkTable.h"
+#include "vtkTableStreamer.h"
+
+static const vtkIdType NumberOfRows = 1000;
+static const vtkIdType BlockSize = 64;
+
+// Values with many duplicates so that ties have to be broken by the row index.
+static double Value(vtkIdType row)
+{
+  return static_cast<double>((row * 37) % 101);
+}
+
+// Fetches all the blocks and checks that they list every row once, in the
+// sorted order.
+static int CheckOrder(vtkTableStreamer* streamer, bool ascending)
+{
+  streamer->SetSortAscending(ascending ? 1 : 0);
+  vtkIdType numBlocks = (NumberOfRows + BlockSize - 1) / BlockSize;
+  vtkIdType numPassed = 0;
+  double lastValue = 0.0;
+  vtkIdType lastIndex = -1;
+  for (vtkIdType block = 0; block < numBlocks; ++block)
+    {
+    streamer->SetBlock(block);
+    streamer->Update();
+    vtkTable* output = vtkTable::SafeDownCast(streamer->GetOutputDataObject(0));
+    vtkDoubleArray* values = vtkDoubleArray::SafeDownCast(
+      output->GetColumnByName("Value"));
+    vtkIdTypeArray* indices = vtkIdTypeArray::SafeDownCast(
+      output->GetColumnByName("vtkOriginalIndices"));
+    if (!values || !indices)
+      {
+      cerr << "Missing columns in block " << block << endl;
+      return 1;
+      }
+    for (vtkIdType row = 0; row < output->GetNumberOfRows(); ++row)
+      {
+      double value = values->GetValue(row);
+      vtkIdType index = indices->GetValue(row);
+      if (value != Value(index))
+        {
+        cerr << "Row " << index << " has the wrong value." << endl;
+        return 1;
+        }
+      if (lastIndex >= 0)
+        {
+        bool ordered = ascending ? (lastValue < value) : (lastValue > value);
+        if (!ordered && !(lastValue == value && lastIndex < index))
+          {
+          cerr << "Row " << index << " is out of order in block " << block
+               << endl;
+          return 1;
+          }
+        }
+      lastValue = value;
+      lastIndex = index;
+      ++numPassed;
+      }
+    }
+  if (numPassed != NumberOfRows)
+    {
+    cerr << numPassed << " rows passed instead of " << NumberOfRows << endl;
+    return 1;
+    }
+  return 0;
+}
+
+/// Streams a table sorted by a column in both orders.
+int main(int, char*[])
+{
+  vtkSmartPointer<vtkDoubleArray> values =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  values->SetName("Value");
+  values->SetNumberOfTuples(NumberOfRows);
+  for (vtkIdType row = 0; row < NumberOfRows; ++row)
+    {
+    values->SetValue(row, Value(row));
+    }
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  table->AddColumn(values);
+
+  vtkSmartPointer<vtkTableStreamer> streamer =
+    vtkSmartPointer<vtkTableStreamer>::New();
+  streamer->SetInput(table);
+  streamer->SetBlockSize(BlockSize);
+  streamer->SetGenerateOriginalIds(1);
+  streamer->SetSortColumnName("Value");
+  if (CheckOrder(streamer, true) || CheckOrder(streamer, false))
+    {
+    return 1;
+    }
+
+  // The cached order has to follow changes of the data.
+  for (vtkIdType row = 0; row < NumberOfRows; ++row)
+    {
+    values->SetValue(row, Value(NumberOfRows - 1 - row));
+    }
+  table->Modified();
+  streamer->SetBlock(0);
+  streamer->Update();
+  vtkTable* output = vtkTable::SafeDownCast(streamer->GetOutputDataObject(0));
+  vtkIdTypeArray* indices = vtkIdTypeArray::SafeDownCast(
+    output->GetColumnByName("vtkOriginalIndices"));
+  // The largest value (100) is now at the row that had 0 in it.
+  vtkIdType first = indices ? indices->GetValue(0) : -1;
+  if (first < 0 || values->GetValue(first) != 100.0)
+    {
+    cerr << "The sorted order was not updated." << endl;
+    return 1;
+    }
+  return 0;
+}
@@ -15,6 +15,7 @@
 #include "vtkAMRDualClip.h"
 #include "vtkAMRDualGridHelper.h"
 
+#include "vtkstd/map"
 #include "vtkstd/vector"
 
 // Pipeline & VTK
@@ -45,6 +46,7 @@
 #include "vtkIntArray.h"
 #include "vtkUnsignedCharArray.h"
 #include "vtkUnsignedCharArray.h"
+#include "vtkMultiThreader.h"
 #include <math.h>
 #include <ctime>
 
@@ -404,9 +406,19 @@ public:
     vtkAMRDualClipLocator* neighborLocator,
     int rx, int ry, int rz);
 
+ // Description:
+ // Copies the point ids of the block locator into the neighbor locator.
+ // With a point map, the neighbor locator is left as is and the point map
+ // entry of every id already in the neighbor locator is set to the id of
+ // the block locator instead.
  void ShareBlockLocatorWithNeighbor(
     vtkAMRDualGridHelperBlock* block,
-    vtkAMRDualGridHelperBlock* neighbor);
+    vtkAMRDualGridHelperBlock* neighbor,
+    vtkIdType* pointMap = 0);
+
+  // Description:
+  // Replaces every point id of the locator by its entry in the point map.
+  void MapPointIds(const vtkIdType* pointMap);
 
   // The level mask could be a separate object, but it is used
   // by the locator to position points.
@@ -1205,9 +1217,30 @@ void vtkAMRDualClipLocator::SharePointIdsWithNeighbor(
 // This version works with higher level neighbor blocks.
 // Move the points on boundaries to neighbor locator so there will
 // not be duplicate coincident points between blocks.
+// Passes one point id of a block locator to the neighbor locator, or maps
+// the id of the neighbor locator to it.
+static inline void vtkAMRDualClipSharePointId(
+  vtkIdType pointId, vtkIdType* neighborId, vtkIdType* pointMap)
+{
+  if (pointId < 0)
+    {
+    return;
+    }
+  if (pointMap == 0)
+    {
+    *neighborId = pointId;
+    }
+  else if (*neighborId >= 0)
+    {
+    pointMap[*neighborId] = pointId;
+    }
+}
+
+//----------------------------------------------------------------------------
 void vtkAMRDualClipLocator::ShareBlockLocatorWithNeighbor(
   vtkAMRDualGridHelperBlock* block,
-  vtkAMRDualGridHelperBlock* neighbor)
+  vtkAMRDualGridHelperBlock* neighbor,
+  vtkIdType* pointMap)
 {
   vtkAMRDualClipLocator* blockLocator = vtkAMRDualClipGetBlockLocator(block);
   vtkAMRDualClipLocator* neighborLocator = vtkAMRDualClipGetBlockLocator(neighbor);
@@ -1262,7 +1295,6 @@ void vtkAMRDualClipLocator::ShareBlockLocatorWithNeighbor(
   if (ext[5] < 0) { ext[5] = 0; }
   if (ext[5] > blockLocator->DualCellDimensions[2]) { ext[5] = blockLocator->DualCellDimensions[2]; }
 
-  vtkIdType pointId;
   int xOut, yOut, zOut;
   int inOffsetZ, inOffsetY, inOffsetX, outOffsetX, outOffsetY, outOffsetZ;
   inOffsetZ = ext[0] + ext[2]*blockLocator->YIncrement + ext[4]*blockLocator->ZIncrement;
@@ -1287,26 +1319,14 @@ void vtkAMRDualClipLocator::ShareBlockLocatorWithNeighbor(
         if (xOut < 0) { xOut = 0; }
         outOffsetX = outOffsetY + xOut;
 
-        pointId = blockLocator->XEdges[inOffsetX];
-        if (pointId >= 0)
-          {
-          neighborLocator->XEdges[outOffsetX] = pointId;
-          }
-        pointId = blockLocator->YEdges[inOffsetX];
-        if (pointId >= 0)
-          {
-          neighborLocator->YEdges[outOffsetX] = pointId;
-          }
-        pointId = blockLocator->ZEdges[inOffsetX];
-        if (pointId >= 0)
-          {
-          neighborLocator->ZEdges[outOffsetX] = pointId;
-          }
-        pointId = blockLocator->Corners[inOffsetX];
-        if (pointId >= 0)
-          {
-          neighborLocator->Corners[outOffsetX] = pointId;
-          }
+        vtkAMRDualClipSharePointId(blockLocator->XEdges[inOffsetX],
+          neighborLocator->XEdges + outOffsetX, pointMap);
+        vtkAMRDualClipSharePointId(blockLocator->YEdges[inOffsetX],
+          neighborLocator->YEdges + outOffsetX, pointMap);
+        vtkAMRDualClipSharePointId(blockLocator->ZEdges[inOffsetX],
+          neighborLocator->ZEdges + outOffsetX, pointMap);
+        vtkAMRDualClipSharePointId(blockLocator->Corners[inOffsetX],
+          neighborLocator->Corners + outOffsetX, pointMap);
 
         inOffsetX += 1;
         }
@@ -1316,12 +1336,322 @@ void vtkAMRDualClipLocator::ShareBlockLocatorWithNeighbor(
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkAMRDualClipLocator::MapPointIds(const vtkIdType* pointMap)
+{
+  vtkIdType* arrays[4] = { this->XEdges, this->YEdges, this->ZEdges,
+                           this->Corners };
+  for (int ii = 0; ii < 4; ++ii)
+    {
+    vtkIdType* ptr = arrays[ii];
+    for (int idx = 0; idx < this->ArrayLength; ++idx)
+      {
+      if (ptr[idx] >= 0)
+        {
+        ptr[idx] = pointMap[ptr[idx]];
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Collects the neighbors of a block in the same level or higher (the ones
+// it shares its locator and level mask with) or, with lower set, in the
+// same level or lower (the ones it gets its ghost level mask from).
+static void vtkAMRDualClipGetNeighbors(
+  vtkAMRDualGridHelper* helper, vtkAMRDualGridHelperBlock* block, int lower,
+  vtkstd::vector<vtkAMRDualGridHelperBlock*>& neighbors)
+{
+  neighbors.clear();
+  vtkAMRDualGridHelperBlock* neighbor;
+  int firstLevel = lower ? 0 : block->Level;
+  int lastLevel = lower ? block->Level : helper->GetNumberOfLevels() - 1;
+  int xMid, yMid, zMid;
+  int xMin, xMax, yMin, yMax, zMin, zMax;
+
+  for (int level = firstLevel; level <= lastLevel; ++level)
+    {
+    // Neighborhood.
+    xMid = block->GridIndex[0];
+    yMid = block->GridIndex[1];
+    zMid = block->GridIndex[2];
+    int levelDiff;
+    if (lower)
+      {
+      levelDiff = block->Level - level;
+      xMin = (xMid >> levelDiff) - 1;
+      xMax = (xMid+1) >> levelDiff;
+      yMin = (yMid >> levelDiff) - 1;
+      yMax = (yMid+1) >> levelDiff;
+      zMin = (zMid >> levelDiff) - 1;
+      zMax = (zMid+1) >> levelDiff;
+      }
+    else
+      {
+      levelDiff = level - block->Level;
+      xMin = (xMid << levelDiff) - 1;
+      xMax = (xMid+1) << levelDiff;
+      yMin = (yMid << levelDiff) - 1;
+      yMax = (yMid+1) << levelDiff;
+      zMin = (zMid << levelDiff) - 1;
+      zMax = (zMid+1) << levelDiff;
+      }
+
+    for (int iz = zMin; iz <=zMax; ++iz)
+      {
+      for (int iy = yMin; iy <=yMax; ++iy)
+        {
+        for (int ix = xMin; ix <=xMax; ++ix)
+          {
+          int self = lower ?
+            ((ix << levelDiff) == xMid && (iy << levelDiff) == yMid &&
+             (iz << levelDiff) == zMid) :
+            ((ix >> levelDiff) == xMid && (iy >> levelDiff) == yMid &&
+             (iz >> levelDiff) == zMid);
+          if (!self)
+            {
+            neighbor = helper->GetBlock(level, ix, iy, iz);
+            if (neighbor)
+              {
+              neighbors.push_back(neighbor);
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
 
 
 
 
 
 
+//============================================================================
+// The dual cells of a block that generate some tetrahedra.
+class vtkAMRDualClipCells
+{
+public:
+  // Index of the first corner of the cell in the scalar array of the block.
+  vtkstd::vector<int> Offsets;
+  // Clipping case of the cell.
+  vtkstd::vector<unsigned char> Cases;
+};
+
+//----------------------------------------------------------------------------
+// The local blocks, split in contiguous ranges, one per thread.  Each
+// thread classifies and processes its blocks with its own worker.
+// When points are merged, a block only passes level masks and point ids to
+// the blocks of its thread.  The blocks on the boundary between two
+// threads compute their level mask first and keep their locators: the
+// blocks of the other thread copy the level mask themselves, and the
+// points a block made again are mapped to the ones of the earlier thread
+// when the outputs are appended.
+class vtkAMRDualClipTask
+{
+public:
+  vtkstd::vector<vtkAMRDualGridHelperBlock*> Blocks;
+  vtkstd::vector<int> BlockIds;
+  vtkstd::vector<vtkDataArray*> Scalars;
+  vtkstd::vector<vtkAMRDualClip*> Workers;
+
+  // Only used to merge points.
+  vtkstd::map<vtkAMRDualGridHelperBlock*, int> Indices;
+  vtkstd::vector<int> Threads;
+  // Blocks of earlier threads that pass point ids to each block, in the
+  // order they are processed.
+  vtkstd::vector<vtkstd::vector<int> > Sources;
+  vtkstd::vector<unsigned char> Keep;
+
+  int GetFirstBlock(int threadId, int numThreads)
+    {
+    return static_cast<int>(
+      (this->Blocks.size() * threadId) / numThreads);
+    }
+
+  // Returns -1 for blocks that are not processed here.
+  int GetThread(vtkAMRDualGridHelperBlock* block)
+    {
+    vtkstd::map<vtkAMRDualGridHelperBlock*, int>::const_iterator it =
+      this->Indices.find(block);
+    return it == this->Indices.end() ? -1 : this->Threads[it->second];
+    }
+
+  int KeepLocator(vtkAMRDualGridHelperBlock* block)
+    {
+    vtkstd::map<vtkAMRDualGridHelperBlock*, int>::const_iterator it =
+      this->Indices.find(block);
+    return it != this->Indices.end() && this->Keep[it->second];
+    }
+
+  // Finds the blocks that share level masks or points with the blocks of
+  // other threads and computes their level masks.
+  void InitializeMergePoints(vtkAMRDualGridHelper* helper, int numThreads,
+                             double isoValue)
+    {
+    int numBlocks = static_cast<int>(this->Blocks.size());
+    this->Threads.resize(numBlocks);
+    this->Sources.assign(numBlocks, vtkstd::vector<int>());
+    this->Keep.assign(numBlocks, 0);
+    for (int threadId = 0; threadId < numThreads; ++threadId)
+      {
+      int end = this->GetFirstBlock(threadId + 1, numThreads);
+      for (int ii = this->GetFirstBlock(threadId, numThreads); ii < end; ++ii)
+        {
+        this->Threads[ii] = threadId;
+        this->Indices[this->Blocks[ii]] = ii;
+        }
+      }
+    vtkstd::vector<vtkAMRDualGridHelperBlock*> neighbors;
+    for (int ii = 0; ii < numBlocks; ++ii)
+      {
+      for (int lower = 0; lower < 2; ++lower)
+        {
+        vtkAMRDualClipGetNeighbors(helper, this->Blocks[ii], lower, neighbors);
+        for (size_t kk = 0; kk < neighbors.size(); ++kk)
+          {
+          vtkstd::map<vtkAMRDualGridHelperBlock*, int>::const_iterator it =
+            this->Indices.find(neighbors[kk]);
+          if (it == this->Indices.end() ||
+              this->Threads[it->second] == this->Threads[ii])
+            {
+            continue;
+            }
+          this->Keep[ii] = 1;
+          this->Keep[it->second] = 1;
+          // Only blocks processed later get the point ids.
+          if (!lower && it->second > ii)
+            {
+            this->Sources[it->second].push_back(ii);
+            }
+          }
+        }
+      }
+    for (int ii = 0; ii < numBlocks; ++ii)
+      {
+      if (this->Keep[ii])
+        {
+        vtkAMRDualClipGetBlockLocator(this->Blocks[ii])->ComputeLevelMask(
+          this->Scalars[ii], isoValue);
+        }
+      }
+    }
+
+  // Maps the points that the blocks of a thread share with the blocks of
+  // earlier threads to the output points.
+  void MapSharedPoints(int threadId, int numThreads,
+                       vtkstd::vector<vtkIdType>& pointMap)
+    {
+    if (pointMap.empty())
+      {
+      return;
+      }
+    int end = this->GetFirstBlock(threadId + 1, numThreads);
+    for (int ii = this->GetFirstBlock(threadId, numThreads); ii < end; ++ii)
+      {
+      for (size_t kk = 0; kk < this->Sources[ii].size(); ++kk)
+        {
+        vtkAMRDualGridHelperBlock* source = this->Blocks[this->Sources[ii][kk]];
+        vtkAMRDualClipGetBlockLocator(source)->ShareBlockLocatorWithNeighbor(
+          source, this->Blocks[ii], &pointMap[0]);
+        }
+      }
+    }
+
+  // Once a thread is appended, its locators refer to output points for the
+  // blocks of the next threads.
+  void MapLocators(int threadId, int numThreads,
+                   vtkstd::vector<vtkIdType>& pointMap)
+    {
+    if (pointMap.empty())
+      {
+      return;
+      }
+    int end = this->GetFirstBlock(threadId + 1, numThreads);
+    for (int ii = this->GetFirstBlock(threadId, numThreads); ii < end; ++ii)
+      {
+      if (this->Keep[ii])
+        {
+        vtkAMRDualClipGetBlockLocator(this->Blocks[ii])->MapPointIds(
+          &pointMap[0]);
+        }
+      }
+    }
+
+  void DeleteLocators()
+    {
+    for (size_t ii = 0; ii < this->Keep.size(); ++ii)
+      {
+      if (this->Keep[ii])
+        {
+        delete vtkAMRDualClipGetBlockLocator(this->Blocks[ii]);
+        this->Blocks[ii]->UserData = 0;
+        }
+      }
+    }
+
+  // Appends the tetrahedra of a worker to the output.  Points already
+  // mapped to an output point are not copied; the others are added in
+  // order.
+  static void Append(vtkAMRDualClip* self, vtkAMRDualClip* worker,
+                     vtkstd::vector<vtkIdType>& pointMap)
+    {
+    vtkIdType numPoints = worker->Points->GetNumberOfPoints();
+    for (vtkIdType ii = 0; ii < numPoints; ++ii)
+      {
+      if (pointMap[ii] < 0)
+        {
+        pointMap[ii] =
+          self->Points->InsertNextPoint(worker->Points->GetPoint(ii));
+        self->LevelMaskPointArray->InsertNextValue(
+          worker->LevelMaskPointArray->GetValue(ii));
+        }
+      }
+    vtkIdType npts;
+    vtkIdType* pts;
+    worker->Cells->InitTraversal();
+    while (worker->Cells->GetNextCell(npts, pts))
+      {
+      self->Cells->InsertNextCell(static_cast<int>(npts));
+      for (vtkIdType ii = 0; ii < npts; ++ii)
+        {
+        self->Cells->InsertCellPoint(pointMap[pts[ii]]);
+        }
+      }
+    vtkIdType numValues = worker->BlockIdCellArray->GetNumberOfTuples();
+    for (vtkIdType ii = 0; ii < numValues; ++ii)
+      {
+      self->BlockIdCellArray->InsertNextValue(
+        worker->BlockIdCellArray->GetValue(ii));
+      }
+    }
+
+  void Execute(int threadId, int numThreads)
+    {
+    vtkAMRDualClip* worker = this->Workers[threadId];
+    vtkAMRDualClipCells cells;
+    int end = this->GetFirstBlock(threadId + 1, numThreads);
+    for (int ii = this->GetFirstBlock(threadId, numThreads); ii < end; ++ii)
+      {
+      worker->ClassifyBlock(this->Blocks[ii], this->Scalars[ii], &cells);
+      worker->ProcessBlock(this->Blocks[ii], this->BlockIds[ii],
+                           this->Scalars[ii], &cells);
+      }
+    }
+};
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkAMRDualClipThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkAMRDualClipTask* task =
+    static_cast<vtkAMRDualClipTask*>(info->UserData);
+  task->Execute(info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //============================================================================
 //----------------------------------------------------------------------------
 // Description:
@@ -1344,6 +1674,8 @@ vtkAMRDualClip::vtkAMRDualClip()
   this->Helper = 0;
 
   this->BlockLocator = 0;
+  this->Task = 0;
+  this->ThreadId = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -1507,17 +1839,106 @@ vtkAMRDualClip::DoRequestData(vtkHierarchicalBoxDataSet* hbdsInput,
   int numBlocks;
   int blockId;
 
-  // Add each block.
+  // Collect the local blocks in the order they have to be processed.
+  // Remote blocks are only to setup local block bit flags.
+  vtkAMRDualClipTask task;
   for (int level = 0; level < numLevels; ++level)
     {
     numBlocks = this->Helper->GetNumberOfBlocksInLevel(level);
     for (blockId = 0; blockId < numBlocks; ++blockId)
       {
       vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-      this->ProcessBlock(block, blockId, arrayNameToProcess);
+      // We are looking for only cell data arrays.
+      vtkDataArray* scalars = 0;
+      if (block->Image)
+        {
+        scalars = block->Image->GetCellData()->GetArray(arrayNameToProcess);
+        }
+      if (scalars)
+        {
+        task.Blocks.push_back(block);
+        task.BlockIds.push_back(blockId);
+        task.Scalars.push_back(scalars);
+        }
       }
     }
 
+  // Add each block.
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  int numThreads = threader->GetNumberOfThreads();
+  numBlocks = static_cast<int>(task.Blocks.size());
+  if (numThreads > numBlocks)
+    {
+    numThreads = numBlocks;
+    }
+  threader->SetNumberOfThreads(numThreads > 0 ? numThreads : 1);
+  threader->SetSingleMethod(vtkAMRDualClipThread, &task);
+  if (numThreads <= 1)
+    {
+    vtkAMRDualClipCells cells;
+    for (int ii = 0; ii < numBlocks; ++ii)
+      {
+      this->ClassifyBlock(task.Blocks[ii], task.Scalars[ii], &cells);
+      this->ProcessBlock(task.Blocks[ii], task.BlockIds[ii],
+                         task.Scalars[ii], &cells);
+      }
+    }
+  else
+    {
+    // Each thread processes a contiguous range of blocks with its own
+    // locators and output, which are appended in order so that the result
+    // does not depend on the number of threads.  The points a block shares
+    // with the blocks of an earlier thread are merged while appending.
+    if (this->EnableMergePoints)
+      {
+      task.InitializeMergePoints(this->Helper, numThreads, this->IsoValue);
+      }
+    for (int ii = 0; ii < numThreads; ++ii)
+      {
+      vtkAMRDualClip* worker = vtkAMRDualClip::New();
+      worker->IsoValue = this->IsoValue;
+      worker->EnableDegenerateCells = this->EnableDegenerateCells;
+      worker->EnableMergePoints = this->EnableMergePoints;
+      worker->Helper = this->Helper;
+      worker->Points = vtkPoints::New();
+      worker->Cells = vtkCellArray::New();
+      worker->BlockIdCellArray = vtkIntArray::New();
+      worker->LevelMaskPointArray = vtkUnsignedCharArray::New();
+      worker->Task = &task;
+      worker->ThreadId = ii;
+      task.Workers.push_back(worker);
+      }
+    threader->SingleMethodExecute();
+    for (int ii = 0; ii < numThreads; ++ii)
+      {
+      vtkAMRDualClip* worker = task.Workers[ii];
+      vtkstd::vector<vtkIdType> pointMap(
+        worker->Points->GetNumberOfPoints(), -1);
+      if (this->EnableMergePoints)
+        {
+        task.MapSharedPoints(ii, numThreads, pointMap);
+        }
+      vtkAMRDualClipTask::Append(this, worker, pointMap);
+      if (this->EnableMergePoints)
+        {
+        task.MapLocators(ii, numThreads, pointMap);
+        }
+      worker->Points->Delete();
+      worker->Points = 0;
+      worker->Cells->Delete();
+      worker->Cells = 0;
+      worker->BlockIdCellArray->Delete();
+      worker->BlockIdCellArray = 0;
+      worker->LevelMaskPointArray->Delete();
+      worker->LevelMaskPointArray = 0;
+      worker->Helper = 0;
+      worker->Task = 0;
+      worker->Delete();
+      }
+    task.DeleteLocators();
+    }
+  threader->Delete();
+
   this->BlockIdCellArray->Delete();
   this->BlockIdCellArray = 0;
   this->LevelMaskPointArray->Delete();
@@ -1562,48 +1983,24 @@ void vtkDualGridClipExtractCornerValues(
 void vtkAMRDualClip::ShareBlockLocatorWithNeighbors(
   vtkAMRDualGridHelperBlock* block)
 {
-  vtkAMRDualGridHelperBlock* neighbor;
   // Blocks are processed low level to high so, we only need to share
   // the locator with blocks in the same level or higher.
-  int numLevels = this->Helper->GetNumberOfLevels();
-  int xMid, yMid, zMid;
-  int xMin, xMax, yMin, yMax, zMin, zMax;
-
-  for (int level = block->Level; level < numLevels; ++level)
-    {
-    // Neighborhood.
-    int levelDiff = level - block->Level;
-    xMid = block->GridIndex[0];
-    xMin = (xMid << levelDiff) - 1;
-    xMax = (xMid+1) << levelDiff;
-    yMid = block->GridIndex[1];
-    yMin = (yMid << levelDiff) - 1;
-    yMax = (yMid+1) << levelDiff;
-    zMid = block->GridIndex[2];
-    zMin = (zMid << levelDiff) - 1;
-    zMax = (zMid+1) << levelDiff;
-
-    // Lets just start with neighbors in the same level.
-    for (int iz = zMin; iz <=zMax; ++iz)
+  vtkstd::vector<vtkAMRDualGridHelperBlock*> neighbors;
+  vtkAMRDualClipGetNeighbors(this->Helper, block, 0, neighbors);
+  for (size_t ii = 0; ii < neighbors.size(); ++ii)
+    {
+    vtkAMRDualGridHelperBlock* neighbor = neighbors[ii];
+    // The blocks of other threads are merged with this one at the end.
+    // Their locators are not ours to touch.
+    if (this->Task && this->Task->GetThread(neighbor) != this->ThreadId)
       {
-      for (int iy = yMin; iy <=yMax; ++iy)
-        {
-        for (int ix = xMin; ix <=xMax; ++ix)
-          {
-          if ((ix >> levelDiff) != xMid ||
-              (iy >> levelDiff) != yMid ||
-              (iz >> levelDiff) != zMid)
-            {
-            neighbor = this->Helper->GetBlock(level, ix, iy, iz);
-            // The unused center flag is used as a flag to indicate
-            if (neighbor && neighbor->Image && neighbor->RegionBits[1][1][1])
-              {
-              vtkAMRDualClipLocator* blockLocator = vtkAMRDualClipGetBlockLocator(block);
-              blockLocator->ShareBlockLocatorWithNeighbor(block, neighbor);
-              }
-            }
-          }
-        }
+      continue;
+      }
+    // The unused center flag is used as a flag to indicate
+    if (neighbor->Image && neighbor->RegionBits[1][1][1])
+      {
+      vtkAMRDualClipLocator* blockLocator = vtkAMRDualClipGetBlockLocator(block);
+      blockLocator->ShareBlockLocatorWithNeighbor(block, neighbor);
       }
     }
 }
@@ -1663,9 +2060,17 @@ void vtkAMRDualClip::InitializeLevelMask(vtkAMRDualGridHelperBlock* block)
             {
             // I could further prune and only copy to regions I own.
             neighbor = this->Helper->GetBlock(level, ix, iy, iz);
+            int neighborThread = this->Task && neighbor ?
+              this->Task->GetThread(neighbor) : -1;
+            if (neighborThread >= 0 && neighborThread != this->ThreadId)
+              {
+              // The blocks of other threads do not pass their level mask.
+              // It was computed before the threads started.
+              locator->CopyNeighborLevelMask(block, neighbor);
+              }
             // If the neighbor was already processed, then its level mask
             // was copied to this block already.
-            if (neighbor && neighbor->RegionBits[1][1][1] != 0)
+            else if (neighbor && neighbor->RegionBits[1][1][1] != 0)
               {
               neighborLocator = vtkAMRDualClipGetBlockLocator(neighbor);
               image = neighbor->Image;
@@ -1754,6 +2159,12 @@ void vtkAMRDualClip::ShareLevelMask(vtkAMRDualGridHelperBlock* block)
             {
             // I could further prune and only copy to regions owned by neighbor.
             neighbor = this->Helper->GetBlock(level, ix, iy, iz);
+            // The blocks of other threads copy the level mask themselves.
+            if (neighbor && this->Task &&
+                this->Task->GetThread(neighbor) != this->ThreadId)
+              {
+              continue;
+              }
             // If the neighbor was already processed, then its level mask
             // was copied to this block already.
             if (neighbor && neighbor->Image && neighbor->RegionBits[1][1][1] != 0)
@@ -1770,27 +2181,115 @@ void vtkAMRDualClip::ShareLevelMask(vtkAMRDualGridHelperBlock* block)
 
 
 //----------------------------------------------------------------------------
-void vtkAMRDualClip::ProcessBlock(vtkAMRDualGridHelperBlock* block,
-                                  int blockId, const char* arrayNameToProcess)
+// Sets mask[i] to 1 if value i is above the iso value, 0 otherwise.
+// The loop has no branches so that the compiler can vectorize it.
+template <class T>
+void vtkDualGridClipComputeMask(
+  T* ptr, vtkIdType numValues, double isoValue,
+  unsigned char* mask)
 {
-  vtkImageData* image = block->Image;
-  if (image == 0)
-    { // Remote blocks are only to setup local block bit flags.
+  for (vtkIdType idx = 0; idx < numValues; ++idx)
+    {
+    mask[idx] = static_cast<unsigned char>(
+      static_cast<double>(ptr[idx]) > isoValue);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkAMRDualClip::ClassifyBlock(vtkAMRDualGridHelperBlock* block,
+                                   vtkDataArray* scalars,
+                                   vtkAMRDualClipCells* cells)
+{
+  cells->Offsets.clear();
+  cells->Cases.clear();
+  int extent[6];
+  // This is the same as the cell extent of the original grid (with ghosts).
+  block->Image->GetExtent(extent);
+  --extent[1];
+  --extent[3];
+  --extent[5];
+  int xDim = extent[1]-extent[0]+1;
+  int yInc = xDim;
+  int zInc = yInc * (extent[3]-extent[2]+1);
+  vtkIdType numValues = static_cast<vtkIdType>(zInc) * (extent[5]-extent[4]+1);
+  if (xDim < 2 || numValues <= 0)
+    {
     return;
     }
 
-  // We are looking for only cell data arrays.
-  vtkDataArray* volumeFractionArray =
-    image->GetCellData()->GetArray(arrayNameToProcess);
+  // First pass: one bit per value.
+  vtkstd::vector<unsigned char> mask(numValues);
+  switch (scalars->GetDataType())
+    {
+    vtkTemplateMacro(vtkDualGridClipComputeMask(
+                     static_cast<VTK_TT*>(scalars->GetVoidPointer(0)),
+                     numValues, this->IsoValue, &mask[0]));
+    default:
+      vtkGenericWarningMacro("Execute: Unknown ScalarType");
+      return;
+    }
 
-  if(!volumeFractionArray)
+  // Second pass: the case of a row of cells at a time.
+  // Bits follow the corner order of vtkDualGridClipExtractCornerValues.
+  vtkstd::vector<unsigned char> rowCases(xDim-1);
+  int xMax = extent[1]-1;
+  int yMax = extent[3]-1;
+  int zMax = extent[5]-1;
+  for (int z = extent[4]; z < extent[5]; ++z)
     {
+    int nz = 1;
+    if (z == extent[4]) {nz = 0;}
+    else if (z == zMax) {nz = 2;}
+    for (int y = extent[2]; y < extent[3]; ++y)
+      {
+      int ny = 1;
+      if (y == extent[2]) {ny = 0;}
+      else if (y == yMax) {ny = 2;}
+      int rowOffset = (y-extent[2])*yInc + (z-extent[4])*zInc;
+      const unsigned char* m = &mask[rowOffset];
+      unsigned char* c = &rowCases[0];
+      for (int x = 0; x < xDim-1; ++x)
+        {
+        c[x] = static_cast<unsigned char>(
+          m[x] | (m[x+1]<<1) | (m[x+yInc]<<2) | (m[x+1+yInc]<<3) |
+          (m[x+zInc]<<4) | (m[x+1+zInc]<<5) | (m[x+yInc+zInc]<<6) |
+          (m[x+1+yInc+zInc]<<7));
+        }
+      for (int x = extent[0]; x < extent[1]; ++x)
+        {
+        unsigned char cubeCase = c[x-extent[0]];
+        // Same early exit as ProcessDualCell.
+        if (cubeCase == 0)
+          {
+          continue;
+          }
+        int nx = 1;
+        if (x == extent[0]) {nx = 0;}
+        else if (x == xMax) {nx = 2;}
+        // Skip the cell if a neighbor is already processing it.
+        if ( (block->RegionBits[nx][ny][nz] & vtkAMRRegionBitOwner) )
+          {
+          cells->Offsets.push_back(rowOffset + x-extent[0]);
+          cells->Cases.push_back(cubeCase);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkAMRDualClip::ProcessBlock(vtkAMRDualGridHelperBlock* block,
+                                  int blockId,
+                                  vtkDataArray* volumeFractionArray,
+                                  vtkAMRDualClipCells* cells)
+{
+  vtkImageData* image = block->Image;
+  if (image == 0)
+    { // Remote blocks are only to setup local block bit flags.
     return;
     }
 
   void* volumeFractionPtr = volumeFractionArray->GetVoidPointer(0);
-  double  origin[3];
-  double* spacing;
   int     extent[6];
 
   // Get the origin and point extent of the dual grid (with ghost level).
@@ -1816,12 +2315,6 @@ void vtkAMRDualClip::ProcessBlock(vtkAMRDualGridHelperBlock* block,
     this->BlockLocator->Initialize(extent[1]-extent[0], extent[3]-extent[2], extent[5]-extent[4]);
     //this->BlockLocator->CopyRegionLevelDifferences(block);
     }
-  image->GetOrigin(origin);
-  spacing = image->GetSpacing();
-  // Dual cells are shifted half a pixel.
-  origin[0] += 0.5 * spacing[0];
-  origin[1] += 0.5 * spacing[1];
-  origin[2] += 0.5 * spacing[2];
 
   // We deal with the various data types by copying the corner values
   // into a double array.  We have to cast anyway to compute the case.
@@ -1831,104 +2324,31 @@ void vtkAMRDualClip::ProcessBlock(vtkAMRDualGridHelperBlock* block,
   // cast to the correct datatype.
   int yInc = (extent[1]-extent[0]+1);
   int zInc = yInc * (extent[3]-extent[2]+1);
-  // Use void pointers to march through the volume before we cast.
   int dataType = volumeFractionArray->GetDataType();
   int xVoidInc = volumeFractionArray->GetDataTypeSize();
-  int yVoidInc = xVoidInc * yInc;
-  int zVoidInc = xVoidInc * zInc;
-
-  int cubeIndex;
 
-  // Loop over all the cells in the dual grid.
-  int x, y, z;
-  // These are needed to handle the cropped boundary cells.
-  double ox, oy, oz;
-  double sx, sy, sz;
-  int xMax = extent[1]-1;
-  int yMax = extent[3]-1;
-  int zMax = extent[5]-1;
-  //-
-  unsigned char* zPtr = (unsigned char*)(volumeFractionPtr);
-  unsigned char* yPtr;
-  unsigned char* xPtr;
-  for (z = extent[4]; z < extent[5]; ++z)
-    {
-    int nz = 1;
-    if (z == extent[4]) {nz = 0;}
-    else if (z == zMax) {nz = 2;}
-    sz = spacing[2];
-    oz = origin[2] + (double)(z)*sz;
-    yPtr = zPtr;
-    for (y = extent[2]; y < extent[3]; ++y)
+  // Loop over the dual cells found by ClassifyBlock.
+  int numCells = static_cast<int>(cells->Offsets.size());
+  for (int ii = 0; ii < numCells; ++ii)
+    {
+    int offset = cells->Offsets[ii];
+    int x = extent[0] + offset % yInc;
+    int y = extent[2] + (offset % zInc) / yInc;
+    int z = extent[4] + offset / zInc;
+    unsigned char* xPtr =
+      static_cast<unsigned char*>(volumeFractionPtr) + offset * xVoidInc;
+    // Get the corner values as doubles
+    switch (dataType)
       {
-      int ny = 1;
-      if (y == extent[2]) {ny = 0;}
-      else if (y == yMax) {ny = 2;}
-      sy = spacing[1];
-      oy = origin[1] + (double)(y)*sy;
-      xPtr = yPtr;
-      for (x = extent[0]; x < extent[1]; ++x)
-        {
-        int nx = 1;
-        if (x == extent[0]) {nx = 0;}
-        else if (x == xMax) {nx = 2;}
-        sx = spacing[0];
-        ox = origin[0] + (double)(x)*sx;
-        // Skip the cell if a neighbor is already processing it.
-        if ( (block->RegionBits[nx][ny][nz] & vtkAMRRegionBitOwner) )
-          {
-          // Get the corner values as doubles
-          switch (dataType)
-            {
-            vtkTemplateMacro(vtkDualGridClipExtractCornerValues(
-                             (VTK_TT *)(xPtr), yInc, zInc,
-                             cornerValues));
-            default:
-              vtkGenericWarningMacro("Execute: Unknown ScalarType");
-            }
-          // compute the case index
-          cubeIndex = 0;
-          if (cornerValues[0] > this->IsoValue)
-            {
-            cubeIndex += 1;
-            }
-          if (cornerValues[1] > this->IsoValue)
-            {
-            cubeIndex += 2;
-            }
-          if (cornerValues[2] > this->IsoValue)
-            {
-            cubeIndex += 4;
-            }
-          if (cornerValues[3] > this->IsoValue)
-            {
-            cubeIndex += 8;
-            }
-          if (cornerValues[4] > this->IsoValue)
-            {
-            cubeIndex += 16;
-            }
-          if (cornerValues[5] > this->IsoValue)
-            {
-            cubeIndex += 32;
-            }
-          if (cornerValues[6] > this->IsoValue)
-            {
-            cubeIndex += 64;
-            }
-          if (cornerValues[7] > this->IsoValue)
-            {
-            cubeIndex += 128;
-            }
-          this->ProcessDualCell(block, blockId,
-                                cubeIndex, x, y, z,
-                                cornerValues);
-          }
-        xPtr += xVoidInc;
-        }
-      yPtr += yVoidInc;
+      vtkTemplateMacro(vtkDualGridClipExtractCornerValues(
+                       (VTK_TT *)(xPtr), yInc, zInc,
+                       cornerValues));
+      default:
+        vtkGenericWarningMacro("Execute: Unknown ScalarType");
       }
-    zPtr += zVoidInc;
+    this->ProcessDualCell(block, blockId,
+                          cells->Cases[ii], x, y, z,
+                          cornerValues);
     }
 
   if (this->EnableMergePoints)
@@ -1936,10 +2356,14 @@ void vtkAMRDualClip::ProcessBlock(vtkAMRDualGridHelperBlock* block,
     this->ShareLevelMask(block);
     // Copy point ids into neighbor locators.
     this->ShareBlockLocatorWithNeighbors(block);
-    // We are done.  We no longer need the locator for this block.
-    delete this->BlockLocator;
+    // We are done.  We no longer need the locator for this block, unless
+    // it shares level masks or points with the blocks of another thread.
+    if (this->Task == 0 || !this->Task->KeepLocator(block))
+      {
+      delete this->BlockLocator;
+      block->UserData = 0;
+      }
     this->BlockLocator = 0;
-    block->UserData = 0;
     // Lets use this unused flag (owner of center region/block) to indicate
     // that the block is already processes.
     // This will keep neighbors from recreating the locator.
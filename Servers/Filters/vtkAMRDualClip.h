@@ -19,6 +19,13 @@
 // transitions are handled correctly, and second is that interal
 // cells are decimated.  I use a variation of degenerate points/cells
 // used for level transitions.
+// The blocks are split in contiguous ranges processed by several threads
+// (see vtkMultiThreader).  With EnableMergePoints, the level masks and
+// point ids are passed between the blocks of a thread.  A block next to
+// the range of another thread gets its ghost level mask from the mask of
+// the neighbor, computed before the threads start, and its points are
+// merged with the ones of the earlier range when the tetrahedra of the
+// threads are appended.
 
 #ifndef __vtkAMRDualClip_h
 #define __vtkAMRDualClip_h
@@ -26,6 +33,7 @@
 #include "vtkMultiBlockDataSetAlgorithm.h"
 
 class vtkDataSet;
+class vtkDataArray;
 class vtkImageData;
 class vtkUnstructuredGrid;
 class vtkHierarchicalBoxDataSet;
@@ -43,6 +51,8 @@ class vtkAMRDualGridHelper;
 class vtkAMRDualGridHelperBlock;
 class vtkAMRDualGridHelperFace;
 class vtkAMRDualClipLocator;
+class vtkAMRDualClipCells;
+class vtkAMRDualClipTask;
 
 
 class VTK_EXPORT vtkAMRDualClip : public vtkMultiBlockDataSetAlgorithm
@@ -101,8 +111,14 @@ protected:
   void ShareBlockLocatorWithNeighbors(
     vtkAMRDualGridHelperBlock* block);
 
+  // Description:
+  // Finds the dual cells of a block that generate some tetrahedra.  This
+  // only reads the block, so several blocks can be classified at once.
+  void ClassifyBlock(vtkAMRDualGridHelperBlock* block, vtkDataArray* scalars,
+                     vtkAMRDualClipCells* cells);
   void ProcessBlock(vtkAMRDualGridHelperBlock* block, int blockId,
-                    const char* arrayName);
+                    vtkDataArray* scalars, vtkAMRDualClipCells* cells);
+  friend class vtkAMRDualClipTask;
 
   void ProcessDualCell(
     vtkAMRDualGridHelperBlock* block, int blockId,
@@ -138,6 +154,11 @@ protected:
 
   vtkAMRDualClipLocator* BlockLocator;
 
+  // Set on the workers of the threads that merge points.  Level masks and
+  // point ids are only passed to the blocks of the same thread.
+  vtkAMRDualClipTask* Task;
+  int ThreadId;
+
 private:
   vtkAMRDualClip(const vtkAMRDualClip&);  // Not implemented.
   void operator=(const vtkAMRDualClip&);  // Not implemented.
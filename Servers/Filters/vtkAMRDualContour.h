@@ -18,6 +18,11 @@
 // surface.  It also performs connectivity on the particles and generates
 // a particle index as part of the cell data of the output.  It computes
 // the volume of each particle from the volume fraction.
+// The blocks are split in contiguous ranges processed by several threads
+// (see vtkMultiThreader).  With EnableMergePoints, edge and corner point
+// ids are passed between the blocks of a thread, and the points on the
+// boundary between two ranges are merged when the polygons of the threads
+// are appended, so the surface is the same for any number of threads.
 
 // This will turn on validation and debug i/o of the filter.
 //#define vtkAMRDualContourDEBUG
@@ -42,11 +47,14 @@ class vtkIntArray;
 class vtkMultiProcessController;
 class vtkDataArraySelection;
 class vtkCallbackCommand;
+class vtkDataArray;
 
 class vtkAMRDualGridHelper;
 class vtkAMRDualGridHelperBlock;
 class vtkAMRDualGridHelperFace;
 class vtkAMRDualContourEdgeLocator;
+class vtkAMRDualContourCells;
+class vtkAMRDualContourTask;
 
 
 class VTK_EXPORT vtkAMRDualContour : public vtkMultiBlockDataSetAlgorithm
@@ -118,7 +126,18 @@ protected:
   void ShareBlockLocatorWithNeighbors(
     vtkAMRDualGridHelperBlock* block);
 
-  void ProcessBlock(vtkAMRDualGridHelperBlock* block, int blockId);
+  // Description:
+  // Finds the dual cells of a block that generate some surface.  The cases
+  // of a whole row of cells are computed at once from a mask of the values
+  // above the iso value.  This only reads the block and the ivars, so
+  // several threads can classify different blocks.
+  void ClassifyBlock(vtkAMRDualGridHelperBlock* block,
+                     vtkDataArray* scalars,
+                     vtkAMRDualContourCells* cells);
+
+  void ProcessBlock(vtkAMRDualGridHelperBlock* block, int blockId,
+                    vtkDataArray* scalars, vtkAMRDualContourCells* cells);
+  friend class vtkAMRDualContourTask;
   
   void ProcessDualCell(
     vtkAMRDualGridHelperBlock* block, int blockId,
@@ -158,6 +177,11 @@ protected:
 
   vtkAMRDualContourEdgeLocator* BlockLocator;
 
+  // Set on the workers of the threads that merge points.  Point ids are
+  // only passed to the blocks of the same thread.
+  vtkAMRDualContourTask* Task;
+  int ThreadId;
+
 private:
   vtkAMRDualContour(const vtkAMRDualContour&);  // Not implemented.
   void operator=(const vtkAMRDualContour&);  // Not implemented.
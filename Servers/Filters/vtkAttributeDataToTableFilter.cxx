@@ -29,6 +29,8 @@
 #include "vtkImageData.h"
 #include "vtkIntArray.h"
 
+#include <string.h>
+
 vtkStandardNewMacro(vtkAttributeDataToTableFilter);
 //----------------------------------------------------------------------------
 vtkAttributeDataToTableFilter::vtkAttributeDataToTableFilter()
@@ -103,45 +105,60 @@ int vtkAttributeDataToTableFilter::RequestData(
 }
 
 //----------------------------------------------------------------------------
+// Arrays as long as the longest one are passed as is. Only the shorter ones
+// are copied, to pad them with zeros.
 void vtkAttributeDataToTableFilter::PassFieldData(vtkFieldData* output,
   vtkFieldData* input)
 {
-  output->DeepCopy(input);
-  // Now resize arrays to match the longest one.
+  output->Initialize();
   vtkIdType max_Tuples = 0;
   int cc;
-  for (cc=0; cc < output->GetNumberOfArrays(); cc++)
+  for (cc=0; cc < input->GetNumberOfArrays(); cc++)
     {
-    vtkAbstractArray* arr = output->GetAbstractArray(cc);
+    vtkAbstractArray* arr = input->GetAbstractArray(cc);
     if (arr && arr->GetNumberOfTuples() > max_Tuples)
       {
       max_Tuples = arr->GetNumberOfTuples();
       }
     }
-  for (cc=0; cc < output->GetNumberOfArrays(); cc++)
+  for (cc=0; cc < input->GetNumberOfArrays(); cc++)
     {
-    vtkAbstractArray* arr = output->GetAbstractArray(cc);
+    vtkAbstractArray* arr = input->GetAbstractArray(cc);
+    if (!arr)
+      {
+      continue;
+      }
     vtkIdType numTuples = arr->GetNumberOfTuples();
-    if (numTuples != max_Tuples)
+    if (numTuples == max_Tuples)
       {
-      arr->Resize(max_Tuples);
-      arr->SetNumberOfTuples(max_Tuples);
-      int num_comps = arr->GetNumberOfComponents();
+      output->AddArray(arr);
+      continue;
+      }
 
-      vtkDataArray* da = vtkDataArray::SafeDownCast(arr);
-      if (da)
+    vtkAbstractArray* padded = arr->NewInstance();
+    padded->DeepCopy(arr);
+    padded->Resize(max_Tuples);
+    padded->SetNumberOfTuples(max_Tuples);
+    vtkDataArray* da = vtkDataArray::SafeDownCast(padded);
+    int num_comps = padded->GetNumberOfComponents();
+    if (da && da->GetDataType() != VTK_BIT)
+      {
+      memset(da->GetVoidPointer(numTuples*num_comps), 0,
+        static_cast<size_t>((max_Tuples-numTuples)*num_comps)*
+        da->GetDataTypeSize());
+      }
+    else if (da)
+      {
+      for (vtkIdType jj=numTuples; jj < max_Tuples; jj++)
         {
-        double *tuple = new double[num_comps+1];
-        for (int kk=0; kk < num_comps+1; kk++)
-          {
-          tuple[kk] = 0;
-          }
-        for (vtkIdType jj=numTuples; jj < max_Tuples; jj++)
+        for (int kk=0; kk < num_comps; kk++)
           {
-          da->SetTuple(jj, tuple);
+          da->SetComponent(jj, kk, 0.0);
           }
         }
       }
+    output->AddArray(padded);
+    padded->Delete();
     }
 }
 
@@ -218,16 +235,24 @@ void vtkAttributeDataToTableFilter::Decorate(vtkTable* output,
     dimensions = cellDims;
     }
 
+  vtkIdType numCells = input->GetNumberOfElements(vtkDataObject::CELL);
   if (this->FieldAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS &&
-    input->GetNumberOfElements(vtkDataObject::CELL) > 0)
+    numCells > 0 && output->GetNumberOfColumns() == 0)
     {
-      //at minimum always have cell ids
-      vtkIdTypeArray* originalIndices = vtkIdTypeArray::New();
-      originalIndices->SetNumberOfComponents(1);
-      originalIndices->SetNumberOfTuples( input->GetNumberOfElements(vtkDataObject::CELL));
-      originalIndices->SetName("vtkOriginalIndices");
-      output->GetRowData()->AddArray(originalIndices);
-      originalIndices->Delete();
+    // At minimum always have cell ids, so that the table has one row per
+    // cell. When there are cell arrays, the ids are not stored: consumers
+    // such as vtkTableStreamer generate them for the rows they pass.
+    vtkIdTypeArray* originalIndices = vtkIdTypeArray::New();
+    originalIndices->SetNumberOfComponents(1);
+    originalIndices->SetNumberOfTuples(numCells);
+    originalIndices->SetName("vtkOriginalIndices");
+    vtkIdType* ids = originalIndices->GetPointer(0);
+    for (vtkIdType cc=0; cc < numCells; cc++)
+      {
+      ids[cc] = cc;
+      }
+    output->GetRowData()->AddArray(originalIndices);
+    originalIndices->Delete();
     }
   else if (this->FieldAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS &&
     psInput && psInput->GetPoints())
@@ -19,6 +19,11 @@
 // chosen attribute in the input dataobject. This filter can accept composite
 // datasets. If the input is a composite dataset, the output is a multiblock
 // with vtkTable leaves.
+// The columns of the output are the arrays of the input attribute; they are
+// not copied. Only the columns computed by this filter (and padded field data
+// arrays) take memory. Cell ids are not stored unless the cells have no
+// arrays, since consumers such as vtkTableStreamer generate them for the rows
+// they pass.
 
 #ifndef __vtkAttributeDataToTableFilter_h
 #define __vtkAttributeDataToTableFilter_h
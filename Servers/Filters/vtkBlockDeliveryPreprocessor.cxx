@@ -100,6 +100,24 @@ int vtkBlockDeliveryPreprocessor::RequestData(vtkInformation*,
   clone.TakeReference(inputDO->NewInstance());
   clone->ShallowCopy(inputDO);
 
+  // When possible, only convert the chosen block, so that other blocks are
+  // not flattened (which copies their arrays) for nothing.
+  vtkMultiBlockDataSet* output = vtkMultiBlockDataSet::SafeDownCast(
+    outputDO);
+  bool extracted = false;
+  if (output && this->CompositeDataSetIndex != 0 &&
+    clone->IsA("vtkMultiBlockDataSet"))
+    {
+    vtkSmartPointer<vtkExtractBlock> eb = vtkSmartPointer<vtkExtractBlock>::New();
+    eb->SetInput(clone);
+    eb->AddIndex(this->CompositeDataSetIndex);
+    eb->PruneOutputOff();
+    eb->Update();
+    clone.TakeReference(eb->GetOutput()->NewInstance());
+    clone->ShallowCopy(eb->GetOutput());
+    extracted = true;
+    }
+
   vtkSmartPointer<vtkAttributeDataToTableFilter> adtf =
     vtkSmartPointer<vtkAttributeDataToTableFilter>::New();
   adtf->SetInput(clone);
@@ -123,15 +141,13 @@ int vtkBlockDeliveryPreprocessor::RequestData(vtkInformation*,
     split->Update();
     }
 
-  vtkMultiBlockDataSet* output = vtkMultiBlockDataSet::SafeDownCast(
-    outputDO);
   if (!output)
     {
     outputDO->ShallowCopy(filter->GetOutputDataObject(0));
     return 1;
     }
 
-  if (this->CompositeDataSetIndex != 0)
+  if (this->CompositeDataSetIndex != 0 && !extracted)
     {
     vtkSmartPointer<vtkExtractBlock> eb = vtkSmartPointer<vtkExtractBlock>::New();
     eb->SetInputConnection(filter->GetOutputPort());
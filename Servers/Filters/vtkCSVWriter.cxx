@@ -28,9 +28,14 @@
 #include "vtkTable.h"
 #include "vtkSmartPointer.h"
 
+#include <vtkstd/string>
 #include <vtkstd/vector>
 #include <vtksys/ios/sstream>
 
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
 vtkStandardNewMacro(vtkCSVWriter);
 //-----------------------------------------------------------------------------
 vtkCSVWriter::vtkCSVWriter()
@@ -62,9 +67,9 @@ int vtkCSVWriter::FillInputPortInformation(
 }
 
 //-----------------------------------------------------------------------------
-bool vtkCSVWriter::OpenFile()
+bool vtkCSVWriter::OpenFile(const char* fileName)
 {
-  if ( !this->FileName )
+  if ( !fileName )
     {
     vtkErrorMacro(<< "No FileName specified! Can't write!");
     this->SetErrorCode(vtkErrorCode::NoFileNameError);
@@ -73,11 +78,13 @@ bool vtkCSVWriter::OpenFile()
 
   vtkDebugMacro(<<"Opening file for writing...");
 
-  ofstream *fptr = new ofstream(this->FileName, ios::out);
+  delete this->Stream;
+  this->Stream = 0;
+  ofstream *fptr = new ofstream(fileName, ios::out);
 
   if (fptr->fail())
     {
-    vtkErrorMacro(<< "Unable to open file: "<< this->FileName);
+    vtkErrorMacro(<< "Unable to open file: "<< fileName);
     this->SetErrorCode(vtkErrorCode::CannotOpenFileError);
     delete fptr;
     return false;
@@ -87,127 +94,162 @@ bool vtkCSVWriter::OpenFile()
   return true;
 }
 
+namespace
+{
+// Rows are formatted into a buffer which is flushed to the file when it
+// grows beyond this size.
+const size_t vtkCSVWriterBufferSize = 1 << 20;
+
 //-----------------------------------------------------------------------------
-template <class iterT>
-void vtkCSVWriterGetDataString(
-  iterT* iter, vtkIdType tupleIndex, ofstream* stream, vtkCSVWriter* writer,
-  bool* first)
+template <class T>
+void vtkCSVWriterFormatUnsigned(vtkstd::string& buffer, T value)
 {
-  int numComps = iter->GetNumberOfComponents();
-  vtkIdType index = tupleIndex* numComps;
-  for (int cc=0; cc < numComps; cc++)
+  char digits[32];
+  char* ptr = digits + sizeof(digits);
+  do
     {
-    if ((index+cc) < iter->GetNumberOfValues())
-      {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
-      (*stream) << iter->GetValue(index+cc);
-      }
-    else
-      {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
-      }
+    *--ptr = static_cast<char>('0' + static_cast<int>(value % 10));
+    value /= 10;
     }
+  while (value != 0);
+  buffer.append(ptr, digits + sizeof(digits) - ptr);
 }
 
 //-----------------------------------------------------------------------------
-VTK_TEMPLATE_SPECIALIZE
-void vtkCSVWriterGetDataString(
-  vtkArrayIteratorTemplate<vtkStdString>* iter, vtkIdType tupleIndex,
-  ofstream* stream, vtkCSVWriter* writer, bool* first)
+template <class T>
+void vtkCSVWriterFormatSigned(vtkstd::string& buffer, T value)
 {
-  int numComps = iter->GetNumberOfComponents();
-  vtkIdType index = tupleIndex* numComps;
-  for (int cc=0; cc < numComps; cc++)
+  char digits[32];
+  char* ptr = digits + sizeof(digits);
+  bool negative = value < 0;
+  // Work on negative values so that the most negative value is handled.
+  do
     {
-    if ((index+cc) < iter->GetNumberOfValues())
-      {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
-      (*stream) << writer->GetString(iter->GetValue(index+cc));
-      }
-    else
-      {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
-      }
+    T quotient = value / 10;
+    int digit = static_cast<int>(value - quotient*10);
+    *--ptr = static_cast<char>('0' + (negative ? -digit : digit));
+    value = quotient;
     }
+  while (value != 0);
+  if (negative)
+    {
+    *--ptr = '-';
+    }
+  buffer.append(ptr, digits + sizeof(digits) - ptr);
 }
 
 //-----------------------------------------------------------------------------
-VTK_TEMPLATE_SPECIALIZE
-void vtkCSVWriterGetDataString(
-  vtkArrayIteratorTemplate<char>* iter, vtkIdType tupleIndex,
-  ofstream* stream, vtkCSVWriter* writer, bool* first)
+// Write value with the fewest significant digits that read back as the same
+// value, e.g. 0.1 rather than 0.10000000000000001. Every number of up to
+// minDigits (FLT_DIG or DBL_DIG) digits survives the round trip through T,
+// so the search starts there; maxDigits (9 or 17) are always enough.
+template <class T>
+void vtkCSVWriterFormatReal(vtkstd::string& buffer, T value, int minDigits,
+  int maxDigits)
 {
-  int numComps = iter->GetNumberOfComponents();
-  vtkIdType index = tupleIndex* numComps;
-  for (int cc=0; cc < numComps; cc++)
+  char text[64];
+  for (int digits = minDigits; digits < maxDigits; digits++)
     {
-    if ((index+cc) < iter->GetNumberOfValues())
+    sprintf(text, "%.*g", digits, static_cast<double>(value));
+    if (static_cast<T>(strtod(text, 0)) == value)
       {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
-      (*stream) << static_cast<int>( iter->GetValue(index+cc) );
-      }
-    else
-      {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
+      buffer += text;
+      return;
       }
     }
+  sprintf(text, "%.*g", maxDigits, static_cast<double>(value));
+  buffer += text;
 }
 
 //-----------------------------------------------------------------------------
-VTK_TEMPLATE_SPECIALIZE
+template <class T>
+void vtkCSVWriterFormatValue(vtkstd::string& buffer, const T& value,
+  vtkCSVWriter*)
+{
+  // Types without a fast path (e.g. vtkVariant).
+  vtksys_ios::ostringstream stream;
+  stream << value;
+  buffer += stream.str();
+}
+
+#define vtkCSVWriterFormatIntegerMacro(type, format) \
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer, const type& value, \
+  vtkCSVWriter*) \
+{ \
+  format(buffer, value); \
+}
+vtkCSVWriterFormatIntegerMacro(short, vtkCSVWriterFormatSigned)
+vtkCSVWriterFormatIntegerMacro(unsigned short, vtkCSVWriterFormatUnsigned)
+vtkCSVWriterFormatIntegerMacro(int, vtkCSVWriterFormatSigned)
+vtkCSVWriterFormatIntegerMacro(unsigned int, vtkCSVWriterFormatUnsigned)
+vtkCSVWriterFormatIntegerMacro(long, vtkCSVWriterFormatSigned)
+vtkCSVWriterFormatIntegerMacro(unsigned long, vtkCSVWriterFormatUnsigned)
+#if defined(VTK_TYPE_USE_LONG_LONG)
+vtkCSVWriterFormatIntegerMacro(long long, vtkCSVWriterFormatSigned)
+vtkCSVWriterFormatIntegerMacro(unsigned long long, vtkCSVWriterFormatUnsigned)
+#endif
+#undef vtkCSVWriterFormatIntegerMacro
+
+// Characters are written as numbers.
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer, const char& value,
+  vtkCSVWriter*)
+{
+  vtkCSVWriterFormatSigned(buffer, static_cast<int>(value));
+}
+
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer,
+  const signed char& value, vtkCSVWriter*)
+{
+  vtkCSVWriterFormatSigned(buffer, static_cast<int>(value));
+}
+
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer,
+  const unsigned char& value, vtkCSVWriter*)
+{
+  vtkCSVWriterFormatSigned(buffer, static_cast<int>(value));
+}
+
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer, const float& value,
+  vtkCSVWriter*)
+{
+  vtkCSVWriterFormatReal(buffer, value, FLT_DIG, 9);
+}
+
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer, const double& value,
+  vtkCSVWriter*)
+{
+  vtkCSVWriterFormatReal(buffer, value, DBL_DIG, 17);
+}
+
+inline void vtkCSVWriterFormatValue(vtkstd::string& buffer,
+  const vtkStdString& value, vtkCSVWriter* writer)
+{
+  buffer += writer->GetString(value);
+}
+}
+
+//-----------------------------------------------------------------------------
+template <class iterT>
 void vtkCSVWriterGetDataString(
-  vtkArrayIteratorTemplate<unsigned char>* iter, vtkIdType tupleIndex,
-  ofstream* stream, vtkCSVWriter* writer, bool* first)
+  iterT* iter, vtkIdType tupleIndex, vtkstd::string& buffer,
+  vtkCSVWriter* writer, bool* first)
 {
   int numComps = iter->GetNumberOfComponents();
   vtkIdType index = tupleIndex* numComps;
   for (int cc=0; cc < numComps; cc++)
     {
-    if ((index+cc) < iter->GetNumberOfValues())
+    if (*first == false)
       {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
-      (*stream) << static_cast<int>( iter->GetValue(index+cc) );
+      buffer += writer->GetFieldDelimiter();
       }
-    else
+    *first = false;
+    if ((index+cc) < iter->GetNumberOfValues())
       {
-      if (*first == false)
-        {
-        (*stream) << writer->GetFieldDelimiter();
-        }
-      *first = false;
+      vtkCSVWriterFormatValue(buffer, iter->GetValue(index+cc), writer);
       }
     }
 }
 
-
 //-----------------------------------------------------------------------------
 vtkStdString vtkCSVWriter::GetString(vtkStdString string)
 {
@@ -237,27 +279,40 @@ void vtkCSVWriter::WriteData()
 //-----------------------------------------------------------------------------
 void vtkCSVWriter::WriteTable(vtkTable* table)
 {
-  vtkIdType numRows = table->GetNumberOfRows();
-  vtkDataSetAttributes* dsa = table->GetRowData();
-  if (!this->OpenFile())
+  this->WriteTable(table, this->FileName);
+}
+
+//-----------------------------------------------------------------------------
+void vtkCSVWriter::WriteTable(vtkTable* table, const char* fileName)
+{
+  if (!this->OpenFile(fileName))
     {
     return;
     }
 
-  vtkstd::vector<vtkSmartPointer<vtkArrayIterator> > columnsIters;
+  vtkstd::string buffer;
+  buffer.reserve(vtkCSVWriterBufferSize + 4096);
+  this->FormatHeader(table, buffer);
+  this->FormatRows(table, 0, table->GetNumberOfRows(), buffer, this->Stream);
+  this->Stream->write(buffer.c_str(), buffer.size());
 
-  int cc;
+  this->Stream->close();
+}
+
+//-----------------------------------------------------------------------------
+void vtkCSVWriter::FormatHeader(vtkTable* table, vtkstd::string& buffer)
+{
+  vtkDataSetAttributes* dsa = table->GetRowData();
   int numArrays = dsa->GetNumberOfArrays();
   bool first = true;
-  // Write headers:
-  for (cc=0; cc < numArrays; cc++)
+  for (int cc=0; cc < numArrays; cc++)
     {
     vtkAbstractArray* array = dsa->GetAbstractArray(cc);
     for (int comp=0; comp < array->GetNumberOfComponents(); comp++)
       {
       if (!first)
         {
-        (*this->Stream) << this->FieldDelimiter;
+        buffer += this->FieldDelimiter;
         }
       first = false;
 
@@ -267,17 +322,29 @@ void vtkCSVWriter::WriteTable(vtkTable* table)
         {
         array_name << ":" << comp;
         }
-      (*this->Stream) << this->GetString(array_name.str());
+      buffer += this->GetString(array_name.str());
       }
-    vtkArrayIterator* iter = array->NewIterator();
+    }
+  buffer += "\n";
+}
+
+//-----------------------------------------------------------------------------
+void vtkCSVWriter::FormatRows(vtkTable* table, vtkIdType begin, vtkIdType end,
+  vtkstd::string& buffer, ostream* stream)
+{
+  vtkDataSetAttributes* dsa = table->GetRowData();
+  vtkstd::vector<vtkSmartPointer<vtkArrayIterator> > columnsIters;
+  int numArrays = dsa->GetNumberOfArrays();
+  for (int cc=0; cc < numArrays; cc++)
+    {
+    vtkArrayIterator* iter = dsa->GetAbstractArray(cc)->NewIterator();
     columnsIters.push_back(iter);
     iter->Delete();
     }
-  (*this->Stream) << "\n";
 
-  for (vtkIdType index=0; index < numRows; index++)
+  for (vtkIdType index=begin; index < end; index++)
     {
-    first = true;
+    bool first = true;
     vtkstd::vector<vtkSmartPointer<vtkArrayIterator> >::iterator iter;
     for (iter = columnsIters.begin(); iter != columnsIters.end(); ++iter)
       {
@@ -285,13 +352,16 @@ void vtkCSVWriter::WriteTable(vtkTable* table)
         {
         vtkArrayIteratorTemplateMacro(
           vtkCSVWriterGetDataString(static_cast<VTK_TT*>(iter->GetPointer()),
-            index, this->Stream, this, &first));
+            index, buffer, this, &first));
         }
       }
-    (*this->Stream) << "\n";
+    buffer += "\n";
+    if (stream && buffer.size() > vtkCSVWriterBufferSize)
+      {
+      stream->write(buffer.c_str(), buffer.size());
+      buffer.clear();
+      }
     }
-
-  this->Stream->close();
 }
 
 //-----------------------------------------------------------------------------
@@ -13,12 +13,17 @@
 
 =========================================================================*/
 // .NAME vtkCSVWriter - CSV writer for vtkTable
-// Writes a vtkTable as a delimited text file (such as CSV). 
+// Writes a vtkTable as a delimited text file (such as CSV).
+// Rows are formatted into a memory buffer that is written to the file in
+// large blocks. Floating point values are written with enough significant
+// digits (9 for float, 17 for double) to read back as the same value.
 #ifndef __vtkCSVWriter_h
 #define __vtkCSVWriter_h
 
 #include "vtkWriter.h"
 
+#include <vtkstd/string> // for vtkstd::string
+
 class vtkStdString;
 class vtkTable;
 
@@ -60,11 +65,26 @@ protected:
   vtkCSVWriter();
   ~vtkCSVWriter();
 
-  bool OpenFile();
+  bool OpenFile(const char* fileName);
 
   virtual void WriteData();
   virtual void WriteTable(vtkTable* rectilinearGrid);
 
+  // Description:
+  // Write table to fileName instead of FileName.
+  void WriteTable(vtkTable* table, const char* fileName);
+
+  // Description:
+  // Append the column names of table to buffer.
+  void FormatHeader(vtkTable* table, vtkstd::string& buffer);
+
+  // Description:
+  // Append rows [begin, end) of table to buffer. Numbers are written with
+  // enough digits to read back as the same value. If stream is not
+  // NULL, the buffer is written to it and cleared whenever it gets large.
+  void FormatRows(vtkTable* table, vtkIdType begin, vtkIdType end,
+                  vtkstd::string& buffer, ostream* stream);
+
   // see algorithm for more info.
   // This writer takes in vtkTable.
   virtual int FillInputPortInformation(int port, vtkInformation* info);
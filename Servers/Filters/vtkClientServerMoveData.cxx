@@ -31,6 +31,7 @@
 #include "vtkServerConnection.h"
 #include "vtkSocketController.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkUnsignedCharArray.h"
 #include "vtkUnstructuredGrid.h"
 
 #include <vtksys/ios/sstream>
@@ -185,22 +186,23 @@ int vtkClientServerMoveData::SendData(vtkDataObject* input,
   vtkSocketController* controller)
 {
   // This is a server root node.
-  // If it is a selection, use the XML serializer.
+  // If it is a selection, use the binary selection serializer.
   // Otherwise, use the communicator.
   if (vtkSelection::SafeDownCast(input) != NULL)
     {
-    // Convert to XML.
     vtkSelection* sel = vtkSelection::SafeDownCast(input);
-    vtksys_ios::ostringstream res;
-    vtkSelectionSerializer::PrintXML(res, vtkIndent(), 1, sel);
+    vtkUnsignedCharArray* buffer = vtkUnsignedCharArray::New();
+    vtkSelectionSerializer::PrintBinary(sel, buffer);
 
-    // Send the size of the string.
-    int size = static_cast<int>(res.str().size());
+    // Send the size of the buffer.
+    int size = static_cast<int>(buffer->GetNumberOfTuples());
     controller->Send(&size, 1, 1, 
       vtkClientServerMoveData::TRANSMIT_DATA_OBJECT);
-    // Send the XML string.
-    return controller->Send(res.str().c_str(), size, 1, 
+    // Send the buffer.
+    int ret = controller->Send(buffer->GetPointer(0), size, 1, 
       vtkClientServerMoveData::TRANSMIT_DATA_OBJECT);
+    buffer->Delete();
+    return ret;
     }
 
   return controller->Send(input, 1,
@@ -213,20 +215,22 @@ vtkDataObject* vtkClientServerMoveData::ReceiveData(vtkSocketController* control
   vtkDataObject* data = NULL; 
   if (this->OutputDataType == VTK_SELECTION)
     {
-    // Get the size of the string.
+    // Get the size of the buffer.
     int size = 0;
     controller->Receive(&size, 1, 1,
       vtkClientServerMoveData::TRANSMIT_DATA_OBJECT);
-    char* xml = new char[size+1];
-    // Get the string itself.
-    controller->Receive(xml, size, 1,
+    vtkUnsignedCharArray* buffer = vtkUnsignedCharArray::New();
+    buffer->SetNumberOfTuples(size);
+    // Get the buffer itself.
+    controller->Receive(buffer->GetPointer(0), size, 1,
       vtkClientServerMoveData::TRANSMIT_DATA_OBJECT);
-    xml[size] = 0;
 
-    // Parse the XML.
     vtkSelection* sel = vtkSelection::New();
-    vtkSelectionSerializer::Parse(xml, sel);
-    delete[] xml;
+    if (!vtkSelectionSerializer::ParseBinary(buffer, sel))
+      {
+      vtkErrorMacro("Failed to parse the selection received.");
+      }
+    buffer->Delete();
     data = sel;
     }
   else
@@ -16,24 +16,60 @@
 #include "vtkObjectFactory.h"
 #include "vtkIntArray.h"
 
-
-vtkStandardNewMacro(vtkEquivalenceSet);
+#if defined(_WIN32)
+# include "vtkWindows.h"
+#elif !defined(__GNUC__)
+# include "vtkCriticalSection.h"
+#endif
 
 
+vtkStandardNewMacro(vtkEquivalenceSet);
 
+namespace
+{
+#if !defined(_WIN32) && !defined(__GNUC__)
+vtkSimpleCriticalSection vtkEquivalenceSetLock;
+#endif
 
+//----------------------------------------------------------------------------
+// Replaces *ref with newValue if it still holds oldValue, atomically.
+// Returns true if the value was replaced.
+inline bool vtkEquivalenceSetCompareAndSwap(volatile int* ref,
+                                            int oldValue, int newValue)
+{
+#if defined(_WIN32)
+  return InterlockedCompareExchange(reinterpret_cast<volatile LONG*>(ref),
+                                    newValue, oldValue) == oldValue;
+#elif defined(__GNUC__)
+  return __sync_bool_compare_and_swap(ref, oldValue, newValue);
+#else
+  // No atomic instruction available, fall back to a lock.
+  vtkEquivalenceSetLock.Lock();
+  bool swapped = (*ref == oldValue);
+  if (swapped)
+    {
+    *ref = newValue;
+    }
+  vtkEquivalenceSetLock.Unlock();
+  return swapped;
+#endif
+}
+}
 
 //============================================================================
 // A class that implements an equivalent set.  It is used to combine fragments
 // from different processes.
 //
-// I believe that this class is a strictly ordered tree of equivalences.
-// Every member points to its own id or an id smaller than itself.
+// This class is a strictly ordered forest of equivalences (union-find).
+// Every member points to its own id or an id smaller than itself, so the
+// root of a tree is the smallest member of the set.  ResolveEquivalences
+// depends on this order.
 
 //----------------------------------------------------------------------------
 vtkEquivalenceSet::vtkEquivalenceSet()
 {
   this->Resolved = 0;
+  this->NumberOfResolvedSets = 0;
   this->EquivalenceArray = vtkIntArray::New();
 }
 
@@ -60,6 +96,7 @@ void vtkEquivalenceSet::Initialize()
 void vtkEquivalenceSet::DeepCopy(vtkEquivalenceSet* in)
 {
   this->Resolved = in->Resolved;
+  this->NumberOfResolvedSets = in->NumberOfResolvedSets;
   this->EquivalenceArray->DeepCopy(in->EquivalenceArray);
 }
 
@@ -82,18 +119,46 @@ void vtkEquivalenceSet::PrintSelf(ostream& os, vtkIndent indent)
 // Return the id of the equivalent set.
 int vtkEquivalenceSet::GetEquivalentSetId(int memberId)
 {
-  int ref;
+  int ref = this->GetReference(memberId);
+  if (this->Resolved)
+    {
+    return ref;
+    }
 
-  ref = this->GetReference(memberId);
-  while (!this->Resolved && ref != memberId)
+  // Follow the references to the root.  Path halving: every member we
+  // visit is pointed to its grandparent so later lookups are shorter.
+  int* refs = this->EquivalenceArray->GetPointer(0);
+  while (ref != memberId)
     {
+    int grandRef = refs[ref];
+    refs[memberId] = grandRef;
     memberId = ref;
-    ref = this->GetReference(memberId);
+    ref = grandRef;
     }
 
   return ref;
 }
 
+//----------------------------------------------------------------------------
+int vtkEquivalenceSet::ConcurrentGetEquivalentSetId(int memberId)
+{
+  volatile int* refs = this->EquivalenceArray->GetPointer(0);
+  int ref = refs[memberId];
+  while (ref != memberId)
+    {
+    int grandRef = refs[ref];
+    if (grandRef != ref)
+      {
+      // References only decrease, so this cannot undo a merge made by
+      // another thread.  It does not matter if the swap fails.
+      vtkEquivalenceSetCompareAndSwap(refs + memberId, ref, grandRef);
+      }
+    memberId = ref;
+    ref = refs[memberId];
+    }
+  return ref;
+}
+
 //----------------------------------------------------------------------------
 // Return the id of the equivalent set.
 int vtkEquivalenceSet::GetReference(int memberId)
@@ -117,35 +182,83 @@ void vtkEquivalenceSet::AddEquivalence(int id1, int id2)
     return;
     }
 
-  int num = this->EquivalenceArray->GetNumberOfTuples();
-
   // Expand the range to include both ids.
-  while (num <= id1 || num <= id2)
+  // All values inserted are equivalent to only themselves.
+  this->SetNumberOfMembers((id1 > id2 ? id1 : id2) + 1);
+
+  // Our rule for references in the equivalent set is that
+  // all elements must point to a member equal to or smaller
+  // than itself.  Linking the larger root to the smaller root keeps
+  // this order and does not orphan anything previously referenced.
+  id1 = this->GetEquivalentSetId(id1);
+  id2 = this->GetEquivalentSetId(id2);
+  if (id1 < id2)
     {
-    // All values inserted are equivalent to only themselves.
-    this->EquivalenceArray->InsertNextTuple1(num);
-    ++num;
+    this->EquivalenceArray->SetValue(id2, id1);
+    }
+  else if (id2 < id1)
+    {
+    this->EquivalenceArray->SetValue(id1, id2);
     }
+}
 
- // Our rule for references in the equivalent set is that
- // all elements must point to a member equal to or smaller
- // than itself.
+//----------------------------------------------------------------------------
+void vtkEquivalenceSet::ConcurrentAddEquivalence(int id1, int id2)
+{
+  volatile int* refs = this->EquivalenceArray->GetPointer(0);
+  for (;;)
+    {
+    id1 = this->ConcurrentGetEquivalentSetId(id1);
+    id2 = this->ConcurrentGetEquivalentSetId(id2);
+    if (id1 == id2)
+      {
+      return;
+      }
+    if (id2 < id1)
+      {
+      int tmp = id1;
+      id1 = id2;
+      id2 = tmp;
+      }
+    // Link the larger root to the smaller one.  This fails if another
+    // thread linked id2 first, then we start again from the new roots.
+    if (vtkEquivalenceSetCompareAndSwap(refs + id2, id2, id1))
+      {
+      return;
+      }
+    }
+}
 
- // The only problem we could encounter is changing a reference.
- // we do not want to orphan anything previously referenced.
+//----------------------------------------------------------------------------
+void vtkEquivalenceSet::SetNumberOfMembers(int numberOfMembers)
+{
+  int num = this->EquivalenceArray->GetNumberOfTuples();
+  if (numberOfMembers <= num)
+    {
+    return;
+    }
+  if (this->Resolved)
+    {
+    vtkGenericWarningMacro("Set already resolved, you cannot add more members.");
+    return;
+    }
 
-  // Replace the larger references.
-  if (id1 < id2)
+  // Grow geometrically so adding ids one at a time stays linear.
+  vtkIdType size = this->EquivalenceArray->GetSize();
+  if (numberOfMembers > size)
     {
-    // We could follow the references to the smallest.  It might
-    // make this processing more efficient.  This is a compromise.
-    // The referenced id will always be smaller than the id so
-    // order does not change.
-    this->EquateInternal(this->GetReference(id1), id2);
+    vtkIdType newSize = 2 * size;
+    if (newSize < numberOfMembers)
+      {
+      newSize = numberOfMembers;
+      }
+    this->EquivalenceArray->Resize(newSize);
     }
-  else
+  this->EquivalenceArray->SetNumberOfTuples(numberOfMembers);
+  int* ptr = this->EquivalenceArray->GetPointer(0);
+  for (int ii = num; ii < numberOfMembers; ++ii)
     {
-    this->EquateInternal(this->GetReference(id2), id1);
+    ptr[ii] = ii;
     }
 }
 
@@ -175,37 +288,6 @@ vtkIdType vtkEquivalenceSet::Capacity()
 }
 
 
-//----------------------------------------------------------------------------
-// id1 must be less than or equal to id2.
-void vtkEquivalenceSet::EquateInternal(int id1, int id2)
-{
-  // This is the reference that might be orphaned in this process.
-  int oldRef = this->GetEquivalentSetId(id2);
-  
-  // The two ids are already equal (not the only way they might be equal).
-  if (oldRef == id1)
-    {
-    return;
-    }
-  
- // The only problem we could encounter is changing a reference.
- // we do not want to orphan anything previously referenced.
-  if (oldRef == id2)
-    {
-    this->EquivalenceArray->SetValue(id2, id1);
-    }
-  else if (oldRef > id1)
-    {
-    this->EquivalenceArray->SetValue(id2, id1);
-    this->EquateInternal(id1, oldRef);
-    }
-  else
-    { // oldRef < id1
-    this->EquateInternal(oldRef, id1);
-    }
-}
-
-
 //----------------------------------------------------------------------------
 // Returns the number of merged sets.
 int vtkEquivalenceSet::ResolveEquivalences()
@@ -16,6 +16,11 @@
 // .SECTION Description
 // Useful for connectivity on multiple processes.  Run connectivity
 // on each processes, then make touching fragments equivalent.
+// The set is a union-find forest.  Every member references itself or a
+// smaller member, so the root of a set is its smallest member.  Lookups
+// compress the paths they follow.  The Concurrent methods may be called
+// from several threads at once: they are lock free and only use atomic
+// compare-and-swap on the references.
 
 #ifndef __vtkEquivalenceSet_h
 #define __vtkEquivalenceSet_h
@@ -34,6 +39,17 @@ public:
   void Initialize();
   void AddEquivalence(int id1, int id2);
 
+  // Makes sure that ids [0, numberOfMembers) are members of the set.
+  // New members are only equivalent to themselves.  Call this before
+  // using the Concurrent methods because they cannot grow the set.
+  void SetNumberOfMembers(int numberOfMembers);
+
+  // Thread safe versions of AddEquivalence and GetEquivalentSetId.
+  // Both ids must be members already and the set must not be resolved.
+  // Do not mix them with the other methods while threads are running.
+  void ConcurrentAddEquivalence(int id1, int id2);
+  int ConcurrentGetEquivalentSetId(int memberId);
+
   // The length of the equivalent array...
   // The Domain of the equivalance map is [0, numberOfMembers).
   int GetNumberOfMembers();
@@ -78,7 +94,6 @@ private:
 
   // Return the id of the equivalent set.
   int GetReference(int memberId);
-  void EquateInternal(int id1, int id2);
 
 private:
   vtkEquivalenceSet(const vtkEquivalenceSet&);  // Not implemented.
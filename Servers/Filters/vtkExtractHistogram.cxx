@@ -25,6 +25,7 @@
 #include "vtkIntArray.h"
 #include "vtkIOStream.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkOnePieceExtentTranslator.h"
 #include "vtkPointData.h"
@@ -32,8 +33,10 @@
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTable.h"
 
+#include <vtkstd/algorithm>
 #include <vtkstd/vector>
 #include <vtkstd/map>
+#include <vtkstd/set>
 #include <vtkstd/string>
 
 struct vtkEHInternals
@@ -41,12 +44,16 @@ struct vtkEHInternals
   vtkEHInternals() : FieldAssociation(-1) {}
   struct ArrayValuesType
     {
-    // The total of the values per bin - the second vector
-    // is for arrays with multiple components
-    vtkstd::vector<vtkstd::vector<double> > TotalValues;
+    ArrayValuesType() : NumberOfComponents(0) {}
+    // The total of the values per bin, stored as BinCount tuples with
+    // NumberOfComponents components each.
+    int NumberOfComponents;
+    vtkstd::vector<double> TotalValues;
     };
   typedef vtkstd::map<vtkstd::string, ArrayValuesType> ArrayMapType;
   ArrayMapType ArrayValues;
+  // Names of the arrays that could not be averaged, e.g. string arrays.
+  vtkstd::set<vtkstd::string> SkippedArrays;
   int FieldAssociation;
 };
 
@@ -176,7 +183,7 @@ bool vtkExtractHistogram::InitializeBinExtents(
           foundone = true;
           }
         double tRange[2];
-        data_array->GetRange(tRange, this->Component);
+        this->ComputeRange(data_array, this->Component, tRange);
         if (tRange[0] < range[0])
           {
           range[0] = tRange[0];
@@ -215,7 +222,7 @@ bool vtkExtractHistogram::InitializeBinExtents(
       return true;
       }
 
-    data_array->GetRange(range, this->Component);
+    this->ComputeRange(data_array, this->Component, range);
 
     bin_extents->SetName(data_array->GetName());
     }
@@ -270,6 +277,264 @@ inline int vtkExtractHistogramClamp(int value, int min, int max)
   return value;
 }
 
+namespace
+{
+// Arrays smaller than this are processed by a single thread.
+const vtkIdType vtkEHMinimumTuplesPerThread = 65536;
+
+// Tuples are binned in blocks of this size so that the bin index of each
+// tuple in the block can be reused when accumulating the other arrays.
+const vtkIdType vtkEHBlockSize = 4096;
+
+//-----------------------------------------------------------------------------
+// Computes the min/max of one component over [begin, end). Written without
+// branches in the loop body so that the compiler can vectorize it.
+template <class T>
+void vtkEHComputeRange(const T* data, int numComps, int comp,
+  vtkIdType begin, vtkIdType end, double range[2])
+{
+  if (begin >= end)
+    {
+    return;
+    }
+  const T* ptr = data + begin*numComps + comp;
+  T lo = *ptr;
+  T hi = *ptr;
+  for (vtkIdType i = begin; i < end; ++i, ptr += numComps)
+    {
+    const T value = *ptr;
+    lo = value < lo ? value : lo;
+    hi = value > hi ? value : hi;
+    }
+  range[0] = vtkstd::min(range[0], static_cast<double>(lo));
+  range[1] = vtkstd::max(range[1], static_cast<double>(hi));
+}
+
+//-----------------------------------------------------------------------------
+// Bins one component over [begin, end) into bins, and records the bin index
+// of each tuple in indices.
+template <class T>
+void vtkEHComputeBins(const T* data, int numComps, int comp,
+  vtkIdType begin, vtkIdType end, double min, double delta, int binCount,
+  int* indices, vtkIdType* bins)
+{
+  const T* ptr = data + begin*numComps + comp;
+  for (vtkIdType i = begin; i < end; ++i, ptr += numComps)
+    {
+    int index = static_cast<int>((static_cast<double>(*ptr) - min) / delta);
+    // If the value is equal to max, include it in the last bin.
+    index = ::vtkExtractHistogramClamp(index, 0, binCount-1);
+    indices[i-begin] = index;
+    bins[index]++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Adds all components of the tuples in [begin, end) to the totals of the bins
+// given by indices.
+template <class T>
+void vtkEHAccumulate(const T* data, int numComps,
+  vtkIdType begin, vtkIdType end, const int* indices, double* totals)
+{
+  const T* ptr = data + begin*numComps;
+  for (vtkIdType i = begin; i < end; ++i)
+    {
+    double* total = totals + indices[i-begin]*numComps;
+    for (int comp = 0; comp < numComps; ++comp, ++ptr)
+      {
+      total[comp] += static_cast<double>(*ptr);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Returns true if the array's memory can be accessed directly by the typed
+// kernels above.
+bool vtkEHIsTypedArray(vtkDataArray* array)
+{
+  switch (array->GetDataType())
+    {
+    vtkTemplateMacro(return true);
+    }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+// State shared by all threads. Each thread works on a contiguous range of
+// tuples and writes to its own bins and totals, which are summed afterwards.
+struct vtkEHTask
+{
+  // Progress is reported on this algorithm by the calling thread only.
+  vtkAlgorithm* Filter;
+  vtkDataArray* Array;
+  int Component;
+  double Min;
+  double Delta;
+  int BinCount;
+  vtkstd::vector<vtkDataArray*> OtherArrays;
+
+  // Per-thread results.
+  vtkstd::vector<vtkstd::vector<double> > Ranges;
+  vtkstd::vector<vtkstd::vector<vtkIdType> > Bins;
+  vtkstd::vector<vtkstd::vector<vtkstd::vector<double> > > Totals;
+
+  void GetThreadRange(int threadId, int numThreads,
+    vtkIdType& begin, vtkIdType& end)
+    {
+    vtkIdType numTuples = this->Array->GetNumberOfTuples();
+    begin = (numTuples*threadId)/numThreads;
+    end = (numTuples*(threadId+1))/numThreads;
+    }
+};
+
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkEHRangeThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkEHTask* task = static_cast<vtkEHTask*>(info->UserData);
+  vtkIdType begin, end;
+  task->GetThreadRange(info->ThreadID, info->NumberOfThreads, begin, end);
+
+  double* range = &task->Ranges[info->ThreadID][0];
+  void* data = task->Array->GetVoidPointer(0);
+  int numComps = task->Array->GetNumberOfComponents();
+  switch (task->Array->GetDataType())
+    {
+    vtkTemplateMacro(vtkEHComputeRange(static_cast<VTK_TT*>(data),
+        numComps, task->Component, begin, end, range));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkEHBinThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkEHTask* task = static_cast<vtkEHTask*>(info->UserData);
+  vtkIdType begin, end;
+  task->GetThreadRange(info->ThreadID, info->NumberOfThreads, begin, end);
+
+  vtkIdType* bins = &task->Bins[info->ThreadID][0];
+  vtkstd::vector<vtkstd::vector<double> >& totals =
+    task->Totals[info->ThreadID];
+  void* data = task->Array->GetVoidPointer(0);
+  int numComps = task->Array->GetNumberOfComponents();
+
+  int indices[vtkEHBlockSize];
+  int blockCount = 0;
+  for (vtkIdType blockBegin = begin; blockBegin < end;
+    blockBegin += vtkEHBlockSize, ++blockCount)
+    {
+    // Thread 0 runs on the calling thread; its share of the tuples stands
+    // for the overall progress since all threads get the same number.
+    if (info->ThreadID == 0 && task->Filter && blockCount % 16 == 0)
+      {
+      task->Filter->UpdateProgress(0.10 + 0.90*
+        static_cast<double>(blockBegin - begin)/(end - begin));
+      }
+    vtkIdType blockEnd = vtkstd::min(blockBegin + vtkEHBlockSize, end);
+    switch (task->Array->GetDataType())
+      {
+      vtkTemplateMacro(vtkEHComputeBins(static_cast<VTK_TT*>(data),
+          numComps, task->Component, blockBegin, blockEnd, task->Min,
+          task->Delta, task->BinCount, indices, bins));
+      }
+
+    for (size_t cc = 0; cc < task->OtherArrays.size(); ++cc)
+      {
+      vtkDataArray* other = task->OtherArrays[cc];
+      void* otherData = other->GetVoidPointer(0);
+      switch (other->GetDataType())
+        {
+        vtkTemplateMacro(vtkEHAccumulate(static_cast<VTK_TT*>(otherData),
+            other->GetNumberOfComponents(), blockBegin, blockEnd, indices,
+            &totals[cc][0]));
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+// Adds the values of arrays to the totals of the bins, using the generic API
+// for arrays (such as vtkBitArray) that the typed kernels can't access.
+void vtkEHAccumulateGeneric(const vtkEHTask& task,
+  const vtkstd::vector<vtkDataArray*>& arrays, vtkEHInternals* internals)
+{
+  if (arrays.empty())
+    {
+    return;
+    }
+  vtkIdType numTuples = task.Array->GetNumberOfTuples();
+  for (vtkIdType i = 0; i != numTuples; ++i)
+    {
+    const double value = task.Array->GetComponent(i, task.Component);
+    int index = static_cast<int>((value - task.Min) / task.Delta);
+    index = ::vtkExtractHistogramClamp(index, 0, task.BinCount-1);
+    for (size_t cc = 0; cc < arrays.size(); ++cc)
+      {
+      vtkDataArray* array = arrays[cc];
+      vtkEHInternals::ArrayValuesType& arrayValues =
+        internals->ArrayValues[array->GetName()];
+      int numComps = arrayValues.NumberOfComponents;
+      for (int comp = 0; comp < numComps; comp++)
+        {
+        arrayValues.TotalValues[index*numComps + comp] +=
+          array->GetComponent(i, comp);
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+int vtkEHGetNumberOfThreads(vtkMultiThreader* threader, vtkIdType numTuples)
+{
+  int maxThreads = static_cast<int>(
+    vtkstd::max<vtkIdType>(numTuples / vtkEHMinimumTuplesPerThread, 1));
+  return vtkstd::min(threader->GetNumberOfThreads(), maxThreads);
+}
+}
+
+//-----------------------------------------------------------------------------
+void vtkExtractHistogram::ComputeRange(vtkDataArray* data_array, int comp,
+  double range[2])
+{
+  vtkIdType numTuples = data_array->GetNumberOfTuples();
+  if (numTuples == 0 || !::vtkEHIsTypedArray(data_array))
+    {
+    data_array->GetRange(range, comp);
+    return;
+    }
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  int numThreads = ::vtkEHGetNumberOfThreads(threader, numTuples);
+  threader->SetNumberOfThreads(numThreads);
+
+  vtkEHTask task;
+  task.Filter = 0;
+  task.Array = data_array;
+  task.Component = comp;
+  task.Ranges.resize(numThreads, vtkstd::vector<double>(2));
+  for (int cc = 0; cc < numThreads; cc++)
+    {
+    task.Ranges[cc][0] = VTK_DOUBLE_MAX;
+    task.Ranges[cc][1] = -VTK_DOUBLE_MAX;
+    }
+  threader->SetSingleMethod(::vtkEHRangeThread, &task);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  range[0] = VTK_DOUBLE_MAX;
+  range[1] = -VTK_DOUBLE_MAX;
+  for (int cc = 0; cc < numThreads; cc++)
+    {
+    range[0] = vtkstd::min(range[0], task.Ranges[cc][0]);
+    range[1] = vtkstd::max(range[1], task.Ranges[cc][1]);
+    }
+}
+
 //-----------------------------------------------------------------------------
 void vtkExtractHistogram::BinAnArray(vtkDataArray *data_array,
                                      vtkIntArray *bin_values,
@@ -285,46 +550,120 @@ void vtkExtractHistogram::BinAnArray(vtkDataArray *data_array,
     return;
     }
 
-  int num_of_tuples = data_array->GetNumberOfTuples();
-  double bin_delta = (max-min)/this->BinCount;
-  for(int i = 0; i != num_of_tuples; ++i)
+  vtkEHTask task;
+  task.Filter = this;
+  task.Array = data_array;
+  task.Component = this->Component;
+  task.Min = min;
+  task.Delta = (max-min)/this->BinCount;
+  task.BinCount = this->BinCount;
+
+  // Other arrays that can't be accessed directly (such as vtkBitArray) are
+  // totalled in a separate pass using the generic API.
+  vtkstd::vector<vtkDataArray*> genericArrays;
+  if (this->CalculateAverages)
     {
-    if (i%1000 == 0)
+    // Get all other arrays, their values are totalled per bin in the same
+    // pass. At the end, each total is divided by the number of elements in
+    // the bin. Arrays that are not vtkDataArrays have no values to average;
+    // they are left out of the output and reported in a warning.
+    int num_arrays = field->GetNumberOfArrays();
+    for (int idx=0; idx<num_arrays; idx++)
       {
-      this->UpdateProgress(0.10 + 0.90*i/num_of_tuples);
-      }
-    const double value = data_array->GetComponent(i, this->Component);
-    int index = static_cast<int>((value - min) / bin_delta);
-    // If the value is equal to max, include it in the last bin.
-    index = ::vtkExtractHistogramClamp(index, 0, this->BinCount-1);
-    bin_values->SetValue(index, bin_values->GetValue(index)+1);
-    
-    if (this->CalculateAverages)
-      {
-      // Get all other arrays, add their value to the bin
-      // For each bin, we will need 2 values per array ->
-      // total, num. elements
-      // at the end, divide each total by num. elements
-      int num_arrays = field->GetNumberOfArrays();
-      for (int idx=0; idx<num_arrays; idx++)
+      vtkAbstractArray* abstractArray = field->GetAbstractArray(idx);
+      vtkDataArray* array = vtkDataArray::SafeDownCast(abstractArray);
+      if (!array && abstractArray && abstractArray->GetName())
+        {
+        this->Internal->SkippedArrays.insert(abstractArray->GetName());
+        }
+      if (array && array != data_array && array->GetName() &&
+        array->GetNumberOfTuples() == data_array->GetNumberOfTuples())
         {
-        vtkDataArray* array = field->GetArray(idx);
-        if (array != data_array && array->GetName())
+        vtkEHInternals::ArrayValuesType& arrayValues =
+          this->Internal->ArrayValues[array->GetName()];
+        int numComps = array->GetNumberOfComponents();
+        if (arrayValues.NumberOfComponents == 0)
           {
-          vtkEHInternals::ArrayValuesType& arrayValues =
-            this->Internal->ArrayValues[array->GetName()];
-          arrayValues.TotalValues.resize(this->BinCount);
-          int numComps = array->GetNumberOfComponents();
-          arrayValues.TotalValues[index].resize(numComps);
-          for (int comp=0; comp<numComps; comp++)
-            {
-            arrayValues.TotalValues[index][comp] +=
-              array->GetComponent(i, comp);
-            }
+          arrayValues.NumberOfComponents = numComps;
+          arrayValues.TotalValues.resize(this->BinCount*numComps, 0.0);
+          }
+        if (arrayValues.NumberOfComponents != numComps)
+          {
+          continue;
           }
+        if (::vtkEHIsTypedArray(array) && ::vtkEHIsTypedArray(data_array))
+          {
+          task.OtherArrays.push_back(array);
+          }
+        else
+          {
+          genericArrays.push_back(array);
+          }
+        }
+      }
+    }
+
+  vtkIdType num_of_tuples = data_array->GetNumberOfTuples();
+  if (!::vtkEHIsTypedArray(data_array))
+    {
+    // Arrays that can't be accessed directly (such as vtkBitArray) are binned
+    // using the generic API.
+    for (vtkIdType i = 0; i != num_of_tuples; ++i)
+      {
+      if (i%1000 == 0)
+        {
+        this->UpdateProgress(0.10 + 0.90*i/num_of_tuples);
+        }
+      const double value = data_array->GetComponent(i, this->Component);
+      int index = static_cast<int>((value - min) / task.Delta);
+      index = ::vtkExtractHistogramClamp(index, 0, this->BinCount-1);
+      bin_values->SetValue(index, bin_values->GetValue(index)+1);
+      }
+    ::vtkEHAccumulateGeneric(task, genericArrays, this->Internal);
+    return;
+    }
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  int numThreads = ::vtkEHGetNumberOfThreads(threader, num_of_tuples);
+  threader->SetNumberOfThreads(numThreads);
+
+  task.Bins.resize(numThreads,
+    vtkstd::vector<vtkIdType>(this->BinCount, 0));
+  task.Totals.resize(numThreads);
+  for (int tid = 0; tid < numThreads; tid++)
+    {
+    for (size_t cc = 0; cc < task.OtherArrays.size(); ++cc)
+      {
+      task.Totals[tid].push_back(vtkstd::vector<double>(
+        this->BinCount*task.OtherArrays[cc]->GetNumberOfComponents(), 0.0));
+      }
+    }
+
+  threader->SetSingleMethod(::vtkEHBinThread, &task);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Reduce the per-thread results.
+  for (int tid = 0; tid < numThreads; tid++)
+    {
+    for (int bin = 0; bin < this->BinCount; bin++)
+      {
+      bin_values->SetValue(bin, bin_values->GetValue(bin) +
+        static_cast<int>(task.Bins[tid][bin]));
+      }
+    for (size_t cc = 0; cc < task.OtherArrays.size(); ++cc)
+      {
+      vtkstd::vector<double>& totals = this->Internal->ArrayValues[
+        task.OtherArrays[cc]->GetName()].TotalValues;
+      const vtkstd::vector<double>& threadTotals = task.Totals[tid][cc];
+      for (size_t kk = 0; kk < totals.size(); ++kk)
+        {
+        totals[kk] += threadTotals[kk];
         }
       }
     }
+
+  ::vtkEHAccumulateGeneric(task, genericArrays, this->Internal);
 }
 
 //-----------------------------------------------------------------------------
@@ -373,6 +712,7 @@ int vtkExtractHistogram::RequestData(vtkInformation* /*request*/,
 
   output_data->GetRowData()->AddArray(bin_extents);
   output_data->GetRowData()->AddArray(bin_values);
+  this->Internal->SkippedArrays.clear();
 
   vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
   vtkDataObject *input = inInfo->Get(vtkDataObject::DATA_OBJECT());
@@ -413,7 +753,7 @@ int vtkExtractHistogram::RequestData(vtkInformation* /*request*/,
         vtkSmartPointer<vtkDoubleArray>::New();
       vtkstd::string newname2 = iter->first + "_average";
       aa->SetName(newname2.c_str());
-      int numComps = iter->second.TotalValues[0].size();
+      int numComps = iter->second.NumberOfComponents;
       da->SetNumberOfComponents(numComps);
       da->SetNumberOfTuples(this->BinCount);
       aa->SetNumberOfComponents(numComps);
@@ -422,22 +762,14 @@ int vtkExtractHistogram::RequestData(vtkInformation* /*request*/,
         {
         for (int j=0; j<numComps; j++)
           {
-          if (iter->second.TotalValues[i].size() == (unsigned int)numComps)
+          double total = iter->second.TotalValues[i*numComps+j];
+          da->SetValue(i*numComps+j, total);
+          if (bin_values->GetValue(i))
             {
-            da->SetValue(i*numComps+j, iter->second.TotalValues[i][j]);
-            if (bin_values->GetValue(i))
-              {
-              aa->SetValue(i*numComps+j, 
-                iter->second.TotalValues[i][j]/bin_values->GetValue(i));
-              }
-            else
-              {
-              aa->SetValue(i*numComps+j, 0);
-              }
+            aa->SetValue(i*numComps+j, total/bin_values->GetValue(i));
             }
           else
             {
-            da->SetValue(i*numComps+j, 0);
             aa->SetValue(i*numComps+j, 0);
             }
           }
@@ -447,6 +779,20 @@ int vtkExtractHistogram::RequestData(vtkInformation* /*request*/,
       }
 
     this->Internal->ArrayValues.clear();
+
+    if (!this->Internal->SkippedArrays.empty())
+      {
+      vtkstd::string names;
+      vtkstd::set<vtkstd::string>::iterator skipped =
+        this->Internal->SkippedArrays.begin();
+      for (; skipped != this->Internal->SkippedArrays.end(); ++skipped)
+        {
+        names += (names.empty() ? "" : ", ") + *skipped;
+        }
+      vtkWarningMacro("Averages are not computed for arrays that are not "
+        "numeric: " << names.c_str());
+      this->Internal->SkippedArrays.clear();
+      }
     }
 
   return 1;
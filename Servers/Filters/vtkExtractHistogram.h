@@ -33,6 +33,9 @@ struct vtkEHInternals;
 // will have contain a vtkDoubleArray named "bin_extents" which contains
 // the boundaries between each histogram bin, and a vtkUnsignedLongArray
 // named "bin_values" which will contain the value for each bin.
+//
+// Large arrays are binned using multiple threads, each with its own bins,
+// and the averages of the other arrays are accumulated in the same pass.
 
 class VTK_EXPORT vtkExtractHistogram : public vtkTableAlgorithm
 {
@@ -68,7 +71,9 @@ public:
   // Description:
   // This option controls whether the algorithm calculates averages
   // of variables other than the primary variable that fall into each
-  // bin. False by default.
+  // bin. Arrays that are not vtkDataArrays, such as string arrays, have no
+  // average: they are left out of the output with a warning. False by
+  // default.
   vtkSetMacro(CalculateAverages, int);
   vtkGetMacro(CalculateAverages, int);
   vtkBooleanMacro(CalculateAverages, int);
@@ -99,6 +104,11 @@ protected:
 
   void FillBinExtents(vtkDoubleArray* bin_extents, double min, double max);
 
+  // Description:
+  // Computes the range of a component of the array. Uses multiple threads
+  // (see vtkMultiThreader) for large arrays.
+  void ComputeRange(vtkDataArray* data_array, int comp, double range[2]);
+
   double CustomBinRanges[2];
   bool UseCustomBinRanges;
   int Component;
@@ -24,18 +24,34 @@
 
 #include "vtkFileSeriesReader.h"
 
+#include "vtkCellData.h"
+#include "vtkCharArray.h"
 #include "vtkClientServerInterpreter.h"
 #include "vtkClientServerStream.h"
+#include "vtkCommunicator.h"
+#include "vtkCompositeDataIterator.h"
+#include "vtkCompositeDataSet.h"
+#include "vtkDataObjectTypes.h"
+#include "vtkDataSet.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
 #include "vtkGenericDataObjectReader.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationIntegerKey.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
+#include "vtkPointData.h"
 #include "vtkProcessModule.h"
+#include "vtkRectilinearGrid.h"
+#include "vtkSelectionNode.h"
 #include "vtkStdString.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkStringArray.h"
+#include "vtkTable.h"
 #include "vtkTypeTraits.h"
 
 #include "vtkSmartPointer.h"
@@ -47,10 +63,227 @@
 #include <vtkstd/set>
 #include <vtkstd/string>
 #include <vtkstd/vector>
+#include <vtksys/ios/sstream>
+
+#include <string.h>
 
 //=============================================================================
 vtkStandardNewMacro(vtkFileSeriesReader);
 
+// Tag of the partial results sent to process 0 by ReadArraysOverTime.
+static const int vtkFileSeriesReaderArraysOverTimeTag = 39471;
+
+//-----------------------------------------------------------------------------
+// Copies a tuple between two arrays that may have different types.
+static void vtkFileSeriesReaderCopyTuple(vtkDataArray *source,
+                                         vtkIdType sourceId,
+                                         vtkDataArray *target,
+                                         vtkIdType targetId)
+{
+  if (source->GetDataType() == target->GetDataType())
+    {
+    target->InsertTuple(targetId, sourceId, source);
+    }
+  else
+    {
+    target->InsertTuple(targetId, source->GetTuple(sourceId));
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Creates a column like the given array with numRows zero tuples.
+static vtkDataArray *vtkFileSeriesReaderNewColumn(vtkDataArray *array,
+                                                  vtkIdType numRows)
+{
+  vtkDataArray *column = array->NewInstance();
+  column->SetName(array->GetName());
+  column->SetNumberOfComponents(array->GetNumberOfComponents());
+  column->SetNumberOfTuples(numRows);
+  for (int j = 0; j < column->GetNumberOfComponents(); j++)
+    {
+    column->FillComponent(j, 0.0);
+    }
+  return column;
+}
+
+//-----------------------------------------------------------------------------
+// Appends a row to the partial results of ReadArraysOverTime: the time step,
+// the selected id, the process it was found on (-1 when the id means the same
+// element on all processes) and the values of the arrays at sourceId.
+// Columns missing from the source are padded with zeros.
+static void vtkFileSeriesReaderAppendRow(vtkTable *table,
+                                         vtkIdType timeIndex,
+                                         vtkIdType selectedId,
+                                         vtkIdType processId,
+                                         vtkDataSetAttributes *source,
+                                         vtkIdType sourceId)
+{
+  vtkIdTypeArray *timeIndices
+    = vtkIdTypeArray::SafeDownCast(table->GetColumnByName("vtkTimeIndex"));
+  vtkIdTypeArray *selectedIds
+    = vtkIdTypeArray::SafeDownCast(table->GetColumnByName("vtkSelectedId"));
+  vtkIdTypeArray *processIds
+    = vtkIdTypeArray::SafeDownCast(table->GetColumnByName("vtkProcessId"));
+  if (!timeIndices || !selectedIds || !processIds)
+    {
+    table->Initialize();
+    VTK_CREATE(vtkIdTypeArray, newTimeIndices);
+    newTimeIndices->SetName("vtkTimeIndex");
+    table->AddColumn(newTimeIndices);
+    VTK_CREATE(vtkIdTypeArray, newSelectedIds);
+    newSelectedIds->SetName("vtkSelectedId");
+    table->AddColumn(newSelectedIds);
+    VTK_CREATE(vtkIdTypeArray, newProcessIds);
+    newProcessIds->SetName("vtkProcessId");
+    table->AddColumn(newProcessIds);
+    timeIndices = newTimeIndices;
+    selectedIds = newSelectedIds;
+    processIds = newProcessIds;
+    }
+
+  vtkIdType row = timeIndices->GetNumberOfTuples();
+  timeIndices->InsertNextValue(timeIndex);
+  selectedIds->InsertNextValue(selectedId);
+  processIds->InsertNextValue(processId);
+
+  for (int i = 0; i < source->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *array = source->GetArray(i);
+    if (!array || !array->GetName()) continue;
+    vtkDataArray *column
+      = vtkDataArray::SafeDownCast(table->GetColumnByName(array->GetName()));
+    if (!column)
+      {
+      column = vtkFileSeriesReaderNewColumn(array, row);
+      table->AddColumn(column);
+      column->Delete();
+      }
+    if (   (column == timeIndices) || (column == selectedIds)
+        || (column == processIds)
+        || (column->GetNumberOfComponents() != array->GetNumberOfComponents()))
+      {
+      continue;
+      }
+    vtkFileSeriesReaderCopyTuple(array, sourceId, column, row);
+    }
+
+  for (vtkIdType c = 0; c < table->GetNumberOfColumns(); c++)
+    {
+    vtkDataArray *column = vtkDataArray::SafeDownCast(table->GetColumn(c));
+    if (column && (column->GetNumberOfTuples() <= row))
+      {
+      column->SetNumberOfTuples(row+1);
+      for (int j = 0; j < column->GetNumberOfComponents(); j++)
+        {
+        column->SetComponent(row, j, 0.0);
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Appends the selected points or cells of a dataset to the partial results of
+// ReadArraysOverTime.
+static void vtkFileSeriesReaderExtractIds(
+                         vtkDataSet *data, vtkSelectionNode *node,
+                         const vtkstd::set<vtkIdType> &ids,
+                         vtkIdType timeIndex, vtkIdType processId,
+                         vtkTable *partial)
+{
+  vtkDataSetAttributes *attributes;
+  vtkIdType numElements;
+  if (node->GetFieldType() == vtkSelectionNode::POINT)
+    {
+    attributes = data->GetPointData();
+    numElements = data->GetNumberOfPoints();
+    }
+  else
+    {
+    attributes = data->GetCellData();
+    numElements = data->GetNumberOfCells();
+    }
+
+  vtkstd::set<vtkIdType>::const_iterator iter;
+  if (node->GetContentType() == vtkSelectionNode::GLOBALIDS)
+    {
+    vtkDataArray *globalIds = attributes->GetGlobalIds();
+    if (!globalIds) return;
+    for (vtkIdType i = 0; i < numElements; i++)
+      {
+      vtkIdType globalId = static_cast<vtkIdType>(globalIds->GetTuple1(i));
+      if (ids.find(globalId) != ids.end())
+        {
+        vtkFileSeriesReaderAppendRow(partial, timeIndex, globalId, processId,
+                                     attributes, i);
+        }
+      }
+    }
+  else
+    {
+    for (iter = ids.begin(); iter != ids.end(); iter++)
+      {
+      if ((*iter >= 0) && (*iter < numElements))
+        {
+        vtkFileSeriesReaderAppendRow(partial, timeIndex, *iter, processId,
+                                     attributes, *iter);
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Checks whether ReadArraysOverTime can read the selection from reader, whose
+// meta-reader has the output information outInfo.  compositeIndex is set to
+// the flat index of the block the indices refer to, -1 for all the blocks.
+static bool vtkFileSeriesReaderCanReadIds(vtkAlgorithm *reader,
+                                          vtkSelectionNode *node,
+                                          vtkInformation *outInfo,
+                                          int &compositeIndex)
+{
+  compositeIndex = -1;
+  if (!reader || !node) return false;
+
+  int contentType = node->GetContentType();
+  int fieldType = node->GetFieldType();
+  if (   (   (contentType != vtkSelectionNode::INDICES)
+          && (contentType != vtkSelectionNode::GLOBALIDS) )
+      || (   (fieldType != vtkSelectionNode::POINT)
+          && (fieldType != vtkSelectionNode::CELL) ) )
+    {
+    return false;
+    }
+  vtkInformation *properties = node->GetProperties();
+  if (   properties->Has(vtkSelectionNode::INVERSE())
+      && properties->Get(vtkSelectionNode::INVERSE()) )
+    {
+    return false;
+    }
+  vtkDataArray *idList = vtkDataArray::SafeDownCast(node->GetSelectionList());
+  if (!idList || (idList->GetNumberOfTuples() < 1)) return false;
+
+  // Indices into composite data only make sense for a given block.
+  const char *dataType = reader->GetOutputPortInformation(0)->Get(
+                                              vtkDataObject::DATA_TYPE_NAME());
+  vtkDataObject *prototype
+    = dataType ? vtkDataObjectTypes::NewDataObject(dataType) : NULL;
+  bool composite = prototype && prototype->IsA("vtkCompositeDataSet");
+  if (prototype) prototype->Delete();
+  if (composite && (contentType == vtkSelectionNode::INDICES))
+    {
+    if (!properties->Has(vtkSelectionNode::COMPOSITE_INDEX())) return false;
+    compositeIndex = properties->Get(vtkSelectionNode::COMPOSITE_INDEX());
+    }
+
+  if (   !outInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS())
+      || (outInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS()) < 1) )
+    {
+    return false;
+    }
+
+  return (vtkStreamingDemandDrivenPipeline::SafeDownCast(
+                                       reader->GetExecutive()) != NULL);
+}
+
 vtkCxxSetObjectMacro(vtkFileSeriesReader,Reader,vtkAlgorithm);
 
 //=============================================================================
@@ -325,6 +558,9 @@ struct vtkFileSeriesReaderInternals
 {
   vtkstd::vector<vtkstd::string> FileNames;
   bool FileNameIsSet;
+  // True when the time steps are the file indices rather than times reported
+  // by the reader.
+  bool FakeTimes;
   vtkFileSeriesReaderTimeRanges *TimeRanges;
 };
 
@@ -338,6 +574,7 @@ vtkFileSeriesReader::vtkFileSeriesReader()
 
   this->Internal = new vtkFileSeriesReaderInternals;
   this->Internal->FileNameIsSet = false;
+  this->Internal->FakeTimes = false;
   this->Internal->TimeRanges = new vtkFileSeriesReaderTimeRanges;
 
   this->FileNameMethod = NULL;
@@ -543,6 +780,7 @@ int vtkFileSeriesReader::RequestInformation(
     {
     // Input files have no time steps.  Fake a time step for each equal to the
     // index.
+    this->Internal->FakeTimes = true;
     outInfo->Remove(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
     outInfo->Remove(vtkStreamingDemandDrivenPipeline::TIME_RANGE());
     for (int i = 0; i < numFiles; i++)
@@ -555,6 +793,7 @@ int vtkFileSeriesReader::RequestInformation(
   else
     {
     // Record the reported file time info.
+    this->Internal->FakeTimes = false;
     this->Internal->TimeRanges->AddTimeRange(0, outInfo);
 
     // Query all the other files for time info.
@@ -772,6 +1011,290 @@ void vtkFileSeriesReader::UpdateMetaData()
     }
 }
 
+//-----------------------------------------------------------------------------
+int vtkFileSeriesReader::ReadArraysOverTime(
+                                         vtkSelectionNode *node,
+                                         vtkMultiProcessController *controller,
+                                         vtkMultiBlockDataSet *output)
+{
+  int numProcs = controller ? controller->GetNumberOfProcesses() : 1;
+  int procId = controller ? controller->GetLocalProcessId() : 0;
+
+  // All processes have to agree before any of them sends its partial results,
+  // otherwise a process falling back to the pipeline would leave the others
+  // waiting.
+  int compositeIndex = -1;
+  vtkInformation *outInfo = this->GetOutputInformation(0);
+  int canRead = (   output
+                 && vtkFileSeriesReaderCanReadIds(this->Reader, node, outInfo,
+                                                  compositeIndex) ) ? 1 : 0;
+  if (numProcs > 1)
+    {
+    int allCanRead = canRead;
+    controller->AllReduce(&canRead, &allCanRead, 1, vtkCommunicator::MIN_OP);
+    canRead = allCanRead;
+    }
+  if (!canRead) return 0;
+
+  int contentType = node->GetContentType();
+  vtkInformation *properties = node->GetProperties();
+  vtkDataArray *idList = vtkDataArray::SafeDownCast(node->GetSelectionList());
+
+  int numTimeSteps
+    = outInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+  double *timeSteps = outInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+  vtkstd::vector<double> times(timeSteps, timeSteps + numTimeSteps);
+
+  vtkStreamingDemandDrivenPipeline *sddp
+    = vtkStreamingDemandDrivenPipeline::SafeDownCast(
+                                                 this->Reader->GetExecutive());
+
+  // Global ids can be found in the whole dataset, and indices that belong to
+  // a single process in that process's piece.  Either way, every process
+  // reads the same data, so the time steps are split among them.  Otherwise
+  // each process looks for the indices in its own piece at every time step.
+  int piece = procId;
+  int numPieces = numProcs;
+  bool splitTime = false;
+  if (contentType == vtkSelectionNode::GLOBALIDS)
+    {
+    piece = 0;
+    numPieces = 1;
+    splitTime = true;
+    }
+  else if (   properties->Has(vtkSelectionNode::PROCESS_ID())
+           && (properties->Get(vtkSelectionNode::PROCESS_ID()) >= 0) )
+    {
+    piece = properties->Get(vtkSelectionNode::PROCESS_ID());
+    splitTime = true;
+    }
+
+  vtkstd::set<vtkIdType> ids;
+  vtkIdType numIds = idList->GetNumberOfTuples();
+  for (vtkIdType k = 0; k < numIds; k++)
+    {
+    ids.insert(static_cast<vtkIdType>(idList->GetTuple1(k)));
+    }
+  // The same index on different processes is a different element, unless
+  // every process reads the same data.
+  vtkIdType processId = (splitTime || (numProcs == 1)) ? -1 : procId;
+
+  VTK_CREATE(vtkTable, partial);
+  for (int t = 0; t < numTimeSteps; t++)
+    {
+    if (splitTime && ((t % numProcs) != procId)) continue;
+
+    // Read the file for this time step with the reader's own executive, which
+    // leaves the output of this meta-reader untouched.
+    this->RequestInformationForInput(
+                      this->Internal->TimeRanges->GetIndexForTime(times[t]));
+    sddp->UpdateInformation();
+    vtkInformation *readerInfo = this->Reader->GetOutputInformation(0);
+    if (!this->Internal->FakeTimes)
+      {
+      readerInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEPS(),
+                      &times[t], 1);
+      }
+    sddp->SetUpdateExtent(0, piece, numPieces, 0);
+    sddp->Update(0);
+
+    vtkDataObject *data = this->Reader->GetOutputDataObject(0);
+    vtkCompositeDataSet *compositeData = vtkCompositeDataSet::SafeDownCast(data);
+    if (compositeData)
+      {
+      vtkSmartPointer<vtkCompositeDataIterator> iter;
+      iter.TakeReference(compositeData->NewIterator());
+      for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+           iter->GoToNextItem())
+        {
+        if (   (compositeIndex >= 0)
+            && (static_cast<int>(iter->GetCurrentFlatIndex())
+                != compositeIndex) )
+          {
+          continue;
+          }
+        vtkDataSet *block
+          = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+        if (block)
+          {
+          vtkFileSeriesReaderExtractIds(block, node, ids, t, processId,
+                                        partial);
+          }
+        }
+      }
+    else if (vtkDataSet::SafeDownCast(data))
+      {
+      vtkFileSeriesReaderExtractIds(vtkDataSet::SafeDownCast(data), node,
+                                    ids, t, processId, partial);
+      }
+    }
+  // Don't hold on to the last time step read.
+  this->Reader->GetOutputDataObject(0)->ReleaseData();
+
+  // Collect the partial results on process 0.
+  vtkstd::vector<vtkSmartPointer<vtkTable> > partials;
+  partials.push_back(partial);
+  if (numProcs > 1)
+    {
+    if (procId != 0)
+      {
+      controller->Send(partial.GetPointer(), 0,
+                       vtkFileSeriesReaderArraysOverTimeTag);
+      output->Initialize();
+      return 1;
+      }
+    for (int p = 1; p < numProcs; p++)
+      {
+      VTK_CREATE(vtkTable, remote);
+      controller->Receive(remote, p, vtkFileSeriesReaderArraysOverTimeTag);
+      partials.push_back(remote);
+      }
+    }
+
+  // The output has a block for each selected id of process 0, in the order of
+  // its selection list, followed by the ids only found by other processes.
+  // Blocks are identified by the id and the process it was found on (-1 when
+  // the id means the same element everywhere).
+  typedef vtkstd::pair<vtkIdType, vtkIdType> BlockKey;
+  vtkstd::vector<BlockKey> blockKeys;
+  vtkstd::map<BlockKey, vtkIdType> blockIndices;
+  vtkIdType ownerId = (splitTime || (numProcs == 1)) ? -1 : 0;
+  for (vtkIdType k = 0; k < numIds; k++)
+    {
+    BlockKey key(ownerId, static_cast<vtkIdType>(idList->GetTuple1(k)));
+    if (blockIndices.find(key) == blockIndices.end())
+      {
+      blockIndices[key] = static_cast<vtkIdType>(blockKeys.size());
+      blockKeys.push_back(key);
+      }
+    }
+  size_t p;
+  for (p = 0; p < partials.size(); p++)
+    {
+    vtkIdTypeArray *selectedIds = vtkIdTypeArray::SafeDownCast(
+                             partials[p]->GetColumnByName("vtkSelectedId"));
+    vtkIdTypeArray *processIds = vtkIdTypeArray::SafeDownCast(
+                             partials[p]->GetColumnByName("vtkProcessId"));
+    if (!selectedIds || !processIds) continue;
+    for (vtkIdType r = 0; r < selectedIds->GetNumberOfTuples(); r++)
+      {
+      BlockKey key(processIds->GetValue(r), selectedIds->GetValue(r));
+      if (blockIndices.find(key) == blockIndices.end())
+        {
+        blockIndices[key] = static_cast<vtkIdType>(blockKeys.size());
+        blockKeys.push_back(key);
+        }
+      }
+    }
+
+  // Make a 1D grid for each block with a point for each time step, like
+  // vtkExtractArraysOverTime does.
+  vtkIdType numBlocks = static_cast<vtkIdType>(blockKeys.size());
+  output->Initialize();
+  output->SetNumberOfBlocks(static_cast<unsigned int>(numBlocks));
+  vtkstd::vector<vtkPointData *> pointData(numBlocks);
+  for (vtkIdType k = 0; k < numBlocks; k++)
+    {
+    VTK_CREATE(vtkRectilinearGrid, grid);
+    grid->SetDimensions(numTimeSteps, 1, 1);
+    VTK_CREATE(vtkDoubleArray, xCoords);
+    xCoords->SetNumberOfTuples(numTimeSteps);
+    VTK_CREATE(vtkDoubleArray, otherCoords);
+    otherCoords->SetNumberOfTuples(1);
+    otherCoords->SetValue(0, 0.0);
+    grid->SetXCoordinates(xCoords);
+    grid->SetYCoordinates(otherCoords);
+    grid->SetZCoordinates(otherCoords);
+    VTK_CREATE(vtkDoubleArray, timeColumn);
+    timeColumn->SetName("Time");
+    timeColumn->SetNumberOfTuples(numTimeSteps);
+    VTK_CREATE(vtkCharArray, validColumn);
+    validColumn->SetName("vtkValidPointMask");
+    validColumn->SetNumberOfTuples(numTimeSteps);
+    for (int t = 0; t < numTimeSteps; t++)
+      {
+      xCoords->SetValue(t, times[t]);
+      timeColumn->SetValue(t, times[t]);
+      validColumn->SetValue(t, 0);
+      }
+    grid->GetPointData()->AddArray(timeColumn);
+    grid->GetPointData()->AddArray(validColumn);
+
+    unsigned int block = static_cast<unsigned int>(k);
+    output->SetBlock(block, grid);
+    vtksys_ios::ostringstream name;
+    name << ((contentType == vtkSelectionNode::GLOBALIDS) ? "GlobalId " : "Id ")
+         << blockKeys[k].second;
+    if (blockKeys[k].first >= 0)
+      {
+      name << " on process " << blockKeys[k].first;
+      }
+    output->GetMetaData(block)->Set(vtkCompositeDataSet::NAME(),
+                                    name.str().c_str());
+    pointData[k] = grid->GetPointData();
+    }
+
+  for (p = 0; p < partials.size(); p++)
+    {
+    vtkTable *source = partials[p];
+    vtkIdTypeArray *timeIndices
+      = vtkIdTypeArray::SafeDownCast(source->GetColumnByName("vtkTimeIndex"));
+    vtkIdTypeArray *selectedIds
+      = vtkIdTypeArray::SafeDownCast(source->GetColumnByName("vtkSelectedId"));
+    vtkIdTypeArray *processIds
+      = vtkIdTypeArray::SafeDownCast(source->GetColumnByName("vtkProcessId"));
+    if (!timeIndices || !selectedIds || !processIds) continue;
+
+    // Gather the columns, adding the missing arrays to every grid.
+    vtkstd::vector<vtkDataArray *> sourceColumns;
+    for (vtkIdType c = 0; c < source->GetNumberOfColumns(); c++)
+      {
+      vtkDataArray *column = vtkDataArray::SafeDownCast(source->GetColumn(c));
+      if (   !column || (column == timeIndices) || (column == selectedIds)
+          || (column == processIds) || !column->GetName()
+          || (strcmp(column->GetName(), "Time") == 0)
+          || (strcmp(column->GetName(), "vtkValidPointMask") == 0) )
+        {
+        continue;
+        }
+      sourceColumns.push_back(column);
+      for (vtkIdType k = 0; k < numBlocks; k++)
+        {
+        if (!pointData[k]->GetAbstractArray(column->GetName()))
+          {
+          vtkDataArray *newColumn
+            = vtkFileSeriesReaderNewColumn(column, numTimeSteps);
+          pointData[k]->AddArray(newColumn);
+          newColumn->Delete();
+          }
+        }
+      }
+
+    for (vtkIdType r = 0; r < timeIndices->GetNumberOfTuples(); r++)
+      {
+      vtkIdType t = timeIndices->GetValue(r);
+      if ((t < 0) || (t >= numTimeSteps)) continue;
+      vtkIdType k = blockIndices[BlockKey(processIds->GetValue(r),
+                                          selectedIds->GetValue(r))];
+      vtkCharArray::SafeDownCast(
+                    pointData[k]->GetArray("vtkValidPointMask"))->SetValue(t, 1);
+      for (size_t c = 0; c < sourceColumns.size(); c++)
+        {
+        vtkDataArray *target
+          = pointData[k]->GetArray(sourceColumns[c]->GetName());
+        if (   target
+            && (   target->GetNumberOfComponents()
+                == sourceColumns[c]->GetNumberOfComponents()) )
+          {
+          vtkFileSeriesReaderCopyTuple(sourceColumns[c], r, target, t);
+          }
+        }
+      }
+    }
+
+  return 1;
+}
+
 //-----------------------------------------------------------------------------
 void vtkFileSeriesReader::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -43,12 +43,20 @@
 // method is useful when the actual reader points to a set of files itself.  The
 // UseMetaFile toggles between these two methods of specifying files.
 //
+// ReadArraysOverTime() reads the values of a few selected points or cells at
+// every time step in a single pass, without executing the downstream pipeline
+// for each time step.  vtkPVExtractArraysOverTime uses it to plot a selection
+// over time.
+//
 
 #ifndef __vtkFileSeriesReader_h
 #define __vtkFileSeriesReader_h
 
 #include "vtkDataObjectAlgorithm.h"
 
+class vtkMultiBlockDataSet;
+class vtkMultiProcessController;
+class vtkSelectionNode;
 class vtkStringArray;
 
 //BTX
@@ -131,6 +139,23 @@ public:
   vtkSetMacro(IgnoreReaderTime, int);
   vtkBooleanMacro(IgnoreReaderTime, int);
 
+  // Description:
+  // Reads the arrays of the points or cells selected by an INDICES or
+  // GLOBALIDS selection node at every time step reported by the last
+  // RequestInformation, directly from the internal reader.  The time steps
+  // are split among the processes of the controller when the selection allows
+  // it (global ids, or indices from a single process).  The output of process 0
+  // gets one 1D vtkRectilinearGrid per selected id, with a point per time step
+  // (at x = time) and point arrays for the values, the time ("Time") and
+  // whether the id was found at that time ("vtkValidPointMask").  Indices
+  // read by every process from its own piece get a grid per process they are
+  // found on.  Returns 0, leaving the output untouched, if the selection is
+  // not supported on any process or there are no time steps.  All processes
+  // of the controller have to call this method.
+  virtual int ReadArraysOverTime(vtkSelectionNode *node,
+                                 vtkMultiProcessController *controller,
+                                 vtkMultiBlockDataSet *output);
+
 protected:
   vtkFileSeriesReader();
   ~vtkFileSeriesReader();
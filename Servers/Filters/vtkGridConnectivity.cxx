@@ -16,19 +16,22 @@
 
 #include "vtkCellData.h"
 #include "vtkCellType.h"
+#include "vtkCommunicator.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkCompositeDataSet.h"
 #include "vtkDoubleArray.h"
+#include "vtkGenericCell.h"
 #include "vtkIdTypeArray.h"
 #include "vtkIdList.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
 #include "vtkMultiProcessController.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
-#include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkPolygon.h"
 #include "vtkProcessModule.h"
 #include "vtkTriangle.h"
@@ -40,12 +43,17 @@
 #include "vtkCellArray.h"
 #include "vtkEquivalenceSet.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/utility>
+#include <string.h>
+
 
 // Distributed:
 // Find the max process global point id (face hash).
-// Create a map of fragment id/process.
-// Send face structures to process 0.
-// Add remote faces to face hash (mapping fragment ids).
+// Label the cells of the process (several threads for large inputs).
+// Send the remaining faces to the process owning their smallest corner.
+// Faces received twice are internal and join fragments of two processes.
+// Every process resolves the (few) fragment equivalences.
 
 
 // Arbitrary maximum.  Cells are 3D.
@@ -113,11 +121,6 @@ public:
   // Storing it in the face should be good enough.
   int FragmentId;
   
-  // This is used for merging hashes from multiple processes.
-  // It is the index of the face in the original process.
-  // I use it to create a mask to return to the original process.
-  vtkIdType MarshalId;
-  
   // Linked list.
   vtkGridConnectivityFace* NextFace;
 
@@ -256,6 +259,11 @@ public:
   // This creates a hash that expects at most "numberOfPoint" points
   // as indexes.
   void Initialize(vtkIdType numberOfPoints);
+  // This creates a hash for the point ids
+  // [firstPointId, firstPointId+numberOfPoints).
+  void Initialize(vtkIdType firstPointId, vtkIdType numberOfPoints);
+  vtkIdType GetFirstPointId() {return this->FirstPointId;}
+  vtkIdType GetNumberOfPoints() {return this->NumberOfPoints;}
   
   // These methods ass a face to the hash.  The four point method is for convenience.
   // The points do not need to be sorted.
@@ -275,7 +283,8 @@ public:
   vtkGridConnectivityFace* GetNextFace();
   // Since the face does not store the first point id explicitley,
   // this returns the id from the iterator state.
-  vtkIdType GetFirstPointIndex() {return this->IteratorIndex;}
+  vtkIdType GetFirstPointIndex()
+    {return this->FirstPointId + this->IteratorIndex;}
 
 private:
 
@@ -286,6 +295,7 @@ private:
   // Array indexed by faces smallest corner id.
   // Each element is a linked list of faces that share the point.
   vtkGridConnectivityFace** Hash;
+  vtkIdType FirstPointId;
   vtkIdType NumberOfPoints;
 
   // Allocates faces efficiently.
@@ -299,6 +309,7 @@ private:
 vtkGridConnectivityFaceHash::vtkGridConnectivityFaceHash()
 {
   this->Hash = 0;
+  this->FirstPointId = 0;
   this->NumberOfPoints = 0;
   this->Heap = new vtkGridConnectivityFaceHeap;
   
@@ -358,6 +369,12 @@ vtkGridConnectivityFace* vtkGridConnectivityFaceHash::GetNextFace()
 }
 
 void vtkGridConnectivityFaceHash::Initialize(vtkIdType numberOfPoints)
+{
+  this->Initialize(0, numberOfPoints);
+}
+
+void vtkGridConnectivityFaceHash::Initialize(vtkIdType firstPointId,
+                                             vtkIdType numberOfPoints)
 {
   if (this->Hash)
     {
@@ -365,6 +382,7 @@ void vtkGridConnectivityFaceHash::Initialize(vtkIdType numberOfPoints)
     return;
     }
   this->Hash = new vtkGridConnectivityFace*[numberOfPoints];
+  this->FirstPointId = firstPointId;
   this->NumberOfPoints = numberOfPoints;
   memset(this->Hash, 0, sizeof(vtkGridConnectivityFace*)*numberOfPoints);
 }
@@ -420,7 +438,8 @@ vtkGridConnectivityFace* vtkGridConnectivityFaceHash::AddFace(
   // Note: We do not check if the point index is out of bounds.
 
   // Now look for the face in the hash.
-  vtkGridConnectivityFace** ref = this->Hash + pt1; // Keep old ref for editing.
+  // Keep old ref for editing.
+  vtkGridConnectivityFace** ref = this->Hash + (pt1 - this->FirstPointId);
   vtkGridConnectivityFace* face = *ref;
   while (face)
     {
@@ -472,6 +491,8 @@ vtkGridConnectivity::vtkGridConnectivity()
   this->EquivalenceSet = 0;
   this->FragmentVolumes = 0;
   this->FaceHash = 0;
+  this->CellPoints = vtkPoints::New();
+  this->CellPointIds = vtkIdList::New();
   this->Controller = vtkMultiProcessController::GetGlobalController();
   this->ProcessId = this->Controller->GetLocalProcessId();
 }
@@ -479,6 +500,8 @@ vtkGridConnectivity::vtkGridConnectivity()
 //-----------------------------------------------------------------------------
 vtkGridConnectivity::~vtkGridConnectivity()
 {
+  this->CellPoints->Delete();
+  this->CellPointIds->Delete();
   this->Controller = 0;
 }
 
@@ -527,19 +550,29 @@ int vtkGridConnectivity::CheckInput(vtkUnstructuredGrid* input)
 // of partial fragments will be close to the number of final fragments.
 // The equivalence set will be used to merge partial fragments that touch.
 // This method also integrates arrays for partial fragments.
+// Only the cells [begin, end) are labeled.  Cells are numbered through all
+// the inputs, inputCellOffsets[ii] being the number of the first cell of
+// input ii.  New fragments are numbered from firstFragmentId, and the next
+// unused fragment id is returned.  When concurrent is true, other threads
+// label other cell ranges with the same equivalence set at the same time.
 template <class T>
-void vtkGridConnectivityExecuteProcess(
+int vtkGridConnectivityExecuteProcess(
   vtkGridConnectivity* self,
   vtkUnstructuredGrid* inputs[],
+  vtkIdType* inputCellOffsets,
   int numberOfInputs,
   int processId,
   vtkGridConnectivityFaceHash* faceHash,
   vtkEquivalenceSet* equivalenceSet,
+  vtkIdType begin,
+  vtkIdType end,
+  int firstFragmentId,
+  bool concurrent,
   T* globalPtIdPtr)
 {
   // Essentially a count of the fragment ids we have used so far.
   // We start counting from 1 so 0 can be a special value used to remove faces.
-  int nextFragmentId = 1;
+  int nextFragmentId = firstFragmentId;
 
   // I used to allocate a cell array for fragment ids but
   // THIS ARRAY WAS NOT NECESSARY.  WE JUST KEEP THE FRAGMENT IDS
@@ -551,30 +584,47 @@ void vtkGridConnectivityExecuteProcess(
   //int* cellFragments = new int[totalNumberOfCellsInProcess];
   //int* cellFragmentPtr = cellFragments;
 
+  // The cell API of the inputs is not thread safe.  Use our own cell.
+  vtkGenericCell* cell = vtkGenericCell::New();
+
   // Loop through all cells of all inputs adding all faces to hash.
   // Select fragment id for each cell based on neighbors.  We are hoping that
   // cell order will be spatial and will not be random.
   for (int ii = 0; ii < numberOfInputs; ++ii)
     {
+    vtkIdType firstCell = begin - inputCellOffsets[ii];
+    vtkIdType lastCell = end - inputCellOffsets[ii];
+    if (firstCell < 0)
+      {
+      firstCell = 0;
+      }
+    vtkIdType numCells = inputs[ii]->GetNumberOfCells();
+    if (lastCell > numCells)
+      {
+      lastCell = numCells;
+      }
+    if (firstCell >= lastCell)
+      {
+      continue;
+      }
     vtkDataArray* a = inputs[ii]->GetPointData()->GetGlobalIds();
     void *ptr = a->GetVoidPointer(0);
     globalPtIdPtr = static_cast<T*>(ptr);
-    vtkIdType numCells = inputs[ii]->GetNumberOfCells();
     // The status array is a mask that identifies unused cells.
     vtkDoubleArray* statusArray = vtkDoubleArray::SafeDownCast(
                      inputs[ii]->GetCellData()->GetArray("STATUS"));
     double* statusPtr = 0;
     if (statusArray)
       {
-      statusPtr = statusArray->GetPointer(0);
+      statusPtr = statusArray->GetPointer(firstCell);
       }
-    for (int jj = 0; jj < numCells; ++jj)
+    for (vtkIdType jj = firstCell; jj < lastCell; ++jj)
       {
       if (statusPtr == 0 || *statusPtr++ == 0.0)
         {
         // Loop through faces of the cell.
         // This might be an performance bottle neck. (cell api)
-        vtkCell* cell = inputs[ii]->GetCell(jj);
+        inputs[ii]->GetCell(jj, cell);
         int numFaces = cell->GetNumberOfFaces();
         vtkGridConnectivityFace* newFaces[VTK_MAX_FACES_PER_CELL];
         int numNewFaces = 0;
@@ -622,8 +672,16 @@ void vtkGridConnectivityExecuteProcess(
                 {
                 // This cell connects two fragments, we need
                 // to make the fragment ids equivalent.
-                equivalenceSet->AddEquivalence(minFragmentId,
-                                               face->FragmentId);
+                if (concurrent)
+                  {
+                  equivalenceSet->ConcurrentAddEquivalence(minFragmentId,
+                                                           face->FragmentId);
+                  }
+                else
+                  {
+                  equivalenceSet->AddEquivalence(minFragmentId,
+                                                 face->FragmentId);
+                  }
                 }
               // Keep track of the smallest fragment id to use for this cell.
               if (minFragmentId > face->FragmentId)
@@ -654,12 +712,24 @@ void vtkGridConnectivityExecuteProcess(
         if (minFragmentId == nextFragmentId)
           { // Cell has no neighbors (traversed yet). New fragment id.
           // Make sure the equivalence set has the correct number of members.
-          equivalenceSet->AddEquivalence(nextFragmentId,nextFragmentId);
+          // The concurrent set is allocated up front by the caller.
+          if (!concurrent)
+            {
+            equivalenceSet->AddEquivalence(nextFragmentId,nextFragmentId);
+            }
           nextFragmentId++;
           }
         // I do not think that the equivalence set has a more upto date id,
         // but it cannot hurt to check/
-        minFragmentId = equivalenceSet->GetEquivalentSetId(minFragmentId);
+        if (concurrent)
+          {
+          minFragmentId =
+            equivalenceSet->ConcurrentGetEquivalentSetId(minFragmentId);
+          }
+        else
+          {
+          minFragmentId = equivalenceSet->GetEquivalentSetId(minFragmentId);
+          }
         // Label the faces with the fragment id we computed.
         for (int kk = 0; kk < numNewFaces; ++kk)
           {
@@ -670,23 +740,231 @@ void vtkGridConnectivityExecuteProcess(
         } // if status
       } // for cells
     } // for input
+
+  cell->Delete();
+  return nextFragmentId;
+}
+
+//----------------------------------------------------------------------------
+// Computes the range of the global ids of the points used by the cells
+// [begin, end).  Cells are numbered as in vtkGridConnectivityExecuteProcess.
+template <class T>
+void vtkGridConnectivityComputePointRange(
+  vtkUnstructuredGrid* inputs[],
+  vtkIdType* inputCellOffsets,
+  int numberOfInputs,
+  vtkIdType begin,
+  vtkIdType end,
+  vtkIdType range[2],
+  T*)
+{
+  range[0] = VTK_LARGE_ID;
+  range[1] = -1;
+  for (int ii = 0; ii < numberOfInputs; ++ii)
+    {
+    vtkIdType firstCell = vtkstd::max(begin - inputCellOffsets[ii],
+                                      static_cast<vtkIdType>(0));
+    vtkIdType lastCell = vtkstd::min(end - inputCellOffsets[ii],
+                                     inputs[ii]->GetNumberOfCells());
+    if (firstCell >= lastCell)
+      {
+      continue;
+      }
+    T* globalPtIdPtr = static_cast<T*>(
+      inputs[ii]->GetPointData()->GetGlobalIds()->GetVoidPointer(0));
+    for (vtkIdType jj = firstCell; jj < lastCell; ++jj)
+      {
+      vtkIdType npts;
+      vtkIdType* pts;
+      inputs[ii]->GetCellPoints(jj, npts, pts);
+      for (vtkIdType kk = 0; kk < npts; ++kk)
+        {
+        vtkIdType ptId = static_cast<vtkIdType>(globalPtIdPtr[pts[kk]]);
+        if (ptId < range[0])
+          {
+          range[0] = ptId;
+          }
+        if (ptId > range[1])
+          {
+          range[1] = ptId;
+          }
+        }
+      }
+    }
+  if (range[1] < range[0])
+    { // No cells.
+    range[0] = 0;
+    range[1] = -1;
+    }
 }
 
 
 //----------------------------------------------------------------------------
+// Extends range to the ids in ptr.
 template <class T>
-vtkIdType vtkGridConnectivityComputeMax(T* ptr, vtkIdType num)
+void vtkGridConnectivityComputeRange(T* ptr, vtkIdType num, vtkIdType range[2])
 {
-  T max = 0;
   while (num-- > 0)
     {
-    if (*ptr > max)
+    vtkIdType id = static_cast<vtkIdType>(*ptr);
+    if (id < range[0])
+      {
+      range[0] = id;
+      }
+    if (id > range[1])
       {
-      max = *ptr;
+      range[1] = id;
       }
     ++ptr;
     }
-  return static_cast<vtkIdType>(max);
+}
+
+//----------------------------------------------------------------------------
+// The cells of a process are split in contiguous ranges, one per thread.
+// Each thread labels its range with its own face hash and vtkGridConnectivity
+// instance, and numbers its fragments after the first cell of its range so
+// that fragment ids of different threads never collide.  All threads share
+// the equivalence set and integration arrays, which are allocated for one
+// fragment per cell.
+class vtkGridConnectivityTask
+{
+public:
+  vtkUnstructuredGrid** Inputs;
+  int NumberOfInputs;
+  vtkstd::vector<vtkIdType> InputCellOffsets;
+  int ProcessId;
+  int GlobalPointIdType;
+  vtkEquivalenceSet* EquivalenceSet;
+  // The first pass computes the point id range of every thread,
+  // the second pass labels the cells.
+  int Pass;
+  vtkstd::vector<vtkIdType> PointRanges;
+  vtkstd::vector<vtkGridConnectivity*> Workers;
+  vtkstd::vector<vtkGridConnectivityFaceHash*> FaceHashes;
+
+  vtkIdType GetBegin(int threadId, int numThreads)
+    {
+    return (this->InputCellOffsets[this->NumberOfInputs] * threadId) /
+      numThreads;
+    }
+
+  void Execute(int threadId, int numThreads)
+    {
+    vtkIdType begin = this->GetBegin(threadId, numThreads);
+    vtkIdType end = this->GetBegin(threadId + 1, numThreads);
+    vtkIdType* range = &this->PointRanges[2 * threadId];
+    if (this->Pass == 0)
+      {
+      switch (this->GlobalPointIdType)
+        {
+        vtkTemplateMacro(
+          vtkGridConnectivityComputePointRange(this->Inputs,
+            &this->InputCellOffsets[0], this->NumberOfInputs, begin, end,
+            range, static_cast<VTK_TT*>(0)));
+        }
+      return;
+      }
+
+    vtkGridConnectivityFaceHash* faceHash = new vtkGridConnectivityFaceHash;
+    faceHash->Initialize(range[0], range[1] - range[0] + 1);
+    this->FaceHashes[threadId] = faceHash;
+    int nextFragmentId = static_cast<int>(begin + 1);
+    switch (this->GlobalPointIdType)
+      {
+      vtkTemplateMacro(
+        nextFragmentId = vtkGridConnectivityExecuteProcess(
+          this->Workers[threadId], this->Inputs, &this->InputCellOffsets[0],
+          this->NumberOfInputs, this->ProcessId, faceHash,
+          this->EquivalenceSet, begin, end, nextFragmentId, true,
+          static_cast<VTK_TT*>(0)));
+      }
+    // Put the ids this range did not use in the empty fragment 0, so that
+    // they are not counted as fragments.
+    for (vtkIdType id = nextFragmentId; id <= end; ++id)
+      {
+      this->EquivalenceSet->ConcurrentAddEquivalence(0, static_cast<int>(id));
+      }
+    }
+};
+
+namespace
+{
+// Don't spawn threads for fewer cells than this per thread.
+const vtkIdType vtkGCMinimumCellsPerThread = 20000;
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkGridConnectivityThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkGridConnectivityTask* task =
+    static_cast<vtkGridConnectivityTask*>(info->UserData);
+  task->Execute(info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Tag of the messages exchanged between neighbor processes.
+const int vtkGCExchangeIdsTag = 0x47c1;
+
+//----------------------------------------------------------------------------
+// Returns the process that matches the faces with the sorted corners
+// corner1 < corner2 < corner3: the lowest of the processes whose range of
+// global point ids holds the corners.  Returns -1 when no neighbor holds
+// them, the face is then on the boundary.
+int vtkGridConnectivityFaceOwner(vtkIdType corner1, vtkIdType corner3,
+  int myId, const vtkstd::vector<int>& neighbors,
+  const vtkstd::vector<vtkIdType>& pointRanges)
+{
+  int owner = -1;
+  for (size_t ii = 0; ii < neighbors.size(); ++ii)
+    {
+    int procIdx = neighbors[ii];
+    if (pointRanges[2 * procIdx] <= corner1 &&
+        corner3 <= pointRanges[2 * procIdx + 1])
+      {
+      owner = procIdx;
+      break;
+      }
+    }
+  if (owner > myId)
+    {
+    owner = myId;
+    }
+  return owner;
+}
+
+//----------------------------------------------------------------------------
+// Returns the process of a global fragment id.
+int vtkGridConnectivityFragmentProcess(vtkIdType fragmentId,
+  const vtkstd::vector<vtkIdType>& fragmentIdOffsets)
+{
+  return static_cast<int>(
+    vtkstd::upper_bound(fragmentIdOffsets.begin(), fragmentIdOffsets.end(),
+                        fragmentId) - fragmentIdOffsets.begin()) - 1;
+}
+
+//----------------------------------------------------------------------------
+// Orders faces packed as 4 ids (3 corners and fragment id) by corner ids.
+class vtkGridConnectivityFaceLess
+{
+public:
+  vtkGridConnectivityFaceLess(const vtkIdType* faces) : Faces(faces) {}
+  bool operator()(vtkIdType face1, vtkIdType face2) const
+    {
+    const vtkIdType* corners1 = this->Faces + 4 * face1;
+    const vtkIdType* corners2 = this->Faces + 4 * face2;
+    for (int ii = 0; ii < 3; ++ii)
+      {
+      if (corners1[ii] != corners2[ii])
+        {
+        return corners1[ii] < corners2[ii];
+        }
+      }
+    return false;
+    }
+private:
+  const vtkIdType* Faces;
+};
 }
 
 
@@ -695,49 +973,33 @@ void vtkGridConnectivity::InitializeFaceHash(
   vtkUnstructuredGrid** inputs, 
   int numberOfInputs)
 {
-  vtkIdType maxId = 0;
-  
-  // We need to find the maximum global point Id to initialize the face hash.
+  // The hash only needs the range of global point ids of this process.
+  vtkIdType range[2] = {VTK_LARGE_ID, -1};
   for (int ii = 0 ; ii < numberOfInputs; ++ii)
     {
     vtkDataArray* a = inputs[ii]->GetPointData()->GetGlobalIds();
     void *ptr = a->GetVoidPointer(0);
     vtkIdType numIds = a->GetNumberOfTuples();
-    maxId = 0;
     this->GlobalPointIdType = a->GetDataType();
     switch(this->GlobalPointIdType)
       {
         vtkTemplateMacro(
-          maxId = vtkGridConnectivityComputeMax(static_cast<VTK_TT*>(ptr), numIds));
+          vtkGridConnectivityComputeRange(static_cast<VTK_TT*>(ptr), numIds,
+                                          range));
       default:
         vtkErrorMacro("ThreadedRequestData: Unknown input ScalarType");
         return;
       }
     }
-
-  // Now we need to compute the maximum of all processes.
-  int numProcs = this->Controller->GetNumberOfProcesses();
-  if (this->Controller->GetLocalProcessId() != 0)
-    {
-    this->Controller->Send(&maxId, 1, 0, 8897324);
-    // Only process 0 needs a hash to hold all procs faces.
-    }
-  else
-    {
-    for (int ii = 1; ii < numProcs; ++ii)
-      {
-      vtkIdType tmp;
-      this->Controller->Receive(&tmp, 1, ii, 8897324);
-      if (tmp > maxId)
-        {
-        maxId = tmp;
-        }
-      }
+  if (range[1] < range[0])
+    { // No points.
+    range[0] = 0;
+    range[1] = -1;
     }
 
   if (this->FaceHash) { delete this->FaceHash;}
   this->FaceHash = new vtkGridConnectivityFaceHash;
-  this->FaceHash->Initialize(maxId + 1);
+  this->FaceHash->Initialize(range[0], range[1] - range[0] + 1);
 }
 
 
@@ -776,6 +1038,129 @@ void vtkGridConnectivity::InitializeIntegrationArrays(
 }
 
 
+//-----------------------------------------------------------------------------
+// Labels the cells of the inputs with partial fragment ids and fills the face
+// hash, equivalence set and integration arrays.  Large inputs are split in
+// cell ranges labeled by separate threads.  Their face hashes are then
+// merged in the face hash of the process.  Only the faces on the surface of
+// the partial fragments of a thread are left to merge.
+void vtkGridConnectivity::ComputeProcessFragments(
+  vtkUnstructuredGrid** inputs,
+  int numberOfInputs)
+{
+  vtkstd::vector<vtkIdType> inputCellOffsets(numberOfInputs + 1, 0);
+  for (int ii = 0; ii < numberOfInputs; ++ii)
+    {
+    inputCellOffsets[ii + 1] =
+      inputCellOffsets[ii] + inputs[ii]->GetNumberOfCells();
+    }
+  vtkIdType numCells = inputCellOffsets[numberOfInputs];
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  int maxThreads = static_cast<int>(
+    vtkstd::max<vtkIdType>(numCells / vtkGCMinimumCellsPerThread, 1));
+  int numThreads = vtkstd::min(threader->GetNumberOfThreads(), maxThreads);
+  // Threads use one fragment id per cell, which have to fit in an int.
+  if (numThreads > 1 && numCells < VTK_INT_MAX)
+    {
+    vtkGridConnectivityTask task;
+    task.Inputs = inputs;
+    task.NumberOfInputs = numberOfInputs;
+    task.InputCellOffsets = inputCellOffsets;
+    task.ProcessId = this->ProcessId;
+    task.GlobalPointIdType = this->GlobalPointIdType;
+    task.EquivalenceSet = this->EquivalenceSet;
+    task.PointRanges.resize(2 * numThreads);
+    task.FaceHashes.resize(numThreads, 0);
+    task.Pass = 0;
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(vtkGridConnectivityThread, &task);
+    threader->SingleMethodExecute();
+
+    // Each thread needs a face hash for the range of point ids of its
+    // cells.  Do not use threads if the ranges overlap so much that these
+    // take a lot more memory than the face hash of the process.
+    vtkIdType hashSize = 0;
+    for (int t = 0; t < numThreads; ++t)
+      {
+      hashSize += task.PointRanges[2 * t + 1] - task.PointRanges[2 * t] + 1;
+      }
+    if (hashSize <= 2 * this->FaceHash->GetNumberOfPoints())
+      {
+      // One possible fragment for every cell, fragment 0 is not used.
+      this->EquivalenceSet->SetNumberOfMembers(
+        static_cast<int>(numCells + 1));
+      this->FragmentVolumes->SetNumberOfTuples(numCells + 1);
+      memset(this->FragmentVolumes->GetPointer(0), 0,
+             (numCells + 1) * sizeof(double));
+      int numArrays = static_cast<int>(this->CellAttributesIntegration.size());
+      for (int ii = 0; ii < numArrays; ++ii)
+        {
+        vtkDoubleArray* da = this->CellAttributesIntegration[ii];
+        da->SetNumberOfTuples(numCells + 1);
+        memset(da->GetPointer(0), 0, (numCells + 1) * sizeof(double));
+        }
+      for (int t = 0; t < numThreads; ++t)
+        {
+        vtkGridConnectivity* worker = vtkGridConnectivity::New();
+        worker->FragmentVolumes = this->FragmentVolumes;
+        worker->CellAttributesIntegration = this->CellAttributesIntegration;
+        task.Workers.push_back(worker);
+        }
+      task.Pass = 1;
+      threader->SingleMethodExecute();
+
+      // Merge the faces left in the hash of each thread.  A face found in
+      // two threads joins the fragments on both sides.
+      for (int t = 0; t < numThreads; ++t)
+        {
+        vtkGridConnectivityFaceHash* faceHash = task.FaceHashes[t];
+        vtkGridConnectivityFace* face;
+        faceHash->InitTraversal();
+        while ( (face = faceHash->GetNextFace()) )
+          {
+          vtkGridConnectivityFace* processFace = this->FaceHash->AddFace(
+            faceHash->GetFirstPointIndex(), face->CornerId2, face->CornerId3);
+          if (processFace->FragmentId > 0)
+            {
+            this->EquivalenceSet->AddEquivalence(processFace->FragmentId,
+                                                 face->FragmentId);
+            }
+          else
+            {
+            processFace->ProcessId = face->ProcessId;
+            processFace->BlockId = face->BlockId;
+            processFace->CellId = face->CellId;
+            processFace->FaceId = face->FaceId;
+            processFace->FragmentId = face->FragmentId;
+            }
+          }
+        delete faceHash;
+        task.Workers[t]->FragmentVolumes = 0;
+        task.Workers[t]->CellAttributesIntegration.clear();
+        task.Workers[t]->Delete();
+        }
+      threader->Delete();
+      return;
+      }
+    }
+  threader->Delete();
+
+  switch(this->GlobalPointIdType)
+    {
+    vtkTemplateMacro(
+      vtkGridConnectivityExecuteProcess(this, inputs, &inputCellOffsets[0],
+                                        numberOfInputs,
+                                        this->ProcessId,
+                                        this->FaceHash,
+                                        this->EquivalenceSet,
+                                        0, numCells, 1, false,
+                                        static_cast<VTK_TT*>(0)));
+    default:
+      vtkErrorMacro("ExecuteProcess: Unknown input ScalarType");
+    }
+}
+
 //-----------------------------------------------------------------------------
 // The standard execute method.
 int vtkGridConnectivity::RequestData(vtkInformation*,
@@ -873,27 +1258,16 @@ int vtkGridConnectivity::RequestData(vtkInformation*,
   // integrated values for each attribute.  The arrays
   // are initialized to 0 and indexed by fragment id.
   this->InitializeIntegrationArrays(inputs, numberOfInputs);
-  // We need to know the maximum globalNodeId (across all processes)
-  // to initialize the face hash.  This methods computes it and initializes.
+  // The face hash is indexed by the global point ids of this process.
   this->InitializeFaceHash(inputs, numberOfInputs);
 
-  switch(this->GlobalPointIdType)
-    {
-    vtkTemplateMacro(
-      vtkGridConnectivityExecuteProcess(this, inputs, numberOfInputs, 
-                                        this->ProcessId,
-                                        this->FaceHash,
-                                        this->EquivalenceSet,
-                                        static_cast<VTK_TT*>(0)));
-    default:
-      vtkErrorMacro("ExecuteProcess: Unknown input ScalarType");
-      return 0;
-    }
+  // Label the cells with partial fragment ids and integrate the partial
+  // fragments.
+  this->ComputeProcessFragments(inputs, numberOfInputs);
 
-  // Deal with distributed data. Send all polygons to a single process.
-  // Find equivalences in process 0.
-  // If this becomes a bottleneck,  we could build up an occupancy map indexed
-  // by global node ids.
+  // Deal with distributed data.  Faces on the surface of partial fragments
+  // are matched on the process owning their smallest corner, and every
+  // process merges the resulting fragment equivalences.
   // This also combines the volume integration of the partial fragment volumes
   // into final volumes indexed by the resolved fragment ids.
   // Note: the ids start from 1.  This is because we started assigning partial fragment ids
@@ -1139,262 +1513,380 @@ void vtkGridConnectivity::IntegrateCellVolume(
 
 
 //----------------------------------------------------------------------------
-// This method expects that every process has raw (unresolved) equivalence set
-// faces and arrays.  At the end of this method, process 0 has face hash,
-// equivalence set and arrays merged from all processes, and resolved.
-// Every thing looks like it was generated locally (single arrays...).
-// Faces in the root process hash have a processId and marshalId to indicate 
-// the source process.  This is important because only the source process has
-// the inputs used to create the surface geometry.  The marshalId is the index
-// of the face in the originating process hash.
-// All processes call this method at the same time (potential to hang).
-// The fragmentIdOffsets is an empty array allocated byu the caller.
-// The function that maps the local fragment ids to global fragment ids
-// is returned in the array.
-void vtkGridConnectivity::CollectFacesAndArraysToRootProcess(int* fragmentIdOffsets)
+// Sends sendBuffers[p] to process p, which must be this process or one of
+// neighbors (sorted by rank); the other buffers are ignored.  On return,
+// recvBuffer holds what these processes sent to this one, ordered by sender,
+// and the part sent by process p starts at recvOffsets[p].  recvOffsets has
+// one more entry than the number of processes.  This process and its
+// neighbors call this method at the same time.
+// Every pair of neighbors exchanges the lengths and contents of their
+// buffers, the lower rank sending first.  Since every process goes through
+// its neighbors by rank, the pairs cannot wait on each other.
+void vtkGridConnectivity::ExchangeIds(
+  const vtkstd::vector<int>& neighbors,
+  vtkstd::vector<vtkstd::vector<vtkIdType> >& sendBuffers,
+  vtkstd::vector<vtkIdType>& recvBuffer,
+  vtkstd::vector<vtkIdType>& recvOffsets)
 {
-  vtkIdType msg1[2];
-  vtkIdType numFaces;
-  vtkIdType msgLength;
-  vtkIdType* msg2;
-  vtkIdType* msgPtr;
-  vtkIdType corner1, corner2, corner3;
-  vtkIdType blockId, faceId, cellId, fragmentId;
-  vtkGridConnectivityFace* face;
-  int numberOfFragments;
-  
-  if (this->Controller->GetLocalProcessId() != 0)
-    { // Remote process
-    // Resolve equivaleneces Before we send the faces.
-    // This is important because we do not send the equivalence set to process 0.
-    this->ResolveEquivalentFragments();
-    // Marshal the hash and send it to process 0.
-    numFaces = this->FaceHash->GetNumberOfFaces();
-    // Number of fragments.  I assuem this is the
-    // resolved number of fragments, but it will little difference.
-    vtkIdType numFragments = this->EquivalenceSet->GetNumberOfResolvedSets();
-    msg1[0] = numFragments;
-    msg1[1] = numFaces;
-    this->Controller->Send(msg1, 2, 0, 9890831);
-    if (numFaces > 0)
+  int numProcs = this->Controller->GetNumberOfProcesses();
+  int myId = this->Controller->GetLocalProcessId();
+
+  vtkstd::vector<vtkstd::vector<vtkIdType> > received(numProcs);
+  received[myId].swap(sendBuffers[myId]);
+  for (size_t ii = 0; ii < neighbors.size(); ++ii)
+    {
+    int other = neighbors[ii];
+    vtkstd::vector<vtkIdType>& sendBuffer = sendBuffers[other];
+    vtkstd::vector<vtkIdType>& recvIds = received[other];
+    for (int step = 0; step < 2; ++step)
       {
-      // Lets put everything into a single vtkIdType array
-      msgLength = numFaces * 7;
-      msg2 = new vtkIdType[msgLength];
-      msgPtr = msg2;
-      this->FaceHash->InitTraversal();
-      while ( (face = this->FaceHash->GetNextFace()) )
+      if ((step == 0) == (myId < other))
         {
-        *msgPtr++ = this->FaceHash->GetFirstPointIndex();
-        *msgPtr++ = face->CornerId2;
-        *msgPtr++ = face->CornerId3;
-        *msgPtr++ = face->BlockId;
-        *msgPtr++ = face->CellId;
-        *msgPtr++ = face->FaceId;
-        *msgPtr++ = face->FragmentId;
+        vtkIdType length = static_cast<vtkIdType>(sendBuffer.size());
+        this->Controller->Send(&length, 1, other, vtkGCExchangeIdsTag);
+        if (length > 0)
+          {
+          this->Controller->Send(&sendBuffer[0], length, other,
+                                 vtkGCExchangeIdsTag);
+          }
         }
-      this->Controller->Send(msg2, msgLength, 0, 1344897);
-      delete [] msg2;
-      // Now send the integration arrays (volume).
-      this->Controller->Send(this->FragmentVolumes->GetPointer(0), numFragments, 0, 5634780);
-      } // endif numFaces > 0
-    } // end if not process 0
-  else
-    { // Process is 0
-    // Build up a map to make each processes fragment
-    int numProcs = this->Controller->GetNumberOfProcesses();
-    fragmentIdOffsets[0] = 0;
-    fragmentIdOffsets[1] = this->EquivalenceSet->GetNumberOfMembers();
-    for (int procIdx = 1; procIdx < numProcs; ++procIdx)
-      { // loop over every process. 
-      // Receive
-      this->Controller->Receive(msg1, 2, procIdx, 9890831);
-      numberOfFragments = msg1[0];
-      numFaces = msg1[1];
-      // Create a map to assign global fragment ids.
-      fragmentIdOffsets[procIdx+1] = fragmentIdOffsets[procIdx] + numFaces;
-      if (numFaces > 0)
+      else
         {
-        // Receive faces from a remote process.
-        msgLength = numFaces * 7;
-        msg2 = new vtkIdType[msgLength];
-        this->Controller->Receive(msg2,msgLength,procIdx,1344897);
-        msgPtr = msg2;
-        for (int faceIdx = 0; faceIdx < numFaces; ++faceIdx)
+        vtkIdType length = 0;
+        this->Controller->Receive(&length, 1, other, vtkGCExchangeIdsTag);
+        recvIds.resize(length);
+        if (length > 0)
           {
-          corner1 = *msgPtr++;
-          corner2 = *msgPtr++;
-          corner3 = *msgPtr++;
-          blockId = *msgPtr++;
-          cellId = *msgPtr++;
-          faceId = *msgPtr++;
-          fragmentId = *msgPtr++;
-          // Translate the fragmentId to global value.
-          fragmentId +=fragmentIdOffsets[procIdx];
-          // Add the face to the hash.
-          face = this->FaceHash->AddFace(corner1, corner2, corner3);
-          if (face->FragmentId > 0)
-            { // face is attached to another cell.
-            // It has been removed from the hash because it is internal.
-            // It is valid until we create another face. (recycle bin)
-            // This cell connects two fragments, we need
-            // to make the fragment ids equivalent.
-            this->EquivalenceSet->AddEquivalence(fragmentId,
-                                                 face->FragmentId);
-            }
-          else
-            { // Face is new.  Add our cell info.
-            // These are needed to create the surface in the second stage.
-            face->ProcessId = procIdx;
-            face->BlockId = blockId;
-            face->CellId = cellId;
-            face->FaceId = faceId;
-            face->FragmentId = fragmentId;
-            face->MarshalId = faceIdx;
-            } // end if face is new or shared.
-          } // end loop over faces in messages
-        // Now receive the integration arrays and add them to ours.
-        this->FragmentVolumes->Resize(fragmentIdOffsets[procIdx+1]);
-        // I hope the vtkDataArray allocates more than we ask.
-        this->FragmentVolumes->SetNumberOfTuples(fragmentIdOffsets[procIdx+1]);
-        // Read the array right into the end of our array.
-        this->Controller->Receive(
-          this->FragmentVolumes->GetPointer(fragmentIdOffsets[procIdx]), 
-          numberOfFragments, 
-          procIdx,
-          5634780);
-        } // endif numFace > 0
-      } // end loop over processes
-    // Resolve all the fragments, faces and arrays for all processes.
-    this->ResolveEquivalentFragments();
-    } // end if process 0.
+          this->Controller->Receive(&recvIds[0], length, other,
+                                    vtkGCExchangeIdsTag);
+          }
+        }
+      }
+    }
+
+  recvBuffer.clear();
+  recvOffsets.assign(numProcs + 1, 0);
+  for (int procIdx = 0; procIdx < numProcs; ++procIdx)
+    {
+    recvBuffer.insert(recvBuffer.end(), received[procIdx].begin(),
+                      received[procIdx].end());
+    recvOffsets[procIdx + 1] = static_cast<vtkIdType>(recvBuffer.size());
+    }
 }
 
 
 //----------------------------------------------------------------------------
 // This method expects every process to have local faces, equivalences set
 // ind integration arrays.
-// At the end, the equivalence set and integration arrays are resolved
+// At the end, the fragment ids and integration arrays are resolved
 // across all processes and the faces shared between processes (internal)
-// have been removed from the hash.
+// have been marked with the fragment id 0.
 //
-// The algorithm is:  Collect number of faces to process 0.
-// Create a map from process fragment ids to global fragment ids.
-// Collect face hashes to process 0 and merge into 1.
-// Send a mask/fragmentIdArray indexed by original process fragment id
-// back to originating process.
-// The only issue I ran into is returning triangles to their original
-// process.  I am going to create a mask/fragment array to return.
-// The hash has to remember the original process face index to 
-// construct the mask.
-// For resolving integration arrays, Each process needs:
-// A full map of localFragmentIds,procOwner to globalFragId,procOwner.
+// The algorithm is:  Resolve the local fragments and number them after the
+// fragments of the lower processes.
+// Processes exchange the range of global point ids of their cells.  Only
+// processes whose ranges overlap (neighbors) can share faces, and all the
+// messages below are exchanged between neighbors.
+// Send every face left in the hash that another process may have to the
+// lowest process whose range holds its corners.  Only these faces, the
+// surface of the partial fragments, are exchanged.  A face received twice is
+// shared by two processes: it is internal, and the fragments on both sides
+// are equivalent.
+// Return a mask for the faces to the process that sent them, and every
+// equivalence to the processes of the two fragments.
+// Label the fragments with the smallest global fragment id they are
+// equivalent to, passing labels along the equivalences until no label
+// changes anywhere.  The fragments that keep their own id are numbered in
+// order, and these numbers are passed along the equivalences the same way.
+// Sum the integration arrays of all processes by resolved fragment id.
 void vtkGridConnectivity::ResolveProcessesFaces()
 {
-  vtkIdType numFaces;
+  // Merge the partial fragments of this process.
+  this->ResolveEquivalentFragments();
+
   int numProcs = this->Controller->GetNumberOfProcesses();
-  int* fragmentIdOffsets = new int[numProcs+1];
+  if (numProcs <= 1)
+    {
+    return;
+    }
+  int myId = this->Controller->GetLocalProcessId();
+  int procIdx;
+
+  // Global fragment ids are local ids offset by the number of
+  // fragments of lower processes.
+  vtkIdType numFragments = this->EquivalenceSet->GetNumberOfResolvedSets();
+  vtkstd::vector<vtkIdType> fragmentCounts(numProcs);
+  this->Controller->AllGather(&numFragments, &fragmentCounts[0], 1);
+  vtkstd::vector<vtkIdType> fragmentIdOffsets(numProcs + 1, 0);
+  for (procIdx = 0; procIdx < numProcs; ++procIdx)
+    {
+    fragmentIdOffsets[procIdx + 1] =
+      fragmentIdOffsets[procIdx] + fragmentCounts[procIdx];
+    }
+  vtkIdType fragmentIdOffset = fragmentIdOffsets[myId];
+
+  // Find the neighbors from the point id ranges of the face hashes.
+  vtkIdType pointRange[2];
+  pointRange[0] = this->FaceHash->GetFirstPointId();
+  pointRange[1] = pointRange[0] + this->FaceHash->GetNumberOfPoints() - 1;
+  vtkstd::vector<vtkIdType> pointRanges(2 * numProcs);
+  this->Controller->AllGather(pointRange, &pointRanges[0], 2);
+  vtkstd::vector<int> neighbors;
+  for (procIdx = 0; procIdx < numProcs; ++procIdx)
+    {
+    if (procIdx != myId && pointRange[0] <= pointRange[1] &&
+        pointRanges[2 * procIdx] <= pointRanges[2 * procIdx + 1] &&
+        pointRanges[2 * procIdx] <= pointRange[1] &&
+        pointRange[0] <= pointRanges[2 * procIdx + 1])
+      {
+      neighbors.push_back(procIdx);
+      }
+    }
 
-  this->CollectFacesAndArraysToRootProcess(fragmentIdOffsets);
-  
-  // Now send the mask and arrays back to the remote processes.
-  // It may not be necessary to send the entire volume array to all processes,
-  // but it is easy.  There should not be too many fragments anyway.
-  if (this->Controller->GetLocalProcessId() != 0)
-    { // Remote process
-    // Now receive the triangles that survived the resolution process.
-    numFaces = this->FaceHash->GetNumberOfFaces();
-    int* fragmentIds = new int[numFaces];
-    int* fragmentIdPtr = fragmentIds;
-    if (numFaces)
+  // Send the faces to the process that matches them.
+  vtkstd::vector<vtkstd::vector<vtkIdType> > faceBuffers(numProcs);
+  vtkGridConnectivityFace* face;
+  this->FaceHash->InitTraversal();
+  while ( (face = this->FaceHash->GetNextFace()) )
+    {
+    vtkIdType corner1 = this->FaceHash->GetFirstPointIndex();
+    int owner = vtkGridConnectivityFaceOwner(corner1, face->CornerId3, myId,
+                                             neighbors, pointRanges);
+    if (owner >= 0)
       {
-      this->Controller->Receive(fragmentIds, numFaces, 0, 2034301);
-      // Get rid of faces shared by multiple processe and
-      // set the resolved fragment ids.
-      this->FaceHash->InitTraversal();
-      vtkGridConnectivityFace* face;
-      while ( (face = this->FaceHash->GetNextFace()) )
+      vtkstd::vector<vtkIdType>& buffer = faceBuffers[owner];
+      buffer.push_back(corner1);
+      buffer.push_back(face->CornerId2);
+      buffer.push_back(face->CornerId3);
+      buffer.push_back(face->FragmentId + fragmentIdOffset);
+      }
+    }
+  vtkstd::vector<vtkIdType> faces;
+  vtkstd::vector<vtkIdType> faceOffsets;
+  this->ExchangeIds(neighbors, faceBuffers, faces, faceOffsets);
+  faceBuffers.clear();
+
+  // Sort the faces we own to find the ones received twice.
+  vtkIdType numFaces = static_cast<vtkIdType>(faces.size() / 4);
+  vtkstd::vector<vtkIdType> faceOrder(numFaces);
+  for (vtkIdType ii = 0; ii < numFaces; ++ii)
+    {
+    faceOrder[ii] = ii;
+    }
+  if (numFaces > 0)
+    {
+    vtkstd::sort(faceOrder.begin(), faceOrder.end(),
+                 vtkGridConnectivityFaceLess(&faces[0]));
+    }
+  vtkstd::vector<vtkIdType> faceMask(numFaces, 1);
+  vtkstd::vector<vtkstd::pair<vtkIdType, vtkIdType> > equivalences;
+  for (vtkIdType ii = 0; ii + 1 < numFaces; ++ii)
+    {
+    vtkIdType* face1 = &faces[4 * faceOrder[ii]];
+    vtkIdType* face2 = &faces[4 * faceOrder[ii + 1]];
+    if (face1[0] == face2[0] && face1[1] == face2[1] && face1[2] == face2[2])
+      {
+      faceMask[faceOrder[ii]] = 0;
+      faceMask[faceOrder[ii + 1]] = 0;
+      if (face1[3] != face2[3])
         {
-        // I do not want to remove the face from the hash because
-        // we are in the middle of traversing the hash.
-        // It would not work the way the iterator is implemented.
-        // The invalid fragment id (value 0) will be enough to skip faces.
-        face->FragmentId = *fragmentIdPtr++;
+        equivalences.push_back(vtkstd::pair<vtkIdType, vtkIdType>(
+          vtkstd::min(face1[3], face2[3]), vtkstd::max(face1[3], face2[3])));
         }
-      delete [] fragmentIds;
-      vtkIdType numFragments;
-      this->Controller->Receive(&numFragments, 1, 0, 909034);
-      this->FragmentVolumes->SetNumberOfTuples(numFragments);
-      this->Controller->Receive(this->FragmentVolumes->GetPointer(0), 
-                                numFragments, 0, 909035);
-      } // endif numFaces != 0
-    } // endif remote process.
-  else
-    { // if process 0 (root)
-    // Now we have to distribute the new face hash back
-    // to the remote processes.  We have to loop through the hash
-    // to construct the face mask for each process.
-    // Lets create them one by one (looping many times) rather
-    // than all at once.  The code will be simpler and
-    // it should not be too expensive.
-    for (int procIdx = 1; procIdx < numProcs; ++procIdx)
-      {
-      // decode the number of faces from the offsets.
-      vtkGridConnectivityFace* face;
-      numFaces = fragmentIdOffsets[procIdx+1] - fragmentIdOffsets[procIdx];
-      if (numFaces)
-        { // just in case new or MPI does not like 0 length arrays.
-        // Construct the mask / message
-        int* faceMask = new int[numFaces];
-        // Initialize the mask to "empty set".
-        // I am going to index the final fragments starting at 1
-        // so I can use 0 as the special "remove face" value.
-        memset(faceMask,0,numFaces*sizeof(int));
-        // Loop over the faces in the hash.
-        this->FaceHash->InitTraversal();
-        while ( (face = this->FaceHash->GetNextFace()) != 0);
-          {
-          if (face->ProcessId == procIdx)
-            {
-            faceMask[face->MarshalId] = face->FragmentId;
-            } // end if face belongs to process.
-          } // endloop face in hash
-        // Send the mask to the remote process.
-        this->Controller->Send(faceMask, numFaces, procIdx, 2034301);
-        delete [] faceMask;
-        
-        // We need to send the volume array to the remote processes too.
-        vtkIdType numFragments = this->FragmentVolumes->GetNumberOfTuples();
-        this->Controller->Send(&numFragments, 1, procIdx, 909034);
-        this->Controller->Send(this->FragmentVolumes->GetPointer(0),
-                               numFragments, procIdx, 909035);
-        } // endif numFaces > 0
-      } // endloop procIdx
-    } // endelse process 0 (root)
-
-/*
-    // Terms:  PartialFragmentId: Local process frag id before resolution.
-    //         GlobalFragmentId:  PartialFragmentId offset to form global id.
-    //         FinalFragmentId:
-
-    // Now that we know the NumberOfFinal fragments, collect the volumes.
-    vtkDoubleArray* globalVolumes = vtkDoubleArray::New();
-    globalVolumes->SetNumberOfValues(
-    for (int procIdx = 1; procIdx < numProcs; ++procIdx)
-      { // loop over every process. 
-
-
-  double* msgVolume;
+      ++ii;
+      }
+    }
+  // Many faces separate the same two fragments.
+  vtkstd::sort(equivalences.begin(), equivalences.end());
+  equivalences.erase(vtkstd::unique(equivalences.begin(), equivalences.end()),
+                     equivalences.end());
+
+  // Return the masks to the processes that sent the faces.
+  vtkstd::vector<vtkstd::vector<vtkIdType> > maskBuffers(numProcs);
+  for (procIdx = 0; procIdx < numProcs; ++procIdx)
+    {
+    maskBuffers[procIdx].assign(
+      faceMask.begin() + faceOffsets[procIdx] / 4,
+      faceMask.begin() + faceOffsets[procIdx + 1] / 4);
+    }
+  vtkstd::vector<vtkIdType> masks;
+  vtkstd::vector<vtkIdType> maskOffsets;
+  this->ExchangeIds(neighbors, maskBuffers, masks, maskOffsets);
+  maskBuffers.clear();
+
+  // Send every equivalence to the processes of its two fragments, which
+  // sent the faces so they are neighbors.  The local fragment comes first.
+  vtkstd::vector<vtkstd::vector<vtkIdType> > edgeBuffers(numProcs);
+  for (size_t ii = 0; ii < equivalences.size(); ++ii)
+    {
+    vtkIdType id1 = equivalences[ii].first;
+    vtkIdType id2 = equivalences[ii].second;
+    vtkstd::vector<vtkIdType>& buffer1 = edgeBuffers[
+      vtkGridConnectivityFragmentProcess(id1, fragmentIdOffsets)];
+    buffer1.push_back(id1);
+    buffer1.push_back(id2);
+    vtkstd::vector<vtkIdType>& buffer2 = edgeBuffers[
+      vtkGridConnectivityFragmentProcess(id2, fragmentIdOffsets)];
+    buffer2.push_back(id2);
+    buffer2.push_back(id1);
+    }
+  equivalences.clear();
+  vtkstd::vector<vtkIdType> edges;
+  vtkstd::vector<vtkIdType> edgeOffsets;
+  this->ExchangeIds(neighbors, edgeBuffers, edges, edgeOffsets);
+  edgeBuffers.clear();
+
+  vtkstd::vector<vtkIdType> labels(numFragments);
+  for (vtkIdType ii = 0; ii < numFragments; ++ii)
+    {
+    labels[ii] = ii + fragmentIdOffset;
+    }
+  this->PropagateFragmentLabels(neighbors, fragmentIdOffsets, edges, labels);
 
-      // Now receive the volume array index on partial fragmentIds.
-      this->Controller->Receive(msgVolume, numberOfFragments,procIdx,8729987);
+  // Number the fragments that kept their own id, then give their numbers to
+  // the fragments labeled with it.  Fragment 0 of every process is the
+  // unused fragment, and they all make set 0.
+  vtkIdType numRoots = 0;
+  for (vtkIdType ii = 1; ii < numFragments; ++ii)
+    {
+    if (labels[ii] == ii + fragmentIdOffset)
+      {
+      ++numRoots;
+      }
+    }
+  vtkstd::vector<vtkIdType> rootCounts(numProcs);
+  this->Controller->AllGather(&numRoots, &rootCounts[0], 1);
+  vtkIdType numSets = 1;
+  vtkIdType setIdOffset = 1;
+  for (procIdx = 0; procIdx < numProcs; ++procIdx)
+    {
+    if (procIdx == myId)
+      {
+      setIdOffset = numSets;
+      }
+    numSets += rootCounts[procIdx];
+    }
+  vtkstd::vector<vtkIdType> setIds(numFragments, VTK_LARGE_ID);
+  for (vtkIdType ii = 1; ii < numFragments; ++ii)
+    {
+    if (labels[ii] == ii + fragmentIdOffset)
+      {
+      setIds[ii] = setIdOffset++;
+      }
+    }
+  if (numFragments > 0)
+    {
+    setIds[0] = 0;
+    }
+  this->PropagateFragmentLabels(neighbors, fragmentIdOffsets, edges, setIds);
 
-*/
+  // Relabel the faces.  We traverse the hash in the same order as when we
+  // sent the faces, so the masks from each process come in order.
+  vtkstd::vector<vtkIdType> maskIndexes(maskOffsets.begin(),
+                                        maskOffsets.end() - 1);
+  this->FaceHash->InitTraversal();
+  while ( (face = this->FaceHash->GetNextFace()) )
+    {
+    int owner = vtkGridConnectivityFaceOwner(
+      this->FaceHash->GetFirstPointIndex(), face->CornerId3, myId,
+      neighbors, pointRanges);
+    if (owner < 0 || masks[maskIndexes[owner]++])
+      {
+      face->FragmentId = static_cast<int>(setIds[face->FragmentId]);
+      }
+    else
+      {
+      // The face is shared by two processes.  The invalid fragment id
+      // (value 0) is enough to skip it, removing it from the hash would
+      // break the traversal.
+      face->FragmentId = 0;
+      }
+    }
 
+  // Sum the integration arrays of all processes.  There should not be too
+  // many fragments, so every process gets all the values.
+  int numArrays = static_cast<int>(this->CellAttributesIntegration.size());
+  vtkIdType length = numSets * (numArrays + 1);
+  if (length > 0)
+    {
+    vtkstd::vector<double> sums(length, 0.0);
+    vtkstd::vector<double> totals(length);
+    for (vtkIdType ii = 0; ii < numFragments; ++ii)
+      {
+      vtkIdType setId = setIds[ii];
+      sums[setId] += this->FragmentVolumes->GetValue(ii);
+      for (int jj = 0; jj < numArrays; ++jj)
+        {
+        sums[(jj + 1) * numSets + setId] +=
+          this->CellAttributesIntegration[jj]->GetValue(ii);
+        }
+      }
+    this->Controller->AllReduce(&sums[0], &totals[0], length,
+                                vtkCommunicator::SUM_OP);
+    this->FragmentVolumes->SetNumberOfTuples(numSets);
+    memcpy(this->FragmentVolumes->GetPointer(0), &totals[0],
+           numSets * sizeof(double));
+    for (int jj = 0; jj < numArrays; ++jj)
+      {
+      vtkDoubleArray* da = this->CellAttributesIntegration[jj];
+      da->SetNumberOfTuples(numSets);
+      memcpy(da->GetPointer(0), &totals[(jj + 1) * numSets],
+             numSets * sizeof(double));
+      }
+    }
+}
 
+//----------------------------------------------------------------------------
+// edges holds pairs of global fragment ids, the first of this process, for
+// the equivalences between fragments of this process and of its neighbors.
+// values, indexed by local fragment, are passed along the edges and the
+// smallest value is kept, until no value changes on any process.  Values
+// equal to VTK_LARGE_ID are unknown and not passed.  Each pass moves the
+// values one equivalence further, so few passes are needed when fragments
+// span few processes.
+void vtkGridConnectivity::PropagateFragmentLabels(
+  const vtkstd::vector<int>& neighbors,
+  const vtkstd::vector<vtkIdType>& fragmentIdOffsets,
+  const vtkstd::vector<vtkIdType>& edges,
+  vtkstd::vector<vtkIdType>& values)
+{
+  int numProcs = this->Controller->GetNumberOfProcesses();
+  int myId = this->Controller->GetLocalProcessId();
+  vtkIdType fragmentIdOffset = fragmentIdOffsets[myId];
 
-  delete [] fragmentIdOffsets;
+  int changed = 1;
+  while (changed)
+    {
+    vtkstd::vector<vtkstd::vector<vtkIdType> > buffers(numProcs);
+    for (size_t ii = 0; ii + 1 < edges.size(); ii += 2)
+      {
+      vtkIdType value = values[edges[ii] - fragmentIdOffset];
+      if (value != VTK_LARGE_ID)
+        {
+        vtkstd::vector<vtkIdType>& buffer = buffers[
+          vtkGridConnectivityFragmentProcess(edges[ii + 1],
+                                             fragmentIdOffsets)];
+        buffer.push_back(edges[ii + 1]);
+        buffer.push_back(value);
+        }
+      }
+    vtkstd::vector<vtkIdType> received;
+    vtkstd::vector<vtkIdType> receivedOffsets;
+    this->ExchangeIds(neighbors, buffers, received, receivedOffsets);
 
+    int localChanged = 0;
+    for (size_t ii = 0; ii + 1 < received.size(); ii += 2)
+      {
+      vtkIdType& value = values[received[ii] - fragmentIdOffset];
+      if (received[ii + 1] < value)
+        {
+        value = received[ii + 1];
+        localChanged = 1;
+        }
+      }
+    this->Controller->AllReduce(&localChanged, &changed, 1,
+                                vtkCommunicator::MAX_OP);
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -1451,6 +1943,30 @@ void vtkGridConnectivity::ResolveIntegrationArrays()
   // new total fragment volume array.
   this->FragmentVolumes->Delete();
   this->FragmentVolumes = newVolumes;
+
+  // The integrated attributes are indexed the same way.
+  int numArrays = static_cast<int>(this->CellAttributesIntegration.size());
+  for (int jj = 0; jj < numArrays; ++jj)
+    {
+    vtkDoubleArray* da = this->CellAttributesIntegration[jj];
+    if (da->GetNumberOfTuples() < numMembers)
+      {
+      vtkErrorMacro("More partial fragments than integration entries.");
+      continue;
+      }
+    vtkSmartPointer<vtkDoubleArray> newArray =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    newArray->SetName(da->GetName());
+    newArray->SetNumberOfTuples(numSets);
+    memset(newArray->GetPointer(0),0,numSets*sizeof(double));
+    double* partialPtr = da->GetPointer(0);
+    double* finalPtr = newArray->GetPointer(0);
+    for (int ii = 0; ii < numMembers; ++ii)
+      {
+      finalPtr[this->EquivalenceSet->GetEquivalentSetId(ii)] += *partialPtr++;
+      }
+    this->CellAttributesIntegration[jj] = newArray;
+    }
 }
 
 
@@ -79,7 +79,7 @@ protected:
   // This method returns 1 if the input has the necessary arrays for this filter.
   int CheckInput(vtkUnstructuredGrid* grid);
 
-  // Find the maximum global point id and allocate the hash.
+  // Find the range of global point ids of this process and allocate the hash.
   void InitializeFaceHash(vtkUnstructuredGrid** inputs, int numberOfInputs);
   vtkGridConnectivityFaceHash* FaceHash;
 
@@ -109,9 +109,29 @@ protected:
   short ProcessId;
   int   GlobalPointIdType;
   
+  // Labels the cells of the process with partial fragment ids.
+  // Large inputs are labeled by several threads.
+  void ComputeProcessFragments(vtkUnstructuredGrid** inputs,
+                               int numberOfInputs);
+  friend class vtkGridConnectivityTask;
+
   void ResolveEquivalentFragments();
   void ResolveProcessesFaces();
-  void CollectFacesAndArraysToRootProcess(int* fragmentIdOffsets);
+//BTX
+  // Sends sendBuffers[p] to each neighbor process p and receives what the
+  // neighbors sent to this one.
+  void ExchangeIds(const vtkstd::vector<int>& neighbors,
+                   vtkstd::vector<vtkstd::vector<vtkIdType> >& sendBuffers,
+                   vtkstd::vector<vtkIdType>& recvBuffer,
+                   vtkstd::vector<vtkIdType>& recvOffsets);
+  // Passes the smallest value of every fragment along the equivalences
+  // with the fragments of the neighbors.
+  void PropagateFragmentLabels(
+    const vtkstd::vector<int>& neighbors,
+    const vtkstd::vector<vtkIdType>& fragmentIdOffsets,
+    const vtkstd::vector<vtkIdType>& edges,
+    vtkstd::vector<vtkIdType>& values);
+//ETX
 
 private:
   vtkGridConnectivity(const vtkGridConnectivity&);  // Not implemented.
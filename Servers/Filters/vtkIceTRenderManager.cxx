@@ -51,6 +51,9 @@
 #define MY_MAX(x, y)    ((x) < (y) ? (y) : (x))
 #define MY_MIN(x, y)    ((x) < (y) ? (x) : (y))
 
+// Tag used to send composited pipeline stripes to the root process.
+static const int vtkIceTRenderManagerStripeTag = 0x1ce7;
+
 // ******************************************************************
 // Callback commands.
 // ******************************************************************
@@ -126,6 +129,13 @@ vtkIceTRenderManager::vtkIceTRenderManager()
     this->PhysicalViewport[3];
 
   this->EnableTiles = 0;
+
+  this->PipelinedCompositing = 0;
+  this->NumberOfPipelineStripes = 4;
+  this->LastKnownNumberOfStripes = -1;
+  this->StripeGatherTime = 0.0;
+  this->LocalStripeViewports = vtkIntArray::New();
+  this->LocalStripeViewports->SetNumberOfComponents(4);
 }
 
 //-------------------------------------------------------------------------
@@ -144,6 +154,7 @@ vtkIceTRenderManager::~vtkIceTRenderManager()
   this->FixRenderWindowCallback->Delete();
   this->LastViewports->Delete();
   this->ReducedZBuffer->Delete();
+  this->LocalStripeViewports->Delete();
 }
 
 //-------------------------------------------------------------------------
@@ -209,6 +220,13 @@ void vtkIceTRenderManager::UpdateIceTContext()
     this->LastKnownImageReductionFactor = this->ImageReductionFactor;
     }
 
+  int numStripes = this->GetNumberOfActivePipelineStripes();
+  if (numStripes != this->LastKnownNumberOfStripes)
+    {
+    this->TilesDirty = 1;
+    this->LastKnownNumberOfStripes = numStripes;
+    }
+
   vtkRendererCollection *renderers = this->RenderWindow->GetRenderers();
   vtkCollectionSimpleIterator cookie;
   vtkRenderer *ren;
@@ -295,6 +313,34 @@ void vtkIceTRenderManager::UpdateIceTContext()
           visibleViewport[2] = MY_MIN(tileViewport[2], rendererViewport[2]);
           visibleViewport[3] = MY_MIN(tileViewport[3], rendererViewport[3]);
 
+          if (numStripes > 1 && !icetRen->GetCollectDepthBuffer())
+            {
+            // Split the visible viewport into horizontal stripes, each
+            // displayed by a different process, so that IceT can composite
+            // one stripe while the next one is rendered.
+            int stripeHeight = visibleViewport[3] - visibleViewport[1];
+            for (int stripe = 0; stripe < numStripes; stripe++)
+              {
+              int bottom = visibleViewport[1] + (stripeHeight*stripe)/numStripes;
+              int top = visibleViewport[1] + (stripeHeight*(stripe+1))/numStripes;
+              if (top <= bottom)
+                {
+                continue;
+                }
+              icetAddTile(visibleViewport[0], bottom,
+                          visibleViewport[2]-visibleViewport[0], top-bottom,
+                          stripe);
+              if (stripe == this->Controller->GetLocalProcessId())
+                {
+                icetRen->SetPhysicalViewport(visibleViewport[0] - tileViewport[0],
+                                             bottom - tileViewport[1],
+                                             visibleViewport[2] - tileViewport[0],
+                                             top - tileViewport[1]);
+                }
+              }
+            continue;
+            }
+
           icetAddTile(visibleViewport[0],
                       visibleViewport[1],
                       visibleViewport[2]-visibleViewport[0],
@@ -568,6 +614,56 @@ void vtkIceTRenderManager::SetStrategy(int strategy)
 
 //-----------------------------------------------------------------------------
 
+void vtkIceTRenderManager::SetUseTightBounds(int tight)
+{
+  vtkDebugMacro("SetUseTightBounds to " << tight);
+
+  if (!this->RenderWindow)
+    {
+    return;
+    }
+
+  vtkRendererCollection *renderers = this->RenderWindow->GetRenderers();
+  vtkCollectionSimpleIterator cookie;
+  vtkRenderer *_ren;
+
+  renderers->InitTraversal(cookie);
+  while ((_ren = renderers->GetNextRenderer(cookie)) != NULL)
+    {
+    vtkIceTRenderer *ren = vtkIceTRenderer::SafeDownCast(_ren);
+    if (!ren) continue;
+
+    ren->SetUseTightBounds(tight);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+double vtkIceTRenderManager::GetActivePixelFraction()
+{
+  double fraction = 0.0;
+  if (!this->RenderWindow)
+    {
+    return fraction;
+    }
+
+  vtkRendererCollection *renderers = this->RenderWindow->GetRenderers();
+  vtkCollectionSimpleIterator cookie;
+  vtkRenderer *_ren;
+
+  renderers->InitTraversal(cookie);
+  while ((_ren = renderers->GetNextRenderer(cookie)) != NULL)
+    {
+    vtkIceTRenderer *ren = vtkIceTRenderer::SafeDownCast(_ren);
+    if (!ren) continue;
+
+    fraction = MY_MAX(fraction, ren->GetActivePixelFraction());
+    }
+  return fraction;
+}
+
+//-----------------------------------------------------------------------------
+
 void vtkIceTRenderManager::SetStrategy(const char *strategy)
 {
   vtkDebugMacro("SetStrategy to " << strategy);
@@ -898,7 +994,8 @@ void vtkIceTRenderManager::CollectRendererInformation(vtkRenderer *_ren,
     }
 
   stream << ren->GetStrategy()
-         << ren->GetComposeOperation();
+         << ren->GetComposeOperation()
+         << ren->GetUseTightBounds();
 }
 
 //-----------------------------------------------------------------------------
@@ -917,9 +1014,11 @@ bool vtkIceTRenderManager::ProcessRendererInformation(vtkRenderer *_ren,
     {
     int strategy;
     int compose_operation;
-    stream >> strategy >> compose_operation;
+    int tight_bounds;
+    stream >> strategy >> compose_operation >> tight_bounds;
     ren->SetStrategy(strategy);
     ren->SetComposeOperation(compose_operation);
+    ren->SetUseTightBounds(tight_bounds);
     }
   return true;
 }
@@ -967,6 +1066,8 @@ void vtkIceTRenderManager::PreRenderProcessing()
     }
 
   this->UpdateIceTContext();
+  this->LocalStripeViewports->SetNumberOfTuples(0);
+  this->StripeGatherTime = 0.0;
 
   if (rens->GetNumberOfItems() == 0)
     {
@@ -1068,6 +1169,11 @@ void vtkIceTRenderManager::PostRenderProcessing()
     ren->RemoveObservers(vtkCommand::StartEvent, this->FixRenderWindowCallback);
     }
 
+  if (this->GetNumberOfActivePipelineStripes() > 1)
+    {
+    this->GatherPipelineStripes();
+    }
+
   this->WriteFullImage();
 
   // Swap buffers here.
@@ -1091,6 +1197,12 @@ void vtkIceTRenderManager::RecordIceTImage(vtkIceTRenderer *icetRen)
   // See if this renderer is displaying anything in this tile.
   if ((width < 1) || (height < 1)) return;
 
+  if (this->GetNumberOfActivePipelineStripes() > 1 &&
+    !icetRen->GetCollectDepthBuffer())
+    {
+    this->LocalStripeViewports->InsertNextTupleValue(physicalViewport);
+    }
+
   // Yeah, this screws up the render timing for the superclass.  But if you look
   // at my implementation for GetRenderTime, you'll see that that measurement is
   // not used.
@@ -1210,6 +1322,136 @@ void vtkIceTRenderManager::RecordIceTImage(vtkIceTRenderer *icetRen)
     }
 }
 
+//-----------------------------------------------------------------------------
+void vtkIceTRenderManager::SetPipelinedCompositing(int pipelined)
+{
+  if (this->PipelinedCompositing == pipelined)
+    {
+    return;
+    }
+  this->PipelinedCompositing = pipelined;
+  this->TilesDirty = 1;
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkIceTRenderManager::SetNumberOfPipelineStripes(int stripes)
+{
+  stripes = MY_MAX(stripes, 1);
+  if (this->NumberOfPipelineStripes == stripes)
+    {
+    return;
+    }
+  this->NumberOfPipelineStripes = stripes;
+  this->TilesDirty = 1;
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+int vtkIceTRenderManager::GetNumberOfActivePipelineStripes()
+{
+  if (!this->PipelinedCompositing || !this->UseCompositing ||
+    this->EnableTiles || !this->Controller ||
+    this->TileDimensions[0] != 1 || this->TileDimensions[1] != 1)
+    {
+    return 0;
+    }
+  int numProcs = this->Controller->GetNumberOfProcesses();
+  return numProcs > 1? MY_MIN(this->NumberOfPipelineStripes, numProcs) : 0;
+}
+
+//-----------------------------------------------------------------------------
+void vtkIceTRenderManager::GatherPipelineStripes()
+{
+  vtkTimerLog::MarkStartEvent("IceT Gather Stripes");
+  this->Timer->StartTimer();
+
+  int numStripes = this->GetNumberOfActivePipelineStripes();
+  int myId = this->Controller->GetLocalProcessId();
+  int rowLength = this->ReducedImageSize[0];
+
+  if (myId != this->RootProcessId)
+    {
+    if (myId < numStripes)
+      {
+      // Send the viewports followed by the pixels of each stripe.
+      int count = this->LocalStripeViewports->GetNumberOfTuples();
+      this->Controller->Send(&count, 1, this->RootProcessId,
+                             vtkIceTRenderManagerStripeTag);
+      for (int cc=0; cc < count; cc++)
+        {
+        int viewport[4];
+        this->LocalStripeViewports->GetTupleValue(cc, viewport);
+        int width = viewport[2] - viewport[0];
+        int height = viewport[3] - viewport[1];
+        vtkUnsignedCharArray* pixels = vtkUnsignedCharArray::New();
+        pixels->SetNumberOfComponents(4);
+        pixels->SetNumberOfTuples(width*height);
+        unsigned char* dest = pixels->GetPointer(0);
+        for (int j = viewport[1]; j < viewport[3]; j++)
+          {
+          const unsigned char* src = this->ReducedImage->GetPointer(
+            4*(j*rowLength + viewport[0]));
+          memcpy(dest, src, 4*width);
+          dest += 4*width;
+          }
+        this->Controller->Send(viewport, 4, this->RootProcessId,
+                               vtkIceTRenderManagerStripeTag);
+        this->Controller->Send(pixels->GetPointer(0), 4*width*height,
+                               this->RootProcessId,
+                               vtkIceTRenderManagerStripeTag);
+        pixels->Delete();
+        }
+      }
+    }
+  else
+    {
+    vtkUnsignedCharArray* pixels = vtkUnsignedCharArray::New();
+    pixels->SetNumberOfComponents(4);
+    for (int proc = 0; proc < numStripes; proc++)
+      {
+      if (proc == this->RootProcessId)
+        {
+        continue;
+        }
+      int count = 0;
+      this->Controller->Receive(&count, 1, proc,
+                                vtkIceTRenderManagerStripeTag);
+      for (int cc=0; cc < count; cc++)
+        {
+        int viewport[4];
+        this->Controller->Receive(viewport, 4, proc,
+                                  vtkIceTRenderManagerStripeTag);
+        int width = viewport[2] - viewport[0];
+        int height = viewport[3] - viewport[1];
+        pixels->SetNumberOfTuples(width*height);
+        this->Controller->Receive(pixels->GetPointer(0), 4*width*height, proc,
+                                  vtkIceTRenderManagerStripeTag);
+        const unsigned char* src = pixels->GetPointer(0);
+        for (int j = viewport[1]; j < viewport[3]; j++)
+          {
+          unsigned char* dest = this->ReducedImage->GetPointer(
+            4*(j*rowLength + viewport[0]));
+          memcpy(dest, src, 4*width);
+          src += 4*width;
+          }
+        }
+      }
+    pixels->Delete();
+
+    if (this->FullImage->GetPointer(0) != this->ReducedImage->GetPointer(0))
+      {
+      this->MagnifyImage(this->FullImage, this->FullImageSize,
+                         this->ReducedImage, this->ReducedImageSize);
+      }
+    }
+
+  this->Timer->StopTimer();
+  this->StripeGatherTime = this->Timer->GetElapsedTime();
+  this->ImageProcessingTime += this->StripeGatherTime;
+  vtkTimerLog::MarkEndEvent("IceT Gather Stripes");
+}
+
 //-----------------------------------------------------------------------------
 // NOTE x,y are relative to the corner of the most recently rendered
 // view module (this is significant is case of multiviews).
@@ -1310,4 +1552,9 @@ void vtkIceTRenderManager::PrintSelf(ostream &os, vtkIndent indent)
   os.width(0);
   os << indent << "Mullions: " << this->TileMullions[0] << ", "
      << this->TileMullions[1] << endl;
+  os << indent << "PipelinedCompositing: " << this->PipelinedCompositing
+     << endl;
+  os << indent << "NumberOfPipelineStripes: "
+     << this->NumberOfPipelineStripes << endl;
+  os << indent << "StripeGatherTime: " << this->StripeGatherTime << endl;
 }
@@ -104,12 +104,38 @@ public:
   void SetEnableTiles(int x);
   vtkGetMacro(EnableTiles, int);
 
+  // Description:
+  // When enabled, the display of each vtkIceTRenderer is split into
+  // NumberOfPipelineStripes horizontal stripes, each of which is displayed
+  // (composited) by a different process.  IceT then renders the stripes one
+  // at a time and starts transferring a stripe as soon as it is rendered, so
+  // compositing of one stripe overlaps with rendering of the next.  Stripes
+  // that do not intersect the projected local geometry bounds are neither
+  // rendered nor sent.  The composited stripes are gathered on the root
+  // process after the frame.  Pipelining is only used for a single tile
+  // display, with compositing on and when the depth buffer is not collected.
+  // Off by default.
+  virtual void SetPipelinedCompositing(int);
+  vtkGetMacro(PipelinedCompositing, int);
+  vtkBooleanMacro(PipelinedCompositing, int);
+
+  // Description:
+  // Number of stripes used when PipelinedCompositing is on.  The number is
+  // clamped to the number of processes.  Default is 4.
+  virtual void SetNumberOfPipelineStripes(int);
+  vtkGetMacro(NumberOfPipelineStripes, int);
+
   virtual double GetRenderTime();
   virtual double GetImageProcessingTime();
   virtual double GetBufferReadTime();
   virtual double GetBufferWriteTime();
   virtual double GetCompositeTime();
 
+  // Description:
+  // Time spent in the last frame gathering the composited pipeline stripes on
+  // the root process.  Always 0 when PipelinedCompositing is off.
+  vtkGetMacro(StripeGatherTime, double);
+
 //BTX
   enum StrategyType {
     DEFAULT = vtkIceTConstants::DEFAULT,
@@ -176,6 +202,16 @@ public:
   // Kd-tree regions it is assigned to (i.e. turn clipping on).
   virtual void SetSortingKdTree(vtkPKdTree *tree);
 
+  // Description:
+  // Turn on/off passing the bounds of each prop, rather than their union, to
+  // IceT for all IceT renderers.  See vtkIceTRenderer::SetUseTightBounds.
+  virtual void SetUseTightBounds(int);
+
+  // Description:
+  // Returns the largest fraction of the viewport covered by the local
+  // geometry of any IceT renderer in the last frame.
+  virtual double GetActivePixelFraction();
+
   // Description:
   // Set the data replication group for all IceT renderers.  If there is more
   // than one vtkIceTRenderer, each renderer should probably have its own data
@@ -260,6 +296,31 @@ protected:
   int PhysicalViewport[4];
   vtkFloatArray *ReducedZBuffer;
 
+  int PipelinedCompositing;
+  int NumberOfPipelineStripes;
+  double StripeGatherTime;
+
+  // Description:
+  // Number of stripes the IceT context was last set up with. The number of
+  // active stripes also depends on UseCompositing and the tile layout, so the
+  // tiles are marked dirty whenever it changes.
+  int LastKnownNumberOfStripes;
+
+  // Description:
+  // Viewports (in the reduced image) of the stripes composited by this process
+  // in the current frame when pipelined compositing is used.
+  vtkIntArray *LocalStripeViewports;
+
+  // Description:
+  // Returns the number of stripes to split the display into, or 0 if
+  // pipelined compositing should not be used.
+  int GetNumberOfActivePipelineStripes();
+
+  // Description:
+  // Sends the stripes composited locally to the root process, where they are
+  // pasted into the reduced (and full) image.
+  virtual void GatherPipelineStripes();
+
   // Description:
   // Convenience functions for determining IceT's logical viewports for
   // physical tiles.
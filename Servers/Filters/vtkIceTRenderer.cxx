@@ -18,21 +18,30 @@
 
 #include "vtkIceTRenderer.h"
 
+#include "vtkActor.h"
 #include "vtkCamera.h"
 #include "vtkCommand.h"
 #include "vtkHardwareSelector.h"
 #include "vtkIceTContext.h"
 #include "vtkIntArray.h"
 #include "vtkLightCollection.h"
+#include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkProp.h"
 #include "vtkMultiProcessController.h"
+#include "vtkOBBTree.h"
 #include "vtkObjectFactory.h"
 #include "vtkPKdTree.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataMapper.h"
 #include "vtkRenderWindow.h"
 #include "vtkTimerLog.h"
 
 #include <GL/ice-t.h>
 
 #include <vtkstd/algorithm>
+#include <vtkstd/map>
+#include <vtkstd/vector>
 
 //******************************************************************
 // Prototypes
@@ -44,6 +53,112 @@ extern "C"{
 static vtkIceTRenderer *currentRenderer;
 
 
+//******************************************************************
+// Tight bounds of the props.
+//******************************************************************
+
+// The corners of the box passed to IceT for a prop, and what they were
+// computed from.
+struct vtkIceTRendererBox
+{
+  // Only compared against, never dereferenced.
+  vtkDataObject *Input;
+  unsigned long Time;
+  double Corners[24];
+};
+
+typedef vtkstd::map<vtkProp *, vtkIceTRendererBox> vtkIceTRendererBoxMap;
+
+class vtkIceTRenderer::vtkInternals
+{
+public:
+  vtkIceTRendererBoxMap Boxes;
+};
+
+//-----------------------------------------------------------------------------
+static void vtkIceTRendererBoundsCorners(const double bounds[6],
+                                         double corners[24])
+{
+  for (int corner = 0; corner < 8; corner++)
+    {
+    corners[3*corner] = bounds[(corner & 1)? 1 : 0];
+    corners[3*corner+1] = bounds[(corner & 2)? 3 : 2];
+    corners[3*corner+2] = bounds[(corner & 4)? 5 : 4];
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Computes the corners of the oriented bounding box of the points rendered by
+// actor, in world coordinates, and keeps them in box if that box is smaller
+// than the axis-aligned bounds.  Returns false when the rendered geometry is
+// not known, i.e. the actor does not render a vtkPolyData with a
+// vtkPolyDataMapper.
+static bool vtkIceTRendererComputeOrientedBox(vtkProp *prop,
+                                              const double bounds[6],
+                                              vtkIceTRendererBox &box)
+{
+  vtkActor *actor = vtkActor::SafeDownCast(prop);
+  vtkPolyDataMapper *mapper = actor?
+    vtkPolyDataMapper::SafeDownCast(actor->GetMapper()) : NULL;
+  vtkPolyData *input = mapper? mapper->GetInput() : NULL;
+  if (!input || !input->GetPoints() || input->GetNumberOfPoints() < 2)
+    {
+    return false;
+    }
+
+  unsigned long time = vtkstd::max(input->GetMTime(), actor->GetMTime());
+  if (box.Input == input && box.Time == time)
+    {
+    return true;
+    }
+  box.Input = input;
+  box.Time = time;
+  vtkIceTRendererBoundsCorners(bounds, box.Corners);
+
+  double origin[3], axes[3][3], size[3];
+  vtkOBBTree *obb = vtkOBBTree::New();
+  obb->ComputeOBB(input->GetPoints(), origin, axes[0], axes[1], axes[2],
+                  size);
+  obb->Delete();
+
+  // Move the box to world coordinates.
+  vtkMatrix4x4 *matrix = actor->GetMatrix();
+  double worldOrigin[4] = {origin[0], origin[1], origin[2], 1.0};
+  matrix->MultiplyPoint(worldOrigin, worldOrigin);
+  double worldAxes[3][4];
+  double lengths[3];
+  for (int axis = 0; axis < 3; axis++)
+    {
+    double direction[4] = {axes[axis][0], axes[axis][1], axes[axis][2], 0.0};
+    matrix->MultiplyPoint(direction, worldAxes[axis]);
+    lengths[axis] = vtkMath::Norm(worldAxes[axis]);
+    }
+
+  // Keep whichever box has the smaller area.  The boxes of flat or
+  // axis-aligned geometry are no smaller than the bounds.
+  double obbArea = lengths[0]*lengths[1] + lengths[1]*lengths[2]
+    + lengths[0]*lengths[2];
+  double dx = bounds[1] - bounds[0];
+  double dy = bounds[3] - bounds[2];
+  double dz = bounds[5] - bounds[4];
+  double aabbArea = dx*dy + dy*dz + dx*dz;
+  if (obbArea >= aabbArea)
+    {
+    return true;
+    }
+  for (int corner = 0; corner < 8; corner++)
+    {
+    for (int c = 0; c < 3; c++)
+      {
+      box.Corners[3*corner+c] = worldOrigin[c]
+        + ((corner & 1)? worldAxes[0][c] : 0.0)
+        + ((corner & 2)? worldAxes[1][c] : 0.0)
+        + ((corner & 4)? worldAxes[2][c] : 0.0);
+      }
+    }
+  return true;
+}
+
 //******************************************************************
 // vtkIceTRenderer implementation.
 //******************************************************************
@@ -69,6 +184,10 @@ vtkIceTRenderer::vtkIceTRenderer()
   this->SetController(vtkMultiProcessController::GetGlobalController());
   this->PropVisibility = 0;
   this->CollectDepthBuffer = 0;
+  this->UseTightBounds = 1;
+  this->MaximumNumberOfBoundingProps = 64;
+  this->ActivePixelFraction = 0.0;
+  this->Internals = new vtkInternals;
 
   for ( int i = 0; i < 4; ++ i )
     {
@@ -86,6 +205,7 @@ vtkIceTRenderer::~vtkIceTRenderer()
   this->SetDataReplicationGroup(NULL);
 
   this->Context->Delete();
+  delete this->Internals;
 }
 
 //-----------------------------------------------------------------------------
@@ -316,20 +436,7 @@ void vtkIceTRenderer::DeviceRender()
     }
 
   //ICE-T works much better if it knows the bounds of the geometry.
-  double allBounds[6];
-  this->ComputeVisiblePropBounds(allBounds);
-  //Try to detect when bounds are empty and try to let ICE-T know that
-  //nothing is in bounds.
-  if (allBounds[0] > allBounds[1])
-    {
-    float tmp = VTK_LARGE_FLOAT;
-    icetBoundingVertices(1, ICET_FLOAT, 0, 1, &tmp);
-    }
-  else
-    {
-    icetBoundingBoxd(allBounds[0], allBounds[1], allBounds[2], allBounds[3],
-                     allBounds[4], allBounds[5]);
-    }
+  this->SetIceTBounds();
 
   //Setup ICE-T callback function.  Note that this is not thread safe.
   currentRenderer = this;
@@ -360,6 +467,114 @@ void vtkIceTRenderer::DeviceRender()
 
 //-----------------------------------------------------------------------------
 
+void vtkIceTRenderer::SetIceTBounds()
+{
+  // Collect the corners of a box around each visible prop.  This mirrors the
+  // checks in vtkRenderer::ComputeVisiblePropBounds().  IceT reduces them to
+  // a single screen-space rectangle, whose pixels are the only ones read
+  // back and composited.  The boxes of the props that are gone are dropped.
+  vtkIceTRendererBoxMap boxes;
+  vtkstd::vector<double> corners;
+  int numBoundedProps = 0;
+  for (int i = 0; i < this->PropArrayCount; i++)
+    {
+    vtkProp *prop = this->PropArray[i];
+    if (!prop->GetVisibility() || !prop->GetUseBounds())
+      {
+      continue;
+      }
+    double *bounds = prop->GetBounds();
+    if (bounds == NULL ||
+      bounds[0] < -VTK_DOUBLE_MAX || bounds[1] > VTK_DOUBLE_MAX ||
+      bounds[2] < -VTK_DOUBLE_MAX || bounds[3] > VTK_DOUBLE_MAX ||
+      bounds[4] < -VTK_DOUBLE_MAX || bounds[5] > VTK_DOUBLE_MAX ||
+      bounds[0] > bounds[1])
+      {
+      continue;
+      }
+    numBoundedProps++;
+    double propCorners[24];
+    vtkIceTRendererBoundsCorners(bounds, propCorners);
+    if (this->UseTightBounds)
+      {
+      // The box is recomputed only when the data or the prop changed.
+      vtkIceTRendererBoxMap::iterator found =
+        this->Internals->Boxes.find(prop);
+      vtkIceTRendererBox box;
+      if (found != this->Internals->Boxes.end())
+        {
+        box = found->second;
+        }
+      else
+        {
+        box.Input = NULL;
+        box.Time = 0;
+        }
+      if (vtkIceTRendererComputeOrientedBox(prop, bounds, box))
+        {
+        vtkstd::copy(box.Corners, box.Corners + 24, propCorners);
+        boxes[prop] = box;
+        }
+      }
+    corners.insert(corners.end(), propCorners, propCorners + 24);
+    }
+  this->Internals->Boxes.swap(boxes);
+
+  if (numBoundedProps == 0)
+    {
+    //Let ICE-T know that nothing is in bounds so that this process does not
+    //take part in compositing any tile.
+    float tmp = VTK_LARGE_FLOAT;
+    icetBoundingVertices(1, ICET_FLOAT, 0, 1, &tmp);
+    this->ActivePixelFraction = 0.0;
+    return;
+    }
+
+  if (!this->UseTightBounds ||
+    numBoundedProps > this->MaximumNumberOfBoundingProps)
+    {
+    double allBounds[6];
+    this->ComputeVisiblePropBounds(allBounds);
+    corners.resize(24);
+    vtkIceTRendererBoundsCorners(allBounds, &corners[0]);
+    }
+
+  GLsizei numVertices = static_cast<GLsizei>(corners.size()/3);
+  icetBoundingVertices(3, ICET_DOUBLE, 0, numVertices, &corners[0]);
+
+  // Compute the fraction of the viewport covered by the projected vertices.
+  // This is what IceT uses to decide which pixels are active.
+  double aspect[2];
+  this->ComputeAspect();
+  this->GetAspect(aspect);
+  vtkMatrix4x4 *matrix = this->GetActiveCamera()->
+    GetCompositeProjectionTransformMatrix(aspect[0]/aspect[1], -1, 1);
+  double ndc[4] = {1.0, 1.0, -1.0, -1.0};
+  for (GLsizei v = 0; v < numVertices; v++)
+    {
+    double in[4] = {corners[3*v], corners[3*v+1], corners[3*v+2], 1.0};
+    double out[4];
+    matrix->MultiplyPoint(in, out);
+    if (out[3] <= 0.0)
+      {
+      // Vertex behind the viewer, assume the full viewport is covered.
+      ndc[0] = ndc[1] = -1.0;
+      ndc[2] = ndc[3] = 1.0;
+      break;
+      }
+    ndc[0] = vtkstd::min(ndc[0], out[0]/out[3]);
+    ndc[1] = vtkstd::min(ndc[1], out[1]/out[3]);
+    ndc[2] = vtkstd::max(ndc[2], out[0]/out[3]);
+    ndc[3] = vtkstd::max(ndc[3], out[1]/out[3]);
+    }
+  double width = vtkstd::min(ndc[2], 1.0) - vtkstd::max(ndc[0], -1.0);
+  double height = vtkstd::min(ndc[3], 1.0) - vtkstd::max(ndc[1], -1.0);
+  this->ActivePixelFraction = (width > 0.0 && height > 0.0)?
+    (width*height)/4.0 : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+
 void vtkIceTRenderer::Clear()
 {
   if (!this->InIceTRender)
@@ -675,6 +890,10 @@ void vtkIceTRenderer::PrintSelf(ostream &os, vtkIndent indent)
   this->vtkOpenGLRenderer::PrintSelf(os, indent);
 
   os << indent << "CollectDepthBuffer: " << this->CollectDepthBuffer << endl;
+  os << indent << "UseTightBounds: " << this->UseTightBounds << endl;
+  os << indent << "MaximumNumberOfBoundingProps: "
+     << this->MaximumNumberOfBoundingProps << endl;
+  os << indent << "ActivePixelFraction: " << this->ActivePixelFraction << endl;
   os << indent << "ComposeNextFrame: " << this->ComposeNextFrame << endl;
 
   os << indent << "ICE-T Context: " << this->Context << endl;
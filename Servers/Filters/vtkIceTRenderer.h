@@ -169,6 +169,29 @@ public:
   vtkSetMacro(CollectDepthBuffer, int);
   vtkGetMacro(CollectDepthBuffer, int);
 
+  // Description:
+  // When on (the default), each visible prop that renders a vtkPolyData with
+  // a vtkPolyDataMapper is bounded by the oriented bounding box of its points
+  // when that box is smaller than its axis-aligned bounds.  IceT only reads
+  // back and composites the screen-space rectangle enclosing the projected
+  // corners, so geometry that is rotated or elongated with respect to the
+  // axes covers fewer active pixels.  The boxes are recomputed only when the
+  // data or the prop changes.  When off, or when there are more than
+  // MaximumNumberOfBoundingProps props, the union of the bounds of the props
+  // is used.  In either case processes with no visible geometry do not
+  // contribute to any tile.
+  vtkSetMacro(UseTightBounds, int);
+  vtkGetMacro(UseTightBounds, int);
+  vtkBooleanMacro(UseTightBounds, int);
+  vtkSetClampMacro(MaximumNumberOfBoundingProps, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfBoundingProps, int);
+
+  // Description:
+  // Fraction of the viewport covered by the screen-space bounding rectangle of
+  // the local geometry in the last composited frame.  This is 0 when the
+  // process had nothing to render.
+  vtkGetMacro(ActivePixelFraction, double);
+
 
 protected:
   vtkIceTRenderer();
@@ -181,6 +204,9 @@ protected:
   int InIceTRender;
 
   int CollectDepthBuffer;
+  int UseTightBounds;
+  int MaximumNumberOfBoundingProps;
+  double ActivePixelFraction;
   int Strategy;
   int ComposeOperation;
 
@@ -203,6 +229,14 @@ protected:
   // times with depth peeling technique.
   virtual int UpdateTranslucentPolygonalGeometry();
 
+  // Description:
+  // Passes the bounds of the local geometry to IceT and updates
+  // ActivePixelFraction.
+  void SetIceTBounds();
+
+  class vtkInternals;
+  vtkInternals *Internals;
+
   vtkIceTRenderer(const vtkIceTRenderer&); // Not implemented
   void operator=(const vtkIceTRenderer&); // Not implemented
 };
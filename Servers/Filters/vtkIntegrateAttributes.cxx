@@ -16,24 +16,30 @@
 
 #include "vtkCellData.h"
 #include "vtkCellType.h"
+#include "vtkCommunicator.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkCompositeDataSet.h"
 #include "vtkDataSet.h"
 #include "vtkDoubleArray.h"
+#include "vtkGenericCell.h"
 #include "vtkIdList.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
 #include "vtkMultiProcessController.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointData.h"
 #include "vtkPolygon.h"
-#include "vtkProcessModule.h"
 #include "vtkTriangle.h"
 #include "vtkUnstructuredGrid.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/string>
+#include <vtkstd/vector>
+#include <string.h>
 
 vtkStandardNewMacro(vtkIntegrateAttributes);
 
@@ -46,6 +52,82 @@ public:
       { this->vtkDataSetAttributes::FieldList::SetFieldIndex(i, index); }
 };
 
+//-----------------------------------------------------------------------------
+// The cells of a block are split in contiguous ranges, one per thread. Each
+// thread integrates its range with its own vtkIntegrateAttributes instance
+// and output, so that the accumulators are not shared.
+class vtkIntegrateAttributesTask
+{
+public:
+  vtkDataSet* Input;
+  int FieldSetIndex;
+  vtkIntegrateAttributes::vtkFieldList* PointFieldList;
+  vtkIntegrateAttributes::vtkFieldList* CellFieldList;
+  vtkstd::vector<vtkIntegrateAttributes*> Workers;
+  vtkstd::vector<vtkUnstructuredGrid*> Outputs;
+
+  void Execute(int threadId, int numThreads)
+    {
+    vtkIdType numCells = this->Input->GetNumberOfCells();
+    vtkIdType begin = (numCells * threadId) / numThreads;
+    vtkIdType end = (numCells * (threadId + 1)) / numThreads;
+    vtkGenericCell* cell = vtkGenericCell::New();
+    this->Workers[threadId]->IntegrateCells(this->Input,
+      this->Outputs[threadId], this->FieldSetIndex, *this->PointFieldList,
+      *this->CellFieldList, begin, end, cell);
+    cell->Delete();
+    }
+
+  int GetIntegrationDimension(int threadId)
+    {
+    return this->Workers[threadId]->IntegrationDimension;
+    }
+  double GetSum(int threadId)
+    {
+    return this->Workers[threadId]->Sum;
+    }
+  double* GetSumCenter(int threadId)
+    {
+    return this->Workers[threadId]->SumCenter;
+    }
+};
+
+namespace
+{
+// Don't spawn threads for fewer cells than this per thread.
+const vtkIdType vtkIAMinimumCellsPerThread = 20000;
+
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkIntegrateAttributesThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkIntegrateAttributesTask* task =
+    static_cast<vtkIntegrateAttributesTask*>(info->UserData);
+  task->Execute(info->ThreadID, info->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+// Adds the single tuple of each array of inda to the array with the same
+// index in outda. Both have the same layout.
+void vtkIAAddAttributes(vtkDataSetAttributes* inda, vtkDataSetAttributes* outda)
+{
+  int numArrays = outda->GetNumberOfArrays();
+  for (int i = 0; i < numArrays; ++i)
+    {
+    vtkDataArray* inArray = inda->GetArray(i);
+    vtkDataArray* outArray = outda->GetArray(i);
+    int numComponents = outArray->GetNumberOfComponents();
+    for (int j = 0; j < numComponents; ++j)
+      {
+      outArray->SetComponent(0, j,
+        outArray->GetComponent(0, j) + inArray->GetComponent(0, j));
+      }
+    }
+}
+}
+
 //-----------------------------------------------------------------------------
 vtkIntegrateAttributes::vtkIntegrateAttributes()
 {
@@ -115,6 +197,79 @@ void vtkIntegrateAttributes::ExecuteBlock(
   int fieldset_index,
   vtkIntegrateAttributes::vtkFieldList& pdList,
   vtkIntegrateAttributes::vtkFieldList& cdList)
+{
+  vtkIdType numCells = input->GetNumberOfCells();
+  vtkGenericCell* cell = vtkGenericCell::New();
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  int maxThreads = static_cast<int>(
+    vtkstd::max<vtkIdType>(numCells / vtkIAMinimumCellsPerThread, 1));
+  int numThreads = vtkstd::min(threader->GetNumberOfThreads(), maxThreads);
+  if (numThreads <= 1)
+    {
+    threader->Delete();
+    this->IntegrateCells(input, output, fieldset_index, pdList, cdList,
+      0, numCells, cell);
+    cell->Delete();
+    return;
+    }
+
+  // Let the input build the structures it computes on demand (the cells of
+  // a vtkPolyData for instance) before several threads query it.
+  input->GetCell(0, cell);
+  cell->Delete();
+
+  vtkIntegrateAttributesTask task;
+  task.Input = input;
+  task.FieldSetIndex = fieldset_index;
+  task.PointFieldList = &pdList;
+  task.CellFieldList = &cdList;
+  for (int t = 0; t < numThreads; ++t)
+    {
+    task.Workers.push_back(vtkIntegrateAttributes::New());
+    // Same arrays, in the same order, as the output.
+    vtkUnstructuredGrid* threadOutput = vtkUnstructuredGrid::New();
+    threadOutput->GetPointData()->DeepCopy(output->GetPointData());
+    threadOutput->GetCellData()->DeepCopy(output->GetCellData());
+    this->ZeroAttributes(threadOutput->GetPointData());
+    this->ZeroAttributes(threadOutput->GetCellData());
+    task.Outputs.push_back(threadOutput);
+    }
+
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(::vtkIntegrateAttributesThread, &task);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Combine the partial results in thread order so that the result does not
+  // depend on scheduling.
+  for (int t = 0; t < numThreads; ++t)
+    {
+    if (this->CompareIntegrationDimension(output,
+        task.GetIntegrationDimension(t)))
+      {
+      this->Sum += task.GetSum(t);
+      double* center = task.GetSumCenter(t);
+      this->SumCenter[0] += center[0];
+      this->SumCenter[1] += center[1];
+      this->SumCenter[2] += center[2];
+      ::vtkIAAddAttributes(task.Outputs[t]->GetPointData(),
+        output->GetPointData());
+      ::vtkIAAddAttributes(task.Outputs[t]->GetCellData(),
+        output->GetCellData());
+      }
+    task.Workers[t]->Delete();
+    task.Outputs[t]->Delete();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkIntegrateAttributes::IntegrateCells(
+  vtkDataSet* input, vtkUnstructuredGrid* output,
+  int fieldset_index,
+  vtkIntegrateAttributes::vtkFieldList& pdList,
+  vtkIntegrateAttributes::vtkFieldList& cdList,
+  vtkIdType begin, vtkIdType end, vtkGenericCell* cell)
 {
   vtkDataArray* ghostLevelArray =
     input->GetCellData()->GetArray("vtkGhostLevels");
@@ -126,11 +281,10 @@ void vtkIntegrateAttributes::ExecuteBlock(
   this->FieldListIndex = fieldset_index;
 
   vtkIdList* cellPtIds = vtkIdList::New();
-  vtkIdType numCells = input->GetNumberOfCells();
   vtkIdType cellId;
   vtkPoints *cellPoints = 0; // needed if we need to split 3D cells
   int cellType;
-  for (cellId = 0; cellId < numCells; ++cellId)
+  for (cellId = begin; cellId < end; ++cellId)
     {
     cellType = input->GetCellType(cellId);
     // Make sure we are not integrating ghost cells.
@@ -244,7 +398,7 @@ void vtkIntegrateAttributes::ExecuteBlock(
       default:
       {
       // We need to explicitly get the cell
-      vtkCell *cell = input->GetCell(cellId);
+      input->GetCell(cellId, cell);
       int cellDim = cell->GetCellDimension();
       if (cellDim == 0)
         {
@@ -424,47 +578,16 @@ int vtkIntegrateAttributes::RequestData(vtkInformation*,
     return 0;
     }
 
-  // Here is the trick:  The satellites need a point and vertex to
-  // marshal the attributes.  Node zero needs to receive first...
-  int localProcId = 0;
-  // Send results to process 0.
-  if (this->Controller)
+  // Sum the results of all processes on process 0. Satellites end up with
+  // an empty output.
+  this->ReduceProcessResults(output);
+  if (this->Controller && this->Controller->GetLocalProcessId() > 0)
     {
-    localProcId = this->Controller->GetLocalProcessId();
-    if (localProcId == 0)
-      {
-      int numProcs = this->Controller->GetNumberOfProcesses();
-      int id;
-      for (id = 1; id < numProcs; ++id)
-        {
-        double msg[5];
-        this->Controller->Receive(msg,
-                                  5,
-                                  id,
-                                  vtkProcessModule::IntegrateAttrInfo);
-        vtkUnstructuredGrid* tmp = vtkUnstructuredGrid::New();
-        this->Controller->Receive(tmp,
-                                  id,
-                                  vtkProcessModule::IntegrateAttrData);
-        if (this->CompareIntegrationDimension(output, (int)(msg[0])))
-          {
-          this->Sum += msg[1];
-          this->SumCenter[0] += msg[2];
-          this->SumCenter[1] += msg[3];
-          this->SumCenter[2] += msg[4];
-          this->IntegrateSatelliteData(tmp->GetPointData(),
-                                       output->GetPointData());
-          this->IntegrateSatelliteData(tmp->GetCellData(),
-                                       output->GetCellData());
-          }
-        tmp->Delete();
-        tmp = 0;
-        }
-      }
+    output->Initialize();
+    return 1;
     }
 
   // Generate point and vertex.  Add extra attributes for area too.
-  // Satellites do not need the area attribute, but it does not hurt.
   double pt[3];
   vtkPoints* newPoints = vtkPoints::New();
   newPoints->SetNumberOfPoints(1);
@@ -510,32 +633,135 @@ int vtkIntegrateAttributes::RequestData(vtkInformation*,
   output->GetCellData()->AddArray(sumArray);
   sumArray->Delete();
 
-  if (localProcId > 0)
+  if (output->GetPointData()->GetArray("vtkGhostLevels"))
     {
-    double msg[5];
-    msg[0] = (double)(this->IntegrationDimension);
-    msg[1] = this->Sum;
-    msg[2] = this->SumCenter[0];
-    msg[3] = this->SumCenter[1];
-    msg[4] = this->SumCenter[2];
-    this->Controller->Send(msg, 5, 0, vtkProcessModule::IntegrateAttrInfo);
-    this->Controller->Send(output, 0, vtkProcessModule::IntegrateAttrData);
-    // Done sending.  Reset output so satellites will have empty data.
-    output->Initialize();
+    output->GetPointData()->RemoveArray("vtkGhostLevels");
     }
-  else
+  if (output->GetCellData()->GetArray("vtkGhostLevels"))
+    {
+    output->GetCellData()->RemoveArray("vtkGhostLevels");
+    }
+
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkIntegrateAttributes::ReduceProcessResults(vtkUnstructuredGrid* output)
+{
+  if (!this->Controller || this->Controller->GetNumberOfProcesses() <= 1)
     {
-    if (output->GetPointData()->GetArray("vtkGhostLevels"))
+    return;
+    }
+  int localProcId = this->Controller->GetLocalProcessId();
+
+  // As with CompareIntegrationDimension(), only the processes that
+  // integrated the highest dimension contribute.
+  int dimension = this->IntegrationDimension;
+  int maxDimension = dimension;
+  this->Controller->AllReduce(&dimension, &maxDimension, 1,
+    vtkCommunicator::MAX_OP);
+  bool contribute = (dimension == maxDimension);
+
+  // The arrays of process 0 are the ones summed. Tell everyone their names
+  // and number of components so that all processes pack the same values.
+  vtkDataSetAttributes* attributes[2] =
+    { output->GetPointData(), output->GetCellData() };
+  int sizes[3] = { 0, 0, 0 };
+  vtkstd::vector<int> components;
+  vtkstd::vector<char> names;
+  if (localProcId == 0)
+    {
+    for (int a = 0; a < 2; ++a)
       {
-      output->GetPointData()->RemoveArray("vtkGhostLevels");
+      sizes[a] = attributes[a]->GetNumberOfArrays();
+      for (int i = 0; i < sizes[a]; ++i)
+        {
+        vtkDataArray* array = attributes[a]->GetArray(i);
+        const char* name = array->GetName() ? array->GetName() : "";
+        names.insert(names.end(), name, name + strlen(name) + 1);
+        components.push_back(array->GetNumberOfComponents());
+        }
       }
-    if (output->GetCellData()->GetArray("vtkGhostLevels"))
+    sizes[2] = static_cast<int>(names.size());
+    }
+  this->Controller->Broadcast(sizes, 3, 0);
+  components.resize(sizes[0] + sizes[1]);
+  names.resize(sizes[2]);
+  if (!components.empty())
+    {
+    this->Controller->Broadcast(&components[0],
+      static_cast<vtkIdType>(components.size()), 0);
+    }
+  if (!names.empty())
+    {
+    this->Controller->Broadcast(&names[0],
+      static_cast<vtkIdType>(names.size()), 0);
+    }
+
+  // Pack the sum, the center and the array values. Process 0 uses its own
+  // arrays by index; the others look them up by name, like
+  // IntegrateSatelliteData() did, and contribute zeros when missing.
+  vtkstd::vector<double> values;
+  values.push_back(contribute ? this->Sum : 0.0);
+  values.push_back(contribute ? this->SumCenter[0] : 0.0);
+  values.push_back(contribute ? this->SumCenter[1] : 0.0);
+  values.push_back(contribute ? this->SumCenter[2] : 0.0);
+  size_t nameOffset = 0;
+  int index = 0;
+  for (int a = 0; a < 2; ++a)
+    {
+    for (int i = 0; i < sizes[a]; ++i, ++index)
       {
-      output->GetCellData()->RemoveArray("vtkGhostLevels");
+      const char* name = &names[nameOffset];
+      nameOffset += strlen(name) + 1;
+      int numComponents = components[index];
+      vtkDataArray* array = 0;
+      if (contribute && localProcId == 0)
+        {
+        array = attributes[a]->GetArray(i);
+        }
+      else if (contribute && name[0] != '\0')
+        {
+        array = attributes[a]->GetArray(name);
+        if (array && (array->GetNumberOfComponents() != numComponents ||
+            array->GetNumberOfTuples() < 1))
+          {
+          array = 0;
+          }
+        }
+      for (int j = 0; j < numComponents; ++j)
+        {
+        values.push_back(array ? array->GetComponent(0, j) : 0.0);
+        }
       }
     }
 
-  return 1;
+  vtkstd::vector<double> totals(values.size());
+  this->Controller->Reduce(&values[0], &totals[0],
+    static_cast<vtkIdType>(values.size()), vtkCommunicator::SUM_OP, 0);
+  if (localProcId != 0)
+    {
+    return;
+    }
+
+  this->IntegrationDimension = maxDimension;
+  this->Sum = totals[0];
+  this->SumCenter[0] = totals[1];
+  this->SumCenter[1] = totals[2];
+  this->SumCenter[2] = totals[3];
+  size_t k = 4;
+  for (int a = 0; a < 2; ++a)
+    {
+    for (int i = 0; i < sizes[a]; ++i)
+      {
+      vtkDataArray* array = attributes[a]->GetArray(i);
+      int numComponents = array->GetNumberOfComponents();
+      for (int j = 0; j < numComponents; ++j)
+        {
+        array->SetComponent(0, j, totals[k++]);
+        }
+      }
+    }
 }
 
 //-----------------------------------------------------------------------------
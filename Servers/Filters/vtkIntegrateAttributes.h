@@ -21,6 +21,8 @@
 // The output of this filter is a single point and vertex.  The attributes
 // for this point and cell will contain the integration results
 // for the corresponding input attributes.
+// Large datasets are integrated by several threads (see vtkMultiThreader),
+// and the results of all processes are summed with a single reduction.
 
 #ifndef __vtkIntegrateAttributes_h
 #define __vtkIntegrateAttributes_h
@@ -28,6 +30,7 @@
 #include "vtkUnstructuredGridAlgorithm.h"
 
 class vtkDataSet;
+class vtkGenericCell;
 class vtkIdList;
 class vtkInformation;
 class vtkInformationVector;
@@ -105,6 +108,10 @@ protected:
                               vtkDataSetAttributes* outda);
   void ZeroAttributes(vtkDataSetAttributes* outda);
 
+  // Description:
+  // Sums the results of all processes into the output of process 0.
+  void ReduceProcessResults(vtkUnstructuredGrid* output);
+
 private:
   vtkIntegrateAttributes(const vtkIntegrateAttributes&);  // Not implemented.
   void operator=(const vtkIntegrateAttributes&);  // Not implemented.
@@ -119,6 +126,14 @@ private:
   void ExecuteBlock(vtkDataSet* input, vtkUnstructuredGrid* output,
     int fieldset_index, vtkFieldList& pdList, vtkFieldList& cdList);
 
+  // Integrates cells [begin, end) of the input. ExecuteBlock() runs this
+  // over several threads with a separate instance and output for each.
+  void IntegrateCells(vtkDataSet* input, vtkUnstructuredGrid* output,
+    int fieldset_index, vtkFieldList& pdList, vtkFieldList& cdList,
+    vtkIdType begin, vtkIdType end, vtkGenericCell* cell);
+
+  friend class vtkIntegrateAttributesTask;
+
   void IntegrateData1(vtkDataSetAttributes* inda,
                       vtkDataSetAttributes* outda,
                       vtkIdType pt1Id, double k,
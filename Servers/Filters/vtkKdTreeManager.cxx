@@ -15,6 +15,7 @@
 #include "vtkKdTreeManager.h"
 
 #include "vtkAlgorithm.h"
+#include "vtkBSPCuts.h"
 #include "vtkCellType.h"
 #include "vtkCommunicator.h"
 #include "vtkKdTreeGenerator.h"
@@ -25,27 +26,49 @@
 #include "vtkPVUpdateSuppressor.h"
 #include "vtkSmartPointer.h"
 #include "vtkSphereSource.h"
+#include "vtkTimerLog.h"
 #include "vtkUnstructuredGrid.h"
 
 #define VTK_CREATE(type, name) \
   vtkSmartPointer<type> name = vtkSmartPointer<type>::New()
 
+#include <vtkstd/algorithm>
+#include <vtkstd/map>
 #include <vtkstd/set>
 #include <vtkstd/vector>
+#include <math.h>
 
 class vtkKdTreeManager::vtkAlgorithmSet : 
   public vtkstd::set<vtkSmartPointer<vtkAlgorithm> > {};
 
+// The datasets are only compared against, never dereferenced. A dataset
+// deleted and reallocated at the same address has a newer MTime.
+class vtkKdTreeManager::vtkDataSetTimes :
+  public vtkstd::map<vtkDataSet*, unsigned long> {};
+
 vtkStandardNewMacro(vtkKdTreeManager);
 vtkCxxSetObjectMacro(vtkKdTreeManager, StructuredProducer, vtkAlgorithm);
 //----------------------------------------------------------------------------
 vtkKdTreeManager::vtkKdTreeManager()
 {
   this->Producers = new vtkAlgorithmSet();
+  this->PreviousData = new vtkDataSetTimes();
   this->StructuredProducer = 0;
   this->KdTree = 0;
   this->NumberOfPieces = 1;
   this->KdTreeInitialized = false;
+
+  this->ReuseCuts = 0;
+  this->BoundsTolerance = 0.05;
+  this->ImbalanceThreshold = 1.2;
+  this->LastImbalance = 1.0;
+  this->LastBuildTime = 0.0;
+  this->LastCutsReused = 0;
+  this->PreviousCuts = 0;
+  for (int cc=0; cc < 6; cc++)
+    {
+    this->PreviousBounds[cc] = 0.0;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -53,8 +76,10 @@ vtkKdTreeManager::~vtkKdTreeManager()
 {
   this->SetKdTree(0);
   this->SetStructuredProducer(0);
+  this->ClearPreviousCuts();
 
   delete this->Producers;
+  delete this->PreviousData;
 }
 
 //----------------------------------------------------------------------------
@@ -101,7 +126,35 @@ void vtkKdTreeManager::SetKdTree(vtkPKdTree* tree)
     {
     vtkSetObjectBodyMacro(KdTree, vtkPKdTree, tree);
     this->KdTreeInitialized = false;
+    this->ClearPreviousCuts();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkKdTreeManager::ClearPreviousCuts()
+{
+  if (this->PreviousCuts)
+    {
+    this->PreviousCuts->Delete();
+    this->PreviousCuts = 0;
     }
+  this->PreviousData->clear();
+}
+
+//----------------------------------------------------------------------------
+bool vtkKdTreeManager::DataUnchangedSinceBuild(vtkDataSet** datasets,
+  int count)
+{
+  for (int cc=0; cc < count; cc++)
+    {
+    vtkDataSetTimes::iterator iter = this->PreviousData->find(datasets[cc]);
+    if (iter == this->PreviousData->end() ||
+      iter->second != datasets[cc]->GetMTime())
+      {
+      return false;
+      }
+    }
+  return true;
 }
 
 //----------------------------------------------------------------------------
@@ -164,6 +217,11 @@ void vtkKdTreeManager::Update()
     this->AddDataSetToKdTree(*dsIter);
     } 
 
+  vtkTimerLog* timer = vtkTimerLog::New();
+  timer->StartTimer();
+  vtkTimerLog::MarkStartEvent("KdTree Build");
+  this->LastCutsReused = 0;
+
   if (this->StructuredProducer)
     {
     // Ask the vtkKdTreeGenerator to generate the cuts for the kd tree.
@@ -172,20 +230,193 @@ void vtkKdTreeManager::Update()
     generator->SetNumberOfPieces(this->NumberOfPieces);
     generator->BuildTree(this->StructuredProducer->GetOutputDataObject(0));
     generator->Delete();
+    this->KdTree->BuildLocator();
+    this->ClearPreviousCuts();
     }
   else
     {
-    // Ensure that the kdtree is not using predefined cuts.
-    this->KdTree->SetCuts(0);
-    // this is needed to clear the region assignments provided by the structured
-    // dataset.
-    this->KdTree->AssignRegionsContiguous();
+    double bounds[6];
+    bool valid_bounds = this->ComputeGlobalBounds(
+      outputs.empty()? 0 : &outputs[0], static_cast<int>(outputs.size()),
+      bounds);
+
+    // The cuts can be reused when none of the data changed since the last
+    // full build (only the set of producers did), or, with ReuseCuts, when
+    // the data moved by less than BoundsTolerance. All processes must take
+    // the same decision, hence the reduction.
+    bool reuse = false;
+    if (valid_bounds && this->PreviousCuts)
+      {
+      int unchanged = this->DataUnchangedSinceBuild(
+        outputs.empty()? 0 : &outputs[0], static_cast<int>(outputs.size()))?
+        1 : 0;
+      vtkMultiProcessController* controller = this->KdTree->GetController();
+      if (controller)
+        {
+        int allUnchanged = unchanged;
+        controller->AllReduce(&unchanged, &allUnchanged, 1,
+          vtkCommunicator::MIN_OP);
+        unchanged = allUnchanged;
+        }
+      reuse = unchanged ||
+        (this->ReuseCuts && this->BoundsWithinTolerance(bounds));
+      }
+
+    if (reuse)
+      {
+      // Reuse the cuts from the last full build. The region assignment is
+      // recomputed by BuildLocator() using the current assignment scheme.
+      this->KdTree->SetCuts(this->PreviousCuts);
+      this->KdTree->BuildLocator();
+      this->LastImbalance = this->ComputeImbalance();
+      this->LastCutsReused = 1;
+      vtkDebugMacro("Reused KdTree cuts, imbalance: " << this->LastImbalance);
+      }
+
+    if (!this->LastCutsReused ||
+      this->LastImbalance > this->ImbalanceThreshold)
+      {
+      // Ensure that the kdtree is not using predefined cuts.
+      this->KdTree->SetCuts(0);
+      // this is needed to clear the region assignments provided by the
+      // structured dataset.
+      this->KdTree->AssignRegionsContiguous();
+      this->KdTree->BuildLocator();
+      this->LastImbalance = this->ComputeImbalance();
+      this->LastCutsReused = 0;
+
+      // Save the cuts, and the data they were built from, for subsequent
+      // updates.
+      this->ClearPreviousCuts();
+      vtkBSPCuts* cuts = this->KdTree->GetCuts();
+      if (valid_bounds && cuts && cuts->GetKdNodeTree())
+        {
+        this->PreviousCuts = vtkBSPCuts::New();
+        this->PreviousCuts->CreateCuts(cuts->GetKdNodeTree());
+        memcpy(this->PreviousBounds, bounds, sizeof(double)*6);
+        for (dsIter = outputs.begin(); dsIter != outputs.end(); ++dsIter)
+          {
+          (*this->PreviousData)[*dsIter] = (*dsIter)->GetMTime();
+          }
+        }
+      }
     }
 
-  this->KdTree->BuildLocator();
+  vtkTimerLog::MarkEndEvent("KdTree Build");
+  timer->StopTimer();
+  this->LastBuildTime = timer->GetElapsedTime();
+  timer->Delete();
+
   this->UpdateTime.Modified();
 }
 
+//----------------------------------------------------------------------------
+bool vtkKdTreeManager::ComputeGlobalBounds(vtkDataSet** datasets, int count,
+  double bounds[6])
+{
+  // Local bounds are stored as (-xmin, xmax, -ymin, ymax, -zmin, zmax) so
+  // that a single MAX reduction computes the union.
+  double local[6] = {-VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+    -VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+  for (int cc=0; cc < count; cc++)
+    {
+    if (datasets[cc]->GetNumberOfPoints() == 0)
+      {
+      continue;
+      }
+    double dsbounds[6];
+    datasets[cc]->GetBounds(dsbounds);
+    for (int kk=0; kk < 3; kk++)
+      {
+      local[2*kk] = vtkstd::max(local[2*kk], -dsbounds[2*kk]);
+      local[2*kk+1] = vtkstd::max(local[2*kk+1], dsbounds[2*kk+1]);
+      }
+    }
+
+  double global[6];
+  vtkMultiProcessController* controller = this->KdTree->GetController();
+  if (controller)
+    {
+    controller->AllReduce(local, global, 6, vtkCommunicator::MAX_OP);
+    }
+  else
+    {
+    memcpy(global, local, sizeof(double)*6);
+    }
+
+  for (int kk=0; kk < 3; kk++)
+    {
+    bounds[2*kk] = -global[2*kk];
+    bounds[2*kk+1] = global[2*kk+1];
+    if (bounds[2*kk] > bounds[2*kk+1])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkKdTreeManager::BoundsWithinTolerance(const double bounds[6])
+{
+  double diagonal2 = 0.0;
+  for (int kk=0; kk < 3; kk++)
+    {
+    double length = this->PreviousBounds[2*kk+1] - this->PreviousBounds[2*kk];
+    diagonal2 += length * length;
+    }
+  double tolerance = this->BoundsTolerance * sqrt(diagonal2);
+  for (int cc=0; cc < 6; cc++)
+    {
+    if (fabs(bounds[cc] - this->PreviousBounds[cc]) > tolerance)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkKdTreeManager::ComputeImbalance()
+{
+  // vtkPKdTree keeps the cell counts per region for every process on all
+  // processes, so no communication is needed here.
+  vtkMultiProcessController* controller = this->KdTree->GetController();
+  int numProcs = controller? controller->GetNumberOfProcesses() : 1;
+  int numRegions = this->KdTree->GetNumberOfRegions();
+  if (numProcs <= 1 || numRegions <= 0)
+    {
+    return 1.0;
+    }
+
+  vtkstd::vector<double> load(numProcs, 0.0);
+  double total = 0.0;
+  for (int region=0; region < numRegions; region++)
+    {
+    int owner = this->KdTree->GetProcessAssignedToRegion(region);
+    if (owner < 0 || owner >= numProcs)
+      {
+      continue;
+      }
+    for (int proc=0; proc < numProcs; proc++)
+      {
+      int count = this->KdTree->GetProcessCellCountForRegion(proc, region);
+      if (count > 0)
+        {
+        load[owner] += count;
+        total += count;
+        }
+      }
+    }
+
+  if (total <= 0.0)
+    {
+    return 1.0;
+    }
+  double maxLoad = *vtkstd::max_element(load.begin(), load.end());
+  return maxLoad / (total / numProcs);
+}
+
 //-----------------------------------------------------------------------------
 void vtkKdTreeManager::AddDataSetToKdTree(vtkDataSet *data)
 {
@@ -272,6 +503,12 @@ void vtkKdTreeManager::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
   os << indent << "KdTree: " << this->KdTree << endl;
   os << indent << "NumberOfPieces: " << this->NumberOfPieces << endl;
+  os << indent << "ReuseCuts: " << this->ReuseCuts << endl;
+  os << indent << "BoundsTolerance: " << this->BoundsTolerance << endl;
+  os << indent << "ImbalanceThreshold: " << this->ImbalanceThreshold << endl;
+  os << indent << "LastImbalance: " << this->LastImbalance << endl;
+  os << indent << "LastBuildTime: " << this->LastBuildTime << endl;
+  os << indent << "LastCutsReused: " << this->LastCutsReused << endl;
 }
 
 
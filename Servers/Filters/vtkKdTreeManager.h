@@ -14,15 +14,28 @@
 =========================================================================*/
 // .NAME vtkKdTreeManager
 // .SECTION Description
+// vtkKdTreeManager manages the vtkPKdTree used for ordered compositing. It
+// rebuilds the KdTree when data from any of the producers changes. When
+// ReuseCuts is enabled, the cuts from the last full build are reused as long
+// as the global data bounds stay within BoundsTolerance of the bounds used for
+// that build and the resulting load imbalance does not exceed
+// ImbalanceThreshold. This avoids the global median computation for
+// animations where the geometry only deforms slightly.
 //
+// Adding or removing producers (e.g. toggling the visibility of a
+// representation) does not by itself invalidate the previous cuts: when every
+// dataset now in the tree was part of the last full build and has not been
+// modified since, the cuts are reused as long as the load imbalance stays
+// below ImbalanceThreshold, even when ReuseCuts is off.
 
 #ifndef __vtkKdTreeManager_h
 #define __vtkKdTreeManager_h
 
 #include "vtkObject.h"
 
-class vtkPKdTree;
 class vtkAlgorithm;
+class vtkBSPCuts;
+class vtkPKdTree;
 class vtkDataSet;
 
 class VTK_EXPORT vtkKdTreeManager : public vtkObject
@@ -58,6 +71,37 @@ public:
   vtkSetMacro(NumberOfPieces, int);
   vtkGetMacro(NumberOfPieces, int);
 
+  // Description:
+  // When set, the cuts from the last full build are reused when the data
+  // changes but its global bounds have moved by no more than BoundsTolerance.
+  // Not applicable when a StructuredProducer is set. Off by default.
+  vtkSetMacro(ReuseCuts, int);
+  vtkGetMacro(ReuseCuts, int);
+  vtkBooleanMacro(ReuseCuts, int);
+
+  // Description:
+  // Maximum shift of the global data bounds, relative to the length of the
+  // diagonal of the bounds used for the last full build, for which the
+  // previous cuts are reused. Default is 0.05.
+  vtkSetClampMacro(BoundsTolerance, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(BoundsTolerance, double);
+
+  // Description:
+  // When reusing cuts, the tree is rebuilt from scratch if the ratio of the
+  // largest number of cells assigned to a process to the average number of
+  // cells per process exceeds this threshold. Default is 1.2.
+  vtkSetClampMacro(ImbalanceThreshold, double, 1.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(ImbalanceThreshold, double);
+
+  // Description:
+  // Metrics for the last call to Update() that changed the KdTree.
+  // LastImbalance is the ratio of the largest number of cells assigned to a
+  // process to the average, LastBuildTime is the time spent in seconds and
+  // LastCutsReused is 1 if the previous cuts were reused.
+  vtkGetMacro(LastImbalance, double);
+  vtkGetMacro(LastBuildTime, double);
+  vtkGetMacro(LastCutsReused, int);
+
 //BTX
 protected:
   vtkKdTreeManager();
@@ -65,6 +109,41 @@ protected:
 
   void AddDataSetToKdTree(vtkDataSet *data);
 
+  // Description:
+  // Computes the union of the bounds of the datasets across all processes.
+  // Returns false if the datasets are empty on all processes.
+  bool ComputeGlobalBounds(vtkDataSet** datasets, int count, double bounds[6]);
+
+  // Description:
+  // Returns true if the bounds are within BoundsTolerance of the bounds used
+  // for the last full build.
+  bool BoundsWithinTolerance(const double bounds[6]);
+
+  // Description:
+  // Computes the load imbalance for the current region assignment of the
+  // KdTree.
+  double ComputeImbalance();
+
+  // Description:
+  // Returns true if every dataset was part of the last full build and has not
+  // been modified since.
+  bool DataUnchangedSinceBuild(vtkDataSet** datasets, int count);
+
+  // Description:
+  // Forgets the cuts from the last full build.
+  void ClearPreviousCuts();
+
+  int ReuseCuts;
+  double BoundsTolerance;
+  double ImbalanceThreshold;
+  double LastImbalance;
+  double LastBuildTime;
+  int LastCutsReused;
+
+  // Cuts and bounds from the last full build.
+  vtkBSPCuts* PreviousCuts;
+  double PreviousBounds[6];
+
   bool KdTreeInitialized;
   vtkAlgorithm* StructuredProducer;
   vtkPKdTree* KdTree;
@@ -77,6 +156,11 @@ private:
   class vtkAlgorithmSet;
   vtkAlgorithmSet* Producers;
 
+  // The datasets, and their modification times, the previous cuts were
+  // built from.
+  class vtkDataSetTimes;
+  vtkDataSetTimes* PreviousData;
+
 //ETX
 };
 
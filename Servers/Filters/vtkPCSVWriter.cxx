@@ -14,18 +14,23 @@
 =========================================================================*/
 #include "vtkPCSVWriter.h"
 
-#include "vtkCompositeDataPipeline.h"
-#include "vtkCharArray.h"
+#include "vtkCommunicator.h"
+#include "vtkErrorCode.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
-#include "vtkPointData.h"
-#include "vtkCellData.h"
-#include "vtkPolyData.h"
-#include "vtkPolyLineToRectilinearGridFilter.h"
-#include "vtkRectilinearGrid.h"
+#include "vtkPVMergeTables.h"
+#include "vtkReductionFilter.h"
+#include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkTable.h"
+
+#include <vtksys/ios/sstream>
+#include <vtksys/SystemTools.hxx>
+
+#include <vtkstd/string>
+#include <vtkstd/vector>
 
 vtkStandardNewMacro(vtkPCSVWriter);
 
@@ -34,8 +39,14 @@ vtkCxxSetObjectMacro(vtkPCSVWriter, Controller, vtkMultiProcessController);
 //----------------------------------------------------------------------------
 vtkPCSVWriter::vtkPCSVWriter()
 {
+  this->Piece = 0;
+  this->NumberOfPieces = 1;
+  this->GhostLevel = 0;
   this->Controller = 0;
   this->SetController(vtkMultiProcessController::GetGlobalController());
+  this->WriteAllTimeSteps = 0;
+  this->NumberOfTimeSteps = 0;
+  this->CurrentTimeIndex = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -44,16 +55,243 @@ vtkPCSVWriter::~vtkPCSVWriter()
   this->SetController(0);
 }
 
+//----------------------------------------------------------------------------
+int vtkPCSVWriter::ProcessRequest(vtkInformation* request,
+                                  vtkInformationVector** inputVector,
+                                  vtkInformationVector* outputVector)
+{
+  if (request->Has(vtkDemandDrivenPipeline::REQUEST_INFORMATION()))
+    {
+    vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+    if (inInfo->Has(vtkStreamingDemandDrivenPipeline::TIME_STEPS()))
+      {
+      this->NumberOfTimeSteps =
+        inInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+      }
+    else
+      {
+      this->NumberOfTimeSteps = 0;
+      }
+    }
+  if (request->Has(vtkStreamingDemandDrivenPipeline::REQUEST_UPDATE_EXTENT()))
+    {
+    vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER(),
+                this->Piece);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES(),
+                this->NumberOfPieces);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS(),
+                this->GhostLevel);
+    double* inTimes =
+      inInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+    if (inTimes && this->WriteAllTimeSteps &&
+      this->CurrentTimeIndex < this->NumberOfTimeSteps)
+      {
+      double timeReq = inTimes[this->CurrentTimeIndex];
+      inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEPS(),
+                  &timeReq, 1);
+      }
+    return 1;
+    }
+  if (request->Has(vtkDemandDrivenPipeline::REQUEST_DATA()))
+    {
+    bool write_all =
+      (this->WriteAllTimeSteps != 0 && this->NumberOfTimeSteps > 0);
+    if (!write_all)
+      {
+      request->Remove(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
+      this->CurrentTimeIndex = 0;
+      return this->Superclass::ProcessRequest(
+        request, inputVector, outputVector);
+      }
+
+    if (this->CurrentTimeIndex == 0)
+      {
+      // Tell the pipeline to start looping.
+      request->Set(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING(), 1);
+      }
+    int retVal = this->Superclass::ProcessRequest(
+      request, inputVector, outputVector);
+    this->CurrentTimeIndex++;
+    if (this->CurrentTimeIndex >= this->NumberOfTimeSteps)
+      {
+      // Tell the pipeline to stop looping.
+      request->Remove(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
+      this->CurrentTimeIndex = 0;
+      }
+    return retVal;
+    }
+  return this->Superclass::ProcessRequest(request, inputVector, outputVector);
+}
+
 //-----------------------------------------------------------------------------
 void vtkPCSVWriter::WriteData()
 {
+  vtkstd::string fileName = this->FileName ? this->FileName : "";
+  if (this->FileName &&
+    this->WriteAllTimeSteps != 0 && this->NumberOfTimeSteps > 0)
+    {
+    vtkstd::string path =
+      vtksys::SystemTools::GetFilenamePath(this->FileName);
+    vtkstd::string fnamenoext =
+      vtksys::SystemTools::GetFilenameWithoutLastExtension(this->FileName);
+    vtkstd::string ext =
+      vtksys::SystemTools::GetFilenameLastExtension(this->FileName);
+    vtksys_ios::ostringstream fname;
+    fname << path << "/" << fnamenoext << "." << this->CurrentTimeIndex << ext;
+    fileName = fname.str();
+    }
+
+  // Every process must take part in the exchange even without a table.
+  vtkTable* table = vtkTable::SafeDownCast(this->GetInput());
+  if (!table)
+    {
+    vtkErrorMacro(<< "CSVWriter can only write vtkTable.");
+    }
   if (!this->Controller || this->Controller->GetNumberOfProcesses() < 2)
     {
-    this->Superclass::WriteData();
+    if (table)
+      {
+      this->WriteTable(table, this->FileName ? fileName.c_str() : 0);
+      }
+    return;
+    }
+  this->WriteTableInParallel(table, this->FileName ? fileName.c_str() : 0);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPCSVWriter::WriteTableInParallel(vtkTable* table,
+  const char* fileName)
+{
+  vtkMultiProcessController* controller = this->Controller;
+  int numProcs = controller->GetNumberOfProcesses();
+  int myId = controller->GetLocalProcessId();
+
+  // Like vtkPVMergeTables, tables without rows do not contribute.
+  vtkstd::string header;
+  vtkstd::string rows;
+  if (table && table->GetNumberOfColumns() > 0 &&
+    table->GetNumberOfRows() > 0)
+    {
+    this->FormatHeader(table, header);
+    this->FormatRows(table, 0, table->GetNumberOfRows(), rows, 0);
+    }
+
+  // Sizes of the header and rows of every process, in process order.
+  vtkIdType localSizes[2];
+  localSizes[0] = static_cast<vtkIdType>(header.size());
+  localSizes[1] = static_cast<vtkIdType>(rows.size());
+  vtkstd::vector<vtkIdType> sizes(2*numProcs);
+  controller->AllGather(localSizes, &sizes[0], 2);
+
+  int headerProc = -1;
+  vtkIdType offset = 0;
+  for (int cc=0; cc < numProcs; cc++)
+    {
+    if (sizes[2*cc] > 0)
+      {
+      headerProc = cc;
+      offset = sizes[2*cc];
+      break;
+      }
+    }
+  for (int cc=0; cc < myId; cc++)
+    {
+    offset += sizes[2*cc+1];
+    }
+
+  // The rows can only be concatenated when all processes have the same
+  // columns, otherwise let vtkPVMergeTables match them.
+  int sameColumns = 1;
+  if (headerProc >= 0)
+    {
+    vtkstd::vector<char> reference(
+      static_cast<size_t>(sizes[2*headerProc]) + 1, 0);
+    if (myId == headerProc)
+      {
+      header.copy(&reference[0], header.size());
+      }
+    controller->Broadcast(&reference[0], sizes[2*headerProc], headerProc);
+    sameColumns = (header.empty() || header == &reference[0]) ? 1 : 0;
+    }
+  int allSameColumns = 1;
+  controller->AllReduce(&sameColumns, &allSameColumns, 1,
+                        vtkCommunicator::MIN_OP);
+  if (!allSameColumns)
+    {
+    this->WriteMergedTable(table, fileName);
     return;
     }
 
-  // Collect the 
+  // The first process creates (and truncates) the file, then everybody
+  // writes their own byte range.
+  int success = 1;
+  if (myId == 0)
+    {
+    ofstream create(fileName ? fileName : "", ios::out);
+    success = (fileName && !create.fail()) ? 1 : 0;
+    }
+  controller->Broadcast(&success, 1, 0);
+  if (!success)
+    {
+    vtkErrorMacro(<< "Unable to open file: "
+                  << (fileName ? fileName : "(none)"));
+    this->SetErrorCode(vtkErrorCode::CannotOpenFileError);
+    return;
+    }
+
+  if (myId == headerProc || !rows.empty())
+    {
+#ifdef _WIN32
+    fstream file(fileName, ios::in | ios::out | ios::binary);
+#else
+    fstream file(fileName, ios::in | ios::out);
+#endif
+    if (file.fail())
+      {
+      vtkErrorMacro(<< "Unable to open file: "<< fileName);
+      this->SetErrorCode(vtkErrorCode::CannotOpenFileError);
+      }
+    else
+      {
+      if (myId == headerProc)
+        {
+        file.seekp(0);
+        file.write(header.c_str(), header.size());
+        }
+      file.seekp(offset);
+      file.write(rows.c_str(), rows.size());
+      }
+    }
+  // Make sure the file is complete before anybody returns.
+  controller->Barrier();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPCSVWriter::WriteMergedTable(vtkTable* table, const char* fileName)
+{
+  vtkSmartPointer<vtkTable> tableCopy = vtkSmartPointer<vtkTable>::New();
+  if (table)
+    {
+    tableCopy->ShallowCopy(table);
+    }
+  vtkSmartPointer<vtkPVMergeTables> merge =
+    vtkSmartPointer<vtkPVMergeTables>::New();
+  vtkSmartPointer<vtkReductionFilter> reduction =
+    vtkSmartPointer<vtkReductionFilter>::New();
+  reduction->SetController(this->Controller);
+  reduction->SetPostGatherHelper(merge);
+  reduction->SetInputConnection(tableCopy->GetProducerPort());
+  reduction->Update();
+
+  if (this->Controller->GetLocalProcessId() == 0)
+    {
+    vtkTable* merged =
+      vtkTable::SafeDownCast(reduction->GetOutputDataObject(0));
+    this->WriteTable(merged ? merged : tableCopy.GetPointer(), fileName);
+    }
+  // Make sure the file is complete before anybody returns.
+  this->Controller->Barrier();
 }
 
 //----------------------------------------------------------------------------
@@ -64,4 +302,5 @@ void vtkPCSVWriter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Controller " << this->Controller << endl;
   os << indent << "NumberOfPieces: " << this->NumberOfPieces<< endl;
   os << indent << "Piece: " << this->Piece<< endl;
+  os << indent << "WriteAllTimeSteps: " << this->WriteAllTimeSteps << endl;
 }
@@ -14,9 +14,21 @@
 =========================================================================*/
 // .NAME vtkPCSVWriter - writes CSV files in parallel.
 // .SECTION Description
-// vtkPCSVWriter inherits from vtkCSVWriter for writing CSV files in parallel
+// vtkPCSVWriter inherits from vtkCSVWriter for writing CSV files in parallel.
+// Every process formats the rows of its own piece of the table. The sizes
+// of the formatted pieces are exchanged to compute where each piece starts
+// in the file and then all processes write their bytes directly into the
+// single output file. The header is written by the first process that has
+// rows. Rows appear in the file in process order. When the processes with
+// rows do not all have the same columns, the tables are instead gathered to
+// the first process and merged with vtkPVMergeTables, as the gather-to-root
+// CSV writer does.
+//
+// When WriteAllTimeSteps is on, one file is written per time step, with
+// the time step index inserted before the extension of FileName.
 //
 // .SECTION Caveats
+// The output file must be on a file system shared by all the processes.
 //
 // .SECTION See Also
 // vtkCSVWriter
@@ -32,7 +44,6 @@
 #include "vtkCSVWriter.h"
 
 class vtkMultiProcessController;
-class vtkDataSet;
 
 class VTK_EXPORT vtkPCSVWriter : public vtkCSVWriter
 {
@@ -64,30 +75,33 @@ public:
   virtual void SetController(vtkMultiProcessController*);
   vtkGetObjectMacro(Controller, vtkMultiProcessController);
 
+  // Description:
+  // Must be set to true to write all timesteps, otherwise only the current
+  // timestep will be written out. Off by default.
+  vtkGetMacro(WriteAllTimeSteps, int);
+  vtkSetMacro(WriteAllTimeSteps, int);
+  vtkBooleanMacro(WriteAllTimeSteps, int);
+
+  // Description:
+  // Request the piece to write from the upstream pipeline.
+  virtual int ProcessRequest(vtkInformation*,
+                             vtkInformationVector**,
+                             vtkInformationVector*);
+
 protected:
   vtkPCSVWriter();
   ~vtkPCSVWriter();
 
-//BTX
-  enum 
-    {
-    PCSV_COMMUNICATION_TAG=7755
-    };
-//ETX
-
   virtual void WriteData();
 
-  virtual void WriteRectilinearDataInParallel(
-    vtkRectilinearGrid* rectilinearGrid);
+  // Description:
+  // Write the local rows of table at their offset in the shared file.
+  virtual void WriteTableInParallel(vtkTable* table, const char* fileName);
 
-  virtual void AppendCSVDataSet(vtkRectilinearGrid* remoteCSVOutput,
-    vtkRectilinearGrid* rectilinearGrid);
-  
-  // Usual data generation method
-  //   NOTE: rely upon superclass for these methods:
-  //      RequestData, FillInputPortInformation
-  virtual int RequestInformation(vtkInformation *, vtkInformationVector **,
-    vtkInformationVector *);
+  // Description:
+  // Gather the tables to the first process, merge them and write the
+  // result from there.
+  void WriteMergedTable(vtkTable* table, const char* fileName);
 
   vtkMultiProcessController* Controller;
   
@@ -100,6 +114,10 @@ protected:
   // The number of ghost levels to write for unstructured data.
   int GhostLevel;
 
+  int WriteAllTimeSteps;
+  int NumberOfTimeSteps;
+  int CurrentTimeIndex;
+
 private:
   vtkPCSVWriter(const vtkPCSVWriter&);  // Not implemented.
   void operator=(const vtkPCSVWriter&);  // Not implemented.
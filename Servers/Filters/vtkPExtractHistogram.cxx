@@ -16,6 +16,7 @@
 
 #include "vtkAttributeDataReductionFilter.h"
 #include "vtkCellData.h"
+#include "vtkCommunicator.h"
 #include "vtkDataSet.h"
 #include "vtkDoubleArray.h"
 #include "vtkInformation.h"
@@ -33,6 +34,7 @@
 #endif
 
 #include <vtkstd/string>
+#include <vtkstd/vector>
 #include <vtksys/RegularExpression.hxx>
 
 vtkStandardNewMacro(vtkPExtractHistogram);
@@ -197,12 +199,27 @@ int vtkPExtractHistogram::RequestData(vtkInformation *request,
     return 1;
     }
 
-  // Now we need to collect and reduce data from all nodes on the root.
+  vtkTable* output = vtkTable::GetData(outputVector, 0);
+  bool isRoot = (this->Controller->GetLocalProcessId() ==0);
+  if (this->ReduceBins(output))
+    {
+    if (isRoot)
+      {
+      this->ComputeAverages(output);
+      }
+    else
+      {
+      output->Initialize();
+      }
+    return 1;
+    }
+
+  // The histograms don't have the same layout on all processes, collect the
+  // tables and reduce them on the root.
   vtkSmartPointer<vtkReductionFilter> reduceFilter = 
     vtkSmartPointer<vtkReductionFilter>::New();
   reduceFilter->SetController(this->Controller);
 
-  bool isRoot = (this->Controller->GetLocalProcessId() ==0);
   if (isRoot)
     {
     // PostGatherHelper needs to be set only on the root node.
@@ -213,7 +230,6 @@ int vtkPExtractHistogram::RequestData(vtkInformation *request,
     reduceFilter->SetPostGatherHelper(rf);
     }
 
-  vtkTable* output = vtkTable::GetData(outputVector, 0);
   vtkSmartPointer<vtkTable> copy = vtkSmartPointer<vtkTable>::New();
   copy->ShallowCopy(output);
   reduceFilter->SetInput(copy);
@@ -226,38 +242,127 @@ int vtkPExtractHistogram::RequestData(vtkInformation *request,
       output->GetRowData()->GetArray((int)0);
     output->ShallowCopy(reduceFilter->GetOutput());
     output->GetRowData()->GetArray((int)0)->DeepCopy(oldExtents);
-    if (this->CalculateAverages)
+    this->ComputeAverages(output);
+    }
+  else
+    {
+    output->Initialize();
+    }
+
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPExtractHistogram::ReduceBins(vtkTable* output)
+{
+  // Everything but the bin_extents (the first array) and the averages, which
+  // are recomputed from the totals, is summed. Only these values are sent.
+  vtkstd::vector<vtkDataArray*> arrays;
+  vtksys::RegularExpression reg_ex("^(.*)_average$");
+  int numArrays = output->GetRowData()->GetNumberOfArrays();
+  for (int i=1; i<numArrays; i++)
+    {
+    vtkDataArray* array = output->GetRowData()->GetArray(i);
+    if (array && !(array->GetName() && reg_ex.find(array->GetName())))
+      {
+      arrays.push_back(array);
+      }
+    }
+
+  // Make sure all processes have the same arrays in the same order.
+  double signature[3] = {static_cast<double>(arrays.size()), 0.0, 0.0};
+  for (size_t cc=0; cc < arrays.size(); cc++)
+    {
+    signature[1] += static_cast<double>(arrays[cc]->GetNumberOfTuples()) *
+      arrays[cc]->GetNumberOfComponents();
+    const char* name = arrays[cc]->GetName()? arrays[cc]->GetName() : "";
+    for (int kk=0; name[kk]; kk++)
+      {
+      signature[2] += static_cast<double>(name[kk]) * (kk + 1) * (cc + 1);
+      }
+    }
+  double minSignature[3], maxSignature[3];
+  this->Controller->AllReduce(signature, minSignature, 3,
+    vtkCommunicator::MIN_OP);
+  this->Controller->AllReduce(signature, maxSignature, 3,
+    vtkCommunicator::MAX_OP);
+  if (minSignature[0] != maxSignature[0] ||
+    minSignature[1] != maxSignature[1] ||
+    minSignature[2] != maxSignature[2])
+    {
+    return false;
+    }
+
+  vtkIdType numValues = static_cast<vtkIdType>(signature[1]);
+  vtkstd::vector<double> sendBuffer(numValues + 1);
+  vtkstd::vector<double> recvBuffer(numValues + 1);
+  vtkIdType offset = 0;
+  for (size_t cc=0; cc < arrays.size(); cc++)
+    {
+    vtkIdType numTuples = arrays[cc]->GetNumberOfTuples();
+    int numComps = arrays[cc]->GetNumberOfComponents();
+    for (vtkIdType i=0; i < numTuples; i++)
+      {
+      for (int j=0; j < numComps; j++)
+        {
+        sendBuffer[offset++] = arrays[cc]->GetComponent(i, j);
+        }
+      }
+    }
+
+  this->Controller->Reduce(&sendBuffer[0], &recvBuffer[0], numValues,
+    vtkCommunicator::SUM_OP, 0);
+
+  if (this->Controller->GetLocalProcessId() == 0)
+    {
+    offset = 0;
+    for (size_t cc=0; cc < arrays.size(); cc++)
       {
-      vtkDataArray* bin_values = 
-        output->GetRowData()->GetArray("bin_values");
-      vtksys::RegularExpression reg_ex("^(.*)_average$");
-      int numArrays = output->GetRowData()->GetNumberOfArrays();
-      for (int i=0; i<numArrays; i++)
+      vtkIdType numTuples = arrays[cc]->GetNumberOfTuples();
+      int numComps = arrays[cc]->GetNumberOfComponents();
+      for (vtkIdType i=0; i < numTuples; i++)
         {
-        vtkDataArray* array = output->GetRowData()->GetArray(i);
-        if (array && reg_ex.find(array->GetName()))
+        for (int j=0; j < numComps; j++)
           {
-          int numComps = array->GetNumberOfComponents();
-          vtkstd::string name = reg_ex.match(1) + "_total";
-          vtkDataArray* tarray = output->GetRowData()->GetArray(name.c_str());
-          for (vtkIdType idx=0; idx<this->BinCount; idx++)
-            {
-            for (int j=0; j<numComps; j++)
-              {
-              array->SetComponent(idx, j,
-                tarray->GetComponent(idx, j)/bin_values->GetTuple1(idx));
-              }
-            }
+          arrays[cc]->SetComponent(i, j, recvBuffer[offset++]);
           }
         }
       }
     }
-  else
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPExtractHistogram::ComputeAverages(vtkTable* output)
+{
+  if (!this->CalculateAverages)
     {
-    output->Initialize();
+    return;
     }
 
-  return 1;
+  vtkDataArray* bin_values = 
+    output->GetRowData()->GetArray("bin_values");
+  vtksys::RegularExpression reg_ex("^(.*)_average$");
+  int numArrays = output->GetRowData()->GetNumberOfArrays();
+  for (int i=0; i<numArrays; i++)
+    {
+    vtkDataArray* array = output->GetRowData()->GetArray(i);
+    if (array && reg_ex.find(array->GetName()))
+      {
+      int numComps = array->GetNumberOfComponents();
+      vtkstd::string name = reg_ex.match(1) + "_total";
+      vtkDataArray* tarray = output->GetRowData()->GetArray(name.c_str());
+      for (vtkIdType idx=0; idx<this->BinCount; idx++)
+        {
+        double count = bin_values->GetTuple1(idx);
+        for (int j=0; j<numComps; j++)
+          {
+          array->SetComponent(idx, j,
+            count != 0.0? tarray->GetComponent(idx, j)/count : 0.0);
+          }
+        }
+      }
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -15,7 +15,7 @@
 // .NAME vtkPExtractHistogram - Extract histogram for parallel dataset.
 // .SECTION Description
 // vtkPExtractHistogram is vtkExtractHistogram subclass for parallel datasets.
-// It gathers the histogram data on the root node.
+// It reduces the histogram data on the root node.
 
 #ifndef __vtkPExtractHistogram_h
 #define __vtkPExtractHistogram_h
@@ -23,6 +23,7 @@
 #include "vtkExtractHistogram.h"
 
 class vtkMultiProcessController;
+class vtkTable;
 
 class VTK_EXPORT vtkPExtractHistogram : public vtkExtractHistogram
 {
@@ -52,6 +53,16 @@ protected:
     vtkInformationVector** inputVector, vtkDoubleArray* bin_extents,
     double& min, double& max);
 
+  // Description:
+  // Sums the bin values and totals of all processes on the root using a
+  // single reduction. Returns false, without communicating the values, if the
+  // output tables don't have the same arrays on all processes.
+  bool ReduceBins(vtkTable* output);
+
+  // Description:
+  // Computes the "*_average" arrays from the reduced "*_total" arrays.
+  void ComputeAverages(vtkTable* output);
+
   vtkMultiProcessController* Controller;
 private:
   vtkPExtractHistogram(const vtkPExtractHistogram&); // Not implemented.
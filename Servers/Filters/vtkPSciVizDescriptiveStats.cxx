@@ -1,16 +1,251 @@
 #include "vtkPSciVizDescriptiveStats.h"
 #include "vtkSciVizStatisticsPrivate.h"
 
+#include "vtkDataArray.h"
 #include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiProcessController.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPDescriptiveStatistics.h"
+#include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkVariantArray.h"
 
+#include <vtkstd/vector>
+
 vtkStandardNewMacro(vtkPSciVizDescriptiveStats);
 
+namespace
+{
+// Observations handled by each thread are visited in chunks of this size so
+// that the sampling decisions and the moment updates stay in cache.
+const vtkIdType vtkSVDSChunkSize = 4096;
+const vtkIdType vtkSVDSMinimumTuplesPerThread = 65536;
+const int vtkSVDSMomentsTag = 0x5d5;
+
+// Mergeable univariate moments (Pebay, SAND2008-6212).
+struct vtkSVDSMoments
+{
+  enum { Size = 7 };
+  double N;
+  double Min;
+  double Max;
+  double Mean;
+  double M2;
+  double M3;
+  double M4;
+
+  vtkSVDSMoments()
+    {
+    this->N = 0.;
+    this->Min = VTK_DOUBLE_MAX;
+    this->Max = -VTK_DOUBLE_MAX;
+    this->Mean = this->M2 = this->M3 = this->M4 = 0.;
+    }
+
+  void Add( double x )
+    {
+    double n1 = this->N;
+    this->N += 1.;
+    double delta = x - this->Mean;
+    double dn = delta / this->N;
+    double dn2 = dn * dn;
+    double term1 = delta * dn * n1;
+    this->Mean += dn;
+    this->M4 += term1 * dn2 * ( this->N * this->N - 3. * this->N + 3. )
+      + 6. * dn2 * this->M2 - 4. * dn * this->M3;
+    this->M3 += term1 * dn * ( this->N - 2. ) - 3. * dn * this->M2;
+    this->M2 += term1;
+    this->Min = x < this->Min ? x : this->Min;
+    this->Max = x > this->Max ? x : this->Max;
+    }
+
+  void Merge( const vtkSVDSMoments& b )
+    {
+    if ( b.N == 0. )
+      {
+      return;
+      }
+    if ( this->N == 0. )
+      {
+      *this = b;
+      return;
+      }
+    double na = this->N;
+    double nb = b.N;
+    double n = na + nb;
+    double delta = b.Mean - this->Mean;
+    double d2 = delta * delta;
+    double nanb = na * nb;
+    this->M4 += b.M4
+      + d2 * d2 * nanb * ( na * na - nanb + nb * nb ) / ( n * n * n )
+      + 6. * d2 * ( na * na * b.M2 + nb * nb * this->M2 ) / ( n * n )
+      + 4. * delta * ( na * b.M3 - nb * this->M3 ) / n;
+    this->M3 += b.M3
+      + d2 * delta * nanb * ( na - nb ) / ( n * n )
+      + 3. * delta * ( na * b.M2 - nb * this->M2 ) / n;
+    this->M2 += b.M2 + d2 * nanb / n;
+    this->Mean += delta * nb / n;
+    this->N = n;
+    this->Min = b.Min < this->Min ? b.Min : this->Min;
+    this->Max = b.Max > this->Max ? b.Max : this->Max;
+    }
+
+  void Pack( double* buf ) const
+    {
+    buf[0] = this->N;
+    buf[1] = this->Min;
+    buf[2] = this->Max;
+    buf[3] = this->Mean;
+    buf[4] = this->M2;
+    buf[5] = this->M3;
+    buf[6] = this->M4;
+    }
+
+  void Unpack( const double* buf )
+    {
+    this->N = buf[0];
+    this->Min = buf[1];
+    this->Max = buf[2];
+    this->Mean = buf[3];
+    this->M2 = buf[4];
+    this->M3 = buf[5];
+    this->M4 = buf[6];
+    }
+};
+
+struct vtkSVDSTask
+{
+  vtkstd::vector<vtkSciVizStatisticsColumn> Columns;
+  // Moments[thread][column]
+  vtkstd::vector<vtkstd::vector<vtkSVDSMoments> > Moments;
+  double SamplingFraction;
+  unsigned int Seed;
+};
+
+// Small xorshift generator, one per thread so that sampling needs no locks.
+inline unsigned int vtkSVDSRandom( unsigned int& state )
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+template <class T>
+void vtkSVDSAccumulate( const T* data, int ncomp, vtkIdType begin, vtkIdType end,
+  double fraction, unsigned int& state, vtkSVDSMoments& moments )
+{
+  const double scale = 1. / 4294967296.;
+  for ( vtkIdType chunk = begin; chunk < end; chunk += vtkSVDSChunkSize )
+    {
+    vtkIdType chunkEnd = chunk + vtkSVDSChunkSize < end ? chunk + vtkSVDSChunkSize : end;
+    const T* ptr = data + chunk * ncomp;
+    if ( fraction >= 1. )
+      {
+      for ( vtkIdType i = chunk; i < chunkEnd; ++ i, ptr += ncomp )
+        {
+        moments.Add( static_cast<double>( *ptr ) );
+        }
+      }
+    else
+      {
+      for ( vtkIdType i = chunk; i < chunkEnd; ++ i, ptr += ncomp )
+        {
+        if ( vtkSVDSRandom( state ) * scale < fraction )
+          {
+          moments.Add( static_cast<double>( *ptr ) );
+          }
+        }
+      }
+    }
+}
+
+VTK_THREAD_RETURN_TYPE vtkSVDSThread( void* arg )
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>( arg );
+  vtkSVDSTask* task = static_cast<vtkSVDSTask*>( info->UserData );
+  int tid = info->ThreadID;
+  int nthreads = info->NumberOfThreads;
+
+  size_t ncols = task->Columns.size();
+  for ( size_t c = 0; c < ncols; ++ c )
+    {
+    vtkDataArray* arr = task->Columns[c].Array;
+    int ncomp = arr->GetNumberOfComponents();
+    vtkIdType ntup = arr->GetNumberOfTuples();
+    vtkIdType begin = ( ntup * tid ) / nthreads;
+    vtkIdType end = ( ntup * ( tid + 1 ) ) / nthreads;
+    // Seed per thread and column so that results do not depend on scheduling.
+    unsigned int state = task->Seed ^ ( 2654435761U * static_cast<unsigned int>( tid + 1 ) )
+      ^ ( 40503U * static_cast<unsigned int>( c + 1 ) );
+    state = state ? state : 1;
+    vtkSVDSMoments& moments = task->Moments[tid][c];
+    void* vptr = arr->GetVoidPointer( 0 );
+    switch ( arr->GetDataType() )
+      {
+      vtkTemplateMacro(
+        vtkSVDSAccumulate( static_cast<const VTK_TT*>( vptr ) + task->Columns[c].Component,
+          ncomp, begin, end, task->SamplingFraction, state, moments ) );
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Combine the moments of all processes on every process using a binary tree
+// rooted at process 0 followed by a broadcast.
+void vtkSVDSTreeReduce( vtkMultiProcessController* controller, vtkstd::vector<vtkSVDSMoments>& moments )
+{
+  int nprocs = controller ? controller->GetNumberOfProcesses() : 1;
+  if ( nprocs < 2 || moments.empty() )
+    {
+    return;
+    }
+  int rank = controller->GetLocalProcessId();
+  vtkIdType len = static_cast<vtkIdType>( moments.size() ) * vtkSVDSMoments::Size;
+  vtkstd::vector<double> buf( len );
+  for ( int step = 1; step < nprocs; step <<= 1 )
+    {
+    if ( rank & step )
+      {
+      for ( size_t c = 0; c < moments.size(); ++ c )
+        {
+        moments[c].Pack( &buf[c * vtkSVDSMoments::Size] );
+        }
+      controller->Send( &buf[0], len, rank - step, vtkSVDSMomentsTag );
+      break;
+      }
+    if ( rank + step < nprocs )
+      {
+      controller->Receive( &buf[0], len, rank + step, vtkSVDSMomentsTag );
+      for ( size_t c = 0; c < moments.size(); ++ c )
+        {
+        vtkSVDSMoments other;
+        other.Unpack( &buf[c * vtkSVDSMoments::Size] );
+        moments[c].Merge( other );
+        }
+      }
+    }
+  if ( rank == 0 )
+    {
+    for ( size_t c = 0; c < moments.size(); ++ c )
+      {
+      moments[c].Pack( &buf[c * vtkSVDSMoments::Size] );
+      }
+    }
+  controller->Broadcast( &buf[0], len, 0 );
+  for ( size_t c = 0; c < moments.size(); ++ c )
+    {
+    moments[c].Unpack( &buf[c * vtkSVDSMoments::Size] );
+    }
+}
+}
+
 vtkPSciVizDescriptiveStats::vtkPSciVizDescriptiveStats()
 {
   this->SignedDeviations = 0;
@@ -59,6 +294,105 @@ int vtkPSciVizDescriptiveStats::FitModel( vtkDataObject* modelDO, vtkTable* trai
   return 1;
 }
 
+int vtkPSciVizDescriptiveStats::FitModelStreaming(
+  vtkDataObject* modelDO, vtkFieldData* dataAttrIn, double samplingFraction )
+{
+  vtkTable* modelOut = vtkTable::SafeDownCast( modelDO );
+  if ( ! modelOut )
+    {
+    vtkErrorMacro( "Output is not a table" );
+    return 0;
+    }
+
+  vtkIdType ntup = this->PrepareStreamingColumns( dataAttrIn );
+  if ( ntup < 0 )
+    {
+    return -1;
+    }
+  vtkSVDSTask task;
+  task.Columns = this->P->StreamingColumns;
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  int rank = controller ? controller->GetLocalProcessId() : 0;
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  vtkIdType maxThreads = ntup / vtkSVDSMinimumTuplesPerThread;
+  int nthreads = threader->GetNumberOfThreads();
+  nthreads = maxThreads < nthreads ? static_cast<int>( maxThreads ) : nthreads;
+  nthreads = nthreads < 1 ? 1 : nthreads;
+  threader->SetNumberOfThreads( nthreads );
+  task.SamplingFraction = samplingFraction;
+  task.Seed = 1013904223U * static_cast<unsigned int>( rank + 1 );
+  task.Moments.resize( nthreads, vtkstd::vector<vtkSVDSMoments>( task.Columns.size() ) );
+  threader->SetSingleMethod( ::vtkSVDSThread, &task );
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  vtkstd::vector<vtkSVDSMoments>& moments = task.Moments[0];
+  for ( int t = 1; t < nthreads; ++ t )
+    {
+    for ( size_t c = 0; c < moments.size(); ++ c )
+      {
+      moments[c].Merge( task.Moments[t][c] );
+      }
+    }
+  ::vtkSVDSTreeReduce( controller, moments );
+
+  // Build the primary model as vtkDescriptiveStatistics' learn phase would,
+  // then let the engine compute the derived statistics from it.
+  vtkTable* primary = vtkTable::New();
+  vtkStringArray* varCol = vtkStringArray::New();
+  varCol->SetName( "Variable" );
+  primary->AddColumn( varCol );
+  varCol->Delete();
+  vtkIdTypeArray* cardCol = vtkIdTypeArray::New();
+  cardCol->SetName( "Cardinality" );
+  primary->AddColumn( cardCol );
+  cardCol->Delete();
+  const char* names[] = { "Minimum", "Maximum", "Mean", "M2", "M3", "M4" };
+  vtkDoubleArray* cols[6];
+  for ( int i = 0; i < 6; ++ i )
+    {
+    cols[i] = vtkDoubleArray::New();
+    cols[i]->SetName( names[i] );
+    primary->AddColumn( cols[i] );
+    cols[i]->Delete();
+    }
+  for ( size_t c = 0; c < moments.size(); ++ c )
+    {
+    varCol->InsertNextValue( task.Columns[c].Name );
+    cardCol->InsertNextValue( static_cast<vtkIdType>( moments[c].N ) );
+    cols[0]->InsertNextValue( moments[c].Min );
+    cols[1]->InsertNextValue( moments[c].Max );
+    cols[2]->InsertNextValue( moments[c].Mean );
+    cols[3]->InsertNextValue( moments[c].M2 );
+    cols[4]->InsertNextValue( moments[c].M3 );
+    cols[5]->InsertNextValue( moments[c].M4 );
+    }
+
+  // The data input is only used for its column names; it holds no rows.
+  vtkTable* empty = vtkTable::New();
+  this->PrepareStreamingTable( empty );
+
+  vtkPDescriptiveStatistics* stats = vtkPDescriptiveStatistics::New();
+  stats->SetInput( vtkStatisticsAlgorithm::INPUT_DATA, empty );
+  stats->SetInput( vtkStatisticsAlgorithm::INPUT_MODEL, primary );
+  for ( size_t c = 0; c < task.Columns.size(); ++ c )
+    {
+    stats->SetColumnStatus( task.Columns[c].Name.c_str(), 1 );
+    }
+  stats->SetLearnOption( false );
+  stats->SetDeriveOption( true );
+  stats->SetAssessOption( false );
+  stats->Update();
+  empty->Delete();
+  primary->Delete();
+
+  modelOut->ShallowCopy( stats->GetOutput( vtkStatisticsAlgorithm::OUTPUT_MODEL ) );
+  stats->Delete();
+
+  return 1;
+}
+
 int vtkPSciVizDescriptiveStats::AssessData( vtkTable* observations, vtkDataObject* assessedOut, vtkDataObject* modelOut )
 {
   if ( ! assessedOut )
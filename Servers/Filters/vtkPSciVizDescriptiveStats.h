@@ -28,6 +28,11 @@
 // the standard deviation.
 // Thus the assessment is an array whose entries are the number of standard
 // deviations from the mean that each input point lies.
+//
+// When StreamingMode is on, the model is fit in a single pass over the
+// selected arrays without copying them into a table: each thread accumulates
+// the moments of its share of the tuples, the partial moments are merged
+// pairwise and then combined across processes along a binary tree.
 
 #ifndef __vtkPSciVizDescriptiveStats_h
 #define __vtkPSciVizDescriptiveStats_h
@@ -49,6 +54,7 @@ protected:
   virtual ~vtkPSciVizDescriptiveStats();
 
   virtual int FitModel( vtkDataObject* model, vtkTable* trainingData );
+  virtual int FitModelStreaming( vtkDataObject* model, vtkFieldData* dataAttrIn, double samplingFraction );
   virtual int AssessData( vtkTable* observations, vtkDataObject* dataset, vtkDataObject* model );
 
   int SignedDeviations;
@@ -26,6 +26,10 @@
 // The model is then a set of cluster centers.
 // Data is assessed by assigning a cluster center and distance to the
 // cluster to each point in the input data set.
+//
+// This filter ignores StreamingMode: the cluster centers are refined over
+// several passes by the learn phase of vtkPKMeansStatistics, which needs the
+// training data as a table.
 
 #ifndef __vtkPSciVizKMeans_h
 #define __vtkPSciVizKMeans_h
@@ -61,6 +61,10 @@
 // Because the diagonal must be stored for both matrices, an additional
 // row is required - hence the N+1 rows and the final entry of the column
 // named "Column". 
+//
+// When StreamingMode is on, the raw covariance data is accumulated in a
+// single pass over the selected arrays without copying them into a table,
+// and only the derive phase of the engine is run on it.
 
 #ifndef __vtkPSciVizMultiCorrelativeStats_h
 #define __vtkPSciVizMultiCorrelativeStats_h
@@ -81,6 +85,7 @@ protected:
   virtual const char* GetModelDataTypeName() { return "vtkMultiBlockDataSet"; }
 
   virtual int FitModel( vtkDataObject* model, vtkTable* trainingData );
+  virtual int FitModelStreaming( vtkDataObject* model, vtkFieldData* dataAttrIn, double samplingFraction );
   virtual int AssessData( vtkTable* observations, vtkDataObject* dataset, vtkDataObject* model );
 
 private:
@@ -58,6 +58,51 @@ int vtkPSciVizPCAStats::FitModel( vtkDataObject* modelDO, vtkTable* trainingData
   return 1;
 }
 
+int vtkPSciVizPCAStats::FitModelStreaming(
+  vtkDataObject* modelDO, vtkFieldData* dataAttrIn, double samplingFraction )
+{
+  vtkIdType ntup = this->PrepareStreamingColumns( dataAttrIn );
+  if ( ntup < 0 )
+    {
+    return -1;
+    }
+
+  // Accumulate the raw covariance data in one pass over the arrays,
+  // then let the engine derive the rest of the model from it.
+  vtkMultiBlockDataSet* primary = vtkMultiBlockDataSet::New();
+  if ( ! this->LearnCovarianceStreaming( primary, ntup, samplingFraction ) )
+    {
+    primary->Delete();
+    return 0;
+    }
+
+  // The data input is only used for its column names; it holds no rows.
+  vtkTable* empty = vtkTable::New();
+  this->PrepareStreamingTable( empty );
+
+  vtkPPCAStatistics* stats = vtkPPCAStatistics::New();
+  stats->SetInput( vtkStatisticsAlgorithm::INPUT_DATA, empty );
+  stats->SetInput( vtkStatisticsAlgorithm::INPUT_MODEL, primary );
+  vtkIdType ncols = empty->GetNumberOfColumns();
+  for ( vtkIdType i = 0; i < ncols; ++ i )
+    {
+    stats->SetColumnStatus( empty->GetColumnName( i ), 1 );
+    }
+  stats->SetNormalizationScheme( this->NormalizationScheme );
+
+  stats->SetLearnOption( false );
+  stats->SetDeriveOption( true );
+  stats->SetAssessOption( false );
+  stats->Update();
+  empty->Delete();
+  primary->Delete();
+
+  modelDO->ShallowCopy( stats->GetOutputDataObject( vtkStatisticsAlgorithm::OUTPUT_MODEL ) );
+  stats->Delete();
+
+  return 1;
+}
+
 int vtkPSciVizPCAStats::AssessData( vtkTable* observations, vtkDataObject* assessedOut, vtkDataObject* modelOut )
 {
   if ( ! assessedOut )
@@ -39,6 +39,10 @@
 // Below these entries are the eigenvalues of the covariance matrix (in the
 // column labeled "Mean") and the eigenvectors (as row vectors) in an
 // additional NxN matrix.
+//
+// When StreamingMode is on, the raw covariance table is accumulated in a
+// single pass over the selected arrays, as for the multicorrelative filter,
+// and the eigen-decomposition is derived from it.
 
 #ifndef __vtkPSciVizPCAStats_h
 #define __vtkPSciVizPCAStats_h
@@ -71,6 +75,7 @@ protected:
   virtual const char* GetModelDataTypeName() { return "vtkMultiBlockDataSet"; }
 
   virtual int FitModel( vtkDataObject* model, vtkTable* trainingData );
+  virtual int FitModelStreaming( vtkDataObject* model, vtkFieldData* dataAttrIn, double samplingFraction );
   virtual int AssessData( vtkTable* observations, vtkDataObject* dataset, vtkDataObject* model );
 
   int NormalizationScheme;
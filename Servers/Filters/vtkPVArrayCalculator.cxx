@@ -15,21 +15,527 @@
 #include "vtkPVArrayCalculator.h"
 
 #include "vtkGraph.h"
+#include "vtkPoints.h"
 #include "vtkDataSet.h"
 #include "vtkCellData.h"
+#include "vtkPointSet.h"
 #include "vtkPointData.h"
 #include "vtkDataObject.h"
+#include "vtkDoubleArray.h"
 #include "vtkInformation.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
+#include "vtkFunctionParser.h"
+#include "vtkCallbackCommand.h"
 #include "vtkInformationVector.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/vector>
 #include <vtksys/ios/sstream>
 #include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#ifndef VTK_PARSER_BEGIN_VARIABLES
+# define VTK_PARSER_BEGIN_VARIABLES VTK_PARSER_VARIABLE_VALUE_OFFSET
+#endif
+
+namespace
+{
+// Number of tuples evaluated together by one pass over the byte code.
+const vtkIdType vtkPVACBlockSize = 1024;
+// Don't spawn threads for fewer tuples than this per thread.
+const vtkIdType vtkPVACMinimumTuplesPerThread = 16 * vtkPVACBlockSize;
+// Opcode used in a vtkPVACInstruction for a variable reference.
+const int vtkPVACVariable = -1;
+
+//-----------------------------------------------------------------------------
+// Gives access to the byte code that vtkFunctionParser::Parse() produces.
+class vtkPVACParser : public vtkFunctionParser
+{
+public:
+  static vtkPVACParser* New() { return new vtkPVACParser; }
+
+  int Compile() { return this->Parse(); }
+  int GetByteCodeSize() { return this->ByteCodeSize; }
+  int GetByteCode(int i) { return static_cast<int>(this->ByteCode[i]); }
+  double GetImmediate(int i) { return this->Immediates[i]; }
+};
+
+//-----------------------------------------------------------------------------
+// A variable of the function: one or three components taken from an array,
+// or from the point coordinates of the dataset when Array is NULL.
+struct vtkPVACSource
+{
+  vtkDataArray* Array;
+  int NumberOfComponents;
+  int Components[3];
+};
+
+struct vtkPVACInstruction
+{
+  int OpCode;
+  // Index in Immediates for VTK_PARSER_IMMEDIATE, in Sources for
+  // vtkPVACVariable.
+  int Operand;
+};
+
+//-----------------------------------------------------------------------------
+template <class T>
+void vtkPVACGather(const T* data, int numComps, int comp, vtkIdType begin,
+  vtkIdType count, double* out)
+{
+  const T* ptr = data + begin * numComps + comp;
+  for (vtkIdType i = 0; i < count; ++i, ptr += numComps)
+    {
+    out[i] = static_cast<double>(*ptr);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPVACIsTypedArray(vtkDataArray* array)
+{
+  switch (array->GetDataType())
+    {
+    vtkTemplateMacro(return true);
+    }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+// The byte code of the function resolved against the input, evaluated
+// block-by-block. Each stack slot holds vtkPVACBlockSize lanes and every
+// opcode applies the exact scalar operation of vtkFunctionParser::Evaluate()
+// to all lanes, so the results match the parser bit for bit.
+class vtkPVACProgram
+{
+public:
+  vtkstd::vector<vtkPVACInstruction> Instructions;
+  vtkstd::vector<vtkPVACSource> Sources;
+  vtkstd::vector<double> Immediates;
+  vtkDataSet* DataSet;
+  double ReplacementValue;
+  int StackSize;
+  int ResultSize;
+
+  // Description:
+  // Checks the stack usage of the program and computes StackSize and
+  // ResultSize. Returns false if an opcode is not handled here.
+  bool Validate()
+    {
+    int depth = 0;
+    this->StackSize = 0;
+    for (size_t cc = 0; cc < this->Instructions.size(); ++cc)
+      {
+      const vtkPVACInstruction& inst = this->Instructions[cc];
+      int needed = 0;
+      int delta = 0;
+      switch (inst.OpCode)
+        {
+      case vtkPVACVariable:
+        delta = this->Sources[inst.Operand].NumberOfComponents;
+        break;
+      case VTK_PARSER_IMMEDIATE:
+        delta = 1;
+        break;
+      case VTK_PARSER_UNARY_MINUS:
+      case VTK_PARSER_ABSOLUTE_VALUE:
+      case VTK_PARSER_EXPONENT:
+      case VTK_PARSER_CEILING:
+      case VTK_PARSER_FLOOR:
+      case VTK_PARSER_LOGARITHME:
+      case VTK_PARSER_LOGARITHM10:
+      case VTK_PARSER_SQUARE_ROOT:
+      case VTK_PARSER_SINE:
+      case VTK_PARSER_COSINE:
+      case VTK_PARSER_TANGENT:
+      case VTK_PARSER_ARCSINE:
+      case VTK_PARSER_ARCCOSINE:
+      case VTK_PARSER_ARCTANGENT:
+      case VTK_PARSER_HYPERBOLIC_SINE:
+      case VTK_PARSER_HYPERBOLIC_COSINE:
+      case VTK_PARSER_HYPERBOLIC_TANGENT:
+        needed = 1;
+        break;
+      case VTK_PARSER_ADD:
+      case VTK_PARSER_SUBTRACT:
+      case VTK_PARSER_MULTIPLY:
+      case VTK_PARSER_DIVIDE:
+      case VTK_PARSER_POWER:
+      case VTK_PARSER_MIN:
+      case VTK_PARSER_MAX:
+        needed = 2;
+        delta = -1;
+        break;
+      case VTK_PARSER_VECTOR_UNARY_MINUS:
+      case VTK_PARSER_NORMALIZE:
+        needed = 3;
+        break;
+      case VTK_PARSER_MAGNITUDE:
+        needed = 3;
+        delta = -2;
+        break;
+      case VTK_PARSER_SCALAR_TIMES_VECTOR:
+      case VTK_PARSER_VECTOR_TIMES_SCALAR:
+        needed = 4;
+        delta = -1;
+        break;
+      case VTK_PARSER_VECTOR_ADD:
+      case VTK_PARSER_VECTOR_SUBTRACT:
+        needed = 6;
+        delta = -3;
+        break;
+      case VTK_PARSER_DOT_PRODUCT:
+        needed = 6;
+        delta = -5;
+        break;
+      case VTK_PARSER_IHAT:
+      case VTK_PARSER_JHAT:
+      case VTK_PARSER_KHAT:
+        delta = 3;
+        break;
+      default:
+        // VTK_PARSER_LOGARITHM changed meaning between VTK releases, and the
+        // remaining opcodes (cross, sign, if, comparisons...) are rarely
+        // used; leave them to vtkFunctionParser.
+        return false;
+        }
+      if (depth < needed)
+        {
+        return false;
+        }
+      depth += delta;
+      this->StackSize = vtkstd::max(this->StackSize, depth);
+      }
+    this->ResultSize = depth;
+    return (depth == 1 || depth == 3);
+    }
+
+  // Description:
+  // Copies component comp of source src for count tuples starting at begin.
+  void Gather(const vtkPVACSource& src, int comp, vtkIdType begin,
+    vtkIdType count, double* out) const
+    {
+    int component = src.Components[comp];
+    if (src.Array)
+      {
+      void* data = src.Array->GetVoidPointer(0);
+      int numComps = src.Array->GetNumberOfComponents();
+      switch (src.Array->GetDataType())
+        {
+        vtkTemplateMacro(vtkPVACGather(static_cast<VTK_TT*>(data), numComps,
+            component, begin, count, out));
+        }
+      }
+    else
+      {
+      double pt[3];
+      for (vtkIdType i = 0; i < count; ++i)
+        {
+        this->DataSet->GetPoint(begin + i, pt);
+        out[i] = pt[component];
+        }
+      }
+    }
+
+  // Description:
+  // Evaluates tuples [begin, begin+count) with count <= vtkPVACBlockSize.
+  // stack must hold StackSize * vtkPVACBlockSize values. The result is left
+  // in the first ResultSize slots.
+  void Evaluate(vtkIdType begin, vtkIdType count, double* stack) const
+    {
+    const vtkIdType B = vtkPVACBlockSize;
+    const double rep = this->ReplacementValue;
+    int sp = -1;
+    vtkIdType i;
+    for (size_t cc = 0; cc < this->Instructions.size(); ++cc)
+      {
+      const vtkPVACInstruction& inst = this->Instructions[cc];
+      double* top = stack + sp * B;
+      double* a = top - B;
+      switch (inst.OpCode)
+        {
+      case vtkPVACVariable:
+        {
+        const vtkPVACSource& src = this->Sources[inst.Operand];
+        for (int c = 0; c < src.NumberOfComponents; ++c)
+          {
+          this->Gather(src, c, begin, count, stack + (++sp) * B);
+          }
+        }
+        break;
+      case VTK_PARSER_IMMEDIATE:
+        {
+        double value = this->Immediates[inst.Operand];
+        top = stack + (++sp) * B;
+        for (i = 0; i < count; ++i) { top[i] = value; }
+        }
+        break;
+      case VTK_PARSER_UNARY_MINUS:
+        for (i = 0; i < count; ++i) { top[i] = -top[i]; }
+        break;
+      case VTK_PARSER_ADD:
+        for (i = 0; i < count; ++i) { a[i] += top[i]; }
+        sp--;
+        break;
+      case VTK_PARSER_SUBTRACT:
+        for (i = 0; i < count; ++i) { a[i] -= top[i]; }
+        sp--;
+        break;
+      case VTK_PARSER_MULTIPLY:
+        for (i = 0; i < count; ++i) { a[i] *= top[i]; }
+        sp--;
+        break;
+      case VTK_PARSER_DIVIDE:
+        for (i = 0; i < count; ++i)
+          {
+          a[i] = (top[i] == 0) ? rep : a[i] / top[i];
+          }
+        sp--;
+        break;
+      case VTK_PARSER_POWER:
+        for (i = 0; i < count; ++i) { a[i] = pow(a[i], top[i]); }
+        sp--;
+        break;
+      case VTK_PARSER_MIN:
+        for (i = 0; i < count; ++i)
+          {
+          if (top[i] < a[i]) { a[i] = top[i]; }
+          }
+        sp--;
+        break;
+      case VTK_PARSER_MAX:
+        for (i = 0; i < count; ++i)
+          {
+          if (top[i] > a[i]) { a[i] = top[i]; }
+          }
+        sp--;
+        break;
+      case VTK_PARSER_ABSOLUTE_VALUE:
+        for (i = 0; i < count; ++i) { top[i] = fabs(top[i]); }
+        break;
+      case VTK_PARSER_EXPONENT:
+        for (i = 0; i < count; ++i) { top[i] = exp(top[i]); }
+        break;
+      case VTK_PARSER_CEILING:
+        for (i = 0; i < count; ++i) { top[i] = ceil(top[i]); }
+        break;
+      case VTK_PARSER_FLOOR:
+        for (i = 0; i < count; ++i) { top[i] = floor(top[i]); }
+        break;
+      case VTK_PARSER_LOGARITHME:
+        for (i = 0; i < count; ++i)
+          {
+          top[i] = (top[i] <= 0) ? rep : log(top[i]);
+          }
+        break;
+      case VTK_PARSER_LOGARITHM10:
+        for (i = 0; i < count; ++i)
+          {
+          top[i] = (top[i] <= 0) ? rep : log10(top[i]);
+          }
+        break;
+      case VTK_PARSER_SQUARE_ROOT:
+        for (i = 0; i < count; ++i)
+          {
+          top[i] = (top[i] < 0) ? rep : sqrt(top[i]);
+          }
+        break;
+      case VTK_PARSER_SINE:
+        for (i = 0; i < count; ++i) { top[i] = sin(top[i]); }
+        break;
+      case VTK_PARSER_COSINE:
+        for (i = 0; i < count; ++i) { top[i] = cos(top[i]); }
+        break;
+      case VTK_PARSER_TANGENT:
+        for (i = 0; i < count; ++i) { top[i] = tan(top[i]); }
+        break;
+      case VTK_PARSER_ARCSINE:
+        for (i = 0; i < count; ++i)
+          {
+          top[i] = (top[i] < -1 || top[i] > 1) ? rep : asin(top[i]);
+          }
+        break;
+      case VTK_PARSER_ARCCOSINE:
+        for (i = 0; i < count; ++i)
+          {
+          top[i] = (top[i] < -1 || top[i] > 1) ? rep : acos(top[i]);
+          }
+        break;
+      case VTK_PARSER_ARCTANGENT:
+        for (i = 0; i < count; ++i) { top[i] = atan(top[i]); }
+        break;
+      case VTK_PARSER_HYPERBOLIC_SINE:
+        for (i = 0; i < count; ++i) { top[i] = sinh(top[i]); }
+        break;
+      case VTK_PARSER_HYPERBOLIC_COSINE:
+        for (i = 0; i < count; ++i) { top[i] = cosh(top[i]); }
+        break;
+      case VTK_PARSER_HYPERBOLIC_TANGENT:
+        for (i = 0; i < count; ++i) { top[i] = tanh(top[i]); }
+        break;
+      case VTK_PARSER_VECTOR_UNARY_MINUS:
+        for (int c = 0; c < 3; ++c)
+          {
+          double* u = top - c * B;
+          for (i = 0; i < count; ++i) { u[i] = -u[i]; }
+          }
+        break;
+      case VTK_PARSER_DOT_PRODUCT:
+        {
+        double* x1 = top - 5 * B;
+        double* y1 = top - 4 * B;
+        double* z1 = top - 3 * B;
+        double* x2 = top - 2 * B;
+        double* y2 = top - B;
+        for (i = 0; i < count; ++i)
+          {
+          x1[i] = x1[i] * x2[i] + y1[i] * y2[i] + z1[i] * top[i];
+          }
+        sp -= 5;
+        }
+        break;
+      case VTK_PARSER_VECTOR_ADD:
+        for (int c = 0; c < 3; ++c)
+          {
+          double* u = top - (5 - c) * B;
+          double* v = top - (2 - c) * B;
+          for (i = 0; i < count; ++i) { u[i] += v[i]; }
+          }
+        sp -= 3;
+        break;
+      case VTK_PARSER_VECTOR_SUBTRACT:
+        for (int c = 0; c < 3; ++c)
+          {
+          double* u = top - (5 - c) * B;
+          double* v = top - (2 - c) * B;
+          for (i = 0; i < count; ++i) { u[i] -= v[i]; }
+          }
+        sp -= 3;
+        break;
+      case VTK_PARSER_SCALAR_TIMES_VECTOR:
+        {
+        // The scalar sits below the vector; the product moves down one slot
+        // and overwrites the scalar, so read it first.
+        double* x = top - 3 * B;
+        double* y = top - 2 * B;
+        double* z = top - B;
+        for (i = 0; i < count; ++i)
+          {
+          double scalar = x[i];
+          x[i] = y[i] * scalar;
+          y[i] = z[i] * scalar;
+          z[i] = top[i] * scalar;
+          }
+        sp--;
+        }
+        break;
+      case VTK_PARSER_VECTOR_TIMES_SCALAR:
+        for (int c = 0; c < 3; ++c)
+          {
+          double* u = top - (3 - c) * B;
+          for (i = 0; i < count; ++i) { u[i] *= top[i]; }
+          }
+        sp--;
+        break;
+      case VTK_PARSER_MAGNITUDE:
+        {
+        double* x = top - 2 * B;
+        double* y = top - B;
+        for (i = 0; i < count; ++i)
+          {
+          x[i] = sqrt(pow(top[i], 2) + pow(y[i], 2) + pow(x[i], 2));
+          }
+        sp -= 2;
+        }
+        break;
+      case VTK_PARSER_NORMALIZE:
+        {
+        double* x = top - 2 * B;
+        double* y = top - B;
+        for (i = 0; i < count; ++i)
+          {
+          double magnitude =
+            sqrt(pow(top[i], 2) + pow(y[i], 2) + pow(x[i], 2));
+          if (magnitude != 0)
+            {
+            top[i] /= magnitude;
+            y[i] /= magnitude;
+            x[i] /= magnitude;
+            }
+          }
+        }
+        break;
+      case VTK_PARSER_IHAT:
+      case VTK_PARSER_JHAT:
+      case VTK_PARSER_KHAT:
+        for (int c = 0; c < 3; ++c)
+          {
+          double value = (inst.OpCode == VTK_PARSER_IHAT + c) ? 1.0 : 0.0;
+          top = stack + (++sp) * B;
+          for (i = 0; i < count; ++i) { top[i] = value; }
+          }
+        break;
+        }
+      }
+    }
+};
+
+//-----------------------------------------------------------------------------
+struct vtkPVACTask
+{
+  const vtkPVACProgram* Program;
+  double* Output;
+  vtkIdType NumberOfTuples;
+};
+
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPVACThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkPVACTask* task = static_cast<vtkPVACTask*>(info->UserData);
+  const vtkPVACProgram* program = task->Program;
+  const vtkIdType B = vtkPVACBlockSize;
+
+  // Split on block boundaries so that no two threads share a block.
+  vtkIdType numBlocks = (task->NumberOfTuples + B - 1) / B;
+  vtkIdType beginBlock = (numBlocks * info->ThreadID) / info->NumberOfThreads;
+  vtkIdType endBlock =
+    (numBlocks * (info->ThreadID + 1)) / info->NumberOfThreads;
+
+  vtkstd::vector<double> stack(program->StackSize * B);
+  const int numComps = program->ResultSize;
+  for (vtkIdType block = beginBlock; block < endBlock; ++block)
+    {
+    vtkIdType begin = block * B;
+    vtkIdType count = vtkstd::min(B, task->NumberOfTuples - begin);
+    program->Evaluate(begin, count, &stack[0]);
+
+    double* out = task->Output + begin * numComps;
+    if (numComps == 1)
+      {
+      memcpy(out, &stack[0], count * sizeof(double));
+      }
+    else
+      {
+      for (vtkIdType i = 0; i < count; ++i)
+        {
+        out[3 * i] = stack[i];
+        out[3 * i + 1] = stack[B + i];
+        out[3 * i + 2] = stack[2 * B + i];
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
 
 vtkStandardNewMacro( vtkPVArrayCalculator );
 // ----------------------------------------------------------------------------
 vtkPVArrayCalculator::vtkPVArrayCalculator()
 {
+  this->FastEvaluation = 1;
 }
 
 // ----------------------------------------------------------------------------
@@ -153,6 +659,15 @@ int vtkPVArrayCalculator::RequestData
     // put is the input of a (some) subsequent calculator(s) or the user changes
     // the input of a downstream calculator.
     this->UpdateArrayAndVariableNames( input, dataAttrs );
+    
+    vtkDataSet * dsOutput = vtkDataSet::SafeDownCast
+      ( outputVector->GetInformationObject( 0 )
+                    ->Get( vtkDataObject::DATA_OBJECT() ) );
+    if ( this->FastEvaluation && dsInput && dsOutput &&
+         this->FastRequestData( dsInput, dsOutput ) )
+      {
+      return 1;
+      }
     }
   
   input      = NULL;
@@ -163,8 +678,210 @@ int vtkPVArrayCalculator::RequestData
   return this->Superclass::RequestData( request, inputVector, outputVector );
 }
 
+// ----------------------------------------------------------------------------
+int vtkPVArrayCalculator::FastRequestData( vtkDataSet * input,
+                                           vtkDataSet * output )
+{
+  // Invalid values abort vtkFunctionParser::Evaluate() unless they are
+  // replaced, and coordinate results or non-double results need the
+  // superclass's output handling.
+  if ( !this->Function || !this->ResultArrayName ||
+       !this->ReplaceInvalidValues || this->CoordinateResults ||
+       this->ResultArrayType != VTK_DOUBLE )
+    {
+    return 0;
+    }
+  
+  bool usePoints;
+  vtkDataSetAttributes * inAttrs;
+  vtkIdType numTuples;
+  if ( this->AttributeMode == VTK_ATTRIBUTE_MODE_DEFAULT ||
+       this->AttributeMode == VTK_ATTRIBUTE_MODE_USE_POINT_DATA )
+    {
+    usePoints = true;
+    inAttrs   = input->GetPointData();
+    numTuples = input->GetNumberOfPoints();
+    }
+  else if ( this->AttributeMode == VTK_ATTRIBUTE_MODE_USE_CELL_DATA )
+    {
+    usePoints = false;
+    inAttrs   = input->GetCellData();
+    numTuples = input->GetNumberOfCells();
+    }
+  else
+    {
+    return 0;
+    }
+  
+  // Register the variables with a private parser in the order the superclass
+  // does, so that the variable indices in the byte code agree with it. Scalar
+  // and vector variables are numbered separately. The superclass reports
+  // missing arrays and parse errors, hence those are not printed here.
+  vtkPVACProgram program;
+  program.DataSet = input;
+  program.ReplacementValue = this->ReplacementValue;
+  
+  vtkstd::vector<vtkPVACSource> scalarSources;
+  vtkstd::vector<vtkPVACSource> vectorSources;
+  vtkPVACParser * parser = vtkPVACParser::New();
+  vtkCallbackCommand * quiet = vtkCallbackCommand::New();
+  parser->AddObserver( vtkCommand::ErrorEvent, quiet );
+  quiet->Delete();
+  parser->SetFunction( this->Function );
+  
+  bool valid = true;
+  int  i;
+  for ( i = 0; valid && i < this->NumberOfScalarArrays; i ++ )
+    {
+    vtkDataArray * array = inAttrs->GetArray( this->ScalarArrayNames[i] );
+    vtkPVACSource  src;
+    src.Array = array;
+    src.NumberOfComponents = 1;
+    src.Components[0] = this->SelectedScalarComponents[i];
+    valid = array && vtkPVACIsTypedArray( array ) &&
+            src.Components[0] < array->GetNumberOfComponents();
+    parser->SetScalarVariableValue( this->ScalarVariableNames[i], 0.0 );
+    scalarSources.push_back( src );
+    }
+  for ( i = 0; valid && i < this->NumberOfVectorArrays; i ++ )
+    {
+    vtkDataArray * array = inAttrs->GetArray( this->VectorArrayNames[i] );
+    vtkPVACSource  src;
+    src.Array = array;
+    src.NumberOfComponents = 3;
+    valid = array && vtkPVACIsTypedArray( array );
+    for ( int c = 0; c < 3; c ++ )
+      {
+      src.Components[c] = this->SelectedVectorComponents[i][c];
+      valid = valid && src.Components[c] < array->GetNumberOfComponents();
+      }
+    parser->SetVectorVariableValue( this->VectorVariableNames[i], 0, 0, 0 );
+    vectorSources.push_back( src );
+    }
+  
+  if ( valid && usePoints )
+    {
+    // Point coordinates come straight from the points array when there is
+    // one, and through vtkDataSet::GetPoint() otherwise.
+    vtkPointSet  * pointSet = vtkPointSet::SafeDownCast( input );
+    vtkDataArray * coords   = ( pointSet && pointSet->GetPoints() ) ?
+                              pointSet->GetPoints()->GetData() : NULL;
+    if ( coords && !vtkPVACIsTypedArray( coords ) )
+      {
+      valid = false;
+      }
+    else if ( !coords && numTuples > 0 )
+      {
+      // Lets structured datasets build any lazy state before the threads
+      // start calling GetPoint(). Empty datasets have no point to ask for.
+      double pt[3];
+      input->GetPoint( 0, pt );
+      }
+    for ( i = 0; valid && i < this->NumberOfCoordinateScalarArrays; i ++ )
+      {
+      vtkPVACSource src;
+      src.Array = coords;
+      src.NumberOfComponents = 1;
+      src.Components[0] = this->SelectedCoordinateScalarComponents[i];
+      parser->SetScalarVariableValue
+        ( this->CoordinateScalarVariableNames[i], 0.0 );
+      scalarSources.push_back( src );
+      }
+    for ( i = 0; valid && i < this->NumberOfCoordinateVectorArrays; i ++ )
+      {
+      vtkPVACSource src;
+      src.Array = coords;
+      src.NumberOfComponents = 3;
+      for ( int c = 0; c < 3; c ++ )
+        {
+        src.Components[c] = this->SelectedCoordinateVectorComponents[i][c];
+        }
+      parser->SetVectorVariableValue
+        ( this->CoordinateVectorVariableNames[i], 0, 0, 0 );
+      vectorSources.push_back( src );
+      }
+    }
+  
+  // Duplicate names would make a later variable overwrite an earlier one's
+  // value in the parser; leave that to the superclass.
+  valid = valid &&
+    parser->GetNumberOfScalarVariables() ==
+      static_cast<int>( scalarSources.size() ) &&
+    parser->GetNumberOfVectorVariables() ==
+      static_cast<int>( vectorSources.size() ) &&
+    parser->Compile();
+  
+  if ( valid )
+    {
+    program.Sources = scalarSources;
+    program.Sources.insert( program.Sources.end(),
+                            vectorSources.begin(), vectorSources.end() );
+    const int numVariables = static_cast<int>( program.Sources.size() );
+    int numImmediates = 0;
+    for ( i = 0; valid && i < parser->GetByteCodeSize(); i ++ )
+      {
+      vtkPVACInstruction inst;
+      inst.OpCode  = parser->GetByteCode( i );
+      inst.Operand = 0;
+      if ( inst.OpCode == VTK_PARSER_IMMEDIATE )
+        {
+        inst.Operand = numImmediates ++;
+        program.Immediates.push_back( parser->GetImmediate( inst.Operand ) );
+        }
+      else if ( inst.OpCode >= VTK_PARSER_BEGIN_VARIABLES )
+        {
+        // Vector variables are numbered after all the scalar ones, which is
+        // also how program.Sources is laid out.
+        inst.Operand = inst.OpCode - VTK_PARSER_BEGIN_VARIABLES;
+        inst.OpCode  = vtkPVACVariable;
+        valid = inst.Operand < numVariables;
+        }
+      program.Instructions.push_back( inst );
+      }
+    valid = valid && program.Validate();
+    }
+  parser->Delete();
+  
+  if ( !valid )
+    {
+    return 0;
+    }
+  
+  vtkDoubleArray * result = vtkDoubleArray::New();
+  result->SetName( this->ResultArrayName );
+  result->SetNumberOfComponents( program.ResultSize );
+  result->SetNumberOfTuples( numTuples );
+  
+  vtkPVACTask task;
+  task.Program = &program;
+  task.Output = result->GetPointer( 0 );
+  task.NumberOfTuples = numTuples;
+  
+  vtkMultiThreader * threader = vtkMultiThreader::New();
+  int maxThreads = static_cast<int>( vtkstd::max<vtkIdType>
+    ( numTuples / vtkPVACMinimumTuplesPerThread, 1 ) );
+  threader->SetNumberOfThreads
+    ( vtkstd::min( threader->GetNumberOfThreads(), maxThreads ) );
+  threader->SetSingleMethod( ::vtkPVACThread, &task );
+  threader->SingleMethodExecute();
+  threader->Delete();
+  
+  output->CopyStructure( input );
+  output->CopyAttributes( input );
+  vtkDataSetAttributes * outAttrs = usePoints ?
+    static_cast<vtkDataSetAttributes *>( output->GetPointData() ) :
+    static_cast<vtkDataSetAttributes *>( output->GetCellData() );
+  int idx = outAttrs->AddArray( result );
+  outAttrs->SetActiveAttribute( idx, program.ResultSize == 1 ?
+    vtkDataSetAttributes::SCALARS : vtkDataSetAttributes::VECTORS );
+  result->Delete();
+  
+  return 1;
+}
+
 // ----------------------------------------------------------------------------
 void vtkPVArrayCalculator::PrintSelf( ostream & os, vtkIndent indent )
 {
   this->Superclass::PrintSelf( os, indent );
+  os << indent << "FastEvaluation: " << this->FastEvaluation << endl;
 }
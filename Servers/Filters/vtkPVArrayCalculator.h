@@ -33,6 +33,7 @@
 #include "vtkArrayCalculator.h"
 
 class vtkDataObject;
+class vtkDataSet;
 class vtkDataSetAttributes;
 
 class VTK_EXPORT vtkPVArrayCalculator : public vtkArrayCalculator
@@ -43,6 +44,16 @@ public:
 
   static vtkPVArrayCalculator * New();
 
+  // Description:
+  // When on (the default), the function is compiled once into a block
+  // evaluator that works over contiguous chunks of the input arrays on
+  // several threads instead of running vtkFunctionParser tuple by tuple.
+  // Results are identical to the parser's. Functions or settings the block
+  // evaluator does not handle silently use the superclass implementation.
+  vtkSetMacro(FastEvaluation, int);
+  vtkGetMacro(FastEvaluation, int);
+  vtkBooleanMacro(FastEvaluation, int);
+
 protected:
   vtkPVArrayCalculator();
   ~vtkPVArrayCalculator();
@@ -60,6 +71,15 @@ protected:
   // RequestData() only.
   void    UpdateArrayAndVariableNames( vtkDataObject        * theInputObj, 
                                        vtkDataSetAttributes * inDataAttrs );
+
+  // Description:
+  // Evaluates the function with the block evaluator. Returns 0 without
+  // touching the output when the function or the current settings are not
+  // supported, in which case the caller falls back to the superclass.
+  int     FastRequestData( vtkDataSet * input, vtkDataSet * output );
+
+  int FastEvaluation;
+
 private:
   vtkPVArrayCalculator( const vtkPVArrayCalculator & ); // Not implemented.
   void operator = ( const vtkPVArrayCalculator & );     // Not implemented.
@@ -0,0 +1,90 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVExtractArraysOverTime.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVExtractArraysOverTime.h"
+
+#include "vtkAlgorithmOutput.h"
+#include "vtkFileSeriesReader.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiProcessController.h"
+#include "vtkObjectFactory.h"
+#include "vtkSelection.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+vtkStandardNewMacro(vtkPVExtractArraysOverTime);
+//----------------------------------------------------------------------------
+vtkPVExtractArraysOverTime::vtkPVExtractArraysOverTime()
+{
+  this->ReadFromFileSeries = 1;
+  this->Iterating = false;
+}
+
+//----------------------------------------------------------------------------
+vtkPVExtractArraysOverTime::~vtkPVExtractArraysOverTime()
+{
+}
+
+//----------------------------------------------------------------------------
+int vtkPVExtractArraysOverTime::RequestData(vtkInformation* request,
+                                            vtkInformationVector** inputVector,
+                                            vtkInformationVector* outputVector)
+{
+  // Try the reader at the start of each execution. If it cannot handle the
+  // input or selection, the superclass iterates over the time steps as usual.
+  if (!this->Iterating && this->ReadFromFileSeries &&
+    this->ReadArraysFromFileSeries(inputVector, outputVector))
+    {
+    request->Remove(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
+    return 1;
+    }
+
+  int retVal = this->Superclass::RequestData(request, inputVector,
+                                             outputVector);
+  this->Iterating = (retVal != 0) &&
+    request->Has(vtkStreamingDemandDrivenPipeline::CONTINUE_EXECUTING());
+  return retVal;
+}
+
+//----------------------------------------------------------------------------
+int vtkPVExtractArraysOverTime::ReadArraysFromFileSeries(
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkSelection* selection = vtkSelection::GetData(inputVector[1]);
+  vtkMultiBlockDataSet* output = vtkMultiBlockDataSet::GetData(outputVector);
+  if (!selection || selection->GetNumberOfNodes() != 1 || !output ||
+    this->GetNumberOfInputConnections(0) != 1)
+    {
+    return 0;
+    }
+
+  // Only a reader connected directly can skip the pipeline.
+  vtkFileSeriesReader* reader = vtkFileSeriesReader::SafeDownCast(
+    this->GetInputConnection(0, 0)->GetProducer());
+  if (!reader)
+    {
+    return 0;
+    }
+
+  return reader->ReadArraysOverTime(selection->GetNode(0),
+    vtkMultiProcessController::GetGlobalController(), output);
+}
+
+//----------------------------------------------------------------------------
+void vtkPVExtractArraysOverTime::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "ReadFromFileSeries: " << this->ReadFromFileSeries << endl;
+}
@@ -0,0 +1,74 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVExtractArraysOverTime.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkPVExtractArraysOverTime - extracts a selection over time, reading
+// the selected ids directly from file series when possible.
+// .SECTION Description
+// vtkPExtractArraysOverTime executes the upstream pipeline once per time step.
+// When the input comes straight from a vtkFileSeriesReader and the selection
+// is a single node of point or cell ids (indices or global ids), this filter
+// instead asks the reader to read the selected values of all the time steps in
+// one pass (see vtkFileSeriesReader::ReadArraysOverTime), with the time steps
+// split among the processes.  The output has the same layout as the one of the
+// superclass: a 1D grid per selected id, with a point per time step.  Any other
+// input or selection goes through the superclass.
+// .SECTION See Also
+// vtkPExtractArraysOverTime vtkFileSeriesReader
+
+#ifndef __vtkPVExtractArraysOverTime_h
+#define __vtkPVExtractArraysOverTime_h
+
+#include "vtkPExtractArraysOverTime.h"
+
+class VTK_EXPORT vtkPVExtractArraysOverTime : public vtkPExtractArraysOverTime
+{
+public:
+  static vtkPVExtractArraysOverTime* New();
+  vtkTypeMacro(vtkPVExtractArraysOverTime, vtkPExtractArraysOverTime);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // When on (the default), read the selected ids directly from the reader when
+  // the input and selection allow it.
+  vtkSetMacro(ReadFromFileSeries, int);
+  vtkGetMacro(ReadFromFileSeries, int);
+  vtkBooleanMacro(ReadFromFileSeries, int);
+
+//BTX
+protected:
+  vtkPVExtractArraysOverTime();
+  ~vtkPVExtractArraysOverTime();
+
+  virtual int RequestData(vtkInformation*,
+                          vtkInformationVector**,
+                          vtkInformationVector*);
+
+  // Description:
+  // Fills the output using vtkFileSeriesReader::ReadArraysOverTime. Returns 0
+  // if the input or selection is not supported.
+  int ReadArraysFromFileSeries(vtkInformationVector** inputVector,
+                               vtkInformationVector* outputVector);
+
+  int ReadFromFileSeries;
+
+  // True while the superclass iterates over the time steps.
+  bool Iterating;
+
+private:
+  vtkPVExtractArraysOverTime(const vtkPVExtractArraysOverTime&); // Not implemented
+  void operator=(const vtkPVExtractArraysOverTime&); // Not implemented
+//ETX
+};
+
+#endif
@@ -18,11 +18,13 @@
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataSet.h"
 #include "vtkDataObjectTypes.h"
+#include "vtkDataArray.h"
 #include "vtkDataSet.h"
 #include "vtkHierarchicalBoxDataIterator.h"
 #include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkSelection.h"
@@ -31,13 +33,264 @@
 #include "vtkTable.h"
 #include "vtkGraph.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/list>
+#include <vtkstd/map>
+#include <vtkstd/string>
 #include <vtkstd/vector>
 
+#include <math.h>
+
 class vtkPVExtractSelection::vtkSelectionNodeVector :
   public vtkstd::vector<vtkSmartPointer<vtkSelectionNode> >
 {
 };
 
+namespace
+{
+// Arrays with fewer tuples than this are scanned by a single thread.
+const vtkIdType vtkPVESMinimumTuplesPerThread = 65536;
+
+// Memory, in bytes, taken by the query indices kept by each filter. The most
+// recently used index is kept even if it is larger.
+const size_t vtkPVESMaximumIndexMemory = 256*1024*1024;
+
+// Number of components queried once that are remembered, to build their
+// index if they are queried again.
+const size_t vtkPVESMaximumQueried = 1024;
+
+//-----------------------------------------------------------------------------
+// Returns the value of a component of a tuple, or its magnitude when comp is
+// -1.
+template <class T>
+inline double vtkPVESGetValue(const T* tuple, int numComps, int comp)
+{
+  if (comp >= 0)
+    {
+    return static_cast<double>(tuple[comp]);
+    }
+  double sum = 0.0;
+  for (int cc = 0; cc < numComps; ++cc)
+    {
+    double value = static_cast<double>(tuple[cc]);
+    sum += value*value;
+    }
+  return sqrt(sum);
+}
+
+//-----------------------------------------------------------------------------
+// Appends the ids in [begin, end) whose value is inside any of the
+// [ranges[2*i], ranges[2*i+1]] intervals to matches.
+template <class T>
+void vtkPVESMatch(const T* data, int numComps, int comp,
+  vtkIdType begin, vtkIdType end, const vtkstd::vector<double>& ranges,
+  vtkstd::vector<vtkIdType>& matches)
+{
+  size_t numRanges = ranges.size()/2;
+  const T* tuple = data + begin*numComps;
+  for (vtkIdType i = begin; i < end; ++i, tuple += numComps)
+    {
+    double value = ::vtkPVESGetValue(tuple, numComps, comp);
+    for (size_t r = 0; r < numRanges; ++r)
+      {
+      if (value >= ranges[2*r] && value <= ranges[2*r+1])
+        {
+        matches.push_back(i);
+        break;
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// An element of a query index.
+struct vtkPVESIndexEntry
+{
+  double Value;
+  vtkIdType Id;
+
+  bool operator<(const vtkPVESIndexEntry& other) const
+    {
+    return this->Value < other.Value;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Fills entries with the values of a component of all tuples. NaN values
+// never match a query and are left out.
+template <class T>
+void vtkPVESFillIndex(const T* data, int numComps, int comp,
+  vtkIdType numTuples, vtkstd::vector<vtkPVESIndexEntry>& entries)
+{
+  entries.reserve(numTuples);
+  const T* tuple = data;
+  for (vtkIdType i = 0; i < numTuples; ++i, tuple += numComps)
+    {
+    vtkPVESIndexEntry entry;
+    entry.Value = ::vtkPVESGetValue(tuple, numComps, comp);
+    entry.Id = i;
+    if (entry.Value == entry.Value)
+      {
+      entries.push_back(entry);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Returns true if the array's memory can be accessed directly by the typed
+// functions above.
+bool vtkPVESIsTypedArray(vtkDataArray* array)
+{
+  switch (array->GetDataType())
+    {
+    vtkTemplateMacro(return true);
+    }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+// State shared by all threads of a scan. Each thread matches a contiguous
+// range of tuples and collects its own ids, which are concatenated in thread
+// order afterwards so that they stay sorted.
+struct vtkPVESMatchTask
+{
+  vtkDataArray* Array;
+  int Component;
+  vtkstd::vector<double> Ranges;
+  vtkstd::vector<vtkstd::vector<vtkIdType> > Matches;
+};
+
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPVESMatchThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkPVESMatchTask* task = static_cast<vtkPVESMatchTask*>(info->UserData);
+  vtkIdType numTuples = task->Array->GetNumberOfTuples();
+  vtkIdType begin = (numTuples*info->ThreadID)/info->NumberOfThreads;
+  vtkIdType end = (numTuples*(info->ThreadID+1))/info->NumberOfThreads;
+
+  void* data = task->Array->GetVoidPointer(0);
+  int numComps = task->Array->GetNumberOfComponents();
+  switch (task->Array->GetDataType())
+    {
+    vtkTemplateMacro(::vtkPVESMatch(static_cast<VTK_TT*>(data), numComps,
+        task->Component, begin, end, task->Ranges,
+        task->Matches[info->ThreadID]));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//-----------------------------------------------------------------------------
+// Sorted values of array components, most recently used first. An index is
+// identified by the array and the component, and is only valid as long as
+// the array's modification time has not changed. Arrays are never
+// dereferenced through the cache. The least recently used indices are
+// dropped when they take more than vtkPVESMaximumIndexMemory, so that the
+// arrays of all the blocks of a composite dataset can be indexed.
+// Sorting costs more than scanning the array, so an index is only built
+// when the same component is queried again before the array changes.
+class vtkPVExtractSelection::vtkQueryIndexCache
+{
+public:
+  struct vtkIndex
+    {
+    vtkDataArray* Array;
+    int Component;
+    unsigned long MTime;
+    vtkstd::vector<vtkPVESIndexEntry> Entries;
+    };
+  typedef vtkstd::list<vtkIndex> IndexList;
+  typedef vtkstd::pair<vtkDataArray*, int> IndexKey;
+  IndexList Indices;
+  vtkstd::map<IndexKey, IndexList::iterator> Lookup;
+  // Modification time of the components queried once without an index.
+  vtkstd::map<IndexKey, unsigned long> Queried;
+  size_t Memory;
+
+  vtkQueryIndexCache() : Memory(0) {}
+
+  // Returns the index of a component of the array, building it if the
+  // component was queried before. Returns NULL, and remembers the query,
+  // the first time.
+  const vtkIndex* GetIndex(vtkDataArray* array, int comp)
+    {
+    IndexKey key(array, comp);
+    vtkstd::map<IndexKey, IndexList::iterator>::iterator found =
+      this->Lookup.find(key);
+    if (found != this->Lookup.end())
+      {
+      IndexList::iterator iter = found->second;
+      if (iter->MTime == array->GetMTime())
+        {
+        this->Indices.splice(this->Indices.begin(), this->Indices, iter);
+        return &this->Indices.front();
+        }
+      this->Erase(iter);
+      }
+
+    vtkstd::map<IndexKey, unsigned long>::iterator queried =
+      this->Queried.find(key);
+    if (queried == this->Queried.end() ||
+      queried->second != array->GetMTime())
+      {
+      if (this->Queried.size() >= vtkPVESMaximumQueried)
+        {
+        this->Queried.clear();
+        }
+      this->Queried[key] = array->GetMTime();
+      return NULL;
+      }
+    this->Queried.erase(queried);
+
+    this->Indices.push_front(vtkIndex());
+    vtkIndex& index = this->Indices.front();
+    this->Lookup[key] = this->Indices.begin();
+    index.Array = array;
+    index.Component = comp;
+    index.MTime = array->GetMTime();
+    void* data = array->GetVoidPointer(0);
+    switch (array->GetDataType())
+      {
+      vtkTemplateMacro(::vtkPVESFillIndex(static_cast<VTK_TT*>(data),
+          array->GetNumberOfComponents(), comp, array->GetNumberOfTuples(),
+          index.Entries));
+      }
+    vtkstd::sort(index.Entries.begin(), index.Entries.end());
+    this->Memory += index.Entries.size()*sizeof(vtkPVESIndexEntry);
+
+    while (this->Memory > vtkPVESMaximumIndexMemory &&
+      this->Indices.size() > 1)
+      {
+      this->Erase(--this->Indices.end());
+      }
+    return &index;
+    }
+
+  void Erase(IndexList::iterator iter)
+    {
+    this->Memory -= iter->Entries.size()*sizeof(vtkPVESIndexEntry);
+    this->Lookup.erase(IndexKey(iter->Array, iter->Component));
+    this->Indices.erase(iter);
+    }
+
+  // Appends the ids of the entries with a value in [min, max] to ids.
+  static void Find(const vtkIndex& index, double min, double max,
+    vtkstd::vector<vtkIdType>& ids)
+    {
+    vtkPVESIndexEntry key;
+    key.Id = 0;
+    key.Value = min;
+    vtkstd::vector<vtkPVESIndexEntry>::const_iterator first =
+      vtkstd::lower_bound(index.Entries.begin(), index.Entries.end(), key);
+    for (; first != index.Entries.end() && first->Value <= max; ++first)
+      {
+      ids.push_back(first->Id);
+      }
+    }
+};
+
 
 vtkStandardNewMacro(vtkPVExtractSelection);
 
@@ -45,11 +298,14 @@ vtkStandardNewMacro(vtkPVExtractSelection);
 vtkPVExtractSelection::vtkPVExtractSelection()
 {
   this->SetNumberOfOutputPorts(3);
+  this->UseQueryIndex = 0;
+  this->QueryIndices = new vtkQueryIndexCache;
 }
 
 //----------------------------------------------------------------------------
 vtkPVExtractSelection::~vtkPVExtractSelection()
 {
+  delete this->QueryIndices;
 }
 
 //----------------------------------------------------------------------------
@@ -107,7 +363,30 @@ int vtkPVExtractSelection::RequestData(
   vtkInformationVector** inputVector ,
   vtkInformationVector* outputVector)
 {
-  if (!this->Superclass::RequestData(request, inputVector, outputVector))
+  // Queries that can be matched here are given to the superclass as index
+  // selections, which it extracts without looking at the arrays.
+  vtkSelection* querySel = this->ConvertQueries(
+    vtkDataObject::GetData(inputVector[0], 0),
+    vtkSelection::GetData(inputVector[1], 0));
+  int status;
+  if (querySel)
+    {
+    vtkInformation* selInfo = vtkInformation::New();
+    selInfo->Set(vtkDataObject::DATA_OBJECT(), querySel);
+    vtkInformationVector* selVector = vtkInformationVector::New();
+    selVector->Append(selInfo);
+    vtkInformationVector* queryInputVector[2] = { inputVector[0], selVector };
+    status = this->Superclass::RequestData(request, queryInputVector,
+      outputVector);
+    selVector->Delete();
+    selInfo->Delete();
+    querySel->Delete();
+    }
+  else
+    {
+    status = this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+  if (!status)
     {
     return 0;
     }
@@ -238,6 +517,268 @@ int vtkPVExtractSelection::RequestData(
   return 1;
 }
 
+//----------------------------------------------------------------------------
+vtkSelection* vtkPVExtractSelection::ConvertQueries(vtkDataObject* input,
+  vtkSelection* sel)
+{
+  if (!input || !sel)
+    {
+    return NULL;
+    }
+
+  vtkDataSet* ds = vtkDataSet::SafeDownCast(input);
+  vtkCompositeDataSet* cd = vtkCompositeDataSet::SafeDownCast(input);
+  vtkSelection* output = vtkSelection::New();
+  bool converted = false;
+  for (unsigned int cc = 0; cc < sel->GetNumberOfNodes(); ++cc)
+    {
+    vtkSelectionNode* node = sel->GetNode(cc);
+    vtkInformation* properties = node->GetProperties();
+    int contentType = node->GetContentType();
+    if ((contentType != vtkSelectionNode::THRESHOLDS &&
+        contentType != vtkSelectionNode::VALUES) ||
+      properties->Has(vtkSelectionNode::HIERARCHICAL_LEVEL()) ||
+      properties->Has(vtkSelectionNode::HIERARCHICAL_INDEX()))
+      {
+      output->AddNode(node);
+      continue;
+      }
+
+    if (ds)
+      {
+      vtkSelectionNode* queryNode = this->ConvertQuery(ds, node);
+      if (queryNode)
+        {
+        output->AddNode(queryNode);
+        queryNode->Delete();
+        converted = true;
+        }
+      else
+        {
+        output->AddNode(node);
+        }
+      continue;
+      }
+
+    if (!cd)
+      {
+      output->AddNode(node);
+      continue;
+      }
+
+    // For composite datasets, the query is converted for each block it
+    // applies to. If any block can't be converted, the query is left as is.
+    vtkSelectionNodeVector queryNodes;
+    bool supported = true;
+    vtkCompositeDataIterator* iter = cd->NewIterator();
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+      iter->GoToNextItem())
+      {
+      if (properties->Has(vtkSelectionNode::COMPOSITE_INDEX()) &&
+        static_cast<unsigned int>(properties->Get(
+            vtkSelectionNode::COMPOSITE_INDEX())) !=
+        iter->GetCurrentFlatIndex())
+        {
+        continue;
+        }
+      vtkDataSet* block = vtkDataSet::SafeDownCast(
+        iter->GetCurrentDataObject());
+      vtkSelectionNode* queryNode = block? this->ConvertQuery(block, node) :
+        NULL;
+      if (!queryNode)
+        {
+        supported = false;
+        break;
+        }
+      queryNode->GetProperties()->Set(vtkSelectionNode::COMPOSITE_INDEX(),
+        iter->GetCurrentFlatIndex());
+      queryNodes.push_back(queryNode);
+      queryNode->Delete();
+      }
+    iter->Delete();
+    if (supported)
+      {
+      for (vtkSelectionNodeVector::iterator niter = queryNodes.begin();
+        niter != queryNodes.end(); ++niter)
+        {
+        output->AddNode(niter->GetPointer());
+        }
+      converted = true;
+      }
+    else
+      {
+      output->AddNode(node);
+      }
+    }
+
+  if (!converted)
+    {
+    output->Delete();
+    return NULL;
+    }
+  return output;
+}
+
+//----------------------------------------------------------------------------
+vtkSelectionNode* vtkPVExtractSelection::ConvertQuery(vtkDataSet* input,
+  vtkSelectionNode* node)
+{
+  vtkInformation* properties = node->GetProperties();
+  int fieldType = node->GetFieldType();
+  if (fieldType != vtkSelectionNode::POINT &&
+    fieldType != vtkSelectionNode::CELL)
+    {
+    return NULL;
+    }
+  // Cells are selected from point values by a different rule than points.
+  if (fieldType == vtkSelectionNode::POINT &&
+    properties->Has(vtkSelectionNode::CONTAINING_CELLS()) &&
+    properties->Get(vtkSelectionNode::CONTAINING_CELLS()))
+    {
+    return NULL;
+    }
+
+  vtkDataArray* list = vtkDataArray::SafeDownCast(node->GetSelectionList());
+  if (!list || !list->GetName())
+    {
+    return NULL;
+    }
+
+  // Both kinds of queries are turned into a list of [min, max] ranges.
+  vtkstd::vector<double> ranges;
+  vtkIdType numValues = list->GetNumberOfTuples()*list->GetNumberOfComponents();
+  if (node->GetContentType() == vtkSelectionNode::THRESHOLDS)
+    {
+    if (numValues % 2 != 0)
+      {
+      return NULL;
+      }
+    for (vtkIdType cc = 0; cc < numValues; ++cc)
+      {
+      ranges.push_back(list->GetComponent(cc / list->GetNumberOfComponents(),
+          cc % list->GetNumberOfComponents()));
+      }
+    }
+  else
+    {
+    if (list->GetNumberOfComponents() != 1)
+      {
+      return NULL;
+      }
+    for (vtkIdType cc = 0; cc < numValues; ++cc)
+      {
+      ranges.push_back(list->GetComponent(cc, 0));
+      ranges.push_back(list->GetComponent(cc, 0));
+      }
+    }
+
+  vtkDataSetAttributes* dsa = (fieldType == vtkSelectionNode::POINT)?
+    static_cast<vtkDataSetAttributes*>(input->GetPointData()) :
+    static_cast<vtkDataSetAttributes*>(input->GetCellData());
+  vtkIdType numElements = (fieldType == vtkSelectionNode::POINT)?
+    input->GetNumberOfPoints() : input->GetNumberOfCells();
+
+  // Ids come sorted from a scan but not from the index or from overlapping
+  // id ranges.
+  vtkstd::vector<vtkIdType> ids;
+  bool sorted = true;
+  vtkstd::string name = list->GetName();
+  if (name == "vtkIndices")
+    {
+    // Thresholds on the element ids select id ranges.
+    if (node->GetContentType() != vtkSelectionNode::THRESHOLDS)
+      {
+      return NULL;
+      }
+    sorted = (ranges.size() <= 2);
+    for (size_t r = 0; r < ranges.size(); r += 2)
+      {
+      double min = vtkstd::max(ceil(ranges[r]), 0.0);
+      double max = vtkstd::min(floor(ranges[r+1]),
+        static_cast<double>(numElements-1));
+      for (vtkIdType id = static_cast<vtkIdType>(min);
+        id <= static_cast<vtkIdType>(max); ++id)
+        {
+        ids.push_back(id);
+        }
+      }
+    }
+  else
+    {
+    vtkDataArray* array = (name == "vtkGlobalIds")?
+      dsa->GetGlobalIds() : dsa->GetArray(name.c_str());
+    if (!array || array->GetNumberOfTuples() != numElements ||
+      !::vtkPVESIsTypedArray(array))
+      {
+      return NULL;
+      }
+    int numComps = array->GetNumberOfComponents();
+    int comp = (numComps > 1)? -1 : 0;
+    if (numComps > 1 && properties->Has(vtkSelectionNode::COMPONENT_NUMBER()))
+      {
+      comp = properties->Get(vtkSelectionNode::COMPONENT_NUMBER());
+      }
+    if (comp >= numComps || comp < -1 ||
+      (node->GetContentType() == vtkSelectionNode::VALUES && numComps != 1))
+      {
+      return NULL;
+      }
+
+    const vtkQueryIndexCache::vtkIndex* index = this->UseQueryIndex?
+      this->QueryIndices->GetIndex(array, comp) : NULL;
+    if (index)
+      {
+      sorted = false;
+      for (size_t r = 0; r < ranges.size(); r += 2)
+        {
+        vtkQueryIndexCache::Find(*index, ranges[r], ranges[r+1], ids);
+        }
+      }
+    else
+      {
+      vtkPVESMatchTask task;
+      task.Array = array;
+      task.Component = comp;
+      task.Ranges = ranges;
+
+      vtkMultiThreader* threader = vtkMultiThreader::New();
+      int maxThreads = static_cast<int>(vtkstd::max<vtkIdType>(
+          numElements / vtkPVESMinimumTuplesPerThread, 1));
+      int numThreads = vtkstd::min(threader->GetNumberOfThreads(), maxThreads);
+      threader->SetNumberOfThreads(numThreads);
+      task.Matches.resize(numThreads);
+      threader->SetSingleMethod(::vtkPVESMatchThread, &task);
+      threader->SingleMethodExecute();
+      threader->Delete();
+
+      for (int cc = 0; cc < numThreads; ++cc)
+        {
+        ids.insert(ids.end(), task.Matches[cc].begin(), task.Matches[cc].end());
+        }
+      }
+    }
+
+  if (!sorted)
+    {
+    vtkstd::sort(ids.begin(), ids.end());
+    ids.erase(vtkstd::unique(ids.begin(), ids.end()), ids.end());
+    }
+
+  vtkIdTypeArray* idList = vtkIdTypeArray::New();
+  idList->SetNumberOfTuples(static_cast<vtkIdType>(ids.size()));
+  if (!ids.empty())
+    {
+    vtkstd::copy(ids.begin(), ids.end(), idList->GetPointer(0));
+    }
+
+  vtkSelectionNode* output = vtkSelectionNode::New();
+  output->GetProperties()->Copy(properties, /*deep=*/1);
+  output->SetContentType(vtkSelectionNode::INDICES);
+  output->SetSelectionList(idList);
+  idList->Delete();
+  return output;
+}
+
 //----------------------------------------------------------------------------
 vtkSelectionNode* vtkPVExtractSelection::LocateSelection(unsigned int level,
   unsigned int index, vtkSelection* sel)
@@ -384,5 +925,6 @@ int vtkPVExtractSelection::GetContentType(vtkSelection* sel)
 void vtkPVExtractSelection::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
+  os << indent << "UseQueryIndex: " << this->UseQueryIndex << endl;
 }
 
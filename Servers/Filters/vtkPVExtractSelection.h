@@ -32,6 +32,15 @@
 // Output port 2 -- is simply the input vtkSelection (set on input port number
 // 1).
 //
+// Threshold and value queries on point or cell arrays, such as the ones
+// produced by vtkQuerySelectionSource, are matched by this filter itself and
+// handed to the superclass as index selections. When UseQueryIndex is on, a
+// sorted index of the queried array component is built the second time it is
+// queried and kept until the array is modified, so that later queries are
+// binary searches. The indices of all blocks of a composite input are kept,
+// up to 256 MB per filter. Otherwise the array is scanned using multiple
+// threads.
+//
 // .SECTION See Also
 // vtkExtractSelection vtkSelection
 
@@ -40,6 +49,7 @@
 
 #include "vtkExtractSelection.h"
 
+class vtkDataSet;
 class vtkSelectionNode;
 
 class VTK_EXPORT vtkPVExtractSelection : public vtkExtractSelection
@@ -57,6 +67,16 @@ public:
   void RemoveAllSelectionsInputs()
     { this->SetInputConnection(1, 0); }
 
+  // Description:
+  // When on, threshold and value queries are answered from a sorted index of
+  // the queried array component that is cached between executions. The
+  // index is only built when the component is queried again before the
+  // array changes, and takes the memory of a double and an id per element.
+  // When off, every query scans the array. Off by default.
+  vtkSetMacro(UseQueryIndex, int);
+  vtkGetMacro(UseQueryIndex, int);
+  vtkBooleanMacro(UseQueryIndex, int);
+
 //BTX
 protected:
   vtkPVExtractSelection();
@@ -78,11 +98,27 @@ protected:
     unsigned int index, vtkSelection* sel);
   vtkSelectionNode* LocateSelection(unsigned int composite_index, vtkSelection* sel);
 
+  // Description:
+  // Returns a new selection in which the threshold and value queries of sel
+  // on the arrays of input are replaced by index selections, or NULL if no
+  // node of sel could be converted.
+  vtkSelection* ConvertQueries(vtkDataObject* input, vtkSelection* sel);
+
+  // Description:
+  // Returns a new index selection node with the elements of input matched by
+  // the query node, or NULL if the query is not supported.
+  vtkSelectionNode* ConvertQuery(vtkDataSet* input, vtkSelectionNode* node);
+
+  int UseQueryIndex;
+
 private:
   vtkPVExtractSelection(const vtkPVExtractSelection&);  // Not implemented.
   void operator=(const vtkPVExtractSelection&);  // Not implemented.
 
   class vtkSelectionNodeVector;
+  class vtkQueryIndexCache;
+  vtkQueryIndexCache* QueryIndices;
+
   void RequestDataInternal(vtkSelectionNodeVector& outputs,
                            vtkDataObject* dataObjectOutput,
                            vtkSelectionNode* sel);
@@ -15,24 +15,143 @@
 #include "vtkPVGlyphFilter.h"
 
 #include "vtkAppendPolyData.h"
+#include "vtkCellArray.h"
+#include "vtkCommunicator.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataSet.h"
+#include "vtkFloatArray.h"
 #include "vtkGarbageCollector.h"
 #include "vtkHierarchicalBoxDataSet.h"
-#include "vtkCompositeDataSet.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMaskPoints.h"
 #include "vtkMath.h"
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
 #include "vtkProcessModule.h"
+#include "vtkSmartPointer.h"
 #include "vtkUniformGrid.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <vtkstd/vector>
+
+//-----------------------------------------------------------------------------
+// The selection of the points to glyph and what it was computed for.
+class vtkPVGlyphFilter::vtkInternals
+{
+public:
+  vtkInternals()
+    {
+    this->Invalidate();
+    }
+
+  void Invalidate()
+    {
+    this->Input = 0;
+    this->InputTime = 0;
+    this->MaximumNumberOfPoints = -1;
+    this->RandomMode = -1;
+    this->Piece = -1;
+    this->NumberOfPieces = -1;
+    this->GhostLevel = -1;
+    this->MaskedInput = 0;
+    this->BlockPointIds.clear();
+    }
+
+  static unsigned long GetInputTime(vtkDataObject* input)
+    {
+    unsigned long mtime = input->GetMTime();
+    unsigned long utime = input->GetUpdateTime();
+    return mtime > utime ? mtime : utime;
+    }
+
+  bool IsValid(vtkDataObject* input, vtkPVGlyphFilter* self,
+    int piece, int numPieces, int ghostLevel)
+    {
+    return this->Input == input &&
+      this->InputTime == GetInputTime(input) &&
+      this->MaximumNumberOfPoints == self->GetMaximumNumberOfPoints() &&
+      this->RandomMode == self->GetRandomMode() &&
+      this->Piece == piece && this->NumberOfPieces == numPieces &&
+      this->GhostLevel == ghostLevel;
+    }
+
+  void SetKey(vtkDataObject* input, vtkPVGlyphFilter* self,
+    int piece, int numPieces, int ghostLevel)
+    {
+    this->Input = input;
+    this->InputTime = GetInputTime(input);
+    this->MaximumNumberOfPoints = self->GetMaximumNumberOfPoints();
+    this->RandomMode = self->GetRandomMode();
+    this->Piece = piece;
+    this->NumberOfPieces = numPieces;
+    this->GhostLevel = ghostLevel;
+    }
+
+  // Only compared against, never dereferenced.
+  vtkDataObject* Input;
+  unsigned long InputTime;
+  int MaximumNumberOfPoints;
+  int RandomMode;
+  int Piece;
+  int NumberOfPieces;
+  int GhostLevel;
+
+  // The masked input, for datasets.
+  vtkSmartPointer<vtkDataSet> MaskedInput;
+
+  // The sorted ids of the points to glyph in each block, for composite
+  // datasets.
+  vtkstd::vector<vtkSmartPointer<vtkIdTypeArray> > BlockPointIds;
+};
 
 vtkStandardNewMacro(vtkPVGlyphFilter);
 
+//-----------------------------------------------------------------------------
+// Returns the number of points of ds with a ghost level above ghostLevel.
+static vtkIdType vtkPVGlyphFilterCountGhostPoints(vtkDataSet* ds,
+                                                  int ghostLevel)
+{
+  vtkUnsignedCharArray* ghostLevels = vtkUnsignedCharArray::SafeDownCast(
+    ds->GetPointData()->GetArray("vtkGhostLevels"));
+  if (!ghostLevels)
+    {
+    return 0;
+    }
+  vtkIdType numGhostPts = 0;
+  vtkIdType numPts = ghostLevels->GetNumberOfTuples();
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    if (ghostLevels->GetValue(cc) > ghostLevel)
+      {
+      ++numGhostPts;
+      }
+    }
+  return numGhostPts;
+}
+
+//-----------------------------------------------------------------------------
+// Returns 1 if the cached selection of the points to glyph is valid on all
+// processes. Rebuilding it gathers the number of points of all processes,
+// so they have to agree on it.
+static int vtkPVGlyphFilterAllValid(int valid)
+{
+  vtkMultiProcessController* controller =
+    vtkMultiProcessController::GetGlobalController();
+  if (!controller || controller->GetNumberOfProcesses() <= 1)
+    {
+    return valid;
+    }
+  int allValid = valid;
+  controller->AllReduce(&valid, &allValid, 1, vtkCommunicator::MIN_OP);
+  return allValid;
+}
+
 //-----------------------------------------------------------------------------
 vtkPVGlyphFilter::vtkPVGlyphFilter()
 {
@@ -51,6 +170,13 @@ vtkPVGlyphFilter::vtkPVGlyphFilter()
   this->BlockPointCounter = 0;
   this->BlockNumGlyphedPts = 0;
   this->BlockGlyphAllPoints=0;
+  this->BlockGhostLevels = 0;
+  this->RequestedGhostLevel = 0;
+  this->BlockPointIds = 0;
+  this->BlockPointCursor = 0;
+  this->GenerateInstances = 0;
+
+  this->Internals = new vtkInternals();
 }
 
 //-----------------------------------------------------------------------------
@@ -60,6 +186,7 @@ vtkPVGlyphFilter::~vtkPVGlyphFilter()
     {
     this->MaskPoints->Delete();
     }
+  delete this->Internals;
 }
 
 //-----------------------------------------------------------------------------
@@ -162,6 +289,8 @@ int vtkPVGlyphFilter::RequestData(
   vtkInformationVector *outputVector)
 {
   this->BlockOnRatio = 0;
+  this->RequestedGhostLevel = outputVector->GetInformationObject(0)->Get(
+    vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS());
 
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
   vtkDataObject* input = inInfo->Get(vtkDataObject::DATA_OBJECT());
@@ -190,27 +319,48 @@ int vtkPVGlyphFilter::RequestData(
     return 0;
     }
 
-  // Glyph everything? 
-  if (!this->UseMaskPoints)
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+
+  // Glyph a subset? The masked input is reused as long as the input and
+  // the masking parameters do not change.
+  vtkDataSet* glyphInput = dsInput;
+  if (this->UseMaskPoints)
+    {
+    int piece =
+      outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER());
+    int numPieces =
+      outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES());
+    int valid = (this->Internals->IsValid(dsInput, this, piece, numPieces,
+        this->RequestedGhostLevel) && this->Internals->MaskedInput)? 1 : 0;
+    if (!::vtkPVGlyphFilterAllValid(valid))
+      {
+      this->Internals->Invalidate();
+      vtkDataSet* masked = this->MaskInput(dsInput, outInfo);
+      this->Internals->MaskedInput = masked;
+      masked->Delete();
+      this->Internals->SetKey(dsInput, this, piece, numPieces,
+        this->RequestedGhostLevel);
+      }
+    glyphInput = this->Internals->MaskedInput;
+    }
+
+  if (this->GenerateInstances)
+    {
+    vtkPolyData* output = vtkPolyData::SafeDownCast(
+      outInfo->Get(vtkDataObject::DATA_OBJECT()));
+    this->ComputeInstances(glyphInput, 0, output);
+    this->BlockGlyphAllPoints= !this->UseMaskPoints;
+    return 1;
+    }
+
+  if (glyphInput == dsInput)
     {
-    // yes.
     int retVal
       = this->Superclass::RequestData(request, inputVector, outputVector);
     this->BlockGlyphAllPoints= !this->UseMaskPoints;
     return retVal;
     }
 
-  // Glyph a subset.
-  vtkIdType maxNumPts = this->MaximumNumberOfPoints;
-  vtkIdType numPts = dsInput->GetNumberOfPoints();
-  vtkIdType totalNumPts = this->GatherTotalNumberOfPoints(numPts);
-
-  // What fraction of the points will this processes get allocated?
-  maxNumPts
-    = (vtkIdType)((double)(maxNumPts)*(double)(numPts)/(double)(totalNumPts));
-
-  maxNumPts = (maxNumPts < 1) ? 1 : maxNumPts;
-
   vtkInformationVector* inputVs[2];
 
   vtkInformationVector* inputV = inputVector[0];
@@ -218,13 +368,13 @@ int vtkPVGlyphFilter::RequestData(
   inputVs[0]->SetNumberOfInformationObjects(1);
   vtkInformation* newInInfo = vtkInformation::New();
   newInInfo->Copy(inputV->GetInformationObject(0));
+  newInInfo->Set(vtkDataObject::DATA_OBJECT(), glyphInput);
   inputVs[0]->SetInformationObject(0, newInInfo);
   newInInfo->Delete();
   inputVs[1] = inputVector[1];
 
   int retVal
-    = this->MaskAndExecute(numPts, maxNumPts, dsInput,
-                           request, inputVs, outputVector);
+    = this->Superclass::RequestData(request, inputVs, outputVector);
   this->BlockGlyphAllPoints= !this->UseMaskPoints;
 
   inputVs[0]->Delete();
@@ -232,20 +382,26 @@ int vtkPVGlyphFilter::RequestData(
 }
 
 //----------------------------------------------------------------------------
-int vtkPVGlyphFilter::MaskAndExecute(vtkIdType numPts, vtkIdType maxNumPts,
-                                     vtkDataSet* input,
-                                     vtkInformation* request,
-                                     vtkInformationVector **inputVector,
-                                     vtkInformationVector *outputVector)
-
+vtkDataSet* vtkPVGlyphFilter::MaskInput(vtkDataSet* input,
+                                        vtkInformation* outInfo)
 {
+  vtkIdType maxNumPts = this->MaximumNumberOfPoints;
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType totalNumPts = this->GatherTotalNumberOfPoints(numPts);
+
+  // What fraction of the points will this processes get allocated?
+  if (totalNumPts > 0)
+    {
+    maxNumPts = (vtkIdType)
+      ((double)(maxNumPts)*(double)(numPts)/(double)(totalNumPts));
+    }
+  maxNumPts = (maxNumPts < 1) ? 1 : maxNumPts;
+
   vtkDataSet* inputCopy = input->NewInstance();
   inputCopy->ShallowCopy(input);
   this->MaskPoints->SetInput(inputCopy);
   inputCopy->Delete();
 
-  vtkInformation *outInfo = outputVector->GetInformationObject(0);
-
   this->MaskPoints->SetMaximumNumberOfPoints(maxNumPts);
   this->MaskPoints->SetOnRatio(numPts / maxNumPts);
 
@@ -263,22 +419,38 @@ int vtkPVGlyphFilter::MaskAndExecute(vtkIdType numPts, vtkIdType maxNumPts,
       vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS()));
   this->MaskPoints->Update();
 
-  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
-  inInfo->Set(vtkDataObject::DATA_OBJECT(), this->MaskPoints->GetOutput());
-
-  return this->Superclass::RequestData(request, inputVector, outputVector);
+  // vtkMaskPoints creates new arrays each time it executes, so a shallow
+  // copy of its output is not affected by later executions.
+  vtkDataSet* masked = this->MaskPoints->GetOutput()->NewInstance();
+  masked->ShallowCopy(this->MaskPoints->GetOutput());
+  return masked;
 }
 
 //----------------------------------------------------------------------------
-// We are overloading this so that blanking will be supported
-// otehrwise we could use vtkMaskPoints filter.
-int vtkPVGlyphFilter::IsPointVisible(vtkDataSet* ds, vtkIdType ptId)
+int vtkPVGlyphFilter::IsPointVisible(vtkDataSet* vtkNotUsed(ds), vtkIdType ptId)
 {
-  if (this->BlockGlyphAllPoints==1)
+  if (this->BlockGlyphAllPoints==1 || !this->BlockPointIds)
     {
     return 1;
     }
 
+  // vtkGlyph3D asks for the points in increasing order, so a cursor over
+  // the sorted ids is enough.
+  vtkIdType numIds = this->BlockPointIds->GetNumberOfTuples();
+  while (this->BlockPointCursor < numIds &&
+    this->BlockPointIds->GetValue(this->BlockPointCursor) < ptId)
+    {
+    ++this->BlockPointCursor;
+    }
+  return (this->BlockPointCursor < numIds &&
+    this->BlockPointIds->GetValue(this->BlockPointCursor) == ptId) ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+// We are doing the sampling ourselves so that blanking will be supported
+// otehrwise we could use vtkMaskPoints filter.
+int vtkPVGlyphFilter::SelectPoint(vtkDataSet* ds, vtkIdType ptId)
+{
   // check if point has been blanked. If so skip it and
   // do not count it.
   if (this->InputIsUniformGrid)
@@ -290,6 +462,13 @@ int vtkPVGlyphFilter::IsPointVisible(vtkDataSet* ds, vtkIdType ptId)
       }
     }
 
+  // Same for the ghost points vtkGlyph3D would skip.
+  if (this->BlockGhostLevels &&
+    this->BlockGhostLevels->GetValue(ptId) > this->RequestedGhostLevel)
+    {
+    return 0;
+    }
+
   // Have we glyphed enough points yet? And are we
   // at the next point? If so we'll return 1 indicating
   // that this point should be glyphed and compute the
@@ -312,11 +491,124 @@ int vtkPVGlyphFilter::IsPointVisible(vtkDataSet* ds, vtkIdType ptId)
     pointIsVisible=1;
     }
 
-  // Count all non-blanked points.
+  // Count all non-blanked, non-ghost points.
   ++this->BlockPointCounter;
   return pointIsVisible;
 }
 
+//----------------------------------------------------------------------------
+void vtkPVGlyphFilter::SelectBlockPoints(vtkCompositeDataSet* hdInput)
+{
+  this->Internals->BlockPointIds.clear();
+
+  // Get number of points we have in this block
+  // and the number of points in all blocks. The ghost points are not
+  // glyphed, so they do not count.
+  vtkIdType numPts = 0;
+  vtkCompositeDataIterator* iter = hdInput->NewIterator();
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem())
+    {
+    vtkDataSet* ds = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+    if (ds)
+      {
+      numPts += ds->GetNumberOfPoints() -
+        vtkPVGlyphFilterCountGhostPoints(ds, this->RequestedGhostLevel);
+      }
+    }
+  vtkIdType totalNumPts = this->GatherTotalNumberOfPoints(numPts);
+
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem())
+    {
+    vtkDataSet* ds = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+    if (!ds)
+      {
+      continue;
+      }
+
+    // Uniform grids might be blanked, we make a note if we 
+    // have a uniform grid to facilitate blanking friendly
+    // glyph sampling.
+    this->InputIsUniformGrid = ds->IsA("vtkUniformGrid") ? 1 : 0;
+    this->BlockGhostLevels = vtkUnsignedCharArray::SafeDownCast(
+      ds->GetPointData()->GetArray("vtkGhostLevels"));
+
+    // Certain AMR data sets provide blanking information
+    // We will skip blanked points and glyph what's
+    // left if any.
+    vtkIdType numBlankedPts = 0;
+    vtkInformation* blockInfo = iter->GetCurrentMetaData();
+    if (blockInfo)
+      {
+      if
+      (blockInfo->Has(vtkHierarchicalBoxDataSet::NUMBER_OF_BLANKED_POINTS()))
+        {
+        numBlankedPts
+          = blockInfo->Get(vtkHierarchicalBoxDataSet::NUMBER_OF_BLANKED_POINTS());
+        }
+      }
+
+    // When masking points we evenly sample, skipping a fixed number
+    // in between each glyph or we vary our stride randomly between
+    // 1 and 2*stride-1. This is *not* a random sampling of the points
+    double nPtsNotBlanked = static_cast<double>(ds->GetNumberOfPoints() -
+      numBlankedPts -
+      vtkPVGlyphFilterCountGhostPoints(ds, this->RequestedGhostLevel));
+    if (nPtsNotBlanked <= 0.0)
+      {
+      // Nothing to glyph in this block, e.g. only ghost points.
+      this->Internals->BlockPointIds.push_back(
+        vtkSmartPointer<vtkIdTypeArray>::New());
+      continue;
+      }
+    double nPtsVisibleOverAll
+      = static_cast<double>(this->MaximumNumberOfPoints);
+    double nPtsInDataSet
+      = static_cast<double>(totalNumPts);
+    double fractionOfPtsInBlock = nPtsNotBlanked/nPtsInDataSet;
+    double nPtsVisibleOverBlock = nPtsVisibleOverAll*fractionOfPtsInBlock;
+    nPtsVisibleOverBlock 
+      = nPtsVisibleOverBlock<1.0 ? 1.0 : nPtsVisibleOverBlock;
+    nPtsVisibleOverBlock = (  (nPtsVisibleOverBlock > nPtsNotBlanked)
+                            ? nPtsNotBlanked : nPtsVisibleOverBlock );
+    double stride = nPtsNotBlanked/nPtsVisibleOverBlock;
+    this->BlockSampleStride=static_cast<vtkIdType>(stride+0.5);
+    // We will glyph this many points.
+    this->BlockMaxNumPts = static_cast<vtkIdType>(nPtsVisibleOverBlock);
+    //
+    this->BlockPointCounter = 0;
+    this->BlockNumGlyphedPts = 0;
+    // Identify the first point to glyph.
+    if (this->RandomMode)
+      {
+      double r
+        = vtkMath::Random(0.0,this->BlockSampleStride-1.0);
+      this->BlockNextPoint=static_cast<vtkIdType>(r+0.5);
+      }
+    else
+      {
+      this->BlockNextPoint=0;
+      }
+
+    vtkSmartPointer<vtkIdTypeArray> ids =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+    ids->Allocate(this->BlockMaxNumPts);
+    vtkIdType numBlockPts = ds->GetNumberOfPoints();
+    for (vtkIdType ptId = 0; ptId < numBlockPts &&
+      this->BlockNumGlyphedPts < this->BlockMaxNumPts; ++ptId)
+      {
+      if (this->SelectPoint(ds, ptId))
+        {
+        ids->InsertNextValue(ptId);
+        }
+      }
+    this->Internals->BlockPointIds.push_back(ids);
+    }
+  iter->Delete();
+  this->BlockGhostLevels = 0;
+}
+
 //----------------------------------------------------------------------------
 int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
                                            vtkInformationVector** inputVector,
@@ -343,10 +635,24 @@ int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
     return 0;
     }
 
-  // Get number of points we have in this block
-  // and the number of points in all blocks.
-  vtkIdType numPts = hdInput->GetNumberOfPoints();
-  vtkIdType totalNumPts = this->GatherTotalNumberOfPoints(numPts);
+  // Select the points to glyph in every block, unless the selection made
+  // for the same input and masking parameters is still around.
+  if (this->UseMaskPoints)
+    {
+    int piece =
+      info->Get(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER());
+    int numPieces =
+      info->Get(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES());
+    int valid = (this->Internals->IsValid(hdInput, this, piece, numPieces,
+        this->RequestedGhostLevel) && !this->Internals->MaskedInput)? 1 : 0;
+    if (!::vtkPVGlyphFilterAllValid(valid))
+      {
+      this->Internals->Invalidate();
+      this->SelectBlockPoints(hdInput);
+      this->Internals->SetKey(hdInput, this, piece, numPieces,
+        this->RequestedGhostLevel);
+      }
+    }
 
   vtkAppendPolyData* append = vtkAppendPolyData::New();
   int numInputs = 0;
@@ -363,7 +669,7 @@ int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
   inputVs[1] = inputVector[1];
 
   int retVal = 1;
-  this->InputIsUniformGrid = 0;
+  size_t blockIndex = 0;
 
   vtkCompositeDataIterator* iter = hdInput->NewIterator();
 
@@ -374,81 +680,32 @@ int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
       {
       vtkPolyData* tmpOut = vtkPolyData::New();
 
-      // Uniform grids might be blanked, we make a note if we 
-      // have a uniform grid to facilitate blanking friendly
-      // glyph sampling.
-      if (ds->IsA("vtkUniformGrid"))
-        {
-        this->InputIsUniformGrid = 1;
-        }
-      else
-        {
-        this->InputIsUniformGrid = 0;
-        }
-
-      // Certain AMR data sets provide blanking information
-      // We will skip blanked points and glyph what's
-      // left if any.
-      vtkIdType numBlankedPts = 0;
-      vtkInformation* blockInfo = iter->GetCurrentMetaData();
-      if (blockInfo)
+      // Points of this block selected by SelectBlockPoints(), all the
+      // points when not masking.
+      this->BlockPointIds = 0;
+      if (this->UseMaskPoints &&
+        blockIndex < this->Internals->BlockPointIds.size())
         {
-        if
-        (blockInfo->Has(vtkHierarchicalBoxDataSet::NUMBER_OF_BLANKED_POINTS()))
-          {
-          numBlankedPts
-            = blockInfo->Get(vtkHierarchicalBoxDataSet::NUMBER_OF_BLANKED_POINTS());
-          }
+        this->BlockPointIds = this->Internals->BlockPointIds[blockIndex];
         }
+      ++blockIndex;
+      this->BlockPointCursor = 0;
+      this->BlockGlyphAllPoints = this->BlockPointIds ? 0 : 1;
 
-      // When masking points we evenly sample, skipping a fixed number
-      // in between each glyph or we vary our stride randomly between
-      // 1 and 2*stride-1. This is *not* a random sampling of the points
-      double nPtsNotBlanked
-        = static_cast<double>(ds->GetNumberOfPoints() - numBlankedPts);
-      double nPtsVisibleOverAll
-        = static_cast<double>(this->MaximumNumberOfPoints);
-      double nPtsInDataSet
-        = static_cast<double>(totalNumPts);
-      double fractionOfPtsInBlock = nPtsNotBlanked/nPtsInDataSet;
-      double nPtsVisibleOverBlock = nPtsVisibleOverAll*fractionOfPtsInBlock;
-      nPtsVisibleOverBlock 
-        = nPtsVisibleOverBlock<1.0 ? 1.0 : nPtsVisibleOverBlock;
-      nPtsVisibleOverBlock = (  (nPtsVisibleOverBlock > nPtsNotBlanked)
-                              ? nPtsNotBlanked : nPtsVisibleOverBlock );
-      double stride = nPtsNotBlanked/nPtsVisibleOverBlock;
-      if (this->UseMaskPoints)
+      if (this->GenerateInstances)
         {
-        this->BlockSampleStride=static_cast<vtkIdType>(stride+0.5);
+        this->ComputeInstances(ds, this->BlockPointIds, tmpOut);
         }
       else
         {
-        this->BlockSampleStride=1;
+        // We have set all ofthe parameters that will be used in 
+        // our overloaded IsPoitVisible. Now let the glypher take over.
+        newInInfo->Set(vtkDataObject::DATA_OBJECT(), ds);
+        retVal =
+          this->Superclass::RequestData(request, inputVs, outputVector);
+        // Accumulate the results.
+        tmpOut->ShallowCopy(output);
         }
-      // We will glyph this many points.
-      this->BlockMaxNumPts = static_cast<vtkIdType>(nPtsVisibleOverBlock);
-      //
-      this->BlockPointCounter = 0;
-      this->BlockNumGlyphedPts = 0;
-      // Identify the first point to glyph.
-      if (this->MaskPoints->GetRandomMode())
-        {
-        double r
-          = vtkMath::Random(0.0,this->BlockSampleStride-1.0);
-        this->BlockNextPoint=static_cast<vtkIdType>(r+0.5);
-        }
-      else
-        {
-        this->BlockNextPoint=0;
-        }
-
-      // We have set all ofthe parameters that will be used in 
-      // our overloaded IsPoitVisible. Now let the glypher take over.
-      newInInfo->Set(vtkDataObject::DATA_OBJECT(), ds);
-      retVal =
-        this->Superclass::RequestData(request, inputVs, outputVector);
-      // Accumulate the results.
-      tmpOut->ShallowCopy(output);
       append->AddInput(tmpOut);
 
       // Call FastDelete() instead of Delete() to avoid garbage
@@ -459,6 +716,8 @@ int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
       if (!retVal)
         {
         vtkErrorMacro("vtkGlyph3D failed.");
+        this->BlockPointIds = 0;
+        this->BlockGlyphAllPoints= !this->UseMaskPoints;
         iter->Delete();
         inputVs[0]->Delete();
         append->Delete();
@@ -468,6 +727,8 @@ int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
       }
     iter->GoToNextItem();
     }
+  this->BlockPointIds = 0;
+  this->BlockGlyphAllPoints= !this->UseMaskPoints;
 
   // copy the accumulated results to the output.
   if (numInputs > 0)
@@ -484,6 +745,136 @@ int vtkPVGlyphFilter::RequestCompositeData(vtkInformation* request,
   return retVal;
 }
 
+//----------------------------------------------------------------------------
+void vtkPVGlyphFilter::ComputeInstances(vtkDataSet* input,
+                                        vtkIdTypeArray* ids,
+                                        vtkPolyData* output)
+{
+  output->Initialize();
+
+  vtkPointData* inPD = input->GetPointData();
+  vtkPointData* outPD = output->GetPointData();
+  vtkDataArray* inScalars = this->GetInputArrayToProcess(0, input);
+  vtkDataArray* inVectors = this->GetInputArrayToProcess(1, input);
+  vtkDataArray* inNormals = this->GetInputArrayToProcess(2, input);
+  vtkUnsignedCharArray* inGhostLevels = vtkUnsignedCharArray::SafeDownCast(
+    inPD->GetArray("vtkGhostLevels"));
+
+  // Same choice of vector as vtkGlyph3D.
+  vtkDataArray* inDirections =
+    (this->VectorMode == VTK_USE_NORMAL && inNormals) ? inNormals : inVectors;
+  if (inDirections && inDirections->GetNumberOfComponents() != 3)
+    {
+    inDirections = 0;
+    }
+
+  vtkIdType numPts = ids ? ids->GetNumberOfTuples() :
+    input->GetNumberOfPoints();
+
+  vtkPoints* newPts = vtkPoints::New();
+  newPts->Allocate(numPts);
+  vtkCellArray* newVerts = vtkCellArray::New();
+  newVerts->Allocate(newVerts->EstimateSize(numPts, 1));
+  outPD->CopyAllocate(inPD, numPts);
+
+  vtkFloatArray* scales = vtkFloatArray::New();
+  scales->SetName("GlyphScale");
+  scales->SetNumberOfComponents(3);
+  scales->Allocate(3*numPts);
+
+  vtkFloatArray* orientations = 0;
+  if (this->Orient && this->VectorMode != VTK_VECTOR_ROTATION_OFF &&
+    inDirections)
+    {
+    orientations = vtkFloatArray::New();
+    orientations->SetName("GlyphOrientation");
+    orientations->SetNumberOfComponents(3);
+    orientations->Allocate(3*numPts);
+    }
+
+  double den = this->Range[1] - this->Range[0];
+  if (den == 0.0)
+    {
+    den = 1.0;
+    }
+
+  for (vtkIdType cc = 0; cc < numPts; ++cc)
+    {
+    vtkIdType ptId = ids ? ids->GetValue(cc) : cc;
+    if (inGhostLevels &&
+      inGhostLevels->GetValue(ptId) > this->RequestedGhostLevel)
+      {
+      continue;
+      }
+
+    double v[3] = { 0.0, 0.0, 0.0 };
+    if (inDirections)
+      {
+      inDirections->GetTuple(ptId, v);
+      }
+
+    double scale[3] = { 1.0, 1.0, 1.0 };
+    if (this->Scaling)
+      {
+      if (this->ScaleMode == VTK_SCALE_BY_SCALAR && inScalars)
+        {
+        scale[0] = scale[1] = scale[2] = inScalars->GetComponent(ptId, 0);
+        }
+      else if (this->ScaleMode == VTK_SCALE_BY_VECTOR && inDirections)
+        {
+        scale[0] = scale[1] = scale[2] = vtkMath::Norm(v);
+        }
+      else if (this->ScaleMode == VTK_SCALE_BY_VECTORCOMPONENTS &&
+        inDirections)
+        {
+        scale[0] = v[0];
+        scale[1] = v[1];
+        scale[2] = v[2];
+        }
+      for (int comp = 0; comp < 3; ++comp)
+        {
+        if (this->ScaleMode == VTK_DATA_SCALING_OFF)
+          {
+          scale[comp] = 1.0;
+          }
+        else if (this->Clamping)
+          {
+          scale[comp] = (scale[comp] < this->Range[0] ? this->Range[0] :
+            (scale[comp] > this->Range[1] ? this->Range[1] : scale[comp]));
+          scale[comp] = (scale[comp] - this->Range[0]) / den;
+          }
+        scale[comp] *= this->ScaleFactor;
+        if (scale[comp] == 0.0)
+          {
+          scale[comp] = 1.0e-10;
+          }
+        }
+      }
+
+    vtkIdType newId = newPts->InsertNextPoint(input->GetPoint(ptId));
+    newVerts->InsertNextCell(1, &newId);
+    outPD->CopyData(inPD, ptId, newId);
+    scales->InsertNextTuple(scale);
+    if (orientations)
+      {
+      orientations->InsertNextTuple(v);
+      }
+    }
+
+  output->SetPoints(newPts);
+  newPts->Delete();
+  output->SetVerts(newVerts);
+  newVerts->Delete();
+  outPD->AddArray(scales);
+  scales->Delete();
+  if (orientations)
+    {
+    outPD->AddArray(orientations);
+    orientations->Delete();
+    }
+  output->Squeeze();
+}
+
 //-----------------------------------------------------------------------------
 void vtkPVGlyphFilter::ReportReferences(vtkGarbageCollector* collector)
 {
@@ -502,4 +893,7 @@ void vtkPVGlyphFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "UseMaskPoints: " << (this->UseMaskPoints?"on":"off") << endl;
 
   os << indent << "NumberOfProcesses: " << this->NumberOfProcesses << endl;
+
+  os << indent << "GenerateInstances: "
+     << (this->GenerateInstances?"on":"off") << endl;
 }
@@ -16,13 +16,35 @@
 //
 // .SECTION Description
 // This is a subclass of vtkGlyph3D that allows selection of input scalars
+//
+// The points to glyph (see UseMaskPoints) are selected once and cached; the
+// selection is only redone when the input, the piece or ghost level
+// requested or one of UseMaskPoints, MaximumNumberOfPoints and RandomMode
+// changes. Changing how the glyphs look, e.g. the scale factor, reuses the
+// cached selection. In parallel the selection is collective, and since all
+// processes see the same parameters and re-execute their inputs together
+// they agree on whether the cache is valid.
+//
+// When GenerateInstances is on, no glyph geometry is generated. The output
+// holds one vertex per selected point, the point data of the input and two
+// arrays describing the glyph transform of each point: "GlyphScale" (3
+// components, computed following the vtkGlyph3D scaling rules) and, when
+// Orient is on, "GlyphOrientation". A vtkGlyph3DMapper can render the source
+// glyph at each point from these arrays.
+//
+// As in vtkGlyph3D, the points whose ghost level is above the requested
+// ghost level are never glyphed, and they do not count toward
+// MaximumNumberOfPoints.
 
 #ifndef __vtkPVGlyphFilter_h
 #define __vtkPVGlyphFilter_h
 
 #include "vtkGlyph3D.h"
 
+class vtkCompositeDataSet;
+class vtkIdTypeArray;
 class vtkMaskPoints;
+class vtkUnsignedCharArray;
 
 class VTK_EXPORT vtkPVGlyphFilter : public vtkGlyph3D
 {
@@ -53,9 +75,16 @@ public:
   int GetRandomMode();
 
   // Description:
-  // In processing composite datasets, will check if a point
-  // is visible as long as the dataset being process if a
-  // vtkUniformGrid.
+  // When on, output the selected points with their glyph scale and
+  // orientation instead of the glyph geometry. Default is off.
+  vtkSetMacro(GenerateInstances, int);
+  vtkGetMacro(GenerateInstances, int);
+  vtkBooleanMacro(GenerateInstances, int);
+
+  // Description:
+  // In processing composite datasets, returns whether the point is part of
+  // the cached selection of the block being glyphed. Points are expected
+  // in increasing order.
   virtual int IsPointVisible(vtkDataSet* ds, vtkIdType ptId);
 
 protected:
@@ -76,11 +105,28 @@ protected:
   
   vtkIdType GatherTotalNumberOfPoints(vtkIdType localNumPts);
 
-  int MaskAndExecute(vtkIdType numPts, vtkIdType maxNumPts,
-                     vtkDataSet* input,
-                     vtkInformation* request,
-                     vtkInformationVector** inputVector,
-                     vtkInformationVector* outputVector);
+  // Description:
+  // Runs vtkMaskPoints on the input and returns a new dataset with the
+  // masked points.
+  vtkDataSet* MaskInput(vtkDataSet* input, vtkInformation* outInfo);
+
+  // Description:
+  // Selects the points to glyph in each block of the input and stores
+  // their ids in the cache.
+  void SelectBlockPoints(vtkCompositeDataSet* input);
+
+  // Description:
+  // Returns whether the point should be glyphed, using the Block* sampling
+  // parameters. Blanked points and ghost points above RequestedGhostLevel
+  // are skipped and not counted. Used by SelectBlockPoints.
+  int SelectPoint(vtkDataSet* ds, vtkIdType ptId);
+
+  // Description:
+  // Fills output with a vertex, the point data and the glyph transform
+  // arrays for each point of input listed in ids, or for each point when
+  // ids is NULL.
+  void ComputeInstances(vtkDataSet* input, vtkIdTypeArray* ids,
+                        vtkPolyData* output);
 
   vtkMaskPoints *MaskPoints;
   int MaximumNumberOfPoints;
@@ -96,12 +142,28 @@ protected:
   vtkIdType BlockNextPoint;
   vtkIdType BlockNumGlyphedPts;
 
+  // The ghost levels of the block SelectPoint is sampling, if any.
+  vtkUnsignedCharArray* BlockGhostLevels;
+
+  // Ghost level requested downstream; points above it are not glyphed.
+  int RequestedGhostLevel;
+
+  // Replay of the cached selection of the current block.
+  vtkIdTypeArray* BlockPointIds;
+  vtkIdType BlockPointCursor;
+
   int RandomMode;
+  int GenerateInstances;
 
   virtual void ReportReferences(vtkGarbageCollector*);
 private:
   vtkPVGlyphFilter(const vtkPVGlyphFilter&);  // Not implemented.
   void operator=(const vtkPVGlyphFilter&);  // Not implemented.
+
+//BTX
+  class vtkInternals;
+  vtkInternals* Internals;
+//ETX
 };
 
 #endif
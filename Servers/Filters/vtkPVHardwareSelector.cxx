@@ -14,9 +14,123 @@
 =========================================================================*/
 #include "vtkPVHardwareSelector.h"
 
+#include "vtkDataObject.h"
+#include "vtkIdTypeArray.h"
+#include "vtkInformation.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkProcessModule.h"
 #include "vtkProp.h"
+#include "vtkSelection.h"
+#include "vtkSelectionNode.h"
+
+#include <vtkstd/algorithm>
+#include <vtkstd/map>
+#include <vtkstd/utility>
+#include <vtkstd/vector>
+#include <vtksys/hash_set.hxx>
+
+namespace
+{
+// Areas with fewer pixels than this are decoded by a single thread.
+const vtkIdType vtkPVHSMinimumPixelsPerThread = 65536;
+
+struct vtkPVHSIdHash
+{
+  size_t operator()(vtkIdType id) const
+    {
+    return static_cast<size_t>(id);
+    }
+};
+
+typedef vtksys::hash_set<vtkIdType, vtkPVHSIdHash> vtkPVHSIdSet;
+
+// Ids hit for each (process id, prop id) pair.
+typedef vtkstd::map<vtkstd::pair<int, int>, vtkPVHSIdSet> vtkPVHSHits;
+
+//----------------------------------------------------------------------------
+// Returns the value encoded in the color of a pixel, or 0 if the pass was not
+// rendered.
+inline int vtkPVHSDecode(const unsigned char* buffer, vtkIdType pixel)
+{
+  if (!buffer)
+    {
+    return 0;
+    }
+  const unsigned char* rgb = buffer + 3*pixel;
+  return static_cast<int>(rgb[0]) | (static_cast<int>(rgb[1]) << 8) |
+    (static_cast<int>(rgb[2]) << 16);
+}
+
+//----------------------------------------------------------------------------
+// State shared by all threads. Each thread decodes a band of rows and
+// collects its own hits, which are merged afterwards.
+struct vtkPVHSTask
+{
+  const unsigned char* ProcessBuffer;
+  const unsigned char* ActorBuffer;
+  const unsigned char* Low24Buffer;
+  const unsigned char* Mid24Buffer;
+  const unsigned char* High16Buffer;
+  vtkIdType Width;
+  vtkIdType Height;
+  vtkstd::vector<vtkPVHSHits> Hits;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPVHSDecodeThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkPVHSTask* task = static_cast<vtkPVHSTask*>(info->UserData);
+  vtkIdType beginRow = (task->Height*info->ThreadID)/info->NumberOfThreads;
+  vtkIdType endRow = (task->Height*(info->ThreadID+1))/info->NumberOfThreads;
+  vtkPVHSHits& hits = task->Hits[info->ThreadID];
+
+  // Neighboring pixels usually show the same cell, so the last key and id
+  // are remembered to skip most of the hash lookups.
+  vtkstd::pair<int, int> lastKey(-1, -1);
+  vtkPVHSIdSet* lastIds = 0;
+  vtkIdType lastId = -1;
+  for (vtkIdType pixel = beginRow*task->Width; pixel < endRow*task->Width;
+    ++pixel)
+    {
+    // Ids 0 are reserved for the background.
+    int actorId = ::vtkPVHSDecode(task->ActorBuffer, pixel);
+    if (actorId <= 0)
+      {
+      continue;
+      }
+    vtkTypeInt64 id =
+      (static_cast<vtkTypeInt64>(
+          ::vtkPVHSDecode(task->High16Buffer, pixel)) << 48) |
+      (static_cast<vtkTypeInt64>(
+          ::vtkPVHSDecode(task->Mid24Buffer, pixel)) << 24) |
+      static_cast<vtkTypeInt64>(::vtkPVHSDecode(task->Low24Buffer, pixel));
+    if (--id < 0)
+      {
+      continue;
+      }
+    // Without the process pass the process is unknown (-1), as in
+    // vtkHardwareSelector.
+    int processId = ::vtkPVHSDecode(task->ProcessBuffer, pixel) - 1;
+
+    vtkstd::pair<int, int> key(processId, actorId - 1);
+    if (!lastIds || key != lastKey)
+      {
+      lastIds = &hits[key];
+      lastKey = key;
+      lastId = -1;
+      }
+    if (id != lastId)
+      {
+      lastIds->insert(static_cast<vtkIdType>(id));
+      lastId = static_cast<vtkIdType>(id);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
 
 vtkStandardNewMacro(vtkPVHardwareSelector);
 //----------------------------------------------------------------------------
@@ -54,6 +168,96 @@ bool vtkPVHardwareSelector::PassRequired(int pass)
   return true;
 }
 
+//----------------------------------------------------------------------------
+vtkSelection* vtkPVHardwareSelector::Select()
+{
+  vtkSelection* sel = 0;
+  if (this->CaptureBuffers())
+    {
+    sel = this->GenerateSelectionInParallel();
+    this->ReleasePixBuffers();
+    }
+  return sel;
+}
+
+//----------------------------------------------------------------------------
+vtkSelection* vtkPVHardwareSelector::GenerateSelectionInParallel()
+{
+  vtkPVHSTask task;
+  task.ProcessBuffer = this->PixBuffer[PROCESS_PASS];
+  task.ActorBuffer = this->PixBuffer[ACTOR_PASS];
+  task.Low24Buffer = this->PixBuffer[ID_LOW24];
+  task.Mid24Buffer = this->PixBuffer[ID_MID24];
+  task.High16Buffer = this->PixBuffer[ID_HIGH16];
+  task.Width = static_cast<vtkIdType>(this->Area[2] - this->Area[0] + 1);
+  task.Height = static_cast<vtkIdType>(this->Area[3] - this->Area[1] + 1);
+
+  vtkSelection* sel = vtkSelection::New();
+  if (!task.ActorBuffer)
+    {
+    return sel;
+    }
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  int maxThreads = static_cast<int>(vtkstd::max<vtkIdType>(
+      (task.Width*task.Height) / vtkPVHSMinimumPixelsPerThread, 1));
+  int numThreads = vtkstd::min(
+    vtkstd::min(threader->GetNumberOfThreads(), maxThreads),
+    static_cast<int>(task.Height));
+  numThreads = vtkstd::max(numThreads, 1);
+  threader->SetNumberOfThreads(numThreads);
+  task.Hits.resize(numThreads);
+  threader->SetSingleMethod(::vtkPVHSDecodeThread, &task);
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  // Merge the hits of the threads into the largest set for each key.
+  vtkPVHSHits& merged = task.Hits[0];
+  for (int cc = 1; cc < numThreads; ++cc)
+    {
+    for (vtkPVHSHits::iterator iter = task.Hits[cc].begin();
+      iter != task.Hits[cc].end(); ++iter)
+      {
+      vtkPVHSIdSet& ids = merged[iter->first];
+      if (ids.size() < iter->second.size())
+        {
+        ids.swap(iter->second);
+        }
+      ids.insert(iter->second.begin(), iter->second.end());
+      iter->second.clear();
+      }
+    }
+
+  int fieldType = (this->FieldAssociation ==
+    vtkDataObject::FIELD_ASSOCIATION_POINTS)?
+    vtkSelectionNode::POINT : vtkSelectionNode::CELL;
+  for (vtkPVHSHits::iterator iter = merged.begin(); iter != merged.end();
+    ++iter)
+    {
+    vtkIdTypeArray* ids = vtkIdTypeArray::New();
+    ids->SetName("SelectedIds");
+    ids->SetNumberOfTuples(static_cast<vtkIdType>(iter->second.size()));
+    vtkIdType* idsPtr = ids->GetPointer(0);
+    vtkstd::copy(iter->second.begin(), iter->second.end(), idsPtr);
+    vtkstd::sort(idsPtr, idsPtr + ids->GetNumberOfTuples());
+
+    vtkSelectionNode* node = vtkSelectionNode::New();
+    node->SetContentType(vtkSelectionNode::INDICES);
+    node->SetFieldType(fieldType);
+    node->GetProperties()->Set(vtkSelectionNode::PROP_ID(), iter->first.second);
+    if (iter->first.first >= 0)
+      {
+      node->GetProperties()->Set(vtkSelectionNode::PROCESS_ID(),
+        iter->first.first);
+      }
+    node->SetSelectionList(ids);
+    sel->AddNode(node);
+    node->Delete();
+    ids->Delete();
+    }
+  return sel;
+}
+
 //----------------------------------------------------------------------------
 int vtkPVHardwareSelector::GetPropID(int vtkNotUsed(idx), vtkProp* prop)
 {
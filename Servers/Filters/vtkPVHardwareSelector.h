@@ -15,6 +15,10 @@
 // .NAME vtkPVHardwareSelector - vtkHardwareSelector subclass with logic to work
 // in Parallel.
 // .SECTION Description
+// vtkPVHardwareSelector decodes the captured pixel buffers with multiple
+// threads (see vtkMultiThreader). Each thread scans a band of rows and
+// collects the ids hit for every process and prop in hash sets, which are
+// merged into one sorted index selection node per process and prop.
 //
 
 #ifndef __vtkPVHardwareSelector_h
@@ -36,6 +40,11 @@ public:
   void EndSelection()
     { this->Superclass::EndSelection(); }
 
+  // Description:
+  // Captures the buffers and generates the selection for the area. The
+  // caller takes ownership of the returned selection.
+  vtkSelection* Select();
+
   vtkSetMacro(NumberOfIDs, vtkIdType);
   vtkGetMacro(NumberOfIDs, vtkIdType);
 
@@ -55,6 +64,10 @@ protected:
   // Returns is the pass indicated is needed.
   virtual bool PassRequired(int pass);
 
+  // Description:
+  // Generates the selection from the captured buffers.
+  vtkSelection* GenerateSelectionInParallel();
+
   int NumberOfProcesses;
   vtkIdType NumberOfIDs;
 private:
@@ -0,0 +1,165 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVParticleGeometryFilter.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVParticleGeometryFilter.h"
+
+#include "vtkCompositeDataIterator.h"
+#include "vtkCompositeDataSet.h"
+#include "vtkDataSet.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPointSet.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+
+#include <vtkstd/vector>
+
+vtkStandardNewMacro(vtkPVParticleGeometryFilter);
+//----------------------------------------------------------------------------
+vtkPVParticleGeometryFilter::vtkPVParticleGeometryFilter()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPVParticleGeometryFilter::~vtkPVParticleGeometryFilter()
+{
+}
+
+//----------------------------------------------------------------------------
+int vtkPVParticleGeometryFilter::FillInputPortInformation(
+  int vtkNotUsed(port), vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataObject");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVParticleGeometryFilter::ExtractPoints(vtkDataSet* input,
+  vtkPolyData* output)
+{
+  vtkPointSet* ps = vtkPointSet::SafeDownCast(input);
+  if (ps)
+    {
+    // Share the coordinates; only the (empty) cell arrays are new.
+    output->SetPoints(ps->GetPoints());
+    }
+  else
+    {
+    vtkIdType numPts = input->GetNumberOfPoints();
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetNumberOfPoints(numPts);
+    for (vtkIdType cc = 0; cc < numPts; ++cc)
+      {
+      points->SetPoint(cc, input->GetPoint(cc));
+      }
+    output->SetPoints(points);
+    }
+  output->GetPointData()->PassData(input->GetPointData());
+  output->GetFieldData()->PassData(input->GetFieldData());
+}
+
+//----------------------------------------------------------------------------
+int vtkPVParticleGeometryFilter::RequestData(vtkInformation*,
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  vtkDataObject* input = vtkDataObject::GetData(inputVector[0], 0);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector, 0);
+
+  vtkDataSet* ds = vtkDataSet::SafeDownCast(input);
+  if (ds)
+    {
+    this->ExtractPoints(ds, output);
+    return 1;
+    }
+
+  vtkCompositeDataSet* cd = vtkCompositeDataSet::SafeDownCast(input);
+  if (!cd)
+    {
+    return 1;
+    }
+
+  vtkstd::vector<vtkSmartPointer<vtkPolyData> > leaves;
+  vtkIdType numPts = 0;
+  vtkCompositeDataIterator* iter = cd->NewIterator();
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem())
+    {
+    vtkDataSet* leaf = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+    if (leaf && leaf->GetNumberOfPoints() > 0)
+      {
+      vtkSmartPointer<vtkPolyData> points = vtkSmartPointer<vtkPolyData>::New();
+      this->ExtractPoints(leaf, points);
+      leaves.push_back(points);
+      numPts += leaf->GetNumberOfPoints();
+      }
+    }
+  iter->Delete();
+
+  if (leaves.size() == 1)
+    {
+    output->ShallowCopy(leaves[0]);
+    return 1;
+    }
+  if (leaves.empty())
+    {
+    return 1;
+    }
+
+  // Only the arrays present in every leaf are kept.
+  vtkDataSetAttributes::FieldList fields(static_cast<int>(leaves.size()));
+  for (size_t cc = 0; cc < leaves.size(); ++cc)
+    {
+    if (cc == 0)
+      {
+      fields.InitializeFieldList(leaves[cc]->GetPointData());
+      }
+    else
+      {
+      fields.IntersectFieldList(leaves[cc]->GetPointData());
+      }
+    }
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataType(leaves[0]->GetPoints()->GetDataType());
+  points->SetNumberOfPoints(numPts);
+  vtkPointData* outPD = output->GetPointData();
+  outPD->CopyAllocate(fields, numPts);
+
+  vtkIdType offset = 0;
+  for (size_t cc = 0; cc < leaves.size(); ++cc)
+    {
+    vtkPolyData* leaf = leaves[cc];
+    vtkPointData* inPD = leaf->GetPointData();
+    vtkIdType numLeafPts = leaf->GetNumberOfPoints();
+    for (vtkIdType ptId = 0; ptId < numLeafPts; ++ptId)
+      {
+      points->SetPoint(offset + ptId, leaf->GetPoint(ptId));
+      outPD->CopyData(fields, inPD, static_cast<int>(cc), ptId,
+        offset + ptId);
+      }
+    offset += numLeafPts;
+    this->UpdateProgress(static_cast<double>(cc + 1) / leaves.size());
+    }
+  output->SetPoints(points);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVParticleGeometryFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+}
@@ -0,0 +1,59 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVParticleGeometryFilter.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkPVParticleGeometryFilter - converts a dataset to a cell-less
+// polydata holding only its points.
+// .SECTION Description
+// vtkPVParticleGeometryFilter is the geometry filter used by the particle
+// representation. For vtkPointSet inputs the output shares the points and
+// the point data of the input, so no memory is allocated; no vertex cells
+// are generated. Other datasets have their points copied. The leaves of
+// composite datasets are appended.
+// .SECTION See Also
+// vtkPVParticleMapper vtkPVGeometryFilter
+
+#ifndef __vtkPVParticleGeometryFilter_h
+#define __vtkPVParticleGeometryFilter_h
+
+#include "vtkPolyDataAlgorithm.h"
+
+class vtkDataSet;
+
+class VTK_EXPORT vtkPVParticleGeometryFilter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkPVParticleGeometryFilter* New();
+  vtkTypeMacro(vtkPVParticleGeometryFilter, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+//BTX
+protected:
+  vtkPVParticleGeometryFilter();
+  ~vtkPVParticleGeometryFilter();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestData(vtkInformation*, vtkInformationVector**,
+    vtkInformationVector*);
+
+  // Description:
+  // Sets the points and the point data of output from input.
+  void ExtractPoints(vtkDataSet* input, vtkPolyData* output);
+
+private:
+  vtkPVParticleGeometryFilter(const vtkPVParticleGeometryFilter&); // Not implemented
+  void operator=(const vtkPVParticleGeometryFilter&); // Not implemented
+//ETX
+};
+
+#endif
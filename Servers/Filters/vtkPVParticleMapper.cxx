@@ -0,0 +1,341 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVParticleMapper.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVParticleMapper.h"
+
+#include "vtkActor.h"
+#include "vtkCommand.h"
+#include "vtkFloatArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkOpenGL.h"
+#include "vtkOpenGLExtensionManager.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkProperty.h"
+#include "vtkRenderer.h"
+#include "vtkRenderWindow.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkgl.h"
+
+#include <math.h>
+#include <vtkstd/vector>
+
+namespace
+{
+// Points are sent to OpenGL in batches of this size.
+const vtkIdType vtkPVPMBatchSize = 1 << 22;
+
+// Size of the sprite texture.
+const int vtkPVPMSpriteSize = 32;
+
+// Picks about fraction*numPts point ids with selection sampling. The ids come
+// out sorted, which keeps the vertex fetches in order. The generator is
+// reseeded every time so that the same points are picked.
+void vtkPVPMSubsample(vtkIdType numPts, double fraction,
+  vtkstd::vector<GLuint>& ids)
+{
+  vtkIdType needed = static_cast<vtkIdType>(fraction * numPts + 0.5);
+  ids.clear();
+  ids.reserve(needed);
+  vtkTypeUInt32 seed = 1;
+  for (vtkIdType cc = 0; cc < numPts && needed > 0; ++cc)
+    {
+    seed = seed * 1664525u + 1013904223u;
+    if ((seed / 4294967296.0) * (numPts - cc) < needed)
+      {
+      ids.push_back(static_cast<GLuint>(cc));
+      --needed;
+      }
+    }
+}
+}
+
+class vtkPVParticleMapper::vtkInternals
+{
+public:
+  vtkInternals()
+    {
+    this->SpriteTexture = 0;
+    this->SpritesSupported = -1;
+    this->NumberOfSubsampledPoints = -1;
+    this->SubsampleFraction = 1.0;
+    this->Timer = vtkSmartPointer<vtkTimerLog>::New();
+    }
+
+  GLuint SpriteTexture;
+  // -1 until the extension has been looked for.
+  int SpritesSupported;
+
+  // Ids of the points drawn when subsampling, for the given number of points
+  // and fraction.
+  vtkstd::vector<GLuint> SubsampledIds;
+  vtkIdType NumberOfSubsampledPoints;
+  double SubsampleFraction;
+
+  // Coordinates converted to float when the points are neither float nor
+  // double.
+  vtkSmartPointer<vtkFloatArray> Coordinates;
+
+  vtkSmartPointer<vtkTimerLog> Timer;
+};
+
+vtkStandardNewMacro(vtkPVParticleMapper);
+//----------------------------------------------------------------------------
+vtkPVParticleMapper::vtkPVParticleMapper()
+{
+  this->RenderMode = SPRITES;
+  this->SubsampleFraction = 1.0;
+  this->Internals = new vtkInternals();
+}
+
+//----------------------------------------------------------------------------
+vtkPVParticleMapper::~vtkPVParticleMapper()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVParticleMapper::ReleaseGraphicsResources(vtkWindow* win)
+{
+  if (this->Internals->SpriteTexture && win)
+    {
+    win->MakeCurrent();
+    glDeleteTextures(1, &this->Internals->SpriteTexture);
+    }
+  this->Internals->SpriteTexture = 0;
+  this->Internals->SpritesSupported = -1;
+  this->Superclass::ReleaseGraphicsResources(win);
+}
+
+//----------------------------------------------------------------------------
+void vtkPVParticleMapper::BindSpriteTexture()
+{
+  if (this->Internals->SpriteTexture)
+    {
+    glBindTexture(GL_TEXTURE_2D, this->Internals->SpriteTexture);
+    return;
+    }
+
+  // A disc lit from the viewer: the luminance falls off like the normal of a
+  // sphere and the texels outside of the disc are transparent.
+  vtkstd::vector<GLubyte> texels(2 * vtkPVPMSpriteSize * vtkPVPMSpriteSize);
+  double half = 0.5 * vtkPVPMSpriteSize;
+  for (int j = 0; j < vtkPVPMSpriteSize; ++j)
+    {
+    for (int i = 0; i < vtkPVPMSpriteSize; ++i)
+      {
+      double x = (i + 0.5 - half) / half;
+      double y = (j + 0.5 - half) / half;
+      double r2 = x * x + y * y;
+      GLubyte* texel = &texels[2 * (j * vtkPVPMSpriteSize + i)];
+      texel[0] = static_cast<GLubyte>(
+        r2 < 1.0 ? 255.0 * (0.3 + 0.7 * sqrt(1.0 - r2)) : 0.0);
+      texel[1] = r2 < 1.0 ? 255 : 0;
+      }
+    }
+
+  glGenTextures(1, &this->Internals->SpriteTexture);
+  glBindTexture(GL_TEXTURE_2D, this->Internals->SpriteTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, vtkPVPMSpriteSize,
+    vtkPVPMSpriteSize, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, &texels[0]);
+}
+
+//----------------------------------------------------------------------------
+void vtkPVParticleMapper::RenderPiece(vtkRenderer* ren, vtkActor* act)
+{
+  vtkPolyData* input = this->GetInput();
+  if (!input)
+    {
+    vtkErrorMacro("No input!");
+    return;
+    }
+
+  this->InvokeEvent(vtkCommand::StartEvent, NULL);
+  if (!this->Static)
+    {
+    input->Update();
+    }
+  this->InvokeEvent(vtkCommand::EndEvent, NULL);
+
+  vtkPoints* points = input->GetPoints();
+  vtkIdType numPts = input->GetNumberOfPoints();
+  if (!points || numPts == 0 || ren->GetSelector())
+    {
+    return;
+    }
+
+  this->Internals->Timer->StartTimer();
+  ren->GetRenderWindow()->MakeCurrent();
+
+  // Point coordinates are passed as they are when OpenGL can read them.
+  GLenum coordType = GL_FLOAT;
+  void* coords = 0;
+  if (points->GetDataType() == VTK_FLOAT ||
+    points->GetDataType() == VTK_DOUBLE)
+    {
+    coordType = points->GetDataType() == VTK_FLOAT ? GL_FLOAT : GL_DOUBLE;
+    coords = points->GetVoidPointer(0);
+    }
+  else
+    {
+    if (!this->Internals->Coordinates ||
+      this->Internals->Coordinates->GetMTime() < points->GetMTime())
+      {
+      this->Internals->Coordinates = vtkSmartPointer<vtkFloatArray>::New();
+      this->Internals->Coordinates->DeepCopy(points->GetData());
+      }
+    coords = this->Internals->Coordinates->GetVoidPointer(0);
+    }
+
+  // Only point scalars color the particles.
+  vtkProperty* property = act->GetProperty();
+  int cellFlag = 0;
+  vtkUnsignedCharArray* colors = 0;
+  if (vtkAbstractMapper::GetScalars(input, this->ScalarMode,
+      this->ArrayAccessMode, this->ArrayId, this->ArrayName, cellFlag) &&
+    !cellFlag)
+    {
+    colors = this->MapScalars(property->GetOpacity());
+    }
+
+  bool subsample = this->SubsampleFraction < 1.0 &&
+    numPts <= static_cast<vtkIdType>(VTK_UNSIGNED_INT_MAX);
+  if (subsample &&
+    (this->Internals->NumberOfSubsampledPoints != numPts ||
+     this->Internals->SubsampleFraction != this->SubsampleFraction))
+    {
+    vtkPVPMSubsample(numPts, this->SubsampleFraction,
+      this->Internals->SubsampledIds);
+    this->Internals->NumberOfSubsampledPoints = numPts;
+    this->Internals->SubsampleFraction = this->SubsampleFraction;
+    }
+
+  int mode = this->RenderMode;
+  if (mode == SPRITES && this->Internals->SpritesSupported < 0)
+    {
+    vtkSmartPointer<vtkOpenGLExtensionManager> extensions =
+      vtkSmartPointer<vtkOpenGLExtensionManager>::New();
+    extensions->SetRenderWindow(ren->GetRenderWindow());
+    this->Internals->SpritesSupported =
+      extensions->ExtensionSupported("GL_ARB_point_sprite") ? 1 : 0;
+    if (this->Internals->SpritesSupported)
+      {
+      extensions->LoadExtension("GL_ARB_point_sprite");
+      }
+    }
+  if (mode == SPRITES && !this->Internals->SpritesSupported)
+    {
+    mode = ROUND_POINTS;
+    }
+
+  glPushAttrib(GL_ENABLE_BIT | GL_POINT_BIT | GL_TEXTURE_BIT |
+    GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glDisable(GL_LIGHTING);
+  glPointSize(property->GetPointSize());
+
+  if (mode != POINTS)
+    {
+    // Drop the transparent corners so that the depth buffer stays exact and
+    // no sorting is needed.
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0f);
+    }
+  if (mode == SPRITES)
+    {
+    glEnable(GL_TEXTURE_2D);
+    this->BindSpriteTexture();
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(vtkgl::POINT_SPRITE_ARB);
+    glTexEnvi(vtkgl::POINT_SPRITE_ARB, vtkgl::COORD_REPLACE_ARB, GL_TRUE);
+    }
+  else if (mode == ROUND_POINTS)
+    {
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_POINT_SMOOTH);
+    glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
+    }
+  else
+    {
+    glDisable(GL_TEXTURE_2D);
+    }
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, coordType, 0, coords);
+  if (colors)
+    {
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors->GetPointer(0));
+    }
+  else
+    {
+    double* color = property->GetColor();
+    glColor4d(color[0], color[1], color[2], property->GetOpacity());
+    }
+
+  if (subsample)
+    {
+    vtkIdType numIds =
+      static_cast<vtkIdType>(this->Internals->SubsampledIds.size());
+    for (vtkIdType first = 0; first < numIds; first += vtkPVPMBatchSize)
+      {
+      vtkIdType count = numIds - first < vtkPVPMBatchSize ?
+        numIds - first : vtkPVPMBatchSize;
+      glDrawElements(GL_POINTS, static_cast<GLsizei>(count), GL_UNSIGNED_INT,
+        &this->Internals->SubsampledIds[first]);
+      }
+    }
+  else
+    {
+    // The arrays are offset for each batch so that the first index never
+    // overflows a GLint.
+    size_t coordSize = coordType == GL_FLOAT ? sizeof(float) : sizeof(double);
+    for (vtkIdType first = 0; first < numPts; first += vtkPVPMBatchSize)
+      {
+      vtkIdType count = numPts - first < vtkPVPMBatchSize ?
+        numPts - first : vtkPVPMBatchSize;
+      glVertexPointer(3, coordType, 0,
+        static_cast<char*>(coords) + 3 * coordSize * first);
+      if (colors)
+        {
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors->GetPointer(4 * first));
+        }
+      glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+      }
+    }
+
+  glPopClientAttrib();
+  glPopAttrib();
+
+  this->Internals->Timer->StopTimer();
+  this->TimeToDraw = this->Internals->Timer->GetElapsedTime();
+  if (this->TimeToDraw == 0.0)
+    {
+    this->TimeToDraw = 0.0001;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkPVParticleMapper::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "RenderMode: " << this->RenderMode << endl;
+  os << indent << "SubsampleFraction: " << this->SubsampleFraction << endl;
+}
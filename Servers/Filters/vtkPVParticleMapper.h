@@ -0,0 +1,95 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVParticleMapper.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkPVParticleMapper - draws the points of a polydata as particles.
+// .SECTION Description
+// vtkPVParticleMapper renders every point of its input straight from the
+// point coordinates array with vertex arrays; the cells of the input are
+// ignored, so particle data does not need vertex cells.
+//
+// In SPRITES mode each point is drawn as a shaded disc (an impostor for a
+// sphere) when the context supports GL_ARB_point_sprite. Otherwise, and in
+// ROUND_POINTS mode, antialiased round points are drawn, which any OpenGL
+// implementation including software Mesa supports. POINTS draws plain
+// square points.
+//
+// SubsampleFraction draws only a random subset of the points. The subset is
+// picked once for a given number of points, so it does not change from one
+// render to the next. The particle representation uses it for its LOD.
+//
+// Points are not rendered during hardware selection.
+// .SECTION See Also
+// vtkPVParticleGeometryFilter
+
+#ifndef __vtkPVParticleMapper_h
+#define __vtkPVParticleMapper_h
+
+#include "vtkPolyDataMapper.h"
+
+class VTK_EXPORT vtkPVParticleMapper : public vtkPolyDataMapper
+{
+public:
+  static vtkPVParticleMapper* New();
+  vtkTypeMacro(vtkPVParticleMapper, vtkPolyDataMapper);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+//BTX
+  enum
+    {
+    POINTS = 0,
+    ROUND_POINTS = 1,
+    SPRITES = 2
+    };
+//ETX
+
+  // Description:
+  // Set how the points are drawn. Default is SPRITES.
+  vtkSetClampMacro(RenderMode, int, POINTS, SPRITES);
+  vtkGetMacro(RenderMode, int);
+
+  // Description:
+  // Set the fraction of the points that are drawn. Default is 1.
+  vtkSetClampMacro(SubsampleFraction, double, 0.0, 1.0);
+  vtkGetMacro(SubsampleFraction, double);
+
+  // Description:
+  // Draws the points.
+  virtual void RenderPiece(vtkRenderer* ren, vtkActor* act);
+
+  // Description:
+  // Release the sprite texture.
+  virtual void ReleaseGraphicsResources(vtkWindow*);
+
+//BTX
+protected:
+  vtkPVParticleMapper();
+  ~vtkPVParticleMapper();
+
+  // Description:
+  // Binds the sprite texture, creating it if needed.
+  void BindSpriteTexture();
+
+  int RenderMode;
+  double SubsampleFraction;
+
+private:
+  vtkPVParticleMapper(const vtkPVParticleMapper&); // Not implemented
+  void operator=(const vtkPVParticleMapper&); // Not implemented
+
+  class vtkInternals;
+  vtkInternals* Internals;
+//ETX
+};
+
+#endif
@@ -27,11 +27,74 @@
 #include "vtkReductionFilter.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkXMLWriter.h"
 
 #include <vtksys/ios/sstream>
 #include <vtksys/SystemTools.hxx>
 
 #include <vtkstd/string>
+#include <vtkstd/vector>
+
+//-----------------------------------------------------------------------------
+class vtkParallelSerialWriter::vtkInternals
+{
+public:
+  struct IndexEntry
+    {
+    double Time;
+    int Block;
+    int Part;
+    vtkstd::string File;
+    };
+  vtkstd::vector<IndexEntry> Entries;
+  double CurrentTime;
+
+  // Groups of processes used when NumberOfAggregators > 1.
+  vtkSmartPointer<vtkMultiProcessController> GroupController;
+  vtkMultiProcessController* ParentController;
+  int NumberOfGroups;
+  int Group;
+
+  vtkInternals()
+    {
+    this->CurrentTime = 0.0;
+    this->ParentController = 0;
+    this->NumberOfGroups = 1;
+    this->Group = 0;
+    }
+};
+
+namespace
+{
+  // Returns the name of the file written by aggregator "group" (when
+  // non-negative) for time index "timeIndex" (when non-negative).
+  vtkstd::string vtkPSWGetFileName(const char* filename, int group,
+                                   int timeIndex)
+  {
+    if (group < 0 && timeIndex < 0)
+      {
+      return filename;
+      }
+    vtkstd::string path =
+      vtksys::SystemTools::GetFilenamePath(filename);
+    vtkstd::string fnamenoext =
+      vtksys::SystemTools::GetFilenameWithoutLastExtension(filename);
+    vtkstd::string ext =
+      vtksys::SystemTools::GetFilenameLastExtension(filename);
+    vtksys_ios::ostringstream fname;
+    fname << path << "/" << fnamenoext;
+    if (group >= 0)
+      {
+      fname << "_" << group;
+      }
+    if (timeIndex >= 0)
+      {
+      fname << "." << timeIndex;
+      }
+    fname << ext;
+    return fname.str();
+  }
+}
 
 vtkStandardNewMacro(vtkParallelSerialWriter);
 vtkCxxSetObjectMacro(vtkParallelSerialWriter, Writer, vtkAlgorithm);
@@ -57,6 +120,9 @@ vtkParallelSerialWriter::vtkParallelSerialWriter()
   this->WriteAllTimeSteps = 0;
   this->NumberOfTimeSteps = 0;
   this->CurrentTimeIndex = 0;
+
+  this->NumberOfAggregators = 1;
+  this->Internals = new vtkInternals;
 }
 
 //-----------------------------------------------------------------------------
@@ -67,6 +133,7 @@ vtkParallelSerialWriter::~vtkParallelSerialWriter()
   this->SetFileName(0);
   this->SetPreGatherHelper(0);
   this->SetPostGatherHelper(0);
+  delete this->Internals;
 }
 
 //----------------------------------------------------------------------------
@@ -164,6 +231,16 @@ int vtkParallelSerialWriter::RequestData(
   
   vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
   vtkDataObject* input = inInfo->Get(vtkDataObject::DATA_OBJECT());
+  if (this->CurrentTimeIndex == 0)
+    {
+    this->Internals->Entries.clear();
+    }
+  this->Internals->CurrentTime = 0.0;
+  if (input && input->GetInformation()->Has(vtkDataObject::DATA_TIME_STEPS()))
+    {
+    this->Internals->CurrentTime =
+      input->GetInformation()->Get(vtkDataObject::DATA_TIME_STEPS())[0];
+    }
   this->WriteATimestep(input);
 
   if (write_all)
@@ -203,7 +280,7 @@ void vtkParallelSerialWriter::WriteATimestep(vtkDataObject* input)
         vtksys::SystemTools::GetFilenameLastExtension(this->FileName);
       vtksys_ios::ostringstream fname;
       fname << path << "/" << fnamenoext << idx << ext;
-      this->WriteAFile(fname.str().c_str(), curObj);
+      this->WriteAFile(fname.str().c_str(), curObj, idx);
       }
     }
   else if (input)
@@ -211,16 +288,20 @@ void vtkParallelSerialWriter::WriteATimestep(vtkDataObject* input)
     vtkSmartPointer<vtkDataObject> inputCopy;
     inputCopy.TakeReference(input->NewInstance());
     inputCopy->ShallowCopy(input);
-    this->WriteAFile(this->FileName, inputCopy);
+    this->WriteAFile(this->FileName, inputCopy, 0);
     }
   
 }
 
 //----------------------------------------------------------------------------
-void vtkParallelSerialWriter::WriteAFile(const char* filename, vtkDataObject* input)
+void vtkParallelSerialWriter::WriteAFile(const char* filename,
+  vtkDataObject* input, int block)
 {
+  int group = 0;
   vtkMultiProcessController* controller = 
-    vtkProcessModule::GetProcessModule()->GetController();
+    this->GetAggregationController(group);
+  bool aggregate = (this->Internals->NumberOfGroups > 1);
+  int wrote = 0;
   
   vtkSmartPointer<vtkReductionFilter> md = vtkSmartPointer<vtkReductionFilter>::New();
   md->SetController(controller);
@@ -253,27 +334,123 @@ void vtkParallelSerialWriter::WriteAFile(const char* filename, vtkDataObject* in
       outputCopy.TakeReference(output->NewInstance());
       outputCopy->ShallowCopy(output);
 
-      vtksys_ios::ostringstream fname;
-      if (this->WriteAllTimeSteps)
-        {
-        vtkstd::string path = 
-          vtksys::SystemTools::GetFilenamePath(filename);
-        vtkstd::string fnamenoext =
-          vtksys::SystemTools::GetFilenameWithoutLastExtension(filename);
-        vtkstd::string ext =
-          vtksys::SystemTools::GetFilenameLastExtension(filename);
-        fname << path << "/" << fnamenoext << "." << this->CurrentTimeIndex << ext;
-        }
-      else
-        {
-        fname << filename;
-        }
+      vtkstd::string fname = vtkPSWGetFileName(filename,
+        aggregate ? group : -1,
+        this->WriteAllTimeSteps ? this->CurrentTimeIndex : -1);
       this->Writer->SetInputConnection(outputCopy->GetProducerPort());
-      this->SetWriterFileName(fname.str().c_str());
+      this->SetWriterFileName(fname.c_str());
       this->WriteInternal();
       this->Writer->SetInputConnection(0);
+      wrote = 1;
+      }
+    }
+
+  // vtkPVDReader only reads XML files, so there is no index for others.
+  if (aggregate && vtkXMLWriter::SafeDownCast(this->Writer))
+    {
+    this->UpdateIndexFile(filename, block, wrote, this->Internals->CurrentTime);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMultiProcessController* vtkParallelSerialWriter::GetAggregationController(
+  int& group)
+{
+  vtkMultiProcessController* controller = 
+    vtkProcessModule::GetProcessModule()->GetController();
+  int numProcs = controller->GetNumberOfProcesses();
+  int numGroups = this->NumberOfAggregators < numProcs ?
+    this->NumberOfAggregators : numProcs;
+  if (numGroups <= 1)
+    {
+    this->Internals->GroupController = 0;
+    this->Internals->NumberOfGroups = 1;
+    group = 0;
+    return controller;
+    }
+
+  if (!this->Internals->GroupController ||
+    this->Internals->ParentController != controller ||
+    this->Internals->NumberOfGroups != numGroups)
+    {
+    int myId = controller->GetLocalProcessId();
+    // Contiguous ranks share an aggregator, which is the lowest rank of
+    // the group so that it becomes process 0 of the group controller.
+    this->Internals->Group = static_cast<int>(
+      (static_cast<vtkTypeInt64>(myId) * numGroups) / numProcs);
+    this->Internals->GroupController.TakeReference(
+      controller->PartitionController(this->Internals->Group, myId));
+    this->Internals->ParentController = controller;
+    this->Internals->NumberOfGroups = numGroups;
+    }
+  group = this->Internals->Group;
+  return this->Internals->GroupController;
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelSerialWriter::UpdateIndexFile(const char* filename,
+  int block, int wrote, double time)
+{
+  vtkMultiProcessController* controller = 
+    vtkProcessModule::GetProcessModule()->GetController();
+  int numProcs = controller->GetNumberOfProcesses();
+  int numGroups = this->Internals->NumberOfGroups;
+  vtkstd::vector<int> wroteFlags(numProcs, 0);
+  controller->Gather(&wrote, &wroteFlags[0], 1, 0);
+  if (controller->GetLocalProcessId() != 0)
+    {
+    return;
+    }
+
+  for (int cc = 0; cc < numProcs; cc++)
+    {
+    if (!wroteFlags[cc])
+      {
+      continue;
       }
+    vtkInternals::IndexEntry entry;
+    entry.Time = time;
+    entry.Block = block;
+    entry.Part = static_cast<int>(
+      (static_cast<vtkTypeInt64>(cc) * numGroups) / numProcs);
+    // Relative to the index file which is in the same directory.
+    entry.File = vtksys::SystemTools::GetFilenameName(vtkPSWGetFileName(
+      filename, entry.Part,
+      this->WriteAllTimeSteps ? this->CurrentTimeIndex : -1));
+    this->Internals->Entries.push_back(entry);
+    }
+
+  vtkstd::string indexName =
+    vtksys::SystemTools::GetFilenamePath(this->FileName) + "/" +
+    vtksys::SystemTools::GetFilenameWithoutLastExtension(this->FileName) +
+    ".pvd";
+  ofstream index(indexName.c_str());
+  if (!index)
+    {
+    vtkErrorMacro("Could not open index file " << indexName.c_str());
+    return;
+    }
+  index.precision(16);
+  index << "<?xml version=\"1.0\"?>\n"
+        << "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\""
+#ifdef VTK_WORDS_BIGENDIAN
+        << "BigEndian"
+#else
+        << "LittleEndian"
+#endif
+        << "\">\n"
+        << "  <Collection>\n";
+  vtkstd::vector<vtkInternals::IndexEntry>::iterator iter;
+  for (iter = this->Internals->Entries.begin();
+    iter != this->Internals->Entries.end(); ++iter)
+    {
+    index << "    <DataSet timestep=\"" << iter->Time
+          << "\" group=\"" << iter->Block
+          << "\" part=\"" << iter->Part
+          << "\" file=\"" << iter->File << "\"/>\n";
     }
+  index << "  </Collection>\n"
+        << "</VTKFile>\n";
 }
 
 //----------------------------------------------------------------------------
@@ -339,4 +516,5 @@ void vtkParallelSerialWriter::SetWriterFileName(const char* fname)
 void vtkParallelSerialWriter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfAggregators: " << this->NumberOfAggregators << endl;
 }
@@ -20,12 +20,21 @@
 // and PostGatherHelper.
 // This also makes it possible to write time-series for temporal datasets using
 // simple non-time-aware writers.
+//
+// When NumberOfAggregators is greater than 1, the processes are split into
+// that many contiguous groups. The data is only gathered to the first
+// process of each group, which writes its own file. When the internal
+// writer is a vtkXMLWriter, the first process then also writes a .pvd index
+// listing these files as the parts of one dataset, so that the result can
+// be read back with vtkPVDReader. No index is written for other writers.
 
 #ifndef __vtkParallelSerialWriter_h
 #define __vtkParallelSerialWriter_h
 
 #include "vtkDataObjectAlgorithm.h"
 
+class vtkMultiProcessController;
+
 class VTK_EXPORT vtkParallelSerialWriter : public vtkDataObjectAlgorithm
 {
 public:
@@ -94,6 +103,15 @@ public:
   vtkSetMacro(WriteAllTimeSteps, int);
   vtkBooleanMacro(WriteAllTimeSteps, int);
 
+  // Description:
+  // Get/Set the number of processes that write files. The data of each
+  // process is gathered to one of NumberOfAggregators writers instead of
+  // the first process. The file written by aggregator i is named
+  // FileName with "_i" appended before the extension. 1 by default which
+  // writes a single file.
+  vtkSetClampMacro(NumberOfAggregators, int, 1, VTK_LARGE_INTEGER);
+  vtkGetMacro(NumberOfAggregators, int);
+
 protected:
   vtkParallelSerialWriter();
   ~vtkParallelSerialWriter();
@@ -113,7 +131,17 @@ private:
   void operator=(const vtkParallelSerialWriter&); // Not implemented.
   
   void WriteATimestep(vtkDataObject* input);
-  void WriteAFile(const char* fname, vtkDataObject* input);
+  void WriteAFile(const char* fname, vtkDataObject* input, int block);
+
+  // Description:
+  // Return the controller of the group of processes the local process
+  // belongs to and the index of that group, creating the groups if needed.
+  vtkMultiProcessController* GetAggregationController(int& group);
+
+  // Description:
+  // Add the files written for this timestep to the index and write it on
+  // the first process.
+  void UpdateIndexFile(const char* fname, int block, int wrote, double time);
 
   void SetWriterFileName(const char* fname);
   void WriteInternal();
@@ -131,6 +159,11 @@ private:
   int NumberOfTimeSteps;
   int CurrentTimeIndex;
 
+  int NumberOfAggregators;
+
+  class vtkInternals;
+  vtkInternals* Internals;
+
   // The name of the output file.
   char* FileName;
 };
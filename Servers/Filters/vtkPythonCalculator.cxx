@@ -14,6 +14,8 @@
 =========================================================================*/
 #include "vtkPythonCalculator.h"
 
+#include "vtkCompositeDataIterator.h"
+#include "vtkCompositeDataSet.h"
 #include "vtkDataObject.h"
 #include "vtkDataObjectTypes.h"
 #include "vtkDataSet.h"
@@ -34,6 +36,42 @@
 
 vtkStandardNewMacro(vtkPythonCalculator);
 
+namespace
+{
+//----------------------------------------------------------------------------
+// Returns str as a Python string literal.
+vtkstd::string vtkPythonCalculatorQuote(const char* str)
+{
+  vtkstd::string result = "'";
+  for (; str && *str; ++str)
+    {
+    switch (*str)
+      {
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\'':
+        result += "\\'";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      case '\r':
+        result += "\\r";
+        break;
+      case '\t':
+        // Replace tabs with two spaces
+        result += "  ";
+        break;
+      default:
+        result.push_back(*str);
+      }
+    }
+  result += "'";
+  return result;
+}
+}
+
 //----------------------------------------------------------------------------
 
 //----------------------------------------------------------------------------
@@ -101,137 +139,63 @@ void vtkPythonCalculator::ExecuteScript(void *arg)
 }
 
 //----------------------------------------------------------------------------
-void vtkPythonCalculator::Exec(const char* expression,
-                               const char* funcname)
+int vtkPythonCalculator::RequestData(vtkInformation* request,
+                                     vtkInformationVector** inputVector,
+                                     vtkInformationVector* outputVector)
 {
-  if (!expression)
+  vtkCompositeDataSet* input = vtkCompositeDataSet::GetData(inputVector[0], 0);
+  vtkCompositeDataSet* output = vtkCompositeDataSet::GetData(outputVector, 0);
+  if (!input || !output)
     {
-    return;
+    return this->Superclass::RequestData(request, inputVector, outputVector);
     }
 
-  vtkDataObject* firstInput = this->GetInputDataObject(0, 0);
-  vtkFieldData* fd = 0;
-  if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS)
-    {
-    vtkDataSet* ds = vtkDataSet::SafeDownCast(firstInput);
-    if (ds)
-      {
-      fd = ds->GetPointData();
-      }    
-    }
-  else if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS)
+  // Give each leaf of the output the structure of the matching input leaf.
+  // The script then adds the arrays to all of them in one pass.
+  output->CopyStructure(input);
+  vtkCompositeDataIterator* iter = input->NewIterator();
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem())
     {
-    vtkDataSet* ds = vtkDataSet::SafeDownCast(firstInput);
-    if (ds)
+    vtkDataSet* inBlock = vtkDataSet::SafeDownCast(
+      iter->GetCurrentDataObject());
+    if (inBlock)
       {
-      fd = ds->GetCellData();
-      }        
+      vtkDataSet* outBlock = inBlock->NewInstance();
+      outBlock->CopyStructure(inBlock);
+      output->SetDataSet(iter, outBlock);
+      outBlock->Delete();
+      }
     }
-  if (!fd)
+  iter->Delete();
+
+  this->Exec(this->GetExpression(), "RequestData");
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkPythonCalculator::Exec(const char* expression,
+                               const char* vtkNotUsed(funcname))
+{
+  if (!expression)
     {
-    vtkErrorMacro("Unexpected association value.");
     return;
     }
 
-  // Replace tabs with two spaces
-  vtkstd::string orgscript;
-  size_t len = strlen(expression);
-  for(size_t i=0; i< len; i++)
+  const char* association;
+  if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS)
     {
-    if (expression[i] == '\t')
-      {
-      orgscript += "  ";
-      }
-    else
-      {
-      orgscript.push_back(expression[i]);
-      }
+    association = "PointData";
     }
-    
-  //size_t pos = orgscript.rfind("\n");
-    
-  // Construct a script that defines a function
-  vtkstd::string fscript;
-  fscript  = "def ";
-  fscript += funcname;
-
-  fscript += "(self, inputs):\n";
-  fscript += "  arrays = {}\n";
-  int narrays = fd->GetNumberOfArrays();
-  for (int i=0; i<narrays; i++)
-    {
-    const char* aname = fd->GetArray(i)->GetName();
-    if (aname)
-      {
-      fscript += "  import paraview\n";
-      fscript += "  name = paraview.make_name_valid(\"";
-      fscript += aname;
-      fscript += "\")\n";
-      fscript += "  if name:\n";
-      fscript += "    try:\n";
-      fscript += "      exec \"%s = inputs[0].";
-      if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS)
-        {
-        fscript += "PointData['";
-        }
-      else if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS)
-        {
-        fscript += "CellData['";
-        }
-      fscript += aname;
-      fscript += "']\" % (name)\n";
-      fscript += "    except: pass\n";
-      fscript += "  arrays['";
-      fscript += aname;
-      fscript += "'] = inputs[0].";
-      if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS)
-        {
-        fscript += "PointData['";
-        }
-      else if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS)
-        {
-        fscript += "CellData['";
-        }
-      fscript += aname;
-      fscript += "']\n";
-      }
-    }
-  fscript += "  try:\n";
-  fscript += "    points = inputs[0].Points\n";
-  fscript += "  except: pass\n";
-  
-  if (expression && strlen(expression) > 0)  
+  else if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS)
     {
-    fscript += "  retVal = ";
-    fscript += orgscript;
-    fscript += "\n";
-    fscript += "  if not isinstance(retVal, ndarray):\n";
-    fscript += "    retVal = retVal * ones((inputs[0].GetNumberOf";
-    if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS)
-      {
-      fscript += "Points(), 1))\n";
-      }
-    else if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS)
-      {
-      fscript += "Cells(), 1))\n";
-      }
-    fscript += "  return retVal\n";
+    association = "CellData";
     }
   else
     {
-    fscript += "  return None\n";
+    vtkErrorMacro("Unexpected association value.");
+    return;
     }
-  
-  vtkPythonProgrammableFilter::GetGlobalPipelineInterpretor()->RunSimpleString(fscript.c_str());
-
-  vtkstd::string runscript;
-  runscript += "from paraview import vtk\n";
-  runscript += "from paraview.vtk import dataset_adapter\n";
-  runscript += "from numpy import *\n";
-  runscript += "from paraview.vtk.algorithms import *\n";
-  runscript += "from paraview import servermanager\n";
-  runscript += "if servermanager.progressObserverTag:\n";
-  runscript += "  servermanager.ToggleProgressPrinting()\n";
 
   // Set self to point to this
   char addrofthis[1024];
@@ -242,49 +206,27 @@ void vtkPythonCalculator::Exec(const char* expression,
     {
     aplus += 2; //skip over "0x"
     }
-  
-  // Call the function
-  runscript += "myarg = ";
-  runscript += "vtk.vtkProgrammableFilter('";
-  runscript += aplus;
-  runscript += "')\n";
-  runscript += "inputs = []\n";
-  runscript += "index = 0\n";
-  int numinps = this->GetNumberOfInputConnections(0);
-  for (int i=0; i<numinps; i++)
-    {
-    runscript += 
-      "inputs.append(dataset_adapter.WrapDataObject(myarg.GetInputDataObject(0, index)))\n";
-    runscript += "index += 1\n";
-    }
-  runscript += "output = dataset_adapter.WrapDataObject(myarg.GetOutputDataObject(0))\n";
-  if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_POINTS)
-    {
-    runscript +=  "fd = output.PointData\n";
-    }
-  else if (this->ArrayAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS)
-    {
-    runscript += "fd = output.CellData\n";
-    }
-  if (this->CopyArrays)
-    {
-    runscript += "output.GetPointData().PassData(inputs[0].GetPointData().VTKObject)\n";
-    runscript += "output.GetCellData().PassData(inputs[0].GetCellData().VTKObject)\n";
-    }
-  runscript += "retVal = ";
-  runscript += funcname;
-  runscript += "(vtk.vtkProgrammableFilter('";
+
+  // The expression is compiled once by the calculator module, which also
+  // walks the blocks of composite datasets, so the script run here is the
+  // same short call for every execution.
+  vtkstd::string runscript;
+  runscript += "from paraview import vtk\n";
+  runscript += "from paraview import calculator\n";
+  runscript += "from paraview import servermanager\n";
+  runscript += "if servermanager.progressObserverTag:\n";
+  runscript += "  servermanager.ToggleProgressPrinting()\n";
+  runscript += "calculator.execute(vtk.vtkProgrammableFilter('";
   runscript += aplus;
-  runscript += "'), inputs)\n";
-  runscript += "if retVal is not None:\n";
-  runscript += "  fd.append(retVal, '";
-  runscript += this->GetArrayName();
-  runscript += "')\n";
-  runscript += "del myarg\n";
-  runscript += "del inputs\n";
-  runscript += "del fd\n";
-  runscript += "del retVal\n";
-  runscript += "del output\n";
+  runscript += "'), ";
+  runscript += vtkPythonCalculatorQuote(expression);
+  runscript += ", '";
+  runscript += association;
+  runscript += "', ";
+  runscript += vtkPythonCalculatorQuote(this->GetArrayName());
+  runscript += ", ";
+  runscript += this->CopyArrays ? "True" : "False";
+  runscript += ")\n";
   
   vtkPythonProgrammableFilter::GetGlobalPipelineInterpretor()->RunSimpleString(runscript.c_str());
   vtkPythonProgrammableFilter::GetGlobalPipelineInterpretor()->FlushMessages();
@@ -310,6 +252,8 @@ int vtkPythonCalculator::FillInputPortInformation(
   if(port==0)
     {
     info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkDataSet");
+    info->Append(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), 
+      "vtkCompositeDataSet");
     info->Set(vtkAlgorithm::INPUT_IS_REPEATABLE(), 1);
     info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
     }
@@ -26,6 +26,11 @@
 // valid Python variable, it has to be accessed through a dictionary called
 // arrays (i.e. arrays['array_name']). The points can be accessed using the
 // points variable.
+//
+// The expression is evaluated by the paraview.calculator module. Arrays are
+// shared with numpy without copies in both directions, and composite inputs
+// are processed in a single call that evaluates the expression for each
+// block.
 
 #ifndef __vtkPythonCalculator_h
 #define __vtkPythonCalculator_h
@@ -77,6 +82,14 @@ protected:
   // For internal use only.
   void Exec(const char*, const char*);
 
+  // Description:
+  // Composite inputs are handled here rather than block by block by the
+  // executive so that the expression is evaluated for all the blocks in one
+  // call to the interpreter.
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector);
+
   virtual int FillOutputPortInformation(int port, vtkInformation* info);
 
   //overridden to allow multiple inputs to port 0
@@ -38,6 +38,7 @@
 #include "vtkToolkits.h"
 #include "vtkSelection.h"
 #include "vtkSelectionSerializer.h"
+#include "vtkUnsignedCharArray.h"
 
 #include <vtksys/ios/sstream>
 #include <vtkstd/vector>
@@ -316,7 +317,10 @@ void vtkReductionFilter::Reduce(vtkDataObject* input, vtkDataObject* output)
     {
     // Note that preOutput is never the input directly (it is shallow copied at
     // the least, hence we can add arrays to it.
-    if (tablePreOutput->GetNumberOfRows() > 0)
+    // Rows gathered upstream (e.g. by vtkTableStreamer when sorting) already
+    // carry the id of the process they come from.
+    if (tablePreOutput->GetNumberOfRows() > 0 &&
+      !tablePreOutput->GetColumnByName("vtkOriginalProcessIds"))
       {
       vtkIdTypeArray* originalProcessIds = vtkIdTypeArray::New();
       originalProcessIds->SetNumberOfComponents(1);
@@ -387,18 +391,17 @@ void vtkReductionFilter::Send(int receiver, vtkDataObject* data)
 {
   if (data && data->IsA("vtkSelection"))
     {
-    // Convert to XML.
     vtkSelection* sel = vtkSelection::SafeDownCast(data);
-    vtksys_ios::ostringstream res;
-    vtkSelectionSerializer::PrintXML(res, vtkIndent(), 1, sel);
-    res << ends;
-    // Send the size of the string.
-    int size = static_cast<int>(res.str().size());
+    vtkUnsignedCharArray* buffer = vtkUnsignedCharArray::New();
+    vtkSelectionSerializer::PrintBinary(sel, buffer);
+    // Send the size of the buffer.
+    int size = static_cast<int>(buffer->GetNumberOfTuples());
     this->Controller->Send(&size, 1, receiver,
       vtkReductionFilter::TRANSMIT_DATA_OBJECT);
-    // Send the XML string.
-    this->Controller->Send(res.str().c_str(), size, receiver,
+    // Send the buffer.
+    this->Controller->Send(buffer->GetPointer(0), size, receiver,
       vtkReductionFilter::TRANSMIT_DATA_OBJECT);
+    buffer->Delete();
     }
   else
     {
@@ -411,18 +414,21 @@ vtkDataObject* vtkReductionFilter::Receive(int sender, int dataType)
 {
   if (dataType == VTK_SELECTION)
     {
-    // Get the size of the string.
+    // Get the size of the buffer.
     int size = 0;
     this->Controller->Receive(&size, 1, sender,
       vtkReductionFilter::TRANSMIT_DATA_OBJECT);
-    char* xml = new char[size];
-    // Get the string itself.
-    this->Controller->Receive(xml, size, sender,
+    vtkUnsignedCharArray* buffer = vtkUnsignedCharArray::New();
+    buffer->SetNumberOfTuples(size);
+    // Get the buffer itself.
+    this->Controller->Receive(buffer->GetPointer(0), size, sender,
       vtkReductionFilter::TRANSMIT_DATA_OBJECT);
-    // Parse the XML.
     vtkSelection* sel = vtkSelection::New();
-    vtkSelectionSerializer::Parse(xml, sel);
-    delete[] xml;
+    if (!vtkSelectionSerializer::ParseBinary(buffer, sel))
+      {
+      vtkErrorMacro("Failed to parse the selection received from " << sender);
+      }
+    buffer->Delete();
     return sel;
     }
   return this->Controller->ReceiveDataObject(sender,
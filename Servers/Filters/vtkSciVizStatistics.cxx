@@ -3,17 +3,22 @@
 
 #include "vtkAlgorithm.h"
 #include "vtkCellData.h"
+#include "vtkCommunicator.h"
 #include "vtkCompositeDataSet.h"
 #include "vtkCompositeDataIterator.h"
+#include "vtkDataArray.h"
 #include "vtkDataObject.h"
 #include "vtkDataSetAttributes.h"
 #include "vtkDemandDrivenPipeline.h"
+#include "vtkDoubleArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationIntegerKey.h"
 #include "vtkInformationVector.h"
 #include "vtkInstantiator.h"
 #include "vtkMath.h"
 #include "vtkMultiBlockDataSet.h"
+#include "vtkMultiProcessController.h"
+#include "vtkMultiThreader.h"
 #include "vtkPointData.h"
 #include "vtkStatisticsAlgorithm.h"
 #include "vtkStdString.h"
@@ -21,17 +26,238 @@
 #include "vtkTable.h"
 #include "vtkVariantArray.h"
 
+#include <vtkstd/algorithm>
 #include <vtkstd/set>
 #include <vtksys/ios/sstream>
 
 vtkInformationKeyMacro(vtkSciVizStatistics, MULTIPLE_MODELS, Integer);
 
+namespace
+{
+// Observations handled by each thread are converted to doubles in chunks of
+// this many tuples, so that each observation is contiguous while it is used.
+const vtkIdType vtkSVSChunkSize = 1024;
+const vtkIdType vtkSVSMinimumTuplesPerThread = 65536;
+const int vtkSVSCoMomentsTag = 0x5d6;
+
+// Mergeable means and sums of products of deviations of m variables
+// (Pebay, SAND2008-6212). The pairs (j,k), j <= k, are stored row by row.
+struct vtkSVSCoMoments
+{
+  double N;
+  vtkstd::vector<double> Mean;
+  vtkstd::vector<double> M;
+  vtkstd::vector<double> Delta;
+
+  void Initialize( int m )
+    {
+    this->N = 0.;
+    this->Mean.assign( m, 0. );
+    this->M.assign( m * ( m + 1 ) / 2, 0. );
+    this->Delta.assign( m, 0. );
+    }
+
+  int GetPackedSize() const
+    {
+    return 1 + static_cast<int>( this->Mean.size() + this->M.size() );
+    }
+
+  void Add( const double* x )
+    {
+    int m = static_cast<int>( this->Mean.size() );
+    this->N += 1.;
+    double f = ( this->N - 1. ) / this->N;
+    for ( int j = 0; j < m; ++ j )
+      {
+      this->Delta[j] = x[j] - this->Mean[j];
+      }
+    double* mjk = &this->M[0];
+    for ( int j = 0; j < m; ++ j )
+      {
+      double dj = this->Delta[j] * f;
+      for ( int k = j; k < m; ++ k, ++ mjk )
+        {
+        *mjk += dj * this->Delta[k];
+        }
+      }
+    for ( int j = 0; j < m; ++ j )
+      {
+      this->Mean[j] += this->Delta[j] / this->N;
+      }
+    }
+
+  void Merge( const vtkSVSCoMoments& b )
+    {
+    if ( b.N == 0. )
+      {
+      return;
+      }
+    if ( this->N == 0. )
+      {
+      *this = b;
+      return;
+      }
+    int m = static_cast<int>( this->Mean.size() );
+    double n = this->N + b.N;
+    double f = this->N * b.N / n;
+    for ( int j = 0; j < m; ++ j )
+      {
+      this->Delta[j] = b.Mean[j] - this->Mean[j];
+      }
+    double* mjk = &this->M[0];
+    const double* bjk = &b.M[0];
+    for ( int j = 0; j < m; ++ j )
+      {
+      double dj = this->Delta[j] * f;
+      for ( int k = j; k < m; ++ k, ++ mjk, ++ bjk )
+        {
+        *mjk += *bjk + dj * this->Delta[k];
+        }
+      }
+    for ( int j = 0; j < m; ++ j )
+      {
+      this->Mean[j] += this->Delta[j] * b.N / n;
+      }
+    this->N = n;
+    }
+
+  void Pack( double* buf ) const
+    {
+    *buf ++ = this->N;
+    buf = vtkstd::copy( this->Mean.begin(), this->Mean.end(), buf );
+    vtkstd::copy( this->M.begin(), this->M.end(), buf );
+    }
+
+  void Unpack( const double* buf )
+    {
+    this->N = *buf ++;
+    vtkstd::copy( buf, buf + this->Mean.size(), this->Mean.begin() );
+    buf += this->Mean.size();
+    vtkstd::copy( buf, buf + this->M.size(), this->M.begin() );
+    }
+};
+
+struct vtkSVSCoMomentsTask
+{
+  // Streaming columns, sorted by name.
+  vtkstd::vector<vtkSciVizStatisticsColumn> Columns;
+  // CoMoments[thread]
+  vtkstd::vector<vtkSVSCoMoments> CoMoments;
+  vtkIdType NumberOfTuples;
+  double SamplingFraction;
+  unsigned int Seed;
+};
+
+bool vtkSVSColumnNameLess( const vtkSciVizStatisticsColumn& a, const vtkSciVizStatisticsColumn& b )
+{
+  return a.Name < b.Name;
+}
+
+// Small xorshift generator, one per thread so that sampling needs no locks.
+inline unsigned int vtkSVSRandom( unsigned int& state )
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+template <class T>
+void vtkSVSCopyChunk( const T* data, int ncomp, vtkIdType begin, vtkIdType end, double* out, int stride )
+{
+  const T* ptr = data + begin * ncomp;
+  for ( vtkIdType i = begin; i < end; ++ i, ptr += ncomp, out += stride )
+    {
+    *out = static_cast<double>( *ptr );
+    }
+}
+
+VTK_THREAD_RETURN_TYPE vtkSVSCoMomentsThread( void* arg )
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>( arg );
+  vtkSVSCoMomentsTask* task = static_cast<vtkSVSCoMomentsTask*>( info->UserData );
+  int tid = info->ThreadID;
+  int nthreads = info->NumberOfThreads;
+
+  const double scale = 1. / 4294967296.;
+  int m = static_cast<int>( task->Columns.size() );
+  vtkIdType begin = ( task->NumberOfTuples * tid ) / nthreads;
+  vtkIdType end = ( task->NumberOfTuples * ( tid + 1 ) ) / nthreads;
+  unsigned int state = task->Seed ^ ( 2654435761U * static_cast<unsigned int>( tid + 1 ) );
+  state = state ? state : 1;
+  vtkSVSCoMoments& comoments = task->CoMoments[tid];
+  vtkstd::vector<double> chunk( vtkSVSChunkSize * m );
+  for ( vtkIdType first = begin; first < end; first += vtkSVSChunkSize )
+    {
+    vtkIdType last = first + vtkSVSChunkSize < end ? first + vtkSVSChunkSize : end;
+    for ( int c = 0; c < m; ++ c )
+      {
+      vtkDataArray* arr = task->Columns[c].Array;
+      void* vptr = arr->GetVoidPointer( 0 );
+      switch ( arr->GetDataType() )
+        {
+        vtkTemplateMacro(
+          vtkSVSCopyChunk( static_cast<const VTK_TT*>( vptr ) + task->Columns[c].Component,
+            arr->GetNumberOfComponents(), first, last, &chunk[c], m ) );
+        }
+      }
+    const double* x = &chunk[0];
+    for ( vtkIdType i = first; i < last; ++ i, x += m )
+      {
+      if ( task->SamplingFraction >= 1. || vtkSVSRandom( state ) * scale < task->SamplingFraction )
+        {
+        comoments.Add( x );
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+// Combine the co-moments of all processes on every process using a binary
+// tree rooted at process 0 followed by a broadcast.
+void vtkSVSTreeReduce( vtkMultiProcessController* controller, vtkSVSCoMoments& comoments )
+{
+  int nprocs = controller ? controller->GetNumberOfProcesses() : 1;
+  if ( nprocs < 2 )
+    {
+    return;
+    }
+  int rank = controller->GetLocalProcessId();
+  vtkIdType len = comoments.GetPackedSize();
+  vtkstd::vector<double> buf( len );
+  vtkSVSCoMoments other = comoments;
+  for ( int step = 1; step < nprocs; step <<= 1 )
+    {
+    if ( rank & step )
+      {
+      comoments.Pack( &buf[0] );
+      controller->Send( &buf[0], len, rank - step, vtkSVSCoMomentsTag );
+      break;
+      }
+    if ( rank + step < nprocs )
+      {
+      controller->Receive( &buf[0], len, rank + step, vtkSVSCoMomentsTag );
+      other.Unpack( &buf[0] );
+      comoments.Merge( other );
+      }
+    }
+  if ( rank == 0 )
+    {
+    comoments.Pack( &buf[0] );
+    }
+  controller->Broadcast( &buf[0], len, 0 );
+  comoments.Unpack( &buf[0] );
+}
+}
+
 vtkSciVizStatistics::vtkSciVizStatistics()
 {
   this->P = new vtkSciVizStatisticsP;
   this->AttributeMode = vtkDataObject::POINT;
   this->TrainingFraction = 0.1;
   this->Task = MODEL_AND_ASSESS;
+  this->StreamingMode = 0;
   this->SetNumberOfInputPorts( 2 ); // data + optional model
   this->SetNumberOfOutputPorts( 2 ); // model + assessed input
 }
@@ -47,6 +273,7 @@ void vtkSciVizStatistics::PrintSelf( ostream& os, vtkIndent indent )
   os << indent << "Task: " << this->Task << "\n";
   os << indent << "AttributeMode: " << this->AttributeMode << "\n";
   os << indent << "TrainingFraction: " << this->TrainingFraction << "\n";
+  os << indent << "StreamingMode: " << this->StreamingMode << "\n";
 }
 
 int vtkSciVizStatistics::GetNumberOfAttributeArrays()
@@ -414,9 +641,49 @@ int vtkSciVizStatistics::RequestData(
     return 1;
     }
 
+  int stat;
+  bool needAssessment = ( this->Task != CREATE_MODEL && this->Task != FULL_STATISTICS );
+
+  // When possible, fit the model straight from the attribute arrays.
+  int streamed = 0;
+  if ( this->StreamingMode && this->Task != ASSESS_INPUT && modelOut )
+    {
+    vtkIdType N = 0;
+    for ( int i = 0; i < dataAttrIn->GetNumberOfArrays(); ++ i )
+      {
+      vtkAbstractArray* arr = dataAttrIn->GetAbstractArray( i );
+      if ( arr && arr->GetName() && this->P->Has( arr->GetName() ) )
+        {
+        N = arr->GetNumberOfTuples();
+        break;
+        }
+      }
+    // Same rule as the default GetNumberOfObservationsForTraining().
+    vtkIdType M = static_cast<vtkIdType>( N * this->TrainingFraction );
+    M = M < 100 ? ( N < 100 ? N : 100 ) : M;
+    double fraction = ( this->Task == FULL_STATISTICS || N == 0 ) ?
+      1. : static_cast<double>( M ) / static_cast<double>( N );
+
+    modelOut->Initialize();
+    stat = this->FitModelStreaming( modelOut, dataAttrIn, fraction );
+    if ( stat == 0 )
+      {
+      return 0;
+      }
+    streamed = ( stat > 0 );
+    if ( streamed && ! needAssessment )
+      {
+      if ( observationsOut )
+        {
+        observationsOut->ShallowCopy( observationsIn );
+        }
+      return 1;
+      }
+    }
+
   // Create a table with all the data
   vtkTable* tableIn = vtkTable::New();
-  int stat = this->PrepareFullDataTable( tableIn, dataAttrIn );
+  stat = this->PrepareFullDataTable( tableIn, dataAttrIn );
   if ( stat < 1 )
     { // return an error (stat=0) or success (stat=-1)
     tableIn->FastDelete();
@@ -424,7 +691,11 @@ int vtkSciVizStatistics::RequestData(
     }
 
   // Either create or retrieve the model, depending on the task at hand
-  if ( this->Task != ASSESS_INPUT )
+  if ( streamed )
+    {
+    // The model has already been fit from the attribute arrays.
+    }
+  else if ( this->Task != ASSESS_INPUT )
     {
     // We are creating a model by fitting the input data
     // Create a table to hold the training data (unless the TrainingFraction is exactly 1.0)
@@ -488,7 +759,7 @@ int vtkSciVizStatistics::RequestData(
     {
     observationsOut->ShallowCopy( observationsIn );
     }
-  if ( this->Task != CREATE_MODEL && this->Task != FULL_STATISTICS )
+  if ( needAssessment )
     { // we need to assess the data using the input or the just-created model
     stat = this->AssessData( tableIn, observationsOut, modelOut );
     }
@@ -497,6 +768,186 @@ int vtkSciVizStatistics::RequestData(
   return stat ? 1 : 0;
 }
 
+int vtkSciVizStatistics::FitModelStreaming( vtkDataObject*, vtkFieldData*, double )
+{
+  return -1;
+}
+
+vtkIdType vtkSciVizStatistics::PrepareStreamingColumns( vtkFieldData* dataAttrIn )
+{
+  // Collect the columns the table-based path would have created. Only numeric
+  // arrays can be read in place; anything else falls back to the table.
+  vtkstd::vector<vtkSciVizStatisticsColumn>& columns = this->P->StreamingColumns;
+  columns.clear();
+  vtkIdType ntup = -1;
+  int streamable = 1;
+  vtkstd::set<vtkStdString>::iterator colIt;
+  for ( colIt = this->P->Buffer.begin(); colIt != this->P->Buffer.end(); ++ colIt )
+    {
+    vtkAbstractArray* arr = dataAttrIn->GetAbstractArray( colIt->c_str() );
+    if ( ! arr )
+      {
+      continue;
+      }
+    vtkDataArray* darr = vtkDataArray::SafeDownCast( arr );
+    if ( ! darr || ( ntup >= 0 && darr->GetNumberOfTuples() != ntup ) )
+      {
+      streamable = 0;
+      break;
+      }
+    ntup = darr->GetNumberOfTuples();
+    int ncomp = darr->GetNumberOfComponents();
+    for ( int i = 0; i < ncomp; ++ i )
+      {
+      vtkSciVizStatisticsColumn col;
+      col.Array = darr;
+      col.Component = i;
+      if ( ncomp > 1 )
+        {
+        vtksys_ios::ostringstream os;
+        const char* compName = darr->GetComponentName( i );
+        os << darr->GetName() << "_";
+        ( compName ) ? os << compName : os << i;
+        col.Name = os.str();
+        }
+      else
+        {
+        col.Name = darr->GetName();
+        }
+      columns.push_back( col );
+      }
+    }
+  if ( columns.empty() )
+    {
+    // Let the table-based path report the problem.
+    streamable = 0;
+    }
+
+  // The statistics are reduced collectively, so every process has to take the
+  // same path with the same columns. Any process that cannot stream makes
+  // all of them fall back to the table-based path.
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  if ( controller && controller->GetNumberOfProcesses() > 1 )
+    {
+    int local[2];
+    local[0] = streamable;
+    local[1] = static_cast<int>( columns.size() );
+    int minimum[2];
+    int maximum[2];
+    controller->AllReduce( local, minimum, 2, vtkCommunicator::MIN_OP );
+    controller->AllReduce( local, maximum, 2, vtkCommunicator::MAX_OP );
+    streamable = ( minimum[0] && minimum[1] == maximum[1] ) ? 1 : 0;
+    }
+  if ( ! streamable )
+    {
+    columns.clear();
+    return -1;
+    }
+  return ntup;
+}
+
+void vtkSciVizStatistics::PrepareStreamingTable( vtkTable* table )
+{
+  table->Initialize();
+  vtkstd::vector<vtkSciVizStatisticsColumn>::iterator it;
+  for ( it = this->P->StreamingColumns.begin(); it != this->P->StreamingColumns.end(); ++ it )
+    {
+    vtkDoubleArray* col = vtkDoubleArray::New();
+    col->SetName( it->Name.c_str() );
+    table->AddColumn( col );
+    col->Delete();
+    }
+}
+
+int vtkSciVizStatistics::LearnCovarianceStreaming(
+  vtkMultiBlockDataSet* primaryModel, vtkIdType ntup, double samplingFraction )
+{
+  vtkSVSCoMomentsTask task;
+  task.Columns = this->P->StreamingColumns;
+  // vtkMultiCorrelativeStatistics orders the variables by name.
+  vtkstd::sort( task.Columns.begin(), task.Columns.end(), ::vtkSVSColumnNameLess );
+  int m = static_cast<int>( task.Columns.size() );
+  if ( m < 1 )
+    {
+    vtkErrorMacro( "No columns to stream." );
+    return 0;
+    }
+
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  int rank = controller ? controller->GetLocalProcessId() : 0;
+
+  vtkMultiThreader* threader = vtkMultiThreader::New();
+  vtkIdType maxThreads = ntup / vtkSVSMinimumTuplesPerThread;
+  int nthreads = threader->GetNumberOfThreads();
+  nthreads = maxThreads < nthreads ? static_cast<int>( maxThreads ) : nthreads;
+  nthreads = nthreads < 1 ? 1 : nthreads;
+  threader->SetNumberOfThreads( nthreads );
+  task.NumberOfTuples = ntup;
+  task.SamplingFraction = samplingFraction;
+  task.Seed = 1013904223U * static_cast<unsigned int>( rank + 1 );
+  task.CoMoments.resize( nthreads );
+  for ( int t = 0; t < nthreads; ++ t )
+    {
+    task.CoMoments[t].Initialize( m );
+    }
+  threader->SetSingleMethod( ::vtkSVSCoMomentsThread, &task );
+  threader->SingleMethodExecute();
+  threader->Delete();
+
+  vtkSVSCoMoments& comoments = task.CoMoments[0];
+  for ( int t = 1; t < nthreads; ++ t )
+    {
+    comoments.Merge( task.CoMoments[t] );
+    }
+  ::vtkSVSTreeReduce( controller, comoments );
+
+  // Lay out the sparse table as the learn phase of vtkMultiCorrelativeStatistics does:
+  // the number of observations, then the mean of each variable, then the sums
+  // of products of deviations of each pair of variables.
+  vtkTable* sparseCov = vtkTable::New();
+  vtkStringArray* col1 = vtkStringArray::New();
+  col1->SetName( "Column1" );
+  sparseCov->AddColumn( col1 );
+  col1->Delete();
+  vtkStringArray* col2 = vtkStringArray::New();
+  col2->SetName( "Column2" );
+  sparseCov->AddColumn( col2 );
+  col2->Delete();
+  vtkDoubleArray* entries = vtkDoubleArray::New();
+  entries->SetName( "Entries" );
+  sparseCov->AddColumn( entries );
+  entries->Delete();
+
+  vtkStdString empty;
+  col1->InsertNextValue( "Cardinality" );
+  col2->InsertNextValue( empty );
+  entries->InsertNextValue( comoments.N );
+  for ( int j = 0; j < m; ++ j )
+    {
+    col1->InsertNextValue( task.Columns[j].Name );
+    col2->InsertNextValue( empty );
+    entries->InsertNextValue( comoments.Mean[j] );
+    }
+  const double* mjk = &comoments.M[0];
+  for ( int j = 0; j < m; ++ j )
+    {
+    for ( int k = j; k < m; ++ k, ++ mjk )
+      {
+      col1->InsertNextValue( task.Columns[j].Name );
+      col2->InsertNextValue( task.Columns[k].Name );
+      entries->InsertNextValue( *mjk );
+      }
+    }
+
+  primaryModel->Initialize();
+  primaryModel->SetNumberOfBlocks( 1 );
+  primaryModel->SetBlock( 0, sparseCov );
+  primaryModel->GetMetaData( static_cast<unsigned>( 0 ) )->Set( vtkCompositeDataSet::NAME(), "Raw Sparse Covariance Data" );
+  sparseCov->Delete();
+
+  return 1;
+}
+
 int vtkSciVizStatistics::PrepareFullDataTable( vtkTable* tableIn, vtkFieldData* dataAttrIn )
 {
   vtkstd::set<vtkStdString>::iterator colIt;
@@ -34,6 +34,7 @@ class vtkFieldData;
 class vtkSciVizStatisticsP;
 class vtkStatisticsAlgorithm;
 class vtkInformationIntegerKey;
+class vtkMultiBlockDataSet;
 
 class VTK_EXPORT vtkSciVizStatistics : public vtkTableAlgorithm
 {
@@ -100,6 +101,21 @@ public:
   vtkSetMacro(Task,int);
   vtkGetMacro(Task,int);
 
+  // Description:
+  // Set/get whether the model should be fit directly from the attribute arrays
+  // instead of first copying them into a table.
+  // When on, and the subclass supports it (see FitModelStreaming()), the arrays
+  // are read in place, so that fitting a model needs no extra memory
+  // proportional to the input size. A table is still built when the data must
+  // be assessed. Subclasses that do not support streaming ignore this flag.
+  // Descriptive, multi-correlative and PCA statistics support it; k-means
+  // does not yet, since its model is refined over several passes by the
+  // engine's own learn phase, and it always fits from a table.
+  // The default is off.
+  vtkSetMacro(StreamingMode,int);
+  vtkGetMacro(StreamingMode,int);
+  vtkBooleanMacro(StreamingMode,int);
+
   // Description:
   // A key used to mark the output model data object (output port 0) when it is a multiblock
   // of models (any of which may be multiblock dataset themselves) as opposed to a multiblock
@@ -149,6 +165,45 @@ protected:
   // as well as returned in the \a model parameter.
   virtual int FitModel( vtkDataObject* model, vtkTable* trainingData ) = 0;
 
+  // Description:
+  // Method subclasses <b>may</b> override to fit a model directly from the attribute arrays selected
+  // for processing, without building a table, when StreamingMode is on.
+  // Each selected array with more than one component is treated as one column per component,
+  // named as in PrepareFullDataTable().
+  // Return 1 on success, 0 on failure and -1 if the model cannot be fit this way,
+  // in which case the table-based FitModel() is used.
+  // In parallel, all processes must return the same value.
+  // The default implementation returns -1.
+  //
+  // @param model - the output model
+  // @param dataAttrIn - the attributes of the input dataset
+  // @param samplingFraction - the probability with which each observation should be used for training
+  virtual int FitModelStreaming( vtkDataObject* model, vtkFieldData* dataAttrIn, double samplingFraction );
+
+  // Description:
+  // Collect the columns FitModelStreaming() should read in place from \a dataAttrIn.
+  // Only numeric arrays of the same length can be streamed; all processes agree
+  // on whether the columns can be streamed, so this must be called collectively.
+  // Returns the number of tuples in each column, or -1 when the model must be fit
+  // from a table instead.
+  virtual vtkIdType PrepareStreamingColumns( vtkFieldData* dataAttrIn );
+
+  // Description:
+  // Fill \a table with one empty column per streaming column, for engines that
+  // need the names of the variables of interest but no observations.
+  virtual void PrepareStreamingTable( vtkTable* table );
+
+  // Description:
+  // Compute the means and the sums of products of deviations of the streaming
+  // columns in one pass and store them in block 0 of \a primaryModel, laid out
+  // as the learn phase of vtkMultiCorrelativeStatistics would, so that the
+  // multi-correlative and PCA engines can derive their models from it.
+  // Each thread accumulates its share of the tuples; the partial sums are
+  // merged pairwise and then across processes along a binary tree.
+  // This must be called collectively after PrepareStreamingColumns().
+  virtual int LearnCovarianceStreaming(
+    vtkMultiBlockDataSet* primaryModel, vtkIdType numberOfTuples, double samplingFraction );
+
   // Description:
   // Method subclasses <b>must</b> override to assess an input table given a model of the proper type.
   // The \a dataset parameter contains a shallow copy of input port 0 and should be modified to include the assessment.
@@ -174,6 +229,7 @@ protected:
 
   int AttributeMode;
   int Task;
+  int StreamingMode;
   double TrainingFraction;
   vtkSciVizStatisticsP* P;
 
@@ -21,6 +21,18 @@
 
 #include "vtkStatisticsAlgorithmPrivate.h"
 
+#include <vtkstd/vector>
+
+class vtkDataArray;
+
+// One column of the table PrepareFullDataTable() would build: a component of a data array.
+struct vtkSciVizStatisticsColumn
+{
+  vtkDataArray* Array;
+  int Component;
+  vtkStdString Name;
+};
+
 class vtkSciVizStatisticsP : public vtkStatisticsAlgorithmPrivate
 {
 public:
@@ -28,6 +40,9 @@ public:
     {
     return this->Buffer.find( arrName ) != this->Buffer.end();
     }
+
+  // Columns read in place by FitModelStreaming(); see vtkSciVizStatistics::PrepareStreamingColumns().
+  vtkstd::vector<vtkSciVizStatisticsColumn> StreamingColumns;
 };
 
 
@@ -73,21 +73,43 @@ int vtkSelectionStreamer::RequestData(vtkInformation*,
   vtkDataObject* inputDO = vtkDataObject::GetData(inputVector[1], 0);
   vtkSelection* output = vtkSelection::GetData(outputVector, 0);
 
-  vtkstd::vector<vtkstd::pair<vtkIdType, vtkIdType> > indices;
-  if (!this->DetermineIndicesToPass(inputDO, indices))
+  // The rows of every leaf in the current block, in the sorted order when
+  // sorting.
+  vtkstd::vector<vtkstd::vector<vtkIdType> > leafRows;
+  if (this->SortColumnName && this->SortColumnName[0])
     {
-    return 0;
+    vtkstd::vector<vtkstd::vector<vtkIdType> > leafRanks;
+    if (!this->SortRows(inputDO))
+      {
+      return 0;
+      }
+    this->DetermineSortedRowsToPass(leafRows, leafRanks);
+    }
+  else
+    {
+    vtkstd::vector<vtkstd::pair<vtkIdType, vtkIdType> > indices;
+    if (!this->DetermineIndicesToPass(inputDO, indices))
+      {
+      return 0;
+      }
+    leafRows.resize(indices.size());
+    for (size_t kk=0; kk < indices.size(); kk++)
+      {
+      for (vtkIdType cc=0; cc < indices[kk].second; cc++)
+        {
+        leafRows[kk].push_back(indices[kk].first + cc);
+        }
+      }
     }
 
   if (!inputDO->IsA("vtkCompositeDataSet"))
     {
     vtkSelectionNode* inSel = this->LocateSelection(inputSel);
-    if (inSel)
+    if (inSel && !leafRows.empty())
       {
       vtkSmartPointer<vtkSelectionNode> outputNode =
         vtkSmartPointer<vtkSelectionNode>::New();
-      this->PassBlock(outputNode, inSel,
-        indices[0].first, indices[0].second);
+      this->PassBlock(outputNode, inSel, leafRows[0]);
       output->AddNode(outputNode);
       }
     return 1;
@@ -102,12 +124,10 @@ int vtkSelectionStreamer::RequestData(vtkInformation*,
   vtkCompositeDataIterator* iter = input->NewIterator();
   iter->SkipEmptyNodesOff();
   int cc=0;
-  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
-    iter->GoToNextItem(), cc++)
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal() &&
+    cc < static_cast<int>(leafRows.size()); iter->GoToNextItem(), cc++)
     {
-    vtkIdType curOffset = indices[cc].first;
-    vtkIdType curCount = indices[cc].second;
-    if (curCount > 0)
+    if (!leafRows[cc].empty())
       {
       vtkSelectionNode* curSel = this->LocateSelection(iter, inputSel);
       if (!curSel)
@@ -134,7 +154,7 @@ int vtkSelectionStreamer::RequestData(vtkInformation*,
         }
       else 
         {
-        hit |= this->PassBlock(curOutputSel, curSel, curOffset, curCount);
+        hit |= this->PassBlock(curOutputSel, curSel, leafRows[cc]);
         }
       if (hit)
         {
@@ -270,7 +290,7 @@ bool vtkSelectionStreamer::LocateSelection(vtkSelectionNode* node)
 
 //----------------------------------------------------------------------------
 bool vtkSelectionStreamer::PassBlock(vtkSelectionNode* output, vtkSelectionNode* input,
-  vtkIdType offset, vtkIdType count)
+  const vtkstd::vector<vtkIdType>& rows)
 {
   bool hit = false;
   output->GetProperties()->Copy(input->GetProperties());
@@ -282,9 +302,9 @@ bool vtkSelectionStreamer::PassBlock(vtkSelectionNode* output, vtkSelectionNode*
     outIds->SetNumberOfComponents(1);
     output->SetSelectionList(outIds);
     outIds->Delete();
-    for (vtkIdType cc=0; cc < count; cc++)
+    for (size_t cc=0; cc < rows.size(); cc++)
       {
-      vtkIdType curVal = offset + cc;
+      vtkIdType curVal = rows[cc];
       if (input->GetSelectionList()->LookupValue(vtkVariant(curVal)) != -1)
         {
         outIds->InsertNextValue(curVal);
@@ -17,7 +17,8 @@
 // vtkSelectionStreamer is a streamer for vtkSelection corresponding to
 // vtkTableStreamer. This is used to sections from input vtkSelection relevant
 // to the sections passed through by a vtkTableStreamer with same attributes and
-// inputs.
+// inputs. When sorting, the sections follow the sorted order of the rows as
+// they do in vtkTableStreamer.
 
 #ifndef __vtkSelectionStreamer_h
 #define __vtkSelectionStreamer_h
@@ -78,8 +79,10 @@ protected:
 
   bool LocateSelection(vtkSelectionNode* node);
 
+  // Description:
+  // Passes the ids of \c input that are among the given rows of the leaf.
   bool PassBlock(vtkSelectionNode* output, vtkSelectionNode* input,
-    vtkIdType offset, vtkIdType count);
+    const vtkstd::vector<vtkIdType>& rows);
 
   int FieldAssociation;
 private:
@@ -14,6 +14,8 @@
 =========================================================================*/
 #include "vtkTableStreamer.h"
 
+#include "vtkAbstractArray.h"
+#include "vtkCommunicator.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkDataSetAttributes.h"
@@ -30,6 +32,12 @@
 #include "vtkTable.h"
 #include "vtkUnsignedIntArray.h"
 
+#include <vtkstd/algorithm>
+#include <vtkstd/string>
+
+#include <math.h>
+#include <string.h>
+
 static void vtkFillComponent(vtkUnsignedIntArray* array,
   int component, unsigned int value)
 {
@@ -42,6 +50,69 @@ static void vtkFillComponent(vtkUnsignedIntArray* array,
     }
 }
  
+//----------------------------------------------------------------------------
+// Sort key of a row: the value in the sort column and the index of the row in
+// the input order (over all processes), which breaks ties so that every row
+// has a unique position.
+struct vtkTableStreamerKey
+{
+  double Value;
+  vtkIdType Id;
+  // Index of the row among the rows of all leaves on this process.
+  vtkIdType Row;
+};
+
+class vtkTableStreamerKeyLess
+{
+public:
+  vtkTableStreamerKeyLess(bool ascending) : Ascending(ascending) {}
+  bool operator()(const vtkTableStreamerKey& a,
+                  const vtkTableStreamerKey& b) const
+    {
+    if (a.Value != b.Value)
+      {
+      return this->Ascending ? (a.Value < b.Value) : (a.Value > b.Value);
+      }
+    return a.Id < b.Id;
+    }
+  bool Ascending;
+};
+
+//----------------------------------------------------------------------------
+class vtkTableStreamer::vtkInternals
+{
+public:
+  vtkInternals() : Valid(false), Input(0), InputMTime(0),
+    Component(-1), Ascending(1) {}
+
+  // The rows of this process (indices among the rows of all leaves) in the
+  // sorted order, and their position in the sorted order of all processes.
+  // SortedRanks is increasing.
+  vtkstd::vector<vtkIdType> SortedRows;
+  vtkstd::vector<vtkIdType> SortedRanks;
+  // Index of the first row of each leaf among the rows of all leaves on this
+  // process. The last entry is the number of rows.
+  vtkstd::vector<vtkIdType> LeafOffsets;
+
+  // What the cached order was computed for.
+  bool Valid;
+  vtkDataObject* Input;
+  unsigned long InputMTime;
+  vtkstd::string ColumnName;
+  int Component;
+  int Ascending;
+};
+
+namespace
+{
+  enum
+    {
+    SORTED_ROWS_TAG = 29871,
+    SORTED_KEYS_TAG = 29872,
+    SORTED_RANKS_TAG = 29873
+    };
+}
+
 vtkStandardNewMacro(vtkTableStreamer);
 vtkCxxSetObjectMacro(vtkTableStreamer, Controller, vtkMultiProcessController);
 //----------------------------------------------------------------------------
@@ -52,12 +123,18 @@ vtkTableStreamer::vtkTableStreamer()
   this->BlockSize = 1024;
   this->Block = 0;
   this->GenerateOriginalIds = 0;
+  this->SortColumnName = 0;
+  this->SortComponent = -1;
+  this->SortAscending = 1;
+  this->Internals = new vtkInternals();
 }
 
 //----------------------------------------------------------------------------
 vtkTableStreamer::~vtkTableStreamer()
 {
   this->SetController(0);
+  this->SetSortColumnName(0);
+  delete this->Internals;
 }
 
 //----------------------------------------------------------------------------
@@ -129,8 +206,16 @@ int vtkTableStreamer::RequestData(vtkInformation*,
   vtkDataObject* inputDO = vtkDataObject::GetData(inputVector[0], 0);
   vtkDataObject* outputDO = vtkDataObject::GetData(outputVector, 0);
 
+  bool sorted = (this->SortColumnName && this->SortColumnName[0]);
   vtkstd::vector<vtkstd::pair<vtkIdType, vtkIdType> > indices;
-  if (!this->DetermineIndicesToPass(inputDO, indices))
+  if (sorted)
+    {
+    if (!this->SortRows(inputDO))
+      {
+      return 0;
+      }
+    }
+  else if (!this->DetermineIndicesToPass(inputDO, indices))
     {
     return 0;
     }
@@ -153,116 +238,143 @@ int vtkTableStreamer::RequestData(vtkInformation*,
     }
   output->CopyStructure(input);
 
-  vtkCompositeDataIterator* iter = input->NewIterator();
-  iter->SkipEmptyNodesOff();
-
   bool something_added = false;
-  int cc=0;
-  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
-    iter->GoToNextItem(), cc++)
+  if (sorted)
     {
-    vtkTable* curTable = vtkTable::SafeDownCast(iter->GetCurrentDataObject());
-    vtkIdType curOffset = indices[cc].first;
-    vtkIdType curCount = indices[cc].second;
-    if (curCount <= 0)
+    if (!this->PassSortedRows(input, output))
       {
-      continue;
+      return 0;
       }
+    something_added = (output->GetNumberOfBlocks() > 0 &&
+      output->GetBlock(0) != 0);
+    }
+  else
+    {
+    vtkCompositeDataIterator* iter = input->NewIterator();
+    iter->SkipEmptyNodesOff();
 
-    something_added = true;
-    vtkTable* outTable = vtkTable::New();
-    output->SetDataSet(iter, outTable);
-    outTable->Delete();
+    vtkstd::vector<vtkIdType> rows;
+    int cc=0;
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+      iter->GoToNextItem(), cc++)
+      {
+      vtkTable* curTable = vtkTable::SafeDownCast(iter->GetCurrentDataObject());
+      vtkIdType curOffset = indices[cc].first;
+      vtkIdType curCount = indices[cc].second;
+      if (curCount <= 0)
+        {
+        continue;
+        }
 
-    outTable->GetRowData()->CopyAllocate(curTable->GetRowData());
-    outTable->GetRowData()->SetNumberOfTuples(curCount);
+      something_added = true;
+      vtkTable* outTable = vtkTable::New();
+      output->SetDataSet(iter, outTable);
+      outTable->Delete();
 
-    vtkSmartPointer<vtkIdTypeArray> originalIndices;
-    if (this->GenerateOriginalIds)
-      {
-      originalIndices = vtkSmartPointer<vtkIdTypeArray>::New();
-      originalIndices->SetNumberOfComponents(1);
-      originalIndices->SetNumberOfTuples(curCount);
-      originalIndices->SetName("vtkOriginalIndices");
+      rows.resize(curCount);
+      for (vtkIdType jj=0; jj < curCount; jj++)
+        {
+        rows[jj] = curOffset+jj;
+        }
+      this->PassRows(iter, curTable, rows, outTable);
       }
+    iter->Delete();
+    }
+    
+  if (!outputDO->IsA("vtkMultiBlockDataSet") && something_added)
+    {
+    outputDO->ShallowCopy(output->GetBlock(0));
+    }
+  return 1;
+}
 
-    int dimensions[3] = {0, 0, 0};
-    vtkSmartPointer<vtkIdTypeArray> structuredIndices;
-    if (curTable->GetFieldData()->GetArray("STRUCTURED_DIMENSIONS"))
-      {
-      vtkIntArray::SafeDownCast(
-        curTable->GetFieldData()->GetArray("STRUCTURED_DIMENSIONS"))->
-        GetTupleValue(0, dimensions);
-      structuredIndices = vtkSmartPointer<vtkIdTypeArray>::New();
-      structuredIndices->SetNumberOfComponents(3);
-      structuredIndices->SetNumberOfTuples(curCount);
-      structuredIndices->SetName("Structured Coordinates");
-      }
+//----------------------------------------------------------------------------
+void vtkTableStreamer::PassRows(vtkCompositeDataIterator* iter,
+  vtkTable* curTable, const vtkstd::vector<vtkIdType>& rows,
+  vtkTable* outTable)
+{
+  vtkIdType curCount = static_cast<vtkIdType>(rows.size());
+  outTable->GetRowData()->CopyAllocate(curTable->GetRowData());
+  outTable->GetRowData()->SetNumberOfTuples(curCount);
 
-    vtkSmartPointer<vtkUnsignedIntArray> compositeIndex;
-    if (iter->GetCurrentMetaData()->Has(vtkSelectionNode::HIERARCHICAL_LEVEL()) &&
-      iter->GetCurrentMetaData()->Has(vtkSelectionNode::HIERARCHICAL_INDEX()))
-      {
-      compositeIndex = vtkSmartPointer<vtkUnsignedIntArray>::New();
-      compositeIndex->SetName("vtkCompositeIndexArray");
-      compositeIndex->SetNumberOfComponents(2);
-      compositeIndex->SetNumberOfTuples(curCount);
-      ::vtkFillComponent(compositeIndex, 0, static_cast<unsigned int>(
-          iter->GetCurrentMetaData()->Get(vtkSelectionNode::HIERARCHICAL_LEVEL())));
-      ::vtkFillComponent(compositeIndex, 1, static_cast<unsigned int>(
-          iter->GetCurrentMetaData()->Get(vtkSelectionNode::HIERARCHICAL_INDEX())));
+  vtkSmartPointer<vtkIdTypeArray> originalIndices;
+  if (this->GenerateOriginalIds)
+    {
+    originalIndices = vtkSmartPointer<vtkIdTypeArray>::New();
+    originalIndices->SetNumberOfComponents(1);
+    originalIndices->SetNumberOfTuples(curCount);
+    originalIndices->SetName("vtkOriginalIndices");
+    }
 
-      }
-    else if (iter->GetCurrentMetaData()->Has(vtkSelectionNode::COMPOSITE_INDEX()))
-      {
-      compositeIndex = vtkSmartPointer<vtkUnsignedIntArray>::New();
-      compositeIndex->SetName("vtkCompositeIndexArray");
-      compositeIndex->SetNumberOfComponents(1);
-      compositeIndex->SetNumberOfTuples(curCount);
-      ::vtkFillComponent(compositeIndex, 0, static_cast<unsigned int>(
-          iter->GetCurrentMetaData()->Get(vtkSelectionNode::COMPOSITE_INDEX())));
-      }
+  int dimensions[3] = {0, 0, 0};
+  vtkSmartPointer<vtkIdTypeArray> structuredIndices;
+  if (curTable->GetFieldData()->GetArray("STRUCTURED_DIMENSIONS"))
+    {
+    vtkIntArray::SafeDownCast(
+      curTable->GetFieldData()->GetArray("STRUCTURED_DIMENSIONS"))->
+      GetTupleValue(0, dimensions);
+    structuredIndices = vtkSmartPointer<vtkIdTypeArray>::New();
+    structuredIndices->SetNumberOfComponents(3);
+    structuredIndices->SetNumberOfTuples(curCount);
+    structuredIndices->SetName("Structured Coordinates");
+    }
 
-    // TODO: add Hierarchical index information.
-    for (vtkIdType jj=0; jj < curCount; jj++)
-      {
-      vtkIdType inIndex = curOffset+jj;
-      outTable->GetRowData()->CopyData(
-        curTable->GetRowData(), inIndex, jj);
-      if (originalIndices)
-        {
-        originalIndices->SetValue(jj, inIndex);
-        }
-      if (structuredIndices)
-        {
-        // Compute i,j,k from point id.
-        vtkIdType tuple[3];
-        tuple[0] = (inIndex % dimensions[0]);
-        tuple[1] = (inIndex/dimensions[0]) % dimensions[1];
-        tuple[2] = (inIndex/(dimensions[0]*dimensions[1]));
-        structuredIndices->SetTupleValue(jj, tuple);
-        }
-      }
+  vtkSmartPointer<vtkUnsignedIntArray> compositeIndex;
+  if (iter->GetCurrentMetaData()->Has(vtkSelectionNode::HIERARCHICAL_LEVEL()) &&
+    iter->GetCurrentMetaData()->Has(vtkSelectionNode::HIERARCHICAL_INDEX()))
+    {
+    compositeIndex = vtkSmartPointer<vtkUnsignedIntArray>::New();
+    compositeIndex->SetName("vtkCompositeIndexArray");
+    compositeIndex->SetNumberOfComponents(2);
+    compositeIndex->SetNumberOfTuples(curCount);
+    ::vtkFillComponent(compositeIndex, 0, static_cast<unsigned int>(
+        iter->GetCurrentMetaData()->Get(vtkSelectionNode::HIERARCHICAL_LEVEL())));
+    ::vtkFillComponent(compositeIndex, 1, static_cast<unsigned int>(
+        iter->GetCurrentMetaData()->Get(vtkSelectionNode::HIERARCHICAL_INDEX())));
+
+    }
+  else if (iter->GetCurrentMetaData()->Has(vtkSelectionNode::COMPOSITE_INDEX()))
+    {
+    compositeIndex = vtkSmartPointer<vtkUnsignedIntArray>::New();
+    compositeIndex->SetName("vtkCompositeIndexArray");
+    compositeIndex->SetNumberOfComponents(1);
+    compositeIndex->SetNumberOfTuples(curCount);
+    ::vtkFillComponent(compositeIndex, 0, static_cast<unsigned int>(
+        iter->GetCurrentMetaData()->Get(vtkSelectionNode::COMPOSITE_INDEX())));
+    }
+
+  // TODO: add Hierarchical index information.
+  for (vtkIdType jj=0; jj < curCount; jj++)
+    {
+    vtkIdType inIndex = rows[jj];
+    outTable->GetRowData()->CopyData(
+      curTable->GetRowData(), inIndex, jj);
     if (originalIndices)
       {
-      outTable->GetRowData()->AddArray(originalIndices);
+      originalIndices->SetValue(jj, inIndex);
       }
     if (structuredIndices)
       {
-      outTable->GetRowData()->AddArray(structuredIndices);
-      }
-    if (compositeIndex)
-      {
-      outTable->GetRowData()->AddArray(compositeIndex);
+      // Compute i,j,k from point id.
+      vtkIdType tuple[3];
+      tuple[0] = (inIndex % dimensions[0]);
+      tuple[1] = (inIndex/dimensions[0]) % dimensions[1];
+      tuple[2] = (inIndex/(dimensions[0]*dimensions[1]));
+      structuredIndices->SetTupleValue(jj, tuple);
       }
     }
-  iter->Delete();
-    
-  if (!outputDO->IsA("vtkMultiBlockDataSet") && something_added)
+  if (originalIndices)
     {
-    outputDO->ShallowCopy(output->GetBlock(0));
+    outTable->GetRowData()->AddArray(originalIndices);
+    }
+  if (structuredIndices)
+    {
+    outTable->GetRowData()->AddArray(structuredIndices);
+    }
+  if (compositeIndex)
+    {
+    outTable->GetRowData()->AddArray(compositeIndex);
     }
-  return 1;
 }
 
 //----------------------------------------------------------------------------
@@ -409,10 +521,546 @@ bool vtkTableStreamer::DetermineIndicesToPass(vtkDataObject* inputDO,
   return true;
 }
 
+//----------------------------------------------------------------------------
+// Ranks the rows of all processes with a sample sort:  Every process sorts
+// its keys and picks regularly spaced samples.  All processes gather the
+// samples and choose the same splitters, which divide the keys in one range
+// per process.  The keys are exchanged between every pair of processes at
+// once, so that every process receives the keys of its range.  It sorts them
+// and computes their position in the global order (its range starts after
+// the ranges of the lower processes).  The positions are returned to the
+// processes owning the rows the same way.  In every pair the lower rank
+// sends first, and since every process goes through the others by rank, the
+// pairs cannot wait on each other.
+bool vtkTableStreamer::SortRows(vtkDataObject* dObj)
+{
+  vtkInternals* internals = this->Internals;
+  int numProcs = 1;
+  int myId = 0;
+  if (this->Controller)
+    {
+    numProcs = this->Controller->GetNumberOfProcesses();
+    myId = this->Controller->GetLocalProcessId();
+    }
+
+  // The cached order is reused until the data or the sort parameters change.
+  // All processes must agree since sorting is collective.
+  int needSort = (!internals->Valid || internals->Input != dObj ||
+    internals->InputMTime != dObj->GetMTime() ||
+    internals->ColumnName != this->SortColumnName ||
+    internals->Component != this->SortComponent ||
+    internals->Ascending != this->SortAscending)? 1 : 0;
+  if (numProcs > 1)
+    {
+    int anyNeedSort = 0;
+    this->Controller->AllReduce(&needSort, &anyNeedSort, 1,
+      vtkCommunicator::MAX_OP);
+    needSort = anyNeedSort;
+    }
+  if (!needSort)
+    {
+    return true;
+    }
+  internals->Valid = false;
+  internals->SortedRows.clear();
+  internals->SortedRanks.clear();
+  internals->LeafOffsets.clear();
+
+  vtkstd::vector<vtkIdType> counts;
+  vtkstd::vector<vtkIdType> offsets;
+  if (!this->CountRows(dObj, counts, offsets))
+    {
+    return false;
+    }
+
+  vtkSmartPointer<vtkCompositeDataSet> input =
+    vtkCompositeDataSet::SafeDownCast(dObj);
+  if (!input)
+    {
+    vtkMultiBlockDataSet* mb = vtkMultiBlockDataSet::New();
+    mb->SetBlock(0, dObj);
+    input = mb;
+    mb->Delete();
+    }
+
+  // Extract the keys of the local rows. Rows without a value (missing
+  // column or NaN) are sorted last.
+  bool ascending = (this->SortAscending != 0);
+  double missing = ascending? VTK_DOUBLE_MAX : VTK_DOUBLE_MIN;
+  vtkstd::vector<vtkTableStreamerKey> keys;
+  vtkIdType leafStart = 0;
+  bool warned = false;
+  vtkCompositeDataIterator* iter = input->NewIterator();
+  iter->SkipEmptyNodesOff();
+  int cc=0;
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem(), cc++)
+    {
+    internals->LeafOffsets.push_back(static_cast<vtkIdType>(keys.size()));
+    vtkTable* curTable = vtkTable::SafeDownCast(iter->GetCurrentDataObject());
+    vtkIdType numRows = curTable? curTable->GetNumberOfRows() : 0;
+    vtkAbstractArray* column = curTable?
+      curTable->GetColumnByName(this->SortColumnName) : 0;
+    vtkDataArray* array = vtkDataArray::SafeDownCast(column);
+    if (column && !array && !warned)
+      {
+      vtkWarningMacro("Column \"" << this->SortColumnName
+        << "\" is not numeric and cannot be sorted.");
+      warned = true;
+      }
+    int numComps = array? array->GetNumberOfComponents() : 0;
+    int comp = this->SortComponent;
+    if (comp >= numComps || (comp < 0 && numComps == 1))
+      {
+      comp = 0;
+      }
+    vtkTableStreamerKey key;
+    for (vtkIdType jj=0; jj < numRows; jj++)
+      {
+      key.Value = missing;
+      if (array && comp >= 0)
+        {
+        key.Value = array->GetComponent(jj, comp);
+        }
+      else if (array)
+        {
+        double sum = 0.0;
+        for (int kk=0; kk < numComps; kk++)
+          {
+          double value = array->GetComponent(jj, kk);
+          sum += value * value;
+          }
+        key.Value = sqrt(sum);
+        }
+      if (key.Value != key.Value)
+        {
+        key.Value = missing;
+        }
+      key.Id = leafStart + offsets[cc] + jj;
+      key.Row = static_cast<vtkIdType>(keys.size());
+      keys.push_back(key);
+      }
+    leafStart += counts[cc];
+    }
+  iter->Delete();
+  vtkIdType numKeys = static_cast<vtkIdType>(keys.size());
+  internals->LeafOffsets.push_back(numKeys);
+
+  vtkTableStreamerKeyLess less(ascending);
+  vtkstd::sort(keys.begin(), keys.end(), less);
+
+  internals->SortedRows.resize(numKeys);
+  internals->SortedRanks.resize(numKeys);
+  for (vtkIdType jj=0; jj < numKeys; jj++)
+    {
+    internals->SortedRows[jj] = keys[jj].Row;
+    internals->SortedRanks[jj] = jj;
+    }
+
+  if (numProcs > 1)
+    {
+    // MPI wants valid pointers even for empty messages.
+    double emptyValue = 0.0;
+    vtkIdType emptyId = 0;
+
+    // Regular samples of the local keys.
+    vtkstd::vector<double> sampleValues;
+    vtkstd::vector<vtkIdType> sampleIds;
+    for (int pp=1; numKeys > 0 && pp < numProcs; pp++)
+      {
+      const vtkTableStreamerKey& key = keys[(numKeys*pp)/numProcs];
+      sampleValues.push_back(key.Value);
+      sampleIds.push_back(key.Id);
+      }
+    vtkIdType numSamples = static_cast<vtkIdType>(sampleValues.size());
+    vtkstd::vector<vtkIdType> sampleLengths(numProcs, 0);
+    vtkstd::vector<vtkIdType> sampleOffsets(numProcs + 1, 0);
+    this->Controller->AllGather(&numSamples, &sampleLengths[0], 1);
+    for (int pp=0; pp < numProcs; pp++)
+      {
+      sampleOffsets[pp+1] = sampleOffsets[pp] + sampleLengths[pp];
+      }
+    vtkIdType totalSamples = sampleOffsets[numProcs];
+    vtkstd::vector<double> allSampleValues(totalSamples + 1);
+    vtkstd::vector<vtkIdType> allSampleIds(totalSamples + 1);
+    this->Controller->AllGatherV(numSamples? &sampleValues[0] : &emptyValue,
+      &allSampleValues[0], numSamples, &sampleLengths[0], &sampleOffsets[0]);
+    this->Controller->AllGatherV(numSamples? &sampleIds[0] : &emptyId,
+      &allSampleIds[0], numSamples, &sampleLengths[0], &sampleOffsets[0]);
+
+    // Splitters, the same on all processes. Process pp owns the keys after
+    // splitter pp-1, up to and including splitter pp.
+    vtkstd::vector<vtkTableStreamerKey> samples(totalSamples);
+    for (vtkIdType jj=0; jj < totalSamples; jj++)
+      {
+      samples[jj].Value = allSampleValues[jj];
+      samples[jj].Id = allSampleIds[jj];
+      samples[jj].Row = 0;
+      }
+    vtkstd::sort(samples.begin(), samples.end(), less);
+    vtkstd::vector<vtkIdType> bounds(numProcs + 1, 0);
+    for (int pp=1; pp < numProcs; pp++)
+      {
+      bounds[pp] = bounds[pp-1];
+      if (totalSamples > 0)
+        {
+        const vtkTableStreamerKey& splitter =
+          samples[(totalSamples*pp)/numProcs];
+        bounds[pp] = static_cast<vtkIdType>(vtkstd::upper_bound(
+            keys.begin(), keys.end(), splitter, less) - keys.begin());
+        }
+      }
+    bounds[numProcs] = numKeys;
+
+    // Every process sends the keys of each range to the process owning it
+    // and receives the keys of its own range, ordered by sender.
+    vtkstd::vector<vtkIdType> recvOffsets(numProcs + 1, 0);
+    vtkstd::vector<double> recvValues;
+    vtkstd::vector<vtkIdType> recvIds;
+    vtkstd::vector<double> sendValues;
+    vtkstd::vector<vtkIdType> sendIds;
+    for (int pp=0; pp < numProcs; pp++)
+      {
+      vtkIdType length = bounds[pp+1] - bounds[pp];
+      sendValues.resize(length);
+      sendIds.resize(length);
+      for (vtkIdType jj=0; jj < length; jj++)
+        {
+        sendValues[jj] = keys[bounds[pp]+jj].Value;
+        sendIds[jj] = keys[bounds[pp]+jj].Id;
+        }
+      if (pp == myId)
+        {
+        recvValues.insert(recvValues.end(), sendValues.begin(),
+          sendValues.end());
+        recvIds.insert(recvIds.end(), sendIds.begin(), sendIds.end());
+        }
+      else
+        {
+        this->ExchangeKeys(pp, sendValues, sendIds, recvValues, recvIds);
+        }
+      recvOffsets[pp+1] = static_cast<vtkIdType>(recvValues.size());
+      }
+    sendValues.clear();
+    sendIds.clear();
+
+    // Sort the keys of the range and number them after the lower ranges.
+    vtkIdType rangeLength = recvOffsets[numProcs];
+    vtkstd::vector<vtkTableStreamerKey> range(rangeLength);
+    for (vtkIdType jj=0; jj < rangeLength; jj++)
+      {
+      range[jj].Value = recvValues[jj];
+      range[jj].Id = recvIds[jj];
+      range[jj].Row = jj;
+      }
+    recvValues.clear();
+    recvIds.clear();
+    vtkstd::sort(range.begin(), range.end(), less);
+    vtkstd::vector<vtkIdType> rangeLengths(numProcs, 0);
+    this->Controller->AllGather(&rangeLength, &rangeLengths[0], 1);
+    vtkIdType rangeStart = 0;
+    for (int pp=0; pp < myId; pp++)
+      {
+      rangeStart += rangeLengths[pp];
+      }
+    vtkstd::vector<vtkIdType> ranks(rangeLength + 1);
+    for (vtkIdType jj=0; jj < rangeLength; jj++)
+      {
+      ranks[range[jj].Row] = rangeStart + jj;
+      }
+    range.clear();
+
+    // Return the positions to the processes owning the rows, in the order
+    // the keys were received.  Both sides know the lengths.
+    for (int pp=0; pp < numProcs; pp++)
+      {
+      vtkIdType* sendRanks = &ranks[recvOffsets[pp]];
+      vtkIdType sendLength = recvOffsets[pp+1] - recvOffsets[pp];
+      vtkIdType recvLength = bounds[pp+1] - bounds[pp];
+      vtkIdType* recvRanks = recvLength > 0?
+        &internals->SortedRanks[bounds[pp]] : 0;
+      if (pp == myId)
+        {
+        vtkstd::copy(sendRanks, sendRanks + sendLength, recvRanks);
+        continue;
+        }
+      for (int step=0; step < 2; step++)
+        {
+        if ((step == 0) == (myId < pp))
+          {
+          if (sendLength > 0)
+            {
+            this->Controller->Send(sendRanks, sendLength, pp,
+              SORTED_RANKS_TAG);
+            }
+          }
+        else if (recvLength > 0)
+          {
+          this->Controller->Receive(recvRanks, recvLength, pp,
+            SORTED_RANKS_TAG);
+          }
+        }
+      }
+    }
+
+  internals->Valid = true;
+  internals->Input = dObj;
+  internals->InputMTime = dObj->GetMTime();
+  internals->ColumnName = this->SortColumnName;
+  internals->Component = this->SortComponent;
+  internals->Ascending = this->SortAscending;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Sends the keys to process \c other and appends the keys it sends to this
+// one.  The lower rank sends first.
+void vtkTableStreamer::ExchangeKeys(int other,
+  vtkstd::vector<double>& sendValues, vtkstd::vector<vtkIdType>& sendIds,
+  vtkstd::vector<double>& recvValues, vtkstd::vector<vtkIdType>& recvIds)
+{
+  int myId = this->Controller->GetLocalProcessId();
+  for (int step=0; step < 2; step++)
+    {
+    if ((step == 0) == (myId < other))
+      {
+      vtkIdType length = static_cast<vtkIdType>(sendValues.size());
+      this->Controller->Send(&length, 1, other, SORTED_KEYS_TAG);
+      if (length > 0)
+        {
+        this->Controller->Send(&sendValues[0], length, other,
+          SORTED_KEYS_TAG);
+        this->Controller->Send(&sendIds[0], length, other, SORTED_KEYS_TAG);
+        }
+      }
+    else
+      {
+      vtkIdType length = 0;
+      this->Controller->Receive(&length, 1, other, SORTED_KEYS_TAG);
+      if (length > 0)
+        {
+        size_t start = recvValues.size();
+        recvValues.resize(start + length);
+        recvIds.resize(start + length);
+        this->Controller->Receive(&recvValues[start], length, other,
+          SORTED_KEYS_TAG);
+        this->Controller->Receive(&recvIds[start], length, other,
+          SORTED_KEYS_TAG);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkTableStreamer::DetermineSortedRowsToPass(
+  vtkstd::vector<vtkstd::vector<vtkIdType> >& leafRows,
+  vtkstd::vector<vtkstd::vector<vtkIdType> >& leafRanks)
+{
+  vtkInternals* internals = this->Internals;
+
+  // The local rows of the block, in the sorted order.
+  vtkIdType blockStartIndex = this->Block*this->BlockSize;
+  vtkIdType blockEndIndex = blockStartIndex + this->BlockSize;
+  vtkstd::vector<vtkIdType>::iterator first = vtkstd::lower_bound(
+    internals->SortedRanks.begin(), internals->SortedRanks.end(),
+    blockStartIndex);
+  vtkstd::vector<vtkIdType>::iterator last = vtkstd::lower_bound(
+    first, internals->SortedRanks.end(), blockEndIndex);
+
+  // Split them by leaf.
+  size_t numLeaves = internals->LeafOffsets.empty()? 0 :
+    internals->LeafOffsets.size() - 1;
+  leafRows.assign(numLeaves, vtkstd::vector<vtkIdType>());
+  leafRanks.assign(numLeaves, vtkstd::vector<vtkIdType>());
+  for (vtkstd::vector<vtkIdType>::iterator rank = first; rank != last; ++rank)
+    {
+    vtkIdType row = internals->SortedRows[rank -
+      internals->SortedRanks.begin()];
+    size_t leaf = vtkstd::upper_bound(internals->LeafOffsets.begin(),
+      internals->LeafOffsets.end(), row) - internals->LeafOffsets.begin() - 1;
+    leafRows[leaf].push_back(row - internals->LeafOffsets[leaf]);
+    leafRanks[leaf].push_back(*rank);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkTableStreamer::PassSortedRows(vtkCompositeDataSet* input,
+  vtkMultiBlockDataSet* output)
+{
+  int numProcs = 1;
+  int myId = 0;
+  if (this->Controller)
+    {
+    numProcs = this->Controller->GetNumberOfProcesses();
+    myId = this->Controller->GetLocalProcessId();
+    }
+
+  vtkstd::vector<vtkstd::vector<vtkIdType> > leafRows;
+  vtkstd::vector<vtkstd::vector<vtkIdType> > leafRanks;
+  this->DetermineSortedRowsToPass(leafRows, leafRanks);
+  size_t numLeaves = leafRows.size();
+
+  vtkCompositeDataIterator* iter = input->NewIterator();
+  iter->SkipEmptyNodesOff();
+  size_t cc=0;
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal() && cc < numLeaves;
+    iter->GoToNextItem(), cc++)
+    {
+    if (leafRows[cc].empty())
+      {
+      continue;
+      }
+    vtkTable* curTable = vtkTable::SafeDownCast(iter->GetCurrentDataObject());
+    vtkTable* outTable = vtkTable::New();
+    output->SetDataSet(iter, outTable);
+    outTable->Delete();
+    this->PassRows(iter, curTable, leafRows[cc], outTable);
+    if (numProcs > 1)
+      {
+      // Needed to merge the rows of all processes. The process ids are kept
+      // since the rows are gathered on the first process.
+      vtkIdTypeArray* ranks = vtkIdTypeArray::New();
+      ranks->SetName("vtkSortedRanks");
+      ranks->SetNumberOfTuples(static_cast<vtkIdType>(leafRanks[cc].size()));
+      vtkstd::copy(leafRanks[cc].begin(), leafRanks[cc].end(),
+        ranks->GetPointer(0));
+      outTable->AddColumn(ranks);
+      ranks->Delete();
+      vtkIdTypeArray* processIds = vtkIdTypeArray::New();
+      processIds->SetName("vtkOriginalProcessIds");
+      processIds->SetNumberOfTuples(ranks->GetNumberOfTuples());
+      processIds->FillComponent(0, myId);
+      outTable->AddColumn(processIds);
+      processIds->Delete();
+      }
+    }
+
+  if (numProcs <= 1)
+    {
+    iter->Delete();
+    return true;
+    }
+
+  // Gather the rows of the block on the first process.
+  if (myId != 0)
+    {
+    this->Controller->Send(output, 0, SORTED_ROWS_TAG);
+    output->CopyStructure(input);
+    iter->Delete();
+    return true;
+    }
+
+  vtkstd::vector<vtkSmartPointer<vtkMultiBlockDataSet> > pieces(numProcs);
+  pieces[0].TakeReference(output->NewInstance());
+  pieces[0]->ShallowCopy(output);
+  for (int pp=1; pp < numProcs; pp++)
+    {
+    vtkDataObject* piece = this->Controller->ReceiveDataObject(pp,
+      SORTED_ROWS_TAG);
+    pieces[pp] = vtkMultiBlockDataSet::SafeDownCast(piece);
+    if (piece)
+      {
+      piece->Delete();
+      }
+    }
+  output->CopyStructure(input);
+
+  // Merge the rows of every leaf by rank.
+  vtkstd::vector<vtkTable*> tables(numProcs);
+  vtkstd::vector<vtkAbstractArray*> sources(numProcs);
+  vtkstd::vector<vtkstd::pair<vtkIdType, vtkstd::pair<int, vtkIdType> > > order;
+  for (iter->InitTraversal(); !iter->IsDoneWithTraversal();
+    iter->GoToNextItem())
+    {
+    order.clear();
+    vtkTable* prototype = 0;
+    for (int pp=0; pp < numProcs; pp++)
+      {
+      tables[pp] = pieces[pp]?
+        vtkTable::SafeDownCast(pieces[pp]->GetDataSet(iter)) : 0;
+      vtkIdTypeArray* ranks = tables[pp]? vtkIdTypeArray::SafeDownCast(
+        tables[pp]->GetColumnByName("vtkSortedRanks")) : 0;
+      if (!ranks)
+        {
+        continue;
+        }
+      prototype = prototype? prototype : tables[pp];
+      for (vtkIdType jj=0; jj < ranks->GetNumberOfTuples(); jj++)
+        {
+        order.push_back(vtkstd::make_pair(ranks->GetValue(jj),
+            vtkstd::make_pair(pp, jj)));
+        }
+      }
+    if (!prototype)
+      {
+      continue;
+      }
+    vtkstd::sort(order.begin(), order.end());
+    vtkIdType numRows = static_cast<vtkIdType>(order.size());
+
+    // The output has the columns of the input table, followed by the ones
+    // added by PassRows().  The rows of other processes may not have their
+    // columns in the same order, so they are copied column by column, by
+    // name.
+    vtkTable* outTable = vtkTable::New();
+    vtkDataSetAttributes* outRows = outTable->GetRowData();
+    vtkTable* inTable = vtkTable::SafeDownCast(input->GetDataSet(iter));
+    if (inTable)
+      {
+      outRows->CopyAllocate(inTable->GetRowData(), numRows);
+      }
+    vtkDataSetAttributes* protoRows = prototype->GetRowData();
+    for (int kk=0; kk < protoRows->GetNumberOfArrays(); kk++)
+      {
+      vtkAbstractArray* column = protoRows->GetAbstractArray(kk);
+      const char* name = column->GetName();
+      if (name && strcmp(name, "vtkSortedRanks") != 0 &&
+        !outRows->GetAbstractArray(name))
+        {
+        vtkAbstractArray* newColumn = column->NewInstance();
+        newColumn->SetName(name);
+        newColumn->SetNumberOfComponents(column->GetNumberOfComponents());
+        outRows->AddArray(newColumn);
+        newColumn->Delete();
+        }
+      }
+    outRows->SetNumberOfTuples(numRows);
+    for (int kk=0; kk < outRows->GetNumberOfArrays(); kk++)
+      {
+      vtkAbstractArray* outColumn = outRows->GetAbstractArray(kk);
+      for (int pp=0; pp < numProcs; pp++)
+        {
+        sources[pp] = tables[pp]? tables[pp]->GetRowData()->GetAbstractArray(
+          outColumn->GetName()) : 0;
+        }
+      for (vtkIdType jj=0; jj < numRows; jj++)
+        {
+        vtkAbstractArray* source = sources[order[jj].second.first];
+        if (source)
+          {
+          outColumn->SetTuple(jj, order[jj].second.second, source);
+          }
+        }
+      }
+    output->SetDataSet(iter, outTable);
+    outTable->Delete();
+    }
+  iter->Delete();
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkTableStreamer::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "Block: " << this->Block << endl;
+  os << indent << "BlockSize: " << this->BlockSize << endl;
+  os << indent << "GenerateOriginalIds: " << this->GenerateOriginalIds << endl;
+  os << indent << "SortColumnName: "
+     << (this->SortColumnName? this->SortColumnName : "(none)") << endl;
+  os << indent << "SortComponent: " << this->SortComponent << endl;
+  os << indent << "SortAscending: " << this->SortAscending << endl;
+  os << indent << "Controller: " << this->Controller << endl;
 }
 
 
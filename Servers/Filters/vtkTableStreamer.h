@@ -15,6 +15,15 @@
 // .NAME vtkTableStreamer - block-based vtkTable streaming filter.
 // .SECTION Description
 // vtkTableStreamer is a block-based vtkTable streaming filter. 
+//
+// When SortColumnName is set, blocks are taken from the rows sorted by that
+// column instead of the input order. The rows of all processes are ranked
+// with a parallel sample sort which is cached until the input or the sort
+// parameters change, so that any block of the sorted order is served by
+// the processes owning its rows. The rows of the block are then gathered,
+// in order, on the first process. For composite input the rows of all the
+// leaves are sorted together and each row is passed in its own leaf. Only
+// numeric columns can be sorted; rows without a value come last.
 
 #ifndef __vtkTableStreamer_h
 #define __vtkTableStreamer_h
@@ -22,7 +31,11 @@
 #include "vtkDataObjectAlgorithm.h"
 #include <vtkstd/vector> // needed for vtkstd::vector
 
+class vtkCompositeDataIterator;
+class vtkCompositeDataSet;
+class vtkMultiBlockDataSet;
 class vtkMultiProcessController;
+class vtkTable;
 
 class VTK_EXPORT vtkTableStreamer : public vtkDataObjectAlgorithm
 {
@@ -48,6 +61,26 @@ public:
   vtkSetMacro(GenerateOriginalIds, int);
   vtkGetMacro(GenerateOriginalIds, int);
 
+  // Description:
+  // Get/Set the name of the column to sort the rows by. When NULL or empty
+  // (default) the rows are passed in the input order.
+  vtkSetStringMacro(SortColumnName);
+  vtkGetStringMacro(SortColumnName);
+
+  // Description:
+  // Get/Set the component of the sort column to sort by. -1 (default) uses
+  // the magnitude of multi-component columns and the only component of
+  // single-component columns.
+  vtkSetMacro(SortComponent, int);
+  vtkGetMacro(SortComponent, int);
+
+  // Description:
+  // Get/Set whether the rows are sorted in ascending (default) or
+  // descending order.
+  vtkSetMacro(SortAscending, int);
+  vtkGetMacro(SortAscending, int);
+  vtkBooleanMacro(SortAscending, int);
+
   // Description:
   // Get/Set the MPI controller used for gathering.
   void SetController(vtkMultiProcessController*);
@@ -78,10 +111,39 @@ protected:
   bool DetermineIndicesToPass(vtkDataObject* dObj,
     vtkstd::vector<vtkstd::pair<vtkIdType, vtkIdType> >& result);
 
+  // Description:
+  // Ranks the rows of all processes by the sort column. The result is
+  // cached until the input or the sort parameters change.
+  bool SortRows(vtkDataObject* dObj);
+
+  // Description:
+  // Fills up \c leafRows with the rows of each leaf node on this process
+  // that are in the current block of the sorted order, in that order, and
+  // \c leafRanks with their position in the sorted order of all processes.
+  // SortRows() must have succeeded first.
+  void DetermineSortedRowsToPass(
+    vtkstd::vector<vtkstd::vector<vtkIdType> >& leafRows,
+    vtkstd::vector<vtkstd::vector<vtkIdType> >& leafRanks);
+
+  // Description:
+  // Passes the rows of the current block of the sorted order. On return,
+  // the first process has all the rows of the block in \c output.
+  bool PassSortedRows(vtkCompositeDataSet* input,
+    vtkMultiBlockDataSet* output);
+
+  // Description:
+  // Copies the given rows of the current leaf of \c iter into \c outTable,
+  // adding the index arrays requested on this filter.
+  void PassRows(vtkCompositeDataIterator* iter, vtkTable* curTable,
+    const vtkstd::vector<vtkIdType>& rows, vtkTable* outTable);
+
 
   vtkIdType Block;
   vtkIdType BlockSize;
   int GenerateOriginalIds;
+  char* SortColumnName;
+  int SortComponent;
+  int SortAscending;
   vtkMultiProcessController* Controller;
 private:
   vtkTableStreamer(const vtkTableStreamer&); // Not implemented
@@ -93,6 +155,16 @@ private:
   // rows). This works in parallel collecting information across all processes.
   bool CountRows(vtkDataObject* dObj, vtkstd::vector<vtkIdType>& counts,
     vtkstd::vector<vtkIdType>& offsets);
+
+  // Description:
+  // Sends the given sort keys to process \c other and appends the keys it
+  // sends to this process. Both processes call this method at the same time.
+  void ExchangeKeys(int other,
+    vtkstd::vector<double>& sendValues, vtkstd::vector<vtkIdType>& sendIds,
+    vtkstd::vector<double>& recvValues, vtkstd::vector<vtkIdType>& recvIds);
+
+  class vtkInternals;
+  vtkInternals* Internals;
 //ETX
 };
 
@@ -0,0 +1,48 @@
+# Test writing XML files from a few aggregator processes and reading them
+# back through the .pvd index.
+
+import SMPythonTesting
+import os
+import os.path
+import sys
+from paraview import servermanager
+
+SMPythonTesting.ProcessCommandLineArguments()
+
+connection = servermanager.Connect()
+numProcs = connection.GetNumberOfDataPartitions()
+
+sphere = servermanager.sources.SphereSource(ThetaResolution=32,
+                                            PhiResolution=32)
+sphere.UpdatePipeline()
+numCells = sphere.GetDataInformation().GetNumberOfCells()
+numPoints = sphere.GetDataInformation().GetNumberOfPoints()
+
+fname = os.path.join(SMPythonTesting.TempDir, "aggregated.vtp")
+writer = servermanager.writers.XMLPolyDataAggregatedWriter(Input=sphere,
+  FileName=fname, NumberOfAggregators=2)
+writer.UpdatePipeline()
+
+if numProcs > 1:
+  # Each aggregator wrote aggregated_<i>.vtp, listed in aggregated.pvd.
+  fname = os.path.join(SMPythonTesting.TempDir, "aggregated.pvd")
+  for i in range(2):
+    piece = os.path.join(SMPythonTesting.TempDir, "aggregated_%d.vtp" % i)
+    if not os.path.exists(piece):
+      print "ERROR: Missing file written by aggregator", i
+      sys.exit(1)
+  reader = servermanager.sources.PVDReader(FileName=fname)
+else:
+  reader = servermanager.sources.XMLPolyDataReader(FileName=fname)
+reader.UpdatePipeline()
+
+readCells = reader.GetDataInformation().GetNumberOfCells()
+if readCells != numCells:
+  print "ERROR: Read", readCells, "cells instead of", numCells
+  sys.exit(1)
+
+# The points on the boundaries of the pieces are duplicated.
+readPoints = reader.GetDataInformation().GetNumberOfPoints()
+if readPoints < numPoints:
+  print "ERROR: Read", readPoints, "points instead of", numPoints
+  sys.exit(1)
@@ -0,0 +1,65 @@
+# Test plotting a selection over time read directly from a file series
+# reader, with the selection given as global ids and as indices.
+
+import SMPythonTesting
+import os.path
+import sys
+from paraview import servermanager
+
+SMPythonTesting.ProcessCommandLineArguments()
+
+servermanager.Connect()
+
+# Point i of step t has the value 10*t + i and the global id 100 + i.
+numPoints = 10
+numSteps = 3
+fnames = []
+for t in range(numSteps):
+  fname = os.path.join(SMPythonTesting.TempDir, "arraysovertime_%d.vtk" % t)
+  f = open(fname, "w")
+  f.write("# vtk DataFile Version 3.0\nstep %d\nASCII\nDATASET POLYDATA\n" % t)
+  f.write("POINTS %d float\n" % numPoints)
+  for i in range(numPoints):
+    f.write("%d 0 0\n" % i)
+  f.write("POINT_DATA %d\n" % numPoints)
+  f.write("SCALARS Value float 1\nLOOKUP_TABLE default\n")
+  for i in range(numPoints):
+    f.write("%d\n" % (10 * t + i))
+  f.write("GLOBAL_IDS Ids vtkIdType\n")
+  for i in range(numPoints):
+    f.write("%d\n" % (100 + i))
+  f.close()
+  fnames.append(fname)
+
+reader = servermanager.sources.LegacyVTKFileReader(FileNames=fnames)
+
+def CheckSelection(selection, indices):
+  extract = servermanager.filters.ExtractSelectionOverTime(Input=reader,
+    Selection=selection)
+  extract.UpdatePipeline()
+  output = servermanager.Fetch(extract, 0)
+  if output.GetNumberOfBlocks() != len(indices):
+    print "ERROR: Got", output.GetNumberOfBlocks(), "blocks instead of", \
+      len(indices)
+    sys.exit(1)
+  for k in range(len(indices)):
+    pointData = output.GetBlock(k).GetPointData()
+    values = pointData.GetArray("Value")
+    mask = pointData.GetArray("vtkValidPointMask")
+    if not values or not mask:
+      print "ERROR: Missing arrays in block", k
+      sys.exit(1)
+    for t in range(numSteps):
+      expected = 10 * t + indices[k]
+      if mask.GetValue(t) != 1 or values.GetValue(t) != expected:
+        print "ERROR: Wrong value for point", indices[k], "at step", t, ":", \
+          values.GetValue(t), "instead of", expected
+        sys.exit(1)
+
+# Every process reads the whole dataset for some of the time steps.
+CheckSelection(servermanager.sources.GlobalIDSelectionSource(
+  IDs=[103, 107], FieldType='POINT'), [3, 7])
+
+# Indices of process 0.
+CheckSelection(servermanager.sources.IDSelectionSource(
+  IDs=[0, 2, 0, 5], FieldType='POINT'), [2, 5])
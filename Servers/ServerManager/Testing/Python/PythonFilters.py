@@ -41,3 +41,54 @@ if hasnumpy:
     # if not SMPythonTesting.DoRegressionTesting(ren.SMProxy):
     #     raise SMPythonTesting.Error('Image comparison failed.')
 
+
+    # The calculator on a composite dataset: every block gets the result.
+    g = GroupDatasets(Input=[Sphere(), Sphere(Center=[2, 0, 0])])
+    pc = PythonCalculator(Input=g, Expression="Normals[:, 1] * 2")
+    pc.UpdatePipeline()
+    mb = servermanager.Fetch(pc)
+    for b in range(mb.GetNumberOfBlocks()):
+        block = mb.GetBlock(b)
+        n_a = block.GetPointData().GetArray('Normals')
+        r_a = block.GetPointData().GetArray('result')
+        if not r_a or r_a.GetNumberOfTuples() != block.GetNumberOfPoints():
+            raise SMPythonTesting.Error("Block %d has no result array" % b)
+        for i in range(10):
+            if n_a.GetValue(i*3 + 1) * 2 != r_a.GetValue(i):
+                raise SMPythonTesting.Error("Block %d value %d does not match" % (b, i))
+
+    # Arrays must be shared between VTK and numpy in both directions.
+    import time
+    from paraview import vtk
+    from paraview.vtk import dataset_adapter
+
+    ntuples = 1000000
+    pd = vtk.vtkPolyData()
+    velocity = vtk.vtkFloatArray()
+    velocity.SetName('Velocity')
+    velocity.SetNumberOfComponents(3)
+    velocity.SetNumberOfTuples(ntuples)
+    velocity.FillComponent(0, 1.0)
+    pd.GetPointData().AddArray(velocity)
+    wpd = dataset_adapter.WrapDataObject(pd)
+
+    v = wpd.PointData['Velocity']
+    v[0, 0] = 42
+    if velocity.GetComponent(0, 0) != 42:
+        raise SMPythonTesting.Error("Input array was copied")
+
+    result = arange(3.0 * ntuples).reshape(ntuples, 3)
+    wpd.PointData.append(result, 'result')
+    result[0, 0] = 42
+    if pd.GetPointData().GetArray('result').GetComponent(0, 0) != 42:
+        raise SMPythonTesting.Error("Output array was copied")
+
+    # Report the per-step cost of the conversions.
+    nsteps = 20
+    t = time.time()
+    for i in range(nsteps):
+        v = wpd.PointData['Velocity']
+        w = v * 2
+        wpd.PointData.append(w, 'result')
+    print "VTK -> numpy -> VTK with %d tuples: %g s per step" % \
+      (ntuples, (time.time() - t) / nsteps)
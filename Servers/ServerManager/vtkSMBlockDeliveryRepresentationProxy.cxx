@@ -15,6 +15,7 @@
 #include "vtkSMBlockDeliveryRepresentationProxy.h"
 
 #include "vtkAlgorithm.h"
+#include "vtkCommand.h"
 #include "vtkDataObject.h"
 #include "vtkObjectFactory.h"
 #include "vtkProcessModule.h"
@@ -28,6 +29,8 @@
 
 #include <vtkstd/map>
 
+#include <string.h>
+
 //----------------------------------------------------------------------------
 class vtkSMBlockDeliveryRepresentationProxy::vtkInternal
 {
@@ -37,12 +40,39 @@ public:
   public:
     vtkSmartPointer<vtkDataObject> Dataobject;
     vtkTimeStamp RecentUseTime;
+    // Set for prefetched blocks until they are accessed.
+    bool Prefetched;
     };
 
   typedef vtkstd::map<vtkIdType, CacheInfo> CacheType;
   CacheType CachedBlocks;
 
-  void AddToCache(vtkIdType blockId, vtkDataObject* data, vtkIdType max)
+  // Returns the block to discard to make room for a new one.  Prefetched
+  // blocks that were never accessed go first, then the least-recently-used
+  // block.  When onlyPrefetched is true, accessed blocks are never returned.
+  CacheType::iterator FindBlockToRemove(bool onlyPrefetched)
+    {
+    CacheType::iterator iterToRemove = this->CachedBlocks.end();
+    CacheType::iterator iter = this->CachedBlocks.begin();
+    for (; iter != this->CachedBlocks.end(); ++iter)
+      {
+      if (onlyPrefetched && !iter->second.Prefetched)
+        {
+        continue;
+        }
+      if (iterToRemove == this->CachedBlocks.end() ||
+        (iter->second.Prefetched && !iterToRemove->second.Prefetched) ||
+        (iter->second.Prefetched == iterToRemove->second.Prefetched &&
+         iterToRemove->second.RecentUseTime > iter->second.RecentUseTime))
+        {
+        iterToRemove = iter;
+        }
+      }
+    return iterToRemove;
+    }
+
+  void AddToCache(vtkIdType blockId, vtkDataObject* data, vtkIdType max,
+    bool prefetched=false)
     {
     CacheType::iterator iter = this->CachedBlocks.find(blockId);
     if (iter != this->CachedBlocks.end())
@@ -50,24 +80,16 @@ public:
       this->CachedBlocks.erase(iter);
       }
 
-    if (static_cast<vtkIdType>(this->CachedBlocks.size()) == max)
+    if (static_cast<vtkIdType>(this->CachedBlocks.size()) >= max &&
+      !this->CachedBlocks.empty())
       {
-      // remove least-recent-used block.
-      iter = this->CachedBlocks.begin();
-      CacheType::iterator iterToRemove = this->CachedBlocks.begin();
-      for (; iter != this->CachedBlocks.end(); ++iter)
-        {
-        if (iterToRemove->second.RecentUseTime > iter->second.RecentUseTime)
-          {
-          iterToRemove = iter;
-          }
-        }
-      this->CachedBlocks.erase(iterToRemove);
+      this->CachedBlocks.erase(this->FindBlockToRemove(false));
       }
 
     vtkInternal::CacheInfo info;
     info.Dataobject = data;
     info.RecentUseTime.Modified();
+    info.Prefetched = prefetched;
     this->CachedBlocks[blockId] = info;
     }
 };
@@ -226,9 +248,54 @@ void vtkSMBlockDeliveryRepresentationProxy::Update(vtkSMViewProxy* view)
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkSMBlockDeliveryRepresentationProxy::ExecuteSubProxyEvent(
+  vtkSMProxy* subproxy, unsigned long event, void* data)
+{
+  this->Superclass::ExecuteSubProxyEvent(subproxy, event, data);
+
+  // The cached blocks were taken from the previous order of the rows.
+  const char* name = reinterpret_cast<const char*>(data);
+  if (subproxy && subproxy == this->Streamer && name &&
+    event == vtkCommand::UpdatePropertyEvent &&
+    strncmp(name, "Sort", 4) == 0)
+    {
+    this->CleanCache();
+    this->CacheDirty = true;
+    }
+}
+
 //----------------------------------------------------------------------------
 // Ensure that the block selected by \c block is available on the client.
 void vtkSMBlockDeliveryRepresentationProxy::Fetch(vtkIdType block)
+{
+  this->Fetch(block, false);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSMBlockDeliveryRepresentationProxy::Prefetch(vtkIdType block)
+{
+  if (block < 0 || block >= this->GetNumberOfRequiredBlocks() ||
+    this->IsAvailable(block))
+    {
+    return false;
+    }
+  // Never discard a block that was accessed to make room for one that may
+  // not be.
+  if (static_cast<vtkIdType>(this->Internal->CachedBlocks.size()) >=
+    this->CacheSize &&
+    this->Internal->FindBlockToRemove(true) ==
+    this->Internal->CachedBlocks.end())
+    {
+    return false;
+    }
+  this->Fetch(block, true);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSMBlockDeliveryRepresentationProxy::Fetch(vtkIdType block,
+  bool prefetch)
 {
   vtkInternal::CacheType::iterator iter = 
     this->Internal->CachedBlocks.find(block);
@@ -255,7 +322,7 @@ void vtkSMBlockDeliveryRepresentationProxy::Fetch(vtkIdType block)
 
     vtkDataObject* clone = output->NewInstance();
     clone->ShallowCopy(output);
-    this->Internal->AddToCache(block, clone, this->CacheSize);
+    this->Internal->AddToCache(block, clone, this->CacheSize, prefetch);
     this->IsAvailable(block);
     clone->Delete();
     }
@@ -278,6 +345,7 @@ vtkDataObject* vtkSMBlockDeliveryRepresentationProxy::GetOutput(vtkIdType block)
   if (iter != this->Internal->CachedBlocks.end())
     {
     iter->second.RecentUseTime.Modified();
+    iter->second.Prefetched = false;
     return iter->second.Dataobject.GetPointer();
     }
 
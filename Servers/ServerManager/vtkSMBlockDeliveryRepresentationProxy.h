@@ -44,6 +44,15 @@ public:
   // Indicates if the block is available on the client.
   virtual bool IsAvailable(vtkIdType blockid);
 
+  // Description:
+  // Fetches a block that is likely to be needed soon (e.g. the next block
+  // while scrolling) so that GetOutput() does not have to wait for it.
+  // Prefetched blocks are the first discarded from the cache and never push
+  // out blocks that were accessed with GetOutput().  Returns false, without
+  // fetching anything, if the block is out of range, already available or
+  // if there is no room for it in the cache.
+  virtual bool Prefetch(vtkIdType block);
+
   // Description:
   // Set the cache size as the maximum number of blocks to cache at a given
   // time. When cache size exceeds this number, the least-recently-accessed
@@ -89,9 +98,16 @@ protected:
   // Create the data pipeline.
   virtual bool CreatePipeline(vtkSMSourceProxy* input, int outputport);
 
+  // Description:
+  // Overridden to clean the cache when the sort properties of the streamer
+  // are pushed, since the blocks then hold other rows.
+  virtual void ExecuteSubProxyEvent(vtkSMProxy* o, unsigned long event,
+    void* data);
+
   // Description:
   // Ensures that the block of data is available on the client.
   void Fetch(vtkIdType block);
+  void Fetch(vtkIdType block, bool prefetch);
 
   vtkSMSourceProxy* PreProcessor;
   vtkSMSourceProxy* Streamer;
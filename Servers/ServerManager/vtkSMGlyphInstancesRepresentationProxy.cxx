@@ -0,0 +1,148 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkSMGlyphInstancesRepresentationProxy.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkSMGlyphInstancesRepresentationProxy.h"
+
+#include "vtkCommand.h"
+#include "vtkMemberFunctionCommand.h"
+#include "vtkObjectFactory.h"
+#include "vtkSMInputProperty.h"
+#include "vtkSMPropertyHelper.h"
+#include "vtkSMRepresentationStrategy.h"
+#include "vtkSMSourceProxy.h"
+
+vtkStandardNewMacro(vtkSMGlyphInstancesRepresentationProxy);
+//----------------------------------------------------------------------------
+vtkSMGlyphInstancesRepresentationProxy::vtkSMGlyphInstancesRepresentationProxy()
+{
+  vtkMemberFunctionCommand<vtkSMGlyphInstancesRepresentationProxy>* command =
+    vtkMemberFunctionCommand<vtkSMGlyphInstancesRepresentationProxy>::New();
+  command->SetCallback(*this,
+    &vtkSMGlyphInstancesRepresentationProxy::UpdateSourceFromInput);
+  this->Observer = command;
+}
+
+//----------------------------------------------------------------------------
+vtkSMGlyphInstancesRepresentationProxy::~vtkSMGlyphInstancesRepresentationProxy()
+{
+  if (this->ObservedInput)
+    {
+    this->ObservedInput->RemoveObserver(this->Observer);
+    }
+  this->Observer->Delete();
+  this->Observer = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSMGlyphInstancesRepresentationProxy::AddInput(
+  unsigned int inputPort, vtkSMSourceProxy* input,
+  unsigned int outputPort, const char* method)
+{
+  this->Superclass::AddInput(inputPort, input, outputPort, method);
+
+  if (inputPort == 0)
+    {
+    if (this->ObservedInput)
+      {
+      this->ObservedInput->RemoveObserver(this->Observer);
+      }
+    this->ObservedInput = input;
+    if (input && vtkSMInputProperty::SafeDownCast(input->GetProperty("Source")))
+      {
+      // The glyph type is picked in the filter panel: follow the "Source"
+      // of the filter whenever the filter is updated.
+      input->AddObserver(vtkCommand::UpdateEvent, this->Observer);
+      this->UpdateSourceFromInput();
+      }
+    return;
+    }
+
+  if (this->GlyphSourceStrategy && this->Source)
+    {
+    vtkSMPropertyHelper(this->GlyphSourceStrategy, "Input").Set(
+      this->Source, this->SourceOutputPort);
+    this->GlyphSourceStrategy->UpdateVTKObjects();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSMGlyphInstancesRepresentationProxy::UpdateSourceFromInput()
+{
+  if (!this->ObservedInput)
+    {
+    return;
+    }
+  vtkSMInputProperty* inputSource = vtkSMInputProperty::SafeDownCast(
+    this->ObservedInput->GetProperty("Source"));
+  if (!inputSource || inputSource->GetNumberOfProxies() == 0)
+    {
+    return;
+    }
+
+  vtkSMProxy* source = inputSource->GetProxy(0);
+  unsigned int port = inputSource->GetOutputPortForConnection(0);
+  if (source == this->Source.GetPointer() && port == this->SourceOutputPort)
+    {
+    return;
+    }
+  vtkSMPropertyHelper(this, "Source").Set(source, port);
+  this->UpdateProperty("Source");
+}
+
+//----------------------------------------------------------------------------
+bool vtkSMGlyphInstancesRepresentationProxy::EndCreateVTKObjects()
+{
+  if (!this->Superclass::EndCreateVTKObjects())
+    {
+    return false;
+    }
+
+  // vtkPVGlyphFilter computed the scale and orientation of every glyph;
+  // apply them as they are. The LODGlyphMapper shares these properties.
+  vtkSMPropertyHelper scaleArray(this->GlyphMapper, "SelectScaleArray");
+  scaleArray.Set(0, "0");
+  scaleArray.Set(1, "0");
+  scaleArray.Set(2, "0");
+  scaleArray.Set(3, "0");
+  scaleArray.Set(4, "GlyphScale");
+
+  vtkSMPropertyHelper orientationArray(this->GlyphMapper,
+    "SelectOrientationVectors");
+  orientationArray.Set(0, "3");
+  orientationArray.Set(1, "0");
+  orientationArray.Set(2, "0");
+  orientationArray.Set(3, "0");
+  orientationArray.Set(4, "GlyphOrientation");
+
+  vtkSMPropertyHelper(this->GlyphMapper, "Scaling").Set(1);
+  vtkSMPropertyHelper(this->GlyphMapper, "ScaleMode").Set(2);
+  vtkSMPropertyHelper(this->GlyphMapper, "ScaleFactor").Set(1.0);
+  // The filter already applied its own Clamping and Range to the scales;
+  // clamping them again would map the final sizes to [0, 1].
+  vtkSMPropertyHelper(this->GlyphMapper, "Clamping").Set(0);
+  vtkSMPropertyHelper range(this->GlyphMapper, "Range");
+  range.Set(0, 0.0);
+  range.Set(1, 1.0);
+  vtkSMPropertyHelper(this->GlyphMapper, "Orient").Set(1);
+  this->GlyphMapper->UpdateVTKObjects();
+  this->LODGlyphMapper->UpdateVTKObjects();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSMGlyphInstancesRepresentationProxy::PrintSelf(ostream& os,
+  vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+}
@@ -0,0 +1,82 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkSMGlyphInstancesRepresentationProxy.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkSMGlyphInstancesRepresentationProxy - representation for the
+// output of the Glyph filter in instancing mode.
+// .SECTION Description
+// vtkSMGlyphInstancesRepresentationProxy renders the output of a
+// vtkPVGlyphFilter with GenerateInstances on: the glyph source is drawn once
+// per point by a vtkGlyph3DMapper, scaled and oriented with the
+// "GlyphScale" and "GlyphOrientation" arrays computed by the filter. The
+// scaling options of the filter (scale mode, clamping, range and scale
+// factor) are already applied to these arrays, so the mappers are set up
+// to use them as they are, with their own clamping off. The glyph geometry
+// is never generated nor delivered to the rendering nodes; only the points
+// and the source glyph are.
+//
+// The glyph source follows the "Source" property of the input filter, so
+// the glyph type is chosen in the filter panel. When the input has no such
+// property, the default arrow is used.
+// .SECTION See Also
+// vtkPVGlyphFilter vtkSMGlyph3DMapperRepresentationProxy
+
+#ifndef __vtkSMGlyphInstancesRepresentationProxy_h
+#define __vtkSMGlyphInstancesRepresentationProxy_h
+
+#include "vtkSMGlyph3DMapperRepresentationProxy.h"
+#include "vtkWeakPointer.h" // needed for vtkWeakPointer.
+
+class vtkCommand;
+
+class VTK_EXPORT vtkSMGlyphInstancesRepresentationProxy :
+  public vtkSMGlyph3DMapperRepresentationProxy
+{
+public:
+  static vtkSMGlyphInstancesRepresentationProxy* New();
+  vtkTypeMacro(vtkSMGlyphInstancesRepresentationProxy,
+    vtkSMGlyph3DMapperRepresentationProxy);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Overridden to follow the "Source" of the input and to pass a new glyph
+  // source to the rendering nodes.
+  virtual void AddInput(unsigned int inputPort, vtkSMSourceProxy* input,
+    unsigned int outputPort, const char* method);
+  virtual void AddInput(vtkSMSourceProxy* input,
+                        const char* method)
+     { this->Superclass::AddInput(input, method); }
+
+//BTX
+protected:
+  vtkSMGlyphInstancesRepresentationProxy();
+  ~vtkSMGlyphInstancesRepresentationProxy();
+
+  // Description:
+  // Overridden to have the glyph mappers use the glyph transform arrays.
+  virtual bool EndCreateVTKObjects();
+
+  // Description:
+  // Called when the input is updated. Copies its "Source" property.
+  void UpdateSourceFromInput();
+
+  vtkWeakPointer<vtkSMProxy> ObservedInput;
+  vtkCommand* Observer;
+
+private:
+  vtkSMGlyphInstancesRepresentationProxy(const vtkSMGlyphInstancesRepresentationProxy&); // Not implemented
+  void operator=(const vtkSMGlyphInstancesRepresentationProxy&); // Not implemented
+//ETX
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkSMParticleRepresentationProxy.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkSMParticleRepresentationProxy.h"
+
+#include "vtkClientServerStream.h"
+#include "vtkObjectFactory.h"
+#include "vtkProcessModule.h"
+#include "vtkSMRepresentationStrategy.h"
+#include "vtkSMSourceProxy.h"
+#include "vtkSMViewProxy.h"
+#include "vtkSmartPointer.h"
+
+vtkStandardNewMacro(vtkSMParticleRepresentationProxy);
+//----------------------------------------------------------------------------
+vtkSMParticleRepresentationProxy::vtkSMParticleRepresentationProxy()
+{
+  this->LODFraction = 0.1;
+}
+
+//----------------------------------------------------------------------------
+vtkSMParticleRepresentationProxy::~vtkSMParticleRepresentationProxy()
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkSMParticleRepresentationProxy::InitializeStrategy(vtkSMViewProxy* view)
+{
+  vtkSmartPointer<vtkSMRepresentationStrategy> strategy;
+  strategy.TakeReference(view->NewStrategy(VTK_POLY_DATA));
+  if (!strategy.GetPointer())
+    {
+    vtkErrorMacro("View could not provide a strategy to use. "
+      << "Cannot be rendered in this view of type " << view->GetClassName());
+    return false;
+    }
+
+  // The LOD mapper subsamples the full resolution data itself.
+  strategy->SetEnableLOD(false);
+
+  this->Connect(this->GeometryFilter, strategy);
+  this->Connect(strategy->GetOutput(), this->Mapper);
+  this->Connect(strategy->GetOutput(), this->LODMapper);
+
+  // Creates the strategy objects.
+  strategy->UpdateVTKObjects();
+
+  this->AddStrategy(strategy);
+
+  // Skip vtkSMSurfaceRepresentationProxy which sets up its own strategy.
+  return this->vtkSMPropRepresentationProxy::InitializeStrategy(view);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSMParticleRepresentationProxy::EndCreateVTKObjects()
+{
+  if (!this->Superclass::EndCreateVTKObjects())
+    {
+    return false;
+    }
+  this->UpdateLODFraction();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSMParticleRepresentationProxy::SetLODFraction(double fraction)
+{
+  fraction = fraction < 0.0 ? 0.0 : (fraction > 1.0 ? 1.0 : fraction);
+  if (this->LODFraction != fraction)
+    {
+    this->LODFraction = fraction;
+    this->UpdateLODFraction();
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSMParticleRepresentationProxy::UpdateLODFraction()
+{
+  if (!this->ObjectsCreated || !this->LODMapper)
+    {
+    return;
+    }
+  vtkClientServerStream stream;
+  stream  << vtkClientServerStream::Invoke
+          << this->LODMapper->GetID()
+          << "SetSubsampleFraction" << this->LODFraction
+          << vtkClientServerStream::End;
+  vtkProcessModule::GetProcessModule()->SendStream(this->ConnectionID,
+    this->LODMapper->GetServers(), stream);
+}
+
+//----------------------------------------------------------------------------
+void vtkSMParticleRepresentationProxy::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "LODFraction: " << this->LODFraction << endl;
+}
@@ -0,0 +1,77 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkSMParticleRepresentationProxy.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkSMParticleRepresentationProxy - representation for large
+// particle datasets.
+// .SECTION Description
+// vtkSMParticleRepresentationProxy is a surface representation whose
+// geometry filter is a vtkPVParticleGeometryFilter and whose mappers are
+// vtkPVParticleMapper instances, so that the points are rendered directly
+// from the coordinates array without any cells.
+//
+// The strategy LOD pipeline is not used: decimating a cell-less polydata
+// yields nothing. Instead the LOD mapper is fed the full resolution data and
+// draws a random subset of it (see the LODFraction property).
+//
+// Selection is not supported: the geometry has no cells, so nothing can be
+// picked in the view.
+
+#ifndef __vtkSMParticleRepresentationProxy_h
+#define __vtkSMParticleRepresentationProxy_h
+
+#include "vtkSMSurfaceRepresentationProxy.h"
+
+class VTK_EXPORT vtkSMParticleRepresentationProxy :
+  public vtkSMSurfaceRepresentationProxy
+{
+public:
+  static vtkSMParticleRepresentationProxy* New();
+  vtkTypeMacro(vtkSMParticleRepresentationProxy,
+    vtkSMSurfaceRepresentationProxy);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Set the fraction of the particles drawn when the view renders the LOD.
+  // Default is 0.1.
+  void SetLODFraction(double fraction);
+  vtkGetMacro(LODFraction, double);
+
+//BTX
+protected:
+  vtkSMParticleRepresentationProxy();
+  ~vtkSMParticleRepresentationProxy();
+
+  // Description:
+  // Overridden to disable the LOD of the strategy and connect both mappers
+  // to its full resolution output.
+  virtual bool InitializeStrategy(vtkSMViewProxy* view);
+
+  // Description:
+  // Overridden to pass the LODFraction to the LOD mapper.
+  virtual bool EndCreateVTKObjects();
+
+  // Description:
+  // Sends the LODFraction to the LOD mapper. The mappers share their
+  // properties, so the value is not set through a property.
+  void UpdateLODFraction();
+
+  double LODFraction;
+
+private:
+  vtkSMParticleRepresentationProxy(const vtkSMParticleRepresentationProxy&); // Not implemented
+  void operator=(const vtkSMParticleRepresentationProxy&); // Not implemented
+//ETX
+};
+
+#endif
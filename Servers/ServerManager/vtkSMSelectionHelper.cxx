@@ -38,6 +38,7 @@
 #include "vtkSMPropertyHelper.h"
 #include "vtkSMProxyManager.h"
 #include "vtkSMSourceProxy.h"
+#include "vtkUnsignedCharArray.h"
 #include "vtkUnsignedIntArray.h"
 
 #include <vtkstd/vector>
@@ -56,13 +57,20 @@ void vtkSMSelectionHelper::SendSelection(vtkSelection* sel, vtkSMProxy* proxy)
 {
   vtkProcessModule* processModule = vtkProcessModule::GetProcessModule();
 
-  vtksys_ios::ostringstream res;
-  vtkSelectionSerializer::PrintXML(res, vtkIndent(), 1, sel);
+  vtkUnsignedCharArray* buffer = vtkUnsignedCharArray::New();
+  vtkSelectionSerializer::PrintBinary(sel, buffer);
+  vtkClientServerStream packed;
+  packed << vtkClientServerStream::Reply
+         << vtkClientServerStream::InsertArray(buffer->GetPointer(0),
+           static_cast<int>(buffer->GetNumberOfTuples()))
+         << vtkClientServerStream::End;
+  buffer->Delete();
+
   vtkClientServerStream stream;
   vtkClientServerID parserID =
     processModule->NewStreamObject("vtkSelectionSerializer", stream);
   stream << vtkClientServerStream::Invoke
-         << parserID << "Parse" << res.str().c_str() << proxy->GetID()
+         << parserID << "ParseBinary" << packed << proxy->GetID()
          << vtkClientServerStream::End;
   processModule->DeleteStreamObject(parserID, stream);
 
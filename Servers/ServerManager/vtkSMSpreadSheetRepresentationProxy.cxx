@@ -125,9 +125,11 @@ void vtkSMSpreadSheetRepresentationProxy::PassEssentialAttributes()
   // properties has to be managed a bit more gracefully.
 
   // Pass essential properties to the selection representation
-  // such as "BlockSize", "CacheSize", "FieldAssociation"
+  // such as "BlockSize", "CacheSize", "FieldAssociation" and the sort
+  // properties, so that its blocks hold the same rows.
   const char* pnames[] =
-    {"BlockSize", "CacheSize", "FieldAssociation", 0};
+    {"BlockSize", "CacheSize", "FieldAssociation", "SortColumnName",
+     "SortComponent", "SortAscending", 0};
   for (int cc=0; pnames[cc]; cc++)
     {
     vtkSMProperty* src = this->GetProperty(pnames[cc]);
@@ -0,0 +1,130 @@
+#==============================================================================
+#
+#  Program:   ParaView
+#  Module:    calculator.py
+#
+#  Copyright (c) Kitware, Inc.
+#  All rights reserved.
+#  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+#
+#     This software is distributed WITHOUT ANY WARRANTY; without even
+#     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#     PURPOSE.  See the above copyright notice for more information.
+#
+#==============================================================================
+r"""
+This module is used by vtkPythonCalculator. It evaluates an expression over
+the arrays of the inputs of the filter and adds the result to its output.
+
+The expression is compiled once and reused for later executions. Composite
+datasets are processed in a single call that evaluates the expression for
+each block. Arrays are passed between VTK and numpy without copies (see
+dataset_adapter).
+"""
+
+import paraview
+from paraview import vtk
+from paraview.vtk import dataset_adapter
+from numpy import *
+from paraview.vtk.algorithms import *
+
+_compiled_expressions = {}
+
+def get_code(expression):
+    """Returns the compiled form of an expression. Each expression is compiled
+    only the first time it is seen."""
+    code = _compiled_expressions.get(expression)
+    if code is None:
+        if len(_compiled_expressions) > 100:
+            _compiled_expressions.clear()
+        code = compile(expression, "<expression>", "eval")
+        _compiled_expressions[expression] = code
+    return code
+
+def compute(inputs, association, code, ns=None):
+    """Evaluates the compiled expression code for a list of wrapped datasets.
+    The arrays of inputs[0] with the given association ('PointData' or
+    'CellData') are defined as variables, as are the arrays dictionary, the
+    points and the inputs list. A scalar result is expanded to an array with
+    one value per point or cell."""
+    if ns is None:
+        ns = {}
+    arrays = {}
+    fd = getattr(inputs[0], association)
+    for name in fd.keys():
+        array = fd[name]
+        if array is None:
+            continue
+        arrays[name] = array
+        varname = paraview.make_name_valid(name)
+        if varname:
+            ns[varname] = array
+    ns['arrays'] = arrays
+    ns['inputs'] = inputs
+    try:
+        ns['points'] = inputs[0].Points
+    except AttributeError:
+        pass
+
+    retVal = eval(code, globals(), ns)
+    if not isinstance(retVal, ndarray):
+        if association == 'PointData':
+            n = inputs[0].GetNumberOfPoints()
+        else:
+            n = inputs[0].GetNumberOfCells()
+        retVal = retVal * ones((n, 1))
+    return retVal
+
+def execute_block(self, inputs, output, code, association, arrayname,
+                  copyarrays):
+    """Executes the calculator for non-composite datasets."""
+    for inp in inputs:
+        if inp is None or not inp.IsA("vtkDataSet"):
+            return
+    inputs = [dataset_adapter.WrapDataObject(inp) for inp in inputs]
+    output = dataset_adapter.WrapDataObject(output)
+    if copyarrays:
+        output.GetPointData().PassData(inputs[0].GetPointData().VTKObject)
+        output.GetCellData().PassData(inputs[0].GetCellData().VTKObject)
+    if code is None:
+        return
+    retVal = compute(inputs, association, code, {'self' : self})
+    if retVal is not None:
+        getattr(output, association).append(retVal, arrayname)
+
+def execute(self, expression, association, arrayname, copyarrays):
+    """Called by vtkPythonCalculator to compute its output. self is the
+    filter. When the inputs are composite datasets, the output has the same
+    structure as the first input and the expression is evaluated for each
+    of its leaves using the matching leaves of the other inputs."""
+    code = None
+    if expression.strip():
+        code = get_code(expression.strip())
+
+    inputs = []
+    for i in range(self.GetNumberOfInputConnections(0)):
+        inputs.append(self.GetInputDataObject(0, i))
+    output = self.GetOutputDataObject(0)
+    if not inputs or not output:
+        return
+
+    if not output.IsA("vtkCompositeDataSet"):
+        execute_block(self, inputs, output, code, association, arrayname,
+                      copyarrays)
+        return
+
+    it = inputs[0].NewIterator()
+    it.UnRegister(None)
+    it.InitTraversal()
+    while not it.IsDoneWithTraversal():
+        blockinputs = []
+        for inp in inputs:
+            if inp.IsA("vtkCompositeDataSet"):
+                blockinputs.append(inp.GetDataSet(it))
+            else:
+                blockinputs.append(inp)
+        blockoutput = output.GetDataSet(it)
+        if blockoutput:
+            execute_block(self, blockinputs, blockoutput, code, association,
+                          arrayname, copyarrays)
+        it.GoToNextItem()
@@ -25,9 +25,52 @@ def MakeObserver(numpy_array):
         foo = numpy_array
     return Closure
 
+def vtk_to_numpy_view(array):
+    """Returns a numpy array that shares memory with the given vtkDataArray.
+    The result has one row per tuple. It is 1-dimensional for single
+    component arrays."""
+    dtype = numpy_support.get_numpy_array_type(array.GetDataType())
+    ntuples = array.GetNumberOfTuples()
+    ncomps = array.GetNumberOfComponents()
+    if ntuples == 0:
+        # frombuffer() refuses empty buffers.
+        narray = numpy.empty(ntuples*ncomps, dtype=dtype)
+    else:
+        narray = numpy.frombuffer(array, dtype=dtype, count=ntuples*ncomps)
+    if ncomps > 1:
+        narray = narray.reshape(ntuples, ncomps)
+    return narray
+
+def numpy_to_vtk_adopt(array):
+    """Returns a vtkDataArray that uses the memory of the given numpy array
+    without copying it, along with the numpy array actually referenced. That
+    array is a contiguous, flattened view of the input unless the input had to
+    be copied because it was not contiguous or because its type has no VTK
+    equivalent. The caller must keep it alive as long as the vtkDataArray."""
+    narray = numpy.asarray(array)
+    shape = narray.shape
+    if len(shape) > 2:
+        raise ValueError("Only arrays of dimensionality 2 or lower are allowed.")
+    try:
+        vtktype = numpy_support.get_vtk_array_type(narray.dtype)
+    except (KeyError, TypeError):
+        # bool and other types without a VTK equivalent
+        vtktype = numpy_support.get_vtk_array_type(numpy.float64)
+    dtype = numpy.dtype(numpy_support.get_numpy_array_type(vtktype))
+    flat = numpy.ascontiguousarray(narray, dtype=dtype).ravel()
+
+    vtkarray = numpy_support.create_vtk_array(vtktype)
+    if len(shape) == 2:
+        vtkarray.SetNumberOfComponents(shape[1])
+    # The last argument tells the VTK array not to free the memory. Setting
+    # the number of tuples is not needed: SetVoidArray() sets the size.
+    vtkarray.SetVoidArray(flat, len(flat), 1)
+    return vtkarray, flat
+
 def vtkDataArrayToVTKArray(array, dataset=None):
-    "Given a vtkDataArray and a dataset owning it, returns a VTKArray."
-    narray = numpy_support.vtk_to_numpy(array)
+    """Given a vtkDataArray and a dataset owning it, returns a VTKArray.
+    The VTKArray is a view of the memory of the vtkDataArray."""
+    narray = vtk_to_numpy_view(array)
 
     # Make arrays of 9 components into matrices. Also transpose
     # as VTK store matrices in Fortran order
@@ -39,15 +82,13 @@ def vtkDataArrayToVTKArray(array, dataset=None):
     
 def numpyTovtkDataArray(array, name="numpy_array"):
     """Given a numpy array or a VTKArray and a name, returns a vtkDataArray.
-    The resulting vtkDataArray will store a reference to the numpy array
-    through a DeleteEvent observer: the numpy array is released only when
-    the vtkDataArray is destroyed."""
-    if not array.flags.contiguous:
-        array = array.copy()
-    vtkarray = numpy_support.numpy_to_vtk(array)
+    The resulting vtkDataArray uses the memory of the numpy array when it is
+    contiguous and stores a reference to it through a DeleteEvent observer:
+    the numpy array is released only when the vtkDataArray is destroyed."""
+    vtkarray, flat = numpy_to_vtk_adopt(array)
     vtkarray.SetName(name)
-    # This makes the VTK array carry a reference to the numpy array.
-    vtkarray.AddObserver('DeleteEvent', MakeObserver(array))
+    # This makes the VTK array carry a reference to the memory it uses.
+    vtkarray.AddObserver('DeleteEvent', MakeObserver(flat))
     return vtkarray
 
 def make_tensor_array_contiguous(array):
@@ -83,11 +124,13 @@ class VTKArray(numpy.matrix):
         return obj
 
     def __array_finalize__(self,obj):
-        # Copy the VTK array only if the two share data
-        slf = make_tensor_array_contiguous(self)
-        obj2 = make_tensor_array_contiguous(obj)
-        if hasattr(slf, 'data') and hasattr(obj2, 'data') and \
-          slf.data == obj2.data:
+        # Keep the VTK array only if the new array is a view of all of its
+        # memory (a reshape or a transpose). This compares addresses rather
+        # than contents, which is called for every numpy operation.
+        if obj is not None and \
+          self.__array_interface__['data'][0] == \
+            obj.__array_interface__['data'][0] and \
+          self.nbytes == obj.nbytes:
             self.VTKObject = getattr(obj, 'VTKObject', None)
         else:
             self.VTKObject = None
@@ -165,12 +208,10 @@ class DataSetAttributes(VTKObjectWrapper):
                  not narray.flags.contiguous):
                 narray  = narray.transpose(0, 2, 1)
 
-        # If array is not contiguous, make a deep copy that is contiguous
-        if not narray.flags.contiguous:
-            narray = narray.copy()
-
-        # Flatten array of matrices to array of vectors
+        # Flatten array of matrices to array of vectors. This makes a
+        # contiguous copy only if the array is not contiguous already.
         if len(shape) == 3:
+            narray = numpy.ascontiguousarray(narray)
             narray = narray.reshape(shape[0], shape[1]*shape[2])
 
         arr = numpyTovtkDataArray(narray, name)